@@ -0,0 +1,714 @@
+#include <Common/CTimer.h>
+#include <Common/FileUtil.h>
+#include <Common/Log.h>
+#include <Common/TString.h>
+
+#include <Core/CThreadPool.h>
+#include <Core/IProgressNotifier.h>
+#include <Core/IUIRelay.h>
+#include <Core/NCoreTests.h>
+#include <Core/GameProject/CAssetNameMap.h>
+#include <Core/GameProject/CGameExporter.h>
+#include <Core/GameProject/CGameInfo.h>
+#include <Core/GameProject/CGameProject.h>
+#include <Core/GameProject/CResourceStore.h>
+#include <Core/Resource/Script/NGameList.h>
+
+#include <nod/nod.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#if NOD_UCS2
+#define TStringToNodString(string) ToWChar(string)
+#else
+#define TStringToNodString(string) *string
+#endif
+
+static constexpr char gkUsage[] =
+    "Usage: PrimeWorldEditorCli <command> [options]\n"
+    "\n"
+    "Commands:\n"
+    "  export            --iso=<Path> --out=<Dir> [--game=<fe|prime|echoes|corruption>]\n"
+    "                    [--name-map=<Path>] [--game-info=<Path>] [--no-stream]\n"
+    "  rebuild-database  --project=<Path>\n"
+    "  cook-all          --project=<Path>\n"
+    "  cook-dirty        --project=<Path>\n"
+    "  build-iso         --project=<Path> --out=<Path> [--original=<Path>]\n"
+    "  validate-cooker   --project=<Path> [--type=<ResourceType>] [--allowdump]\n"
+    "                    [--shard=<Index>/<Count>] [--report=<Path.xml> [--resume]]\n"
+    "\n"
+    "Options:\n"
+    "  --jobs=<N>        Number of worker threads started in addition to the main thread;\n"
+    "                    0 starts one per core (default)\n"
+    "  --data-dir=<Dir>  Location of the PWE resources and templates directories\n"
+    "  --yes             Answer yes to any question that comes up, such as repairing a corrupt database\n"
+    "\n"
+    "Progress is written to stdout as one JSON object per line.\n";
+
+/** Escapes a string for use inside a JSON string literal */
+static std::string JsonString(const char *pkStr)
+{
+    std::string Out = "\"";
+
+    for (const char *pkChr = pkStr; *pkChr; pkChr++)
+    {
+        const char Chr = *pkChr;
+
+        switch (Chr)
+        {
+        case '"':  Out += "\\\""; break;
+        case '\\': Out += "\\\\"; break;
+        case '\n': Out += "\\n";  break;
+        case '\r': Out += "\\r";  break;
+        case '\t': Out += "\\t";  break;
+        default:
+            if (static_cast<unsigned char>(Chr) < 0x20)
+            {
+                char Escape[8];
+                snprintf(Escape, sizeof(Escape), "\\u%04x", Chr);
+                Out += Escape;
+            }
+            else
+                Out += Chr;
+        }
+    }
+
+    return Out + "\"";
+}
+
+static std::string JsonString(const TString& rkStr)
+{
+    return JsonString(*rkStr);
+}
+
+/** Writes one JSON object per line. Progress can be reported from worker threads, so lines are serialized. */
+static void EmitJson(const std::string& rkFields)
+{
+    static std::mutex sMutex;
+    std::lock_guard Lock(sMutex);
+    fprintf(stdout, "{%s}\n", rkFields.c_str());
+    fflush(stdout);
+}
+
+/** Reports progress as JSON. Step descriptions change for every asset, so a line is only written when the task or whole percentage changes. */
+class CJsonProgressNotifier : public IProgressNotifier
+{
+    std::mutex mMutex;
+    TString mStage;
+    TString mLastTask;
+    int mLastPercent = -1;
+
+public:
+    void SetStage(const TString& rkStage)
+    {
+        std::lock_guard Lock(mMutex);
+        mStage = rkStage;
+        mLastTask = "";
+        mLastPercent = -1;
+    }
+
+    bool ShouldCancel() const override { return false; }
+
+protected:
+    void UpdateProgress(const TString& rkTaskName, const TString& rkStepDesc, float ProgressPercent) override
+    {
+        std::lock_guard Lock(mMutex);
+        const int Percent = static_cast<int>(ProgressPercent * 100.f);
+
+        if (Percent == mLastPercent && rkTaskName == mLastTask)
+            return;
+
+        mLastPercent = Percent;
+        mLastTask = rkTaskName;
+
+        char Progress[32];
+        snprintf(Progress, sizeof(Progress), "%.3f", ProgressPercent);
+
+        EmitJson("\"event\":\"progress\",\"stage\":" + JsonString(mStage) +
+                 ",\"task\":" + JsonString(rkTaskName) +
+                 ",\"step\":" + JsonString(rkStepDesc) +
+                 ",\"progress\":" + Progress);
+    }
+};
+
+/** UI relay for running without a UI. Messages are written as JSON, and questions get the answer passed on the commandline. */
+class CCliUIRelay : public IUIRelay
+{
+    IProgressNotifier *mpProgress;
+    std::unique_ptr<CGameProject> mpProject;
+    bool mAnswerYes;
+
+public:
+    CCliUIRelay(IProgressNotifier *pProgress, bool AnswerYes)
+        : mpProgress(pProgress), mAnswerYes(AnswerYes)
+    {}
+
+    void ShowMessageBox(const TString& rkInfoBoxTitle, const TString& rkMessage) override
+    {
+        EmitJson("\"event\":\"message\",\"title\":" + JsonString(rkInfoBoxTitle) + ",\"text\":" + JsonString(rkMessage));
+    }
+
+    void ShowMessageBoxAsync(const TString& rkInfoBoxTitle, const TString& rkMessage) override
+    {
+        ShowMessageBox(rkInfoBoxTitle, rkMessage);
+    }
+
+    bool AskYesNoQuestion(const TString& rkInfoBoxTitle, const TString& rkQuestion) override
+    {
+        EmitJson("\"event\":\"question\",\"title\":" + JsonString(rkInfoBoxTitle) +
+                 ",\"text\":" + JsonString(rkQuestion) +
+                 ",\"answer\":" + (mAnswerYes ? "true" : "false"));
+        return mAnswerYes;
+    }
+
+    bool OpenProject(const TString& kPath = "") override
+    {
+        CloseProject();
+
+        if (kPath.IsEmpty())
+        {
+            errorf("No project path was given");
+            return false;
+        }
+
+        mpProject = CGameProject::LoadProject(kPath, mpProgress);
+
+        if (!mpProject)
+        {
+            errorf("Failed to open project: %s", *kPath);
+            return false;
+        }
+
+        gpResourceStore = mpProject->ResourceStore();
+        return true;
+    }
+
+    void CloseProject()
+    {
+        if (mpProject)
+        {
+            const bool WasActiveStore = (gpResourceStore == mpProject->ResourceStore());
+            mpProject->ResourceStore()->ConditionalSaveStore();
+            mpProject.reset();
+
+            if (WasActiveStore)
+                gpResourceStore = nullptr;
+        }
+    }
+
+    CGameProject* Project() const { return mpProject.get(); }
+};
+
+class CBatchDriver
+{
+    struct SStageResult
+    {
+        TString Name;
+        double Seconds;
+        bool Success;
+    };
+
+    TString mCommand;
+    std::map<TString, TString> mOptions;
+    CJsonProgressNotifier mProgress;
+    std::unique_ptr<CCliUIRelay> mpUIRelay;
+    std::vector<SStageResult> mStages;
+
+public:
+    /** Main function */
+    int Main(int argc, char *argv[])
+    {
+        if (!ParseCommandline(argc, argv))
+        {
+            fputs(gkUsage, stderr);
+            return 2;
+        }
+
+        // Init log
+        if (!NLog::InitLog(LocateLogPath()))
+            fputs("Couldn't open log file. Logging will not work for this session.\n", stderr);
+
+        // Relay must be set up before anything that may ask a question
+        mpUIRelay = std::make_unique<CCliUIRelay>(&mProgress, HasOption("yes"));
+        gpUIRelay = mpUIRelay.get();
+
+        // Size the worker pools before anything starts using them. The main thread keeps working alongside the pools
+        // (it cooks, and takes part in ParallelFor), so this is the number of extra threads rather than the total.
+        const uint32 NumJobs = static_cast<uint32>(strtoul(*Option("jobs", "0"), nullptr, 10));
+        CThreadPool::SetSharedNumThreads(NumJobs);
+
+        if (!InitDataDirectory(argv[0]))
+            return 1;
+
+        const double StartTime = CTimer::GlobalTime();
+        const bool Success = RunCommand(NumJobs);
+        const double TotalTime = CTimer::GlobalTime() - StartTime;
+
+        mpUIRelay->CloseProject();
+        WriteSummary(Success, TotalTime);
+        return Success ? 0 : 1;
+    }
+
+    /** Clean up any resources at the end of execution */
+    ~CBatchDriver()
+    {
+        if (mpUIRelay)
+            mpUIRelay->CloseProject();
+
+        NGameList::Shutdown();
+        gpUIRelay = nullptr;
+
+        delete gpEditorStore;
+        gpEditorStore = nullptr;
+    }
+
+private:
+    bool ParseCommandline(int argc, char *argv[])
+    {
+        if (argc < 2)
+            return false;
+
+        mCommand = argv[1];
+
+        for (int ArgIdx = 2; ArgIdx < argc; ArgIdx++)
+        {
+            const std::string Arg = argv[ArgIdx];
+
+            if (Arg.size() <= 2 || Arg.compare(0, 2, "--") != 0)
+            {
+                fprintf(stderr, "Unrecognized argument: %s\n", Arg.c_str());
+                return false;
+            }
+
+            const size_t Equals = Arg.find('=');
+
+            if (Equals == std::string::npos)
+                mOptions[Arg.substr(2).c_str()] = "";
+            else
+                mOptions[Arg.substr(2, Equals - 2).c_str()] = Arg.substr(Equals + 1).c_str();
+        }
+
+        return true;
+    }
+
+    bool HasOption(const TString& rkName) const
+    {
+        return mOptions.find(rkName) != mOptions.cend();
+    }
+
+    TString Option(const TString& rkName, const TString& rkDefault = "") const
+    {
+        const auto Find = mOptions.find(rkName);
+        return Find == mOptions.cend() ? rkDefault : Find->second;
+    }
+
+    bool RequireOption(const TString& rkName) const
+    {
+        if (!Option(rkName).IsEmpty())
+            return true;
+
+        EmitJson("\"event\":\"error\",\"text\":" + JsonString("Missing required option --" + rkName));
+        return false;
+    }
+
+    static TString LocateLogPath()
+    {
+#ifndef _WIN32
+        return TString(getenv("HOME")) + "/.primeworldeditor-cli.log";
+#else
+        return "primeworldeditor-cli.log";
+#endif
+    }
+
+    bool InitDataDirectory(const char *pkExePath)
+    {
+        // Same search order as the editor, with the commandline taking priority
+        std::vector<TString> Candidates;
+
+        if (HasOption("data-dir"))
+            Candidates.push_back(Option("data-dir"));
+
+#if !defined(_WIN32) && !defined(__APPLE__) && defined(PWE_DATADIR)
+        Candidates.push_back(PWE_DATADIR);
+#endif
+        const std::filesystem::path ExeDir = std::filesystem::absolute(std::filesystem::u8path(pkExePath)).parent_path();
+        Candidates.push_back((ExeDir.parent_path().u8string() + "/").c_str());
+        Candidates.push_back("..");
+
+        for (const TString& rkCandidate : Candidates)
+        {
+            TString Dir = FileUtil::MakeAbsolute(rkCandidate);
+            Dir.EnsureEndsWith('/');
+            debugf("Checking '%s' for resources", *Dir);
+
+            if (FileUtil::IsDirectory(Dir + "resources"))
+            {
+                gDataDir = Dir;
+                break;
+            }
+        }
+
+        if (gDataDir.IsEmpty())
+        {
+            EmitJson("\"event\":\"error\",\"text\":" + JsonString("Unable to locate the PWE resources directory; pass --data-dir"));
+            return false;
+        }
+
+        gResourcesWritable = FileUtil::IsDirectoryWritable(gDataDir + "resources");
+        gTemplatesWritable = FileUtil::IsDirectoryWritable(gDataDir + "templates");
+
+        // Create editor resource store
+        gpEditorStore = new CResourceStore(gDataDir + "resources/");
+
+        if (!gpEditorStore->AreAllEntriesValid())
+        {
+            debugf("Editor store has invalid entries. Rebuilding database...");
+            gpEditorStore->RebuildFromDirectory();
+            gpEditorStore->ConditionalSaveStore();
+        }
+
+        return true;
+    }
+
+    /** Runs one stage of the command, and records how long it took */
+    bool RunStage(const TString& rkName, const std::function<bool()>& rkFunc)
+    {
+        mProgress.SetStage(rkName);
+        EmitJson("\"event\":\"stage_begin\",\"stage\":" + JsonString(rkName));
+
+        const double StartTime = CTimer::GlobalTime();
+        const bool Success = rkFunc();
+        const double Seconds = CTimer::GlobalTime() - StartTime;
+
+        char Time[32];
+        snprintf(Time, sizeof(Time), "%.3f", Seconds);
+
+        EmitJson("\"event\":\"stage_end\",\"stage\":" + JsonString(rkName) +
+                 ",\"success\":" + (Success ? "true" : "false") +
+                 ",\"seconds\":" + Time);
+
+        mStages.push_back(SStageResult{rkName, Seconds, Success});
+        return Success;
+    }
+
+    void WriteSummary(bool Success, double TotalSeconds) const
+    {
+        std::string Stages;
+
+        for (const SStageResult& rkStage : mStages)
+        {
+            char Time[32];
+            snprintf(Time, sizeof(Time), "%.3f", rkStage.Seconds);
+
+            if (!Stages.empty())
+                Stages += ',';
+
+            Stages += "{\"stage\":" + JsonString(rkStage.Name) +
+                      ",\"success\":" + (rkStage.Success ? "true" : "false") +
+                      ",\"seconds\":" + Time + "}";
+        }
+
+        char Time[32];
+        snprintf(Time, sizeof(Time), "%.3f", TotalSeconds);
+
+        EmitJson("\"event\":\"summary\",\"command\":" + JsonString(mCommand) +
+                 ",\"success\":" + (Success ? "true" : "false") +
+                 ",\"seconds\":" + Time +
+                 ",\"stages\":[" + Stages + "]");
+    }
+
+    bool RunCommand(uint32 NumJobs)
+    {
+        if (mCommand == "export")
+            return ExportGame(NumJobs);
+
+        // Every other command works on an existing project
+        if (!RequireOption("project"))
+            return false;
+
+        if (!RunStage("load-project", [this]() { return mpUIRelay->OpenProject(Option("project")); }))
+            return false;
+
+        CGameProject *pProj = mpUIRelay->Project();
+
+        if (mCommand == "rebuild-database")
+        {
+            return RunStage("rebuild-database", [pProj]()
+            {
+                pProj->TweakManager()->ClearTweaks();
+                pProj->ResourceStore()->RebuildFromDirectory();
+                pProj->TweakManager()->LoadTweaks();
+                return true;
+            });
+        }
+
+        if (mCommand == "cook-all" || mCommand == "cook-dirty")
+            return CookPackages(mCommand == "cook-dirty");
+
+        if (mCommand == "build-iso")
+            return BuildISO();
+
+        if (mCommand == "validate-cooker")
+            return ValidateCooker(NumJobs);
+
+        EmitJson("\"event\":\"error\",\"text\":" + JsonString("Unrecognized command: " + mCommand));
+        return false;
+    }
+
+    bool ExportGame(uint32 NumJobs)
+    {
+        if (!RequireOption("iso") || !RequireOption("out"))
+            return false;
+
+        std::unique_ptr<nod::DiscBase> pDisc;
+        SDiscInfo Info;
+        float BuildVersion = 0.f;
+        bool FrontEnd = false;
+
+        const bool Identified = RunStage("open-disc", [&]()
+        {
+            const TString IsoPath = Option("iso");
+            pDisc = nod::OpenDiscFromImage(TStringToNodString(IsoPath));
+
+            if (!pDisc || !CGameExporter::IdentifyDisc(pDisc.get(), Info))
+            {
+                errorf("Unrecognized disc: %s", *IsoPath);
+                return false;
+            }
+
+            // Wii ports hold more than one game, so let the commandline choose which one to export. Same choices as
+            // CExportGameDialog::RequestWiiPortGame: Trilogy has every game, and Wii de Asobu only has its own game.
+            if (Info.DiscType != EDiscType::Normal)
+            {
+                const TString GameName = Option("game");
+                const bool IsTrilogy = (Info.DiscType == EDiscType::Trilogy);
+                const bool HasMP1 = (IsTrilogy || Info.Game == EGame::Prime);
+                const bool HasMP2 = (IsTrilogy || Info.Game == EGame::Echoes);
+                const bool HasMP3 = IsTrilogy;
+
+                if (GameName == "fe")
+                {
+                    Info.Game = EGame::Corruption;
+                    FrontEnd = true;
+                }
+                else if (GameName == "prime" && HasMP1)
+                    Info.Game = EGame::Prime;
+                else if (GameName == "echoes" && HasMP2)
+                    Info.Game = EGame::Echoes;
+                else if (GameName == "corruption" && HasMP3)
+                    Info.Game = EGame::Corruption;
+                else if (!GameName.IsEmpty() || Info.Game == EGame::Invalid)
+                {
+                    const TString Choices = TString("fe") + (HasMP1 ? ", prime" : "") + (HasMP2 ? ", echoes" : "") + (HasMP3 ? ", corruption" : "");
+                    errorf("This disc holds more than one game; pick one of %s with --game", *Choices);
+                    return false;
+                }
+
+                // Force change game name so it isn't "Metroid Prime Trilogy"
+                if (Info.DiscType == EDiscType::Trilogy && !FrontEnd)
+                    Info.GameTitle = GetGameName(Info.Game);
+            }
+
+            // The demo builds are not supported; see CExportGameDialog::ValidateGame
+            if (Info.Game == EGame::PrimeDemo || Info.Game == EGame::EchoesDemo || Info.Game == EGame::CorruptionProto)
+            {
+                errorf("The demo builds are currently not supported.");
+                return false;
+            }
+
+            BuildVersion = CGameExporter::FindBuildVersion(pDisc.get(), Info.Game);
+            return true;
+        });
+
+        if (!Identified)
+            return false;
+
+        EmitJson("\"event\":\"disc\",\"game\":" + JsonString(GetGameShortName(Info.Game)) +
+                 ",\"title\":" + JsonString(Info.GameTitle) +
+                 ",\"id\":" + JsonString(Info.GameID) +
+                 ",\"region\":" + JsonString(TEnumReflection<ERegion>::ConvertValueToString(Info.Region)));
+
+        CAssetNameMap NameMap(Info.Game);
+        CGameInfo GameInfo;
+
+        const bool Loaded = RunStage("load-game-info", [&]()
+        {
+            // Fall back to the defaults shipped with the editor, like the export dialog does
+            TString NameMapPath = Option("name-map", CAssetNameMap::DefaultNameMapPath(Info.Game));
+            TString GameInfoPath = Option("game-info", CGameInfo::GetDefaultGameInfoPath(Info.Game));
+
+            if (FileUtil::Exists(NameMapPath) && (!NameMap.LoadAssetNames(NameMapPath) || !NameMap.IsValid()))
+            {
+                errorf("Failed to load the asset name map: %s", *NameMapPath);
+                return false;
+            }
+
+            if (FileUtil::Exists(GameInfoPath) && !GameInfo.LoadGameInfo(GameInfoPath))
+            {
+                errorf("Failed to load game info: %s", *GameInfoPath);
+                return false;
+            }
+
+            return true;
+        });
+
+        if (!Loaded)
+            return false;
+
+        return RunStage("export", [&]()
+        {
+            TString ExportDir = Option("out");
+            ExportDir.EnsureEndsWith('/');
+
+            CGameExporter Exporter(Info.DiscType, Info.Game, FrontEnd, Info.Region, Info.GameTitle, Info.GameID, BuildVersion);
+            Exporter.SetNumJobs(NumJobs);
+            Exporter.SetStreamPaks(!HasOption("no-stream"));
+
+            if (!Exporter.Export(pDisc.get(), ExportDir, &NameMap, &GameInfo, &mProgress))
+                return false;
+
+            EmitJson("\"event\":\"project\",\"path\":" + JsonString(Exporter.ProjectPath()));
+            return true;
+        });
+    }
+
+    bool CookPackages(bool DirtyOnly)
+    {
+        CGameProject *pProj = mpUIRelay->Project();
+        std::vector<CPackage*> Packages;
+
+        for (size_t PkgIdx = 0; PkgIdx < pProj->NumPackages(); PkgIdx++)
+        {
+            CPackage *pPackage = pProj->PackageByIndex(PkgIdx);
+
+            if (!DirtyOnly || pPackage->NeedsRecook())
+                Packages.push_back(pPackage);
+        }
+
+        return RunStage(DirtyOnly ? "cook-dirty" : "cook-all", [&]()
+        {
+            return Packages.empty() || pProj->CookPackages(Packages, &mProgress);
+        });
+    }
+
+    bool BuildISO()
+    {
+        if (!RequireOption("out"))
+            return false;
+
+        CGameProject *pProj = mpUIRelay->Project();
+        const bool NeedsDiscMerge = pProj->IsWiiDeAsobu() || pProj->IsTrilogy();
+        std::unique_ptr<nod::DiscBase> pBaseDisc;
+
+        if (NeedsDiscMerge)
+        {
+            if (!RequireOption("original"))
+                return false;
+
+            // Verify this ISO matches the original
+            bool IsWii;
+            pBaseDisc = nod::OpenDiscFromImage(TStringToNodString(Option("original")), IsWii);
+
+            if (!pBaseDisc || !IsWii)
+            {
+                errorf("The ISO provided is not a valid Wii ISO!");
+                return false;
+            }
+
+            if (strncmp(*pProj->GameID(), pBaseDisc->getHeader().m_gameID, 6) != 0)
+            {
+                errorf("The ISO provided doesn't match the project!");
+                return false;
+            }
+        }
+
+        // The disc is built from the cooked paks, so make sure they're up to date first
+        if (!CookPackages(true))
+            return false;
+
+        return RunStage("build-iso", [&]()
+        {
+            const TString IsoPath = FileUtil::MakeAbsolute(Option("out"));
+
+            if (!NeedsDiscMerge)
+                return pProj->BuildISO(IsoPath, &mProgress);
+            else
+                return pProj->MergeISO(IsoPath, (nod::DiscWii*) pBaseDisc.get(), &mProgress);
+        });
+    }
+
+    bool ValidateCooker(uint32 NumJobs)
+    {
+        std::vector<EResourceType> Types;
+
+        if (HasOption("type"))
+        {
+            const EResourceType Type = TEnumReflection<EResourceType>::ConvertStringToValue(*Option("type"));
+
+            if (Type == EResourceType::Invalid)
+            {
+                EmitJson("\"event\":\"error\",\"text\":" + JsonString("Unrecognized resource type: " + Option("type")));
+                return false;
+            }
+
+            Types.push_back(Type);
+        }
+        else
+        {
+            // Every type that CResourceCooker can cook
+            Types = {
+                EResourceType::Area,
+                EResourceType::Model,
+                EResourceType::Scan,
+                EResourceType::StaticGeometryMap,
+                EResourceType::StringTable,
+                EResourceType::Tweaks,
+                EResourceType::World
+            };
+        }
+
+        NCoreTests::SValidateCookerOptions Options;
+        Options.DumpFileContents = HasOption("allowdump");
+        Options.NumJobs = NumJobs;
+        Options.Resume = HasOption("resume");
+
+        if (HasOption("shard") && sscanf(*Option("shard"), "%u/%u", &Options.ShardIndex, &Options.NumShards) != 2)
+        {
+            EmitJson("\"event\":\"error\",\"text\":" + JsonString("--shard must look like <Index>/<Count>"));
+            return false;
+        }
+
+        // Each type gets its own report, named after the one on the commandline
+        const std::string ReportPath = *Option("report");
+        const size_t ExtensionStart = ReportPath.find_last_of('.');
+        const size_t NameEnd = (ExtensionStart == std::string::npos || ExtensionStart < ReportPath.find_last_of("/\\") + 1 ? ReportPath.size() : ExtensionStart);
+        bool Success = true;
+
+        for (EResourceType Type : Types)
+        {
+            const char *pkTypeName = TEnumReflection<EResourceType>::ConvertValueToString(Type);
+
+            if (!ReportPath.empty())
+                Options.ReportPath = (ReportPath.substr(0, NameEnd) + "_" + pkTypeName + ReportPath.substr(NameEnd)).c_str();
+
+            Success &= RunStage(TString("validate-cooker:") + pkTypeName, [Type, &Options]() { return NCoreTests::ValidateCooker(Type, Options); });
+        }
+
+        return Success;
+    }
+};
+
+int main(int argc, char *argv[])
+{
+    CBatchDriver Driver;
+    return Driver.Main(argc, argv);
+}
@@ -0,0 +1,166 @@
+#include "BVHUtil.h"
+#include <array>
+#include <cfloat>
+
+namespace BVHUtil
+{
+    constexpr uint32 gkNumBins = 12;
+
+    struct SBin
+    {
+        CAABox Bounds = CAABox::Infinite();
+        uint32 Count = 0;
+    };
+
+    struct SBuildContext
+    {
+        const std::vector<CAABox>& rkPrimBounds;
+        std::vector<CVector3f> PrimCenters;
+        std::vector<uint32>& rOrder;
+        std::vector<SBuildNode>& rNodes;
+        uint32 MaxLeafPrimitives;
+    };
+
+    float SurfaceArea(const CAABox& rkBox)
+    {
+        const CVector3f Size = rkBox.Size();
+        return 2.f * (Size.X * Size.Y + Size.Y * Size.Z + Size.Z * Size.X);
+    }
+
+    uint32 BuildNode(SBuildContext& rContext, uint32 Begin, uint32 End, uint32 Depth)
+    {
+        std::vector<uint32>& rOrder = rContext.rOrder;
+        const uint32 NodeIdx = static_cast<uint32>(rContext.rNodes.size());
+        rContext.rNodes.emplace_back();
+
+        CAABox Bounds = CAABox::Infinite();
+        CAABox CenterBounds = CAABox::Infinite();
+
+        for (uint32 OrderIdx = Begin; OrderIdx < End; OrderIdx++)
+        {
+            Bounds.ExpandBounds(rContext.rkPrimBounds[rOrder[OrderIdx]]);
+            CenterBounds.ExpandBounds(rContext.PrimCenters[rOrder[OrderIdx]]);
+        }
+
+        rContext.rNodes[NodeIdx].Bounds = Bounds;
+
+        const uint32 NumPrims = End - Begin;
+        uint32 Mid = Begin;
+
+        if (NumPrims > rContext.MaxLeafPrimitives && Depth < gkMaxDepth)
+        {
+            // Split along the axis where the primitive centers are most spread out
+            const CVector3f CenterExtent = CenterBounds.Size();
+            uint32 Axis = 0;
+
+            if (CenterExtent.Y > CenterExtent[Axis]) Axis = 1;
+            if (CenterExtent.Z > CenterExtent[Axis]) Axis = 2;
+
+            const float AxisMin = CenterBounds.Min()[Axis];
+            const float AxisExtent = CenterExtent[Axis];
+
+            if (AxisExtent > 0.f)
+            {
+                // Bin the primitives by their centers, then pick the bin boundary with the lowest cost
+                const float BinScale = gkNumBins / AxisExtent;
+                const auto BinIndex = [&](uint32 PrimIdx) {
+                    return std::min(gkNumBins - 1, static_cast<uint32>((rContext.PrimCenters[PrimIdx][Axis] - AxisMin) * BinScale));
+                };
+
+                std::array<SBin, gkNumBins> Bins;
+
+                for (uint32 OrderIdx = Begin; OrderIdx < End; OrderIdx++)
+                {
+                    SBin& rBin = Bins[BinIndex(rOrder[OrderIdx])];
+                    rBin.Bounds.ExpandBounds(rContext.rkPrimBounds[rOrder[OrderIdx]]);
+                    rBin.Count++;
+                }
+
+                std::array<float, gkNumBins - 1> RightCosts;
+                CAABox SideBounds = CAABox::Infinite();
+                uint32 SideCount = 0;
+
+                for (uint32 Split = gkNumBins - 1; Split > 0; Split--)
+                {
+                    SideBounds.ExpandBounds(Bins[Split].Bounds);
+                    SideCount += Bins[Split].Count;
+                    RightCosts[Split - 1] = (SideCount > 0 ? SurfaceArea(SideBounds) * SideCount : 0.f);
+                }
+
+                float BestCost = FLT_MAX;
+                uint32 BestSplit = 0;
+                SideBounds = CAABox::Infinite();
+                SideCount = 0;
+
+                for (uint32 Split = 0; Split < gkNumBins - 1; Split++)
+                {
+                    SideBounds.ExpandBounds(Bins[Split].Bounds);
+                    SideCount += Bins[Split].Count;
+
+                    if (SideCount == 0 || SideCount == NumPrims)
+                        continue;
+
+                    const float Cost = (SurfaceArea(SideBounds) * SideCount) + RightCosts[Split];
+
+                    if (Cost < BestCost)
+                    {
+                        BestCost = Cost;
+                        BestSplit = Split + 1;
+                    }
+                }
+
+                if (BestSplit != 0)
+                {
+                    const auto MidIter = std::partition(rOrder.begin() + Begin, rOrder.begin() + End, [&](uint32 PrimIdx) {
+                        return BinIndex(PrimIdx) < BestSplit;
+                    });
+                    Mid = static_cast<uint32>(MidIter - rOrder.begin());
+                }
+            }
+
+            // Every primitive is centered at the same spot, so just split them in half to keep leaves small
+            if (Mid == Begin || Mid == End)
+                Mid = Begin + (NumPrims / 2);
+        }
+
+        if (Mid == Begin)
+        {
+            rContext.rNodes[NodeIdx].Index = Begin;
+            rContext.rNodes[NodeIdx].NumPrimitives = NumPrims;
+            return NodeIdx;
+        }
+
+        // The left child is always placed right after its parent
+        BuildNode(rContext, Begin, Mid, Depth + 1);
+        const uint32 RightIdx = BuildNode(rContext, Mid, End, Depth + 1);
+
+        rContext.rNodes[NodeIdx].Index = RightIdx;
+        rContext.rNodes[NodeIdx].NumPrimitives = 0;
+        return NodeIdx;
+    }
+
+    std::vector<SBuildNode> Build(const std::vector<CAABox>& rkPrimBounds, std::vector<uint32>& rOutOrder, uint32 MaxLeafPrimitives)
+    {
+        std::vector<SBuildNode> Nodes;
+        const uint32 NumPrims = static_cast<uint32>(rkPrimBounds.size());
+        rOutOrder.resize(NumPrims);
+
+        if (NumPrims == 0)
+            return Nodes;
+
+        SBuildContext Context{rkPrimBounds, {}, rOutOrder, Nodes, std::max(MaxLeafPrimitives, 1u)};
+        Context.PrimCenters.reserve(NumPrims);
+
+        for (uint32 PrimIdx = 0; PrimIdx < NumPrims; PrimIdx++)
+        {
+            Context.PrimCenters.push_back(rkPrimBounds[PrimIdx].Center());
+            rOutOrder[PrimIdx] = PrimIdx;
+        }
+
+        // A binary tree with n leaves never has more than 2n-1 nodes
+        Nodes.reserve((NumPrims * 2) - 1);
+        BuildNode(Context, 0, NumPrims, 0);
+        Nodes.shrink_to_fit();
+        return Nodes;
+    }
+}
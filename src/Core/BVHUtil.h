@@ -0,0 +1,57 @@
+#ifndef BVHUTIL_H
+#define BVHUTIL_H
+
+#include <Common/BasicTypes.h>
+#include <Common/Math/CAABox.h>
+#include <Common/Math/CVector3f.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+/** Helpers shared by the bounding volume hierarchies used for ray queries */
+namespace BVHUtil
+{
+    /** Maximum depth of a built tree. Traversal code can size its stack off this. */
+    constexpr uint32 gkMaxDepth = 64;
+
+    /** A node of a built tree. Nodes are in depth-first order, so a branch's left child always
+     *  immediately follows it and only the index of the right child needs to be stored. */
+    struct SBuildNode
+    {
+        CAABox Bounds;
+        uint32 Index;          // Branch: index of the right child. Leaf: index of the first primitive in the build order
+        uint32 NumPrimitives;  // Zero for branches
+    };
+
+    /** Builds a tree over primitives with the given bounds using a binned surface area heuristic.
+     *  rOutOrder receives the primitive indices in the order the leaves reference them. */
+    std::vector<SBuildNode> Build(const std::vector<CAABox>& rkPrimBounds, std::vector<uint32>& rOutOrder, uint32 MaxLeafPrimitives = 4);
+
+    /** Reciprocal of a ray direction component that stays finite, so slab tests don't produce NaNs */
+    inline float SafeInverse(float Value)
+    {
+        constexpr float kEpsilon = 1e-20f;
+        return 1.f / (std::abs(Value) > kEpsilon ? Value : std::copysign(kEpsilon, Value));
+    }
+
+    /** Slab test of a ray against a box, using a precomputed inverse direction.
+     *  Passes if the ray enters the box no further than MaxDistance along the ray. */
+    inline bool RayIntersectsBox(const CVector3f& rkMin, const CVector3f& rkMax, const CVector3f& rkOrigin,
+                                 const CVector3f& rkInvDir, float MaxDistance, float& rOutDistance)
+    {
+        const float X0 = (rkMin.X - rkOrigin.X) * rkInvDir.X;
+        const float X1 = (rkMax.X - rkOrigin.X) * rkInvDir.X;
+        const float Y0 = (rkMin.Y - rkOrigin.Y) * rkInvDir.Y;
+        const float Y1 = (rkMax.Y - rkOrigin.Y) * rkInvDir.Y;
+        const float Z0 = (rkMin.Z - rkOrigin.Z) * rkInvDir.Z;
+        const float Z1 = (rkMax.Z - rkOrigin.Z) * rkInvDir.Z;
+
+        const float Near = std::max(std::max(std::min(X0, X1), std::min(Y0, Y1)), std::max(std::min(Z0, Z1), 0.f));
+        const float Far = std::min(std::min(std::max(X0, X1), std::max(Y0, Y1)), std::max(Z0, Z1));
+
+        rOutDistance = Near;
+        return Near <= Far && Near <= MaxDistance;
+    }
+}
+
+#endif // BVHUTIL_H
@@ -0,0 +1,89 @@
+#include "CThreadPool.h"
+
+CThreadPool::CThreadPool(uint32 NumThreads)
+{
+    if (NumThreads == 0)
+        NumThreads = DefaultNumThreads();
+
+    mThreads.reserve(NumThreads);
+
+    for (uint32 ThreadIdx = 0; ThreadIdx < NumThreads; ThreadIdx++)
+        mThreads.emplace_back(&CThreadPool::WorkerMain, this);
+}
+
+CThreadPool::~CThreadPool()
+{
+    {
+        std::lock_guard Lock(mMutex);
+        mShuttingDown = true;
+    }
+    mTaskAvailable.notify_all();
+
+    for (auto& Thread : mThreads)
+        Thread.join();
+}
+
+void CThreadPool::AddTask(std::function<void()> Task)
+{
+    {
+        std::lock_guard Lock(mMutex);
+        mTasks.push_back(std::move(Task));
+        mNumUnfinishedTasks++;
+    }
+    mTaskAvailable.notify_one();
+}
+
+void CThreadPool::WaitForTasks()
+{
+    std::unique_lock Lock(mMutex);
+    mTasksFinished.wait(Lock, [this]() { return mNumUnfinishedTasks == 0; });
+}
+
+uint32 CThreadPool::DefaultNumThreads()
+{
+    const uint32 NumCores = std::thread::hardware_concurrency();
+    return NumCores > 0 ? NumCores : 1;
+}
+
+// Read when the shared pool is first created; 0 uses every core
+static std::atomic<uint32> gSharedNumThreads{0};
+
+CThreadPool* CThreadPool::Shared()
+{
+    static CThreadPool sSharedPool(gSharedNumThreads.load());
+    return &sSharedPool;
+}
+
+void CThreadPool::SetSharedNumThreads(uint32 NumThreads)
+{
+    gSharedNumThreads = NumThreads;
+}
+
+void CThreadPool::WorkerMain()
+{
+    while (true)
+    {
+        std::function<void()> Task;
+
+        {
+            std::unique_lock Lock(mMutex);
+            mTaskAvailable.wait(Lock, [this]() { return mShuttingDown || !mTasks.empty(); });
+
+            if (mTasks.empty())
+                return;
+
+            Task = std::move(mTasks.front());
+            mTasks.pop_front();
+        }
+
+        Task();
+
+        {
+            std::lock_guard Lock(mMutex);
+            mNumUnfinishedTasks--;
+
+            if (mNumUnfinishedTasks == 0)
+                mTasksFinished.notify_all();
+        }
+    }
+}
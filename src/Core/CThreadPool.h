@@ -0,0 +1,118 @@
+#ifndef CTHREADPOOL_H
+#define CTHREADPOOL_H
+
+#include <Common/BasicTypes.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/**
+ * Fixed-size pool of worker threads for CPU-bound jobs such as decompression and cooking.
+ * Tasks must not touch the resource store or any other shared editor state unless the
+ * caller has made that state safe to access; the pool only provides scheduling.
+ */
+class CThreadPool
+{
+    std::vector<std::thread> mThreads;
+    std::deque<std::function<void()>> mTasks;
+    std::mutex mMutex;
+    std::condition_variable mTaskAvailable;
+    std::condition_variable mTasksFinished;
+    uint32 mNumUnfinishedTasks = 0;
+    bool mShuttingDown = false;
+
+public:
+    explicit CThreadPool(uint32 NumThreads = 0);
+    ~CThreadPool();
+
+    CThreadPool(const CThreadPool&) = delete;
+    CThreadPool& operator=(const CThreadPool&) = delete;
+
+    void AddTask(std::function<void()> Task);
+    void WaitForTasks();
+
+    template<typename FuncType>
+    auto Submit(FuncType&& Func) -> std::future<std::invoke_result_t<std::decay_t<FuncType>>>
+    {
+        using ReturnType = std::invoke_result_t<std::decay_t<FuncType>>;
+        auto pTask = std::make_shared<std::packaged_task<ReturnType()>>(std::forward<FuncType>(Func));
+        std::future<ReturnType> Future = pTask->get_future();
+        AddTask([pTask]() { (*pTask)(); });
+        return Future;
+    }
+
+    /** Runs Func(Index) for every index in [0, Count). The calling thread takes part in the work, so this is safe to call from a pool task. */
+    template<typename FuncType>
+    void ParallelFor(size_t Count, FuncType&& Func)
+    {
+        if (Count == 0)
+            return;
+
+        if (Count == 1 || mThreads.empty())
+        {
+            for (size_t Idx = 0; Idx < Count; Idx++)
+                Func(Idx);
+
+            return;
+        }
+
+        // Shared state is reference counted because helper tasks that are scheduled too late
+        // to claim any work may still run after this function has returned.
+        struct SSharedState
+        {
+            std::atomic<size_t> NextIndex{0};
+            std::atomic<size_t> NumFinished{0};
+            std::mutex Mutex;
+            std::condition_variable Finished;
+        };
+        auto pState = std::make_shared<SSharedState>();
+        auto* pFunc = &Func;
+
+        auto RunJobs = [pState, pFunc, Count]()
+        {
+            size_t Idx;
+
+            while ((Idx = pState->NextIndex.fetch_add(1)) < Count)
+            {
+                (*pFunc)(Idx);
+
+                if (pState->NumFinished.fetch_add(1) + 1 == Count)
+                {
+                    std::lock_guard Lock(pState->Mutex);
+                    pState->Finished.notify_all();
+                }
+            }
+        };
+
+        const size_t NumHelpers = std::min<size_t>(mThreads.size(), Count - 1);
+
+        for (size_t HelperIdx = 0; HelperIdx < NumHelpers; HelperIdx++)
+            AddTask(RunJobs);
+
+        RunJobs();
+
+        std::unique_lock Lock(pState->Mutex);
+        pState->Finished.wait(Lock, [&]() { return pState->NumFinished.load() == Count; });
+    }
+
+    uint32 NumThreads() const { return static_cast<uint32>(mThreads.size()); }
+
+    static uint32 DefaultNumThreads();
+    static CThreadPool* Shared();
+
+    /** Sets the number of threads in the shared pool. Has no effect once the shared pool has been created. */
+    static void SetSharedNumThreads(uint32 NumThreads);
+
+private:
+    void WorkerMain();
+};
+
+#endif // CTHREADPOOL_H
@@ -1,5 +1,7 @@
 #include "CompressionUtil.h"
+#include "CThreadPool.h"
 #include <Common/Common.h>
+#include <algorithm>
 
 #if USE_LZOKAY
 #include <lzokay.hpp>
@@ -184,26 +186,93 @@ namespace CompressionUtil
         return ((pSrc == pSrcEnd) && (pDst == pDstEnd));
     }
 
+    bool DecompressBlocks(const std::vector<SDecompressBlock>& rkBlocks)
+    {
+        // Blocks are independent and write to separate parts of the output, so they can be decompressed in any order.
+        // Each one has to fill its destination exactly, or the output is incomplete.
+        std::vector<uint8> Results(rkBlocks.size(), 0);
+
+        CThreadPool::Shared()->ParallelFor(rkBlocks.size(), [&rkBlocks, &Results](size_t BlockIdx)
+        {
+            const SDecompressBlock& rkBlock = rkBlocks[BlockIdx];
+
+            if (rkBlock.Segmented)
+            {
+                Results[BlockIdx] = DecompressSegmentedData(rkBlock.pSrc, rkBlock.SrcLen, rkBlock.pDst, rkBlock.DstLen);
+            }
+            else
+            {
+                uint32 TotalOut = 0;
+                Results[BlockIdx] = DecompressZlib(rkBlock.pSrc, rkBlock.SrcLen, rkBlock.pDst, rkBlock.DstLen, TotalOut) && TotalOut == rkBlock.DstLen;
+            }
+        });
+
+        const auto Failed = std::find(Results.cbegin(), Results.cend(), 0);
+
+        if (Failed != Results.cend())
+        {
+            errorf("Failed to decompress block %d of %d", static_cast<int>(Failed - Results.cbegin()), static_cast<int>(Results.size()));
+            return false;
+        }
+
+        return true;
+    }
+
     // ************ COMPRESS ************
-    bool CompressZlib(uint8 *pSrc, uint32 SrcLen, uint8 *pDst, uint32 DstLen, uint32& rTotalOut)
+    constexpr uint32 gkSegmentSize = 0x4000;
+
+    struct CCompressionContext::SImpl
     {
-        z_stream z;
-        z.zalloc = Z_NULL;
-        z.zfree = Z_NULL;
-        z.opaque = Z_NULL;
-        z.avail_in = SrcLen;
-        z.next_in = pSrc;
-        z.avail_out = DstLen;
-        z.next_out = pDst;
+        z_stream ZStream{};
+        bool ZStreamInitialized = false;
+
+#if USE_LZOKAY
+        lzokay::Dict<> Dict;
+#else
+        std::vector<uint8> WorkMem;
+#endif
+    };
+
+    CCompressionContext::CCompressionContext()
+        : mpImpl(std::make_unique<SImpl>())
+    {
+    }
+
+    CCompressionContext::~CCompressionContext()
+    {
+        if (mpImpl->ZStreamInitialized)
+            deflateEnd(&mpImpl->ZStream);
+    }
 
-        int32 Error = deflateInit(&z, 9);
+    bool CCompressionContext::CompressZlib(uint8 *pSrc, uint32 SrcLen, uint8 *pDst, uint32 DstLen, uint32& rTotalOut)
+    {
+        // Resetting the stream gives the same output as initializing a new one, without reallocating its state
+        z_stream& z = mpImpl->ZStream;
+        int32 Error = Z_OK;
+
+        if (mpImpl->ZStreamInitialized)
+        {
+            Error = deflateReset(&z);
+        }
+        else
+        {
+            z.zalloc = Z_NULL;
+            z.zfree = Z_NULL;
+            z.opaque = Z_NULL;
+            Error = deflateInit(&z, 9);
+            mpImpl->ZStreamInitialized = (Error == Z_OK);
+        }
 
         if (!Error)
         {
-            Error = deflate(&z, Z_FINISH);
+            z.avail_in = SrcLen;
+            z.next_in = pSrc;
+            z.avail_out = DstLen;
+            z.next_out = pDst;
 
-            if (!Error || Error == Z_STREAM_END)
-                Error = deflateEnd(&z);
+            // Anything other than Z_STREAM_END means the output buffer was too small
+            Error = deflate(&z, Z_FINISH);
+            if (Error == Z_OK) Error = Z_BUF_ERROR;
 
             rTotalOut = z.total_out;
         }
@@ -217,11 +286,11 @@ namespace CompressionUtil
         else return true;
     }
 
-    bool CompressLZO(uint8 *pSrc, uint32 SrcLen, uint8 *pDst, uint32 DstLen, uint32& rTotalOut)
+    bool CCompressionContext::CompressLZO(uint8 *pSrc, uint32 SrcLen, uint8 *pDst, uint32 DstLen, uint32& rTotalOut)
     {
 #if USE_LZOKAY
         size_t TotalOut;
-        lzokay::EResult Result = lzokay::compress(pSrc, (size_t) SrcLen, pDst, DstLen, TotalOut);
+        lzokay::EResult Result = lzokay::compress(pSrc, (size_t) SrcLen, pDst, DstLen, TotalOut, mpImpl->Dict);
         rTotalOut = TotalOut;
 
         if (Result < lzokay::EResult::Success)
@@ -234,9 +303,12 @@ namespace CompressionUtil
 #else
         lzo_init();
 
-        uint8 *pWorkMem = new uint8[LZO1X_999_MEM_COMPRESS];
-        int32 Error = lzo1x_999_compress(pSrc, SrcLen, pDst, (lzo_uint*) &rTotalOut, pWorkMem);
-        delete[] pWorkMem;
+        if (mpImpl->WorkMem.empty())
+            mpImpl->WorkMem.resize(LZO1X_999_MEM_COMPRESS);
+
+        lzo_uint TotalOut;
+        int32 Error = lzo1x_999_compress(pSrc, SrcLen, pDst, &TotalOut, mpImpl->WorkMem.data());
+        rTotalOut = (uint32) TotalOut;
 
         if (Error)
         {
@@ -248,27 +320,82 @@ namespace CompressionUtil
 #endif
     }
 
-    bool CompressSegmentedData(uint8 *pSrc, uint32 SrcLen, uint8 *pDst, uint32& rTotalOut, bool IsZlib, bool AllowUncompressedSegments)
+    CCompressionContext& CCompressionContext::ThreadLocal()
     {
-        uint8 *pSrcEnd = pSrc + SrcLen;
-        uint8 *pDstStart = pDst;
+        static thread_local CCompressionContext sContext;
+        return sContext;
+    }
 
-        while (pSrc < pSrcEnd)
-        {
-            // Each segment is compressed separately. Segment size should always be 0x4000 unless there's less than 0x4000 bytes left.
-            uint16 Size;
-            uint32 Remaining = (uint32) (pSrcEnd - pSrc);
+    uint32 MaxCompressedSize(uint32 SrcLen, bool IsZlib)
+    {
+        // Worst case for LZO1X is documented as 1/16 expansion plus a small constant
+        if (IsZlib)
+            return (uint32) compressBound(SrcLen);
+        else
+            return SrcLen + (SrcLen / 16) + 64 + 3;
+    }
 
-            if (Remaining < 0x4000) Size = (uint16) Remaining;
-            else Size = 0x4000;
+    uint32 MaxSegmentedCompressedSize(uint32 SrcLen, bool IsZlib)
+    {
+        // Every segment has a 2-byte size header
+        const uint32 NumFullSegments = SrcLen / gkSegmentSize;
+        const uint32 Remainder = SrcLen % gkSegmentSize;
+        uint32 Size = NumFullSegments * (2 + MaxCompressedSize(gkSegmentSize, IsZlib));
 
-            std::vector<uint8> Compressed(Size * 2);
-            uint32 TotalOut;
+        if (Remainder > 0)
+            Size += 2 + MaxCompressedSize(Remainder, IsZlib);
+
+        return Size;
+    }
+
+    bool CompressZlib(uint8 *pSrc, uint32 SrcLen, uint8 *pDst, uint32 DstLen, uint32& rTotalOut)
+    {
+        return CCompressionContext::ThreadLocal().CompressZlib(pSrc, SrcLen, pDst, DstLen, rTotalOut);
+    }
+
+    bool CompressLZO(uint8 *pSrc, uint32 SrcLen, uint8 *pDst, uint32 DstLen, uint32& rTotalOut)
+    {
+        return CCompressionContext::ThreadLocal().CompressLZO(pSrc, SrcLen, pDst, DstLen, rTotalOut);
+    }
+
+    bool CompressSegmentedData(uint8 *pSrc, uint32 SrcLen, uint8 *pDst, uint32& rTotalOut, bool IsZlib, bool AllowUncompressedSegments)
+    {
+        // Each segment is compressed separately. Segment size should always be 0x4000 unless there's less than 0x4000 bytes left.
+        // Segments don't depend on each other, so they're compressed in parallel into their own slots of a scratch buffer,
+        // then written out in order. The output is the same as compressing them one at a time.
+        const uint32 NumSegments = (SrcLen + gkSegmentSize - 1) / gkSegmentSize;
+        const uint32 SegmentBound = MaxCompressedSize(gkSegmentSize, IsZlib);
+        std::vector<uint8> Compressed(static_cast<size_t>(NumSegments) * SegmentBound);
+        std::vector<uint32> CompressedSizes(NumSegments, 0);
+        std::vector<uint8> Results(NumSegments, 0);
+
+        const auto CompressSegment = [&](size_t SegmentIdx)
+        {
+            const uint32 Offset = static_cast<uint32>(SegmentIdx) * gkSegmentSize;
+            const uint32 Size = std::min(SrcLen - Offset, gkSegmentSize);
+            uint8 *pOut = Compressed.data() + SegmentIdx * SegmentBound;
+            CCompressionContext& rContext = CCompressionContext::ThreadLocal();
 
             if (IsZlib)
-                CompressZlib(pSrc, Size, Compressed.data(), Compressed.size(), TotalOut);
+                Results[SegmentIdx] = rContext.CompressZlib(pSrc + Offset, Size, pOut, SegmentBound, CompressedSizes[SegmentIdx]);
             else
-                CompressLZO(pSrc, Size, Compressed.data(), Compressed.size(), TotalOut);
+                Results[SegmentIdx] = rContext.CompressLZO(pSrc + Offset, Size, pOut, SegmentBound, CompressedSizes[SegmentIdx]);
+        };
+
+        if (NumSegments > 1)
+            CThreadPool::Shared()->ParallelFor(NumSegments, CompressSegment);
+        else if (NumSegments == 1)
+            CompressSegment(0);
+
+        if (std::find(Results.cbegin(), Results.cend(), 0) != Results.cend())
+            return false;
+
+        uint8 *pDstStart = pDst;
+
+        for (uint32 SegmentIdx = 0; SegmentIdx < NumSegments; SegmentIdx++)
+        {
+            const uint16 Size = (uint16) std::min(SrcLen - SegmentIdx * gkSegmentSize, gkSegmentSize);
+            uint32 TotalOut = CompressedSizes[SegmentIdx];
 
             // Verify that the compressed data is actually smaller.
             if (AllowUncompressedSegments && TotalOut >= Size)
@@ -288,7 +415,7 @@ namespace CompressionUtil
                 // Write new compressed size + data to destination
                 *pDst++ = (TotalOut >> 8) & 0xFF;
                 *pDst++ = (TotalOut & 0xFF);
-                memcpy(pDst, Compressed.data(), TotalOut);
+                memcpy(pDst, Compressed.data() + SegmentIdx * SegmentBound, TotalOut);
             }
 
             pSrc += Size;
@@ -4,17 +4,49 @@
 #include <Common/BasicTypes.h>
 #include <Common/FileIO.h>
 #include <Common/TString.h>
+#include <memory>
+#include <vector>
 
 namespace CompressionUtil
 {
+    // A compressed block with a known decompressed size and destination, for decompressing several blocks at once
+    struct SDecompressBlock
+    {
+        uint8 *pSrc;
+        uint32 SrcLen;
+        uint8 *pDst;
+        uint32 DstLen;
+        bool Segmented; // Otherwise a single zlib stream
+    };
+
     // Decompression
     bool DecompressZlib(uint8 *pSrc, uint32 SrcLen, uint8 *pDst, uint32 DstLen, uint32& rTotalOut);
     bool DecompressLZO(uint8 *pSrc, uint32 SrcLen, uint8 *pDst, uint32& rTotalOut);
     bool DecompressSegmentedData(uint8 *pSrc, uint32 SrcLen, uint8 *pDst, uint32 DstLen);
+    bool DecompressBlocks(const std::vector<SDecompressBlock>& rkBlocks);
+
+    // Holds the zlib stream and LZO dictionary used for compression, so they aren't set up again on every call.
+    // A context can only be used by one thread at a time; ThreadLocal() returns one for the calling thread.
+    class CCompressionContext
+    {
+        struct SImpl;
+        std::unique_ptr<SImpl> mpImpl;
+
+    public:
+        CCompressionContext();
+        ~CCompressionContext();
+
+        bool CompressZlib(uint8 *pSrc, uint32 SrcLen, uint8 *pDst, uint32 DstLen, uint32& rTotalOut);
+        bool CompressLZO(uint8 *pSrc, uint32 SrcLen, uint8 *pDst, uint32 DstLen, uint32& rTotalOut);
+
+        static CCompressionContext& ThreadLocal();
+    };
 
     // Compression
+    uint32 MaxCompressedSize(uint32 SrcLen, bool IsZlib);
+    uint32 MaxSegmentedCompressedSize(uint32 SrcLen, bool IsZlib);
     bool CompressZlib(uint8 *pSrc, uint32 SrcLen, uint8 *pDst, uint32 DstLen, uint32& rTotalOut);
-    bool CompressLZO(uint8 *pSrc, uint32 SrcLen, uint8 *pDst, uint32& rTotalOut);
+    bool CompressLZO(uint8 *pSrc, uint32 SrcLen, uint8 *pDst, uint32 DstLen, uint32& rTotalOut);
     bool CompressSegmentedData(uint8 *pSrc, uint32 SrcLen, uint8 *pDst, uint32& rTotalOut, bool IsZlib, bool AllowUncompressedSegments);
     bool CompressZlibSegmented(uint8 *pSrc, uint32 SrcLen, uint8 *pDst, uint32& rTotalOut, bool AllowUncompressedSegments);
     bool CompressLZOSegmented(uint8 *pSrc, uint32 SrcLen, uint8 *pDst, uint32& rTotalOut, bool AllowUncompressedSegments);
@@ -1,6 +1,7 @@
 #include "AssetNameGeneration.h"
 #include "CGameProject.h"
 #include "CResourceIterator.h"
+#include "CResourceMetadataStore.h"
 #include "Core/Resource/CAudioMacro.h"
 #include "Core/Resource/CFont.h"
 #include "Core/Resource/CWorld.h"
@@ -88,6 +89,7 @@ void GenerateAssetNames(CGameProject *pProj)
 {
     debugf("*** Generating Asset Names ***");
     CResourceStore *pStore = pProj->ResourceStore();
+    pStore->MetadataStore()->BeginBatch();
 
 #if REVERT_AUTO_NAMES
     // Revert all auto-generated asset names back to default to prevent name conflicts resulting in inconsistent results.
@@ -662,6 +664,7 @@ void GenerateAssetNames(CGameProject *pProj)
 #endif
 
     pStore->RootDirectory()->DeleteEmptySubdirectories();
+    pStore->MetadataStore()->EndBatch();
     pStore->ConditionalSaveStore();
     debugf("*** Asset Name Generation FINISHED ***");
 }
@@ -0,0 +1,445 @@
+#include "CCompressionCache.h"
+#include <Common/CFourCC.h>
+#include <Common/FileIO.h>
+#include <Common/FileUtil.h>
+#include <Common/Log.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+
+// SHA-256 of the given data. Entries are verified against this instead of a copy of the data they were made from.
+std::array<uint8, 32> SHA256(const uint8 *pkData, uint64 Size)
+{
+    static constexpr uint32 skRoundConstants[64] = {
+        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+        0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+        0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+        0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+        0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+        0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+        0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+        0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+    };
+
+    uint32 State[8] = { 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 };
+
+    const auto RotR = [](uint32 Value, uint32 Bits) { return (Value >> Bits) | (Value << (32 - Bits)); };
+
+    const auto ProcessBlock = [&](const uint8 *pkBlock)
+    {
+        uint32 W[64];
+
+        for (uint32 Idx = 0; Idx < 16; Idx++)
+        {
+            W[Idx] = (static_cast<uint32>(pkBlock[Idx * 4 + 0]) << 24) | (static_cast<uint32>(pkBlock[Idx * 4 + 1]) << 16) |
+                     (static_cast<uint32>(pkBlock[Idx * 4 + 2]) << 8)  |  static_cast<uint32>(pkBlock[Idx * 4 + 3]);
+        }
+
+        for (uint32 Idx = 16; Idx < 64; Idx++)
+        {
+            const uint32 S0 = RotR(W[Idx - 15], 7) ^ RotR(W[Idx - 15], 18) ^ (W[Idx - 15] >> 3);
+            const uint32 S1 = RotR(W[Idx - 2], 17) ^ RotR(W[Idx - 2], 19) ^ (W[Idx - 2] >> 10);
+            W[Idx] = W[Idx - 16] + S0 + W[Idx - 7] + S1;
+        }
+
+        uint32 A = State[0], B = State[1], C = State[2], D = State[3];
+        uint32 E = State[4], F = State[5], G = State[6], H = State[7];
+
+        for (uint32 Idx = 0; Idx < 64; Idx++)
+        {
+            const uint32 T1 = H + (RotR(E, 6) ^ RotR(E, 11) ^ RotR(E, 25)) + ((E & F) ^ (~E & G)) + skRoundConstants[Idx] + W[Idx];
+            const uint32 T2 = (RotR(A, 2) ^ RotR(A, 13) ^ RotR(A, 22)) + ((A & B) ^ (A & C) ^ (B & C));
+            H = G; G = F; F = E; E = D + T1;
+            D = C; C = B; B = A; A = T1 + T2;
+        }
+
+        State[0] += A; State[1] += B; State[2] += C; State[3] += D;
+        State[4] += E; State[5] += F; State[6] += G; State[7] += H;
+    };
+
+    uint64 Offset = 0;
+
+    for (; Offset + 64 <= Size; Offset += 64)
+        ProcessBlock(pkData + Offset);
+
+    // Pad the last block with a 1 bit, zeroes and the big endian bit length
+    uint8 Tail[128] = {};
+    const uint64 Remaining = Size - Offset;
+    const uint64 TailSize = (Remaining < 56 ? 64 : 128);
+    const uint64 BitLength = Size * 8;
+
+    if (Remaining > 0)
+        std::memcpy(Tail, pkData + Offset, Remaining);
+
+    Tail[Remaining] = 0x80;
+
+    for (uint32 ByteIdx = 0; ByteIdx < 8; ByteIdx++)
+        Tail[TailSize - 1 - ByteIdx] = static_cast<uint8>(BitLength >> (ByteIdx * 8));
+
+    for (uint64 BlockOffset = 0; BlockOffset < TailSize; BlockOffset += 64)
+        ProcessBlock(Tail + BlockOffset);
+
+    std::array<uint8, 32> Digest;
+
+    for (uint32 WordIdx = 0; WordIdx < 8; WordIdx++)
+    {
+        Digest[WordIdx * 4 + 0] = static_cast<uint8>(State[WordIdx] >> 24);
+        Digest[WordIdx * 4 + 1] = static_cast<uint8>(State[WordIdx] >> 16);
+        Digest[WordIdx * 4 + 2] = static_cast<uint8>(State[WordIdx] >> 8);
+        Digest[WordIdx * 4 + 3] = static_cast<uint8>(State[WordIdx]);
+    }
+
+    return Digest;
+}
+
+}
+
+CCompressionCache::CCompressionCache(TString CacheDir, uint64 MaxSize)
+    : mCacheDir(std::move(CacheDir))
+    , mMaxSize(MaxSize)
+{
+    FileUtil::MakeDirectory(mCacheDir);
+
+    // An index from another version means the entries are in a format we can't read, so start fresh
+    if (!LoadIndex())
+        Clear();
+    // Otherwise, pick up any entries that were stored after the index was last saved
+    else
+        SyncWithDirectory();
+}
+
+CCompressionCache::~CCompressionCache()
+{
+    SaveIndex();
+}
+
+CCompressionCache::SKey CCompressionCache::MakeKey(const uint8 *pkData, uint32 Size, EGame Game, ECompressionCodec Codec)
+{
+    // The short hash that names the entry is the start of the full digest
+    SKey Key{0, Size, Game, Codec, SHA256(pkData, Size)};
+
+    for (uint32 ByteIdx = 0; ByteIdx < 8; ByteIdx++)
+        Key.ContentHash = (Key.ContentHash << 8) | Key.ContentDigest[ByteIdx];
+
+    return Key;
+}
+
+bool CCompressionCache::Lookup(const SKey& rkKey, std::vector<uint8>& rOutData, bool& rOutCompressed)
+{
+    {
+        std::lock_guard Lock(mMutex);
+        const auto Find = mEntries.find(rkKey);
+
+        if (Find == mEntries.cend())
+        {
+            mNumMisses++;
+            return false;
+        }
+
+        Find->second.LastUsed = ++mUseCounter;
+        mIndexDirty = true;
+    }
+
+    // Read the entry outside the lock. If it was evicted in the meantime, the read fails and we treat it as a miss.
+    CFileInStream File(EntryPath(rkKey), EEndian::BigEndian);
+    bool Valid = File.IsValid();
+    bool Match = false;
+
+    if (Valid)
+    {
+        const uint32 Magic = File.ReadULong();
+        const uint32 Version = File.ReadULong();
+        const uint32 ContentSize = File.ReadULong();
+        std::array<uint8, 32> ContentDigest;
+        File.ReadBytes(ContentDigest.data(), ContentDigest.size());
+        const bool Compressed = File.ReadBool();
+        const uint32 DataSize = File.ReadULong();
+
+        Valid = (Magic == FOURCC('CCEN') && Version == static_cast<uint32>(ECompressionCacheVersion::Current) &&
+                 ContentSize == rkKey.ContentSize && File.Size() - File.Tell() == DataSize);
+
+        if (Valid)
+        {
+            // The key only names the entry by a short hash, so make sure it was made from the same data
+            Match = (ContentDigest == rkKey.ContentDigest);
+
+            if (Match)
+            {
+                rOutData.resize(DataSize);
+                File.ReadBytes(rOutData.data(), DataSize);
+                rOutCompressed = Compressed;
+            }
+        }
+    }
+
+    std::lock_guard Lock(mMutex);
+
+    if (!Valid)
+    {
+        warnf("Discarding invalid compression cache entry: %s", *EntryPath(rkKey));
+        const auto Find = mEntries.find(rkKey);
+
+        if (Find != mEntries.cend())
+        {
+            mTotalSize -= Find->second.FileSize;
+            mEntries.erase(Find);
+        }
+
+        // Otherwise it would come back the next time the cache is loaded
+        FileUtil::DeleteFile(EntryPath(rkKey));
+    }
+    // A hash collision; the entry is still good for the data it was made from, so leave it alone
+    else if (!Match)
+    {
+        warnf("Compression cache entry doesn't match the data being compressed: %s", *EntryPath(rkKey));
+    }
+
+    if (!Match)
+    {
+        mNumMisses++;
+        return false;
+    }
+
+    mNumHits++;
+    return true;
+}
+
+void CCompressionCache::Store(const SKey& rkKey, const std::vector<uint8>& rkData, bool Compressed)
+{
+    // Entries that didn't compress well don't store a payload; the caller already has the uncompressed data
+    const uint32 DataSize = (Compressed ? static_cast<uint32>(rkData.size()) : 0);
+
+    {
+        std::lock_guard Lock(mMutex);
+
+        if (mEntries.find(rkKey) != mEntries.cend() || !mPendingEntries.insert(rkKey).second)
+            return;
+    }
+
+    // Write to a temporary file first, so a crash mid-write can't leave a truncated entry under the real name
+    const TString Path = EntryPath(rkKey);
+    const TString TempPath = Path + ".tmp";
+    uint32 FileSize = 0;
+    {
+        CFileOutStream File(TempPath, EEndian::BigEndian);
+
+        if (File.IsValid())
+        {
+            File.WriteFourCC( FOURCC('CCEN') );
+            File.WriteULong(static_cast<uint32>(ECompressionCacheVersion::Current));
+            File.WriteULong(rkKey.ContentSize);
+            File.WriteBytes(rkKey.ContentDigest.data(), rkKey.ContentDigest.size());
+            File.WriteBool(Compressed);
+            File.WriteULong(DataSize);
+            File.WriteBytes(rkData.data(), DataSize);
+            FileSize = File.Tell();
+        }
+    }
+
+    if (FileSize != 0 && !FileUtil::MoveFile(TempPath, Path))
+    {
+        FileUtil::DeleteFile(TempPath);
+        FileSize = 0;
+    }
+
+    std::lock_guard Lock(mMutex);
+    mPendingEntries.erase(rkKey);
+
+    if (FileSize == 0)
+    {
+        errorf("Failed to write compression cache entry: %s", *Path);
+        return;
+    }
+
+    mEntries.insert_or_assign(rkKey, SEntryInfo{FileSize, ++mUseCounter});
+    mTotalSize += FileSize;
+    mIndexDirty = true;
+
+    // Evict down to a bit under the limit so we aren't evicting on every store once the cache is full
+    if (mTotalSize > mMaxSize)
+        EvictEntries(mMaxSize - mMaxSize / 8);
+}
+
+bool CCompressionCache::SaveIndex()
+{
+    std::lock_guard Lock(mMutex);
+
+    // Enforce the size limit before saving, in case it was lowered since the entries were stored
+    if (mTotalSize > mMaxSize)
+        EvictEntries(mMaxSize - mMaxSize / 8);
+
+    if (!mIndexDirty)
+        return true;
+
+    CFileOutStream Index(IndexPath(), EEndian::BigEndian);
+
+    if (!Index.IsValid())
+    {
+        errorf("Failed to save compression cache index: %s", *IndexPath());
+        return false;
+    }
+
+    Index.WriteFourCC( FOURCC('CCIX') );
+    Index.WriteULong(static_cast<uint32>(ECompressionCacheVersion::Current));
+    Index.WriteULong(static_cast<uint32>(mEntries.size()));
+
+    for (const auto& [Key, Info] : mEntries)
+    {
+        Index.WriteULongLong(Key.ContentHash);
+        Index.WriteULong(Key.ContentSize);
+        Index.WriteULong(static_cast<uint32>(Key.Game));
+        Index.WriteULong(static_cast<uint32>(Key.Codec));
+        Index.WriteULong(Info.FileSize);
+        Index.WriteULongLong(Info.LastUsed);
+    }
+
+    mIndexDirty = false;
+    return true;
+}
+
+void CCompressionCache::Clear()
+{
+    std::lock_guard Lock(mMutex);
+    FileUtil::ClearDirectory(mCacheDir);
+    mEntries.clear();
+    mTotalSize = 0;
+    mUseCounter = 0;
+    mIndexDirty = true;
+}
+
+// ************ PRIVATE ************
+bool CCompressionCache::LoadIndex()
+{
+    // A missing index isn't an error; the entries on disk are picked up by SyncWithDirectory
+    if (!FileUtil::Exists(IndexPath()))
+        return true;
+
+    CFileInStream Index(IndexPath(), EEndian::BigEndian);
+
+    if (!Index.IsValid())
+        return false;
+
+    const uint32 Magic = Index.ReadULong();
+    const uint32 Version = Index.ReadULong();
+
+    if (Magic != FOURCC('CCIX') || Version != static_cast<uint32>(ECompressionCacheVersion::Current))
+        return false;
+
+    const uint32 NumEntries = Index.ReadULong();
+
+    for (uint32 EntryIdx = 0; EntryIdx < NumEntries && !Index.EoF(); EntryIdx++)
+    {
+        SKey Key;
+        Key.ContentHash = Index.ReadULongLong();
+        Key.ContentSize = Index.ReadULong();
+        Key.Game = static_cast<EGame>(Index.ReadULong());
+        Key.Codec = static_cast<ECompressionCodec>(Index.ReadULong());
+
+        SEntryInfo Info;
+        Info.FileSize = Index.ReadULong();
+        Info.LastUsed = Index.ReadULongLong();
+
+        mEntries.insert_or_assign(Key, Info);
+        mTotalSize += Info.FileSize;
+        mUseCounter = std::max(mUseCounter, Info.LastUsed);
+    }
+
+    return mEntries.size() == NumEntries;
+}
+
+void CCompressionCache::SyncWithDirectory()
+{
+    // The entry files are the source of truth. Anything on disk that the index doesn't know about was stored
+    // after the index was last saved; treat it as least recently used. Index entries with no file are dropped.
+    TStringList Files;
+    FileUtil::GetDirectoryContents(mCacheDir, Files);
+
+    std::map<SKey, SEntryInfo> Entries;
+    uint64 TotalSize = 0;
+
+    for (const TString& rkPath : Files)
+    {
+        if (!FileUtil::IsFile(rkPath))
+            continue;
+
+        // Leftover from a store that never finished
+        if (rkPath.EndsWith(".tmp"))
+        {
+            FileUtil::DeleteFile(rkPath);
+            continue;
+        }
+
+        const TString FileName = rkPath.GetFileName();
+        unsigned long long Hash = 0;
+        unsigned int Size = 0;
+        int Game = 0;
+        int Codec = 0;
+
+        if (std::sscanf(*FileName, "%016llX_%08X_%d_%d.bin", &Hash, &Size, &Game, &Codec) != 4)
+            continue;
+
+        const SKey Key{Hash, Size, static_cast<EGame>(Game), static_cast<ECompressionCodec>(Codec)};
+
+        if (EntryPath(Key).GetFileName() != FileName)
+            continue;
+
+        const auto Find = mEntries.find(Key);
+        const uint64 LastUsed = (Find != mEntries.cend() ? Find->second.LastUsed : 0);
+        const uint32 FileSize = static_cast<uint32>(FileUtil::FileSize(rkPath));
+        Entries.insert_or_assign(Key, SEntryInfo{FileSize, LastUsed});
+        TotalSize += FileSize;
+    }
+
+    std::lock_guard Lock(mMutex);
+
+    if (Entries.size() != mEntries.size() || TotalSize != mTotalSize)
+        mIndexDirty = true;
+
+    mEntries = std::move(Entries);
+    mTotalSize = TotalSize;
+
+    if (mTotalSize > mMaxSize)
+        EvictEntries(mMaxSize - mMaxSize / 8);
+}
+
+TString CCompressionCache::IndexPath() const
+{
+    return mCacheDir + "Index.bin";
+}
+
+TString CCompressionCache::EntryPath(const SKey& rkKey) const
+{
+    return mCacheDir + TString::Format("%016llX_%08X_%d_%d.bin",
+                                       static_cast<unsigned long long>(rkKey.ContentHash), rkKey.ContentSize,
+                                       static_cast<int>(rkKey.Game), static_cast<int>(rkKey.Codec));
+}
+
+void CCompressionCache::EvictEntries(uint64 TargetSize)
+{
+    // Called with the mutex held. Evict least recently used entries first.
+    std::vector<std::pair<uint64, SKey>> EntriesByAge;
+    EntriesByAge.reserve(mEntries.size());
+
+    for (const auto& [Key, Info] : mEntries)
+        EntriesByAge.emplace_back(Info.LastUsed, Key);
+
+    std::sort(EntriesByAge.begin(), EntriesByAge.end(), [](const auto& rkLeft, const auto& rkRight) {
+        return rkLeft.first < rkRight.first;
+    });
+
+    for (const auto& [LastUsed, Key] : EntriesByAge)
+    {
+        if (mTotalSize <= TargetSize)
+            break;
+
+        const auto Find = mEntries.find(Key);
+        mTotalSize -= Find->second.FileSize;
+        mEntries.erase(Find);
+        FileUtil::DeleteFile(EntryPath(Key));
+    }
+
+    mIndexDirty = true;
+}
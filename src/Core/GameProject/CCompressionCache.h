@@ -0,0 +1,107 @@
+#ifndef CCOMPRESSIONCACHE_H
+#define CCOMPRESSIONCACHE_H
+
+#include <Common/BasicTypes.h>
+#include <Common/EGame.h>
+#include <Common/TString.h>
+#include <array>
+#include <map>
+#include <mutex>
+#include <set>
+#include <tuple>
+#include <vector>
+
+enum class ECompressionCodec
+{
+    Zlib,
+    LZOSegmented
+};
+
+enum class ECompressionCacheVersion
+{
+    Initial,
+    VerifiedContent,
+    ContentDigest,
+    // Add new versions before this line
+
+    Max,
+    Current = Max - 1
+};
+
+// On-disk cache of compressed asset data used when cooking paks. Entries are keyed by a hash of the
+// cooked asset's contents, so an asset that gets recooked simply misses the cache, and the least
+// recently used entries are evicted whenever the cache grows past its size limit. Each entry also
+// stores the SHA-256 of the uncompressed data it was made from, and a hit is only returned if that
+// matches the caller's data, so a collision in the short key can't put the wrong asset in a pak.
+// The index is only a record of when entries were last used; the entry files themselves are the
+// source of truth, so entries written after the index was last saved are recovered on load.
+// Safe to use from multiple threads.
+class CCompressionCache
+{
+public:
+    struct SKey
+    {
+        uint64 ContentHash;
+        uint32 ContentSize;
+        EGame Game;
+        ECompressionCodec Codec;
+
+        // Full SHA-256 of the content. Only set on keys made by MakeKey, and not part of the ordering.
+        std::array<uint8, 32> ContentDigest{};
+
+        bool operator<(const SKey& rkOther) const
+        {
+            return std::tie(ContentHash, ContentSize, Game, Codec) <
+                   std::tie(rkOther.ContentHash, rkOther.ContentSize, rkOther.Game, rkOther.Codec);
+        }
+    };
+
+    static constexpr uint64 skDefaultMaxSize = 1024ULL * 1024ULL * 1024ULL;
+
+private:
+    struct SEntryInfo
+    {
+        uint32 FileSize;
+        uint64 LastUsed;
+    };
+
+    TString mCacheDir;
+    uint64 mMaxSize;
+    uint64 mTotalSize = 0;
+    uint64 mUseCounter = 0;
+    std::map<SKey, SEntryInfo> mEntries;
+    std::set<SKey> mPendingEntries;
+    std::mutex mMutex;
+    bool mIndexDirty = false;
+
+    // Statistics
+    uint32 mNumHits = 0;
+    uint32 mNumMisses = 0;
+
+public:
+    explicit CCompressionCache(TString CacheDir, uint64 MaxSize = skDefaultMaxSize);
+    ~CCompressionCache();
+
+    static SKey MakeKey(const uint8 *pkData, uint32 Size, EGame Game, ECompressionCodec Codec);
+    bool Lookup(const SKey& rkKey, std::vector<uint8>& rOutData, bool& rOutCompressed);
+    void Store(const SKey& rkKey, const std::vector<uint8>& rkData, bool Compressed);
+    bool SaveIndex();
+    void Clear();
+
+    // Accessors
+    TString CacheDir() const    { return mCacheDir; }
+    uint64 MaxSize() const      { return mMaxSize; }
+    uint32 NumHits() const      { return mNumHits; }
+    uint32 NumMisses() const    { return mNumMisses; }
+
+    void SetMaxSize(uint64 MaxSize) { mMaxSize = MaxSize; }
+
+private:
+    bool LoadIndex();
+    void SyncWithDirectory();
+    TString IndexPath() const;
+    TString EntryPath(const SKey& rkKey) const;
+    void EvictEntries(uint64 TargetSize);
+};
+
+#endif // CCOMPRESSIONCACHE_H
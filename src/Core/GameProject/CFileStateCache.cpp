@@ -0,0 +1,281 @@
+#include "CFileStateCache.h"
+#include <Common/FileUtil.h>
+#include <Common/Log.h>
+
+#ifdef __linux__
+#include <cerrno>
+#include <dirent.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+constexpr uint32 gkWatchMask = IN_CREATE | IN_DELETE | IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR;
+#endif
+
+CFileStateCache::CFileStateCache(TString RootDir)
+    : mRootDir(std::move(RootDir))
+{
+    if (!mRootDir.IsEmpty() && !mRootDir.EndsWith("/"))
+        mRootDir += "/";
+
+#ifdef __linux__
+    mNotifyFD = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+    if (mNotifyFD == -1)
+        warnf("Unable to watch %s for changes; file states won't be cached", *mRootDir);
+#endif
+}
+
+CFileStateCache::~CFileStateCache()
+{
+    StopWatching();
+}
+
+CFileStateCache::SFileState CFileStateCache::Query(const TString& rkPath, bool NeedSizeAndTime)
+{
+    std::lock_guard Lock(mMutex);
+
+    if (mNotifyFD != -1)
+        ProcessEvents();
+
+    // Paths outside the root, and any query made while nothing is being watched, go straight to the filesystem
+    if (mNotifyFD == -1 || !rkPath.StartsWith(mRootDir) || (!mPopulated && !Populate()))
+        return StatFile(rkPath);
+
+    // Every file under the root was either found by the scan or has been reported by the watcher since,
+    // so a file we don't know about doesn't exist
+    const auto Find = mStates.find(rkPath);
+
+    if (Find == mStates.cend())
+        return SFileState();
+
+    SCachedState& rCached = Find->second;
+
+    if (rCached.Known == EKnownState::Stale || (rCached.Known == EKnownState::Exists && NeedSizeAndTime))
+    {
+        rCached.State = StatFile(rkPath);
+        rCached.Known = EKnownState::Full;
+    }
+
+    return rCached.State;
+}
+
+void CFileStateCache::Invalidate(const TString& rkPath)
+{
+    std::lock_guard Lock(mMutex);
+
+    if (mPopulated && rkPath.StartsWith(mRootDir))
+        mStates[rkPath].Known = EKnownState::Stale;
+}
+
+void CFileStateCache::InvalidateAll()
+{
+    std::lock_guard Lock(mMutex);
+    ForgetDirectory(mRootDir);
+    mPopulated = false;
+}
+
+// ************ PRIVATE ************
+bool CFileStateCache::Populate()
+{
+    if (!FileUtil::IsDirectory(mRootDir))
+        return false;
+
+    ScanDirectory(mRootDir);
+    mPopulated = (mNotifyFD != -1);
+    return mPopulated;
+}
+
+void CFileStateCache::ScanDirectory(const TString& rkDir)
+{
+#ifdef __linux__
+    // Start watching before listing the directory, so nothing created in between gets missed
+    const int Watch = inotify_add_watch(mNotifyFD, *rkDir, gkWatchMask);
+
+    if (Watch == -1)
+    {
+        warnf("Unable to watch %s for changes; file states won't be cached", *rkDir);
+        StopWatching();
+        return;
+    }
+
+    // Already watched under another path (e.g. through a symlink)
+    if (!mWatchedDirs.try_emplace(Watch, rkDir).second)
+        return;
+
+    DIR *pDir = opendir(*rkDir);
+
+    if (!pDir)
+        return;
+
+    while (const dirent *pkEntry = readdir(pDir))
+    {
+        const TString Name = pkEntry->d_name;
+
+        if (Name == "." || Name == "..")
+            continue;
+
+        const TString Path = rkDir + Name;
+        bool IsDirectory = (pkEntry->d_type == DT_DIR);
+        bool IsFile = (pkEntry->d_type == DT_REG);
+
+        // Not every filesystem reports entry types, and symlinks need to be resolved
+        if (pkEntry->d_type == DT_UNKNOWN || pkEntry->d_type == DT_LNK)
+        {
+            struct stat Stat;
+            mNumStatCalls++;
+
+            if (stat(*Path, &Stat) != 0)
+                continue;
+
+            IsDirectory = S_ISDIR(Stat.st_mode);
+            IsFile = S_ISREG(Stat.st_mode);
+        }
+
+        if (IsDirectory)
+        {
+            ScanDirectory(Path + "/");
+
+            if (mNotifyFD == -1)
+                break;
+        }
+        else if (IsFile)
+        {
+            SCachedState& rCached = mStates[Path];
+            rCached.Known = EKnownState::Exists;
+            rCached.State.Exists = true;
+        }
+    }
+
+    closedir(pDir);
+#endif
+}
+
+void CFileStateCache::ForgetDirectory(const TString& rkDir)
+{
+#ifdef __linux__
+    for (auto It = mWatchedDirs.begin(); It != mWatchedDirs.end();)
+    {
+        if (It->second.StartsWith(rkDir))
+        {
+            inotify_rm_watch(mNotifyFD, It->first);
+            It = mWatchedDirs.erase(It);
+        }
+        else
+            ++It;
+    }
+#endif
+
+    for (auto It = mStates.begin(); It != mStates.end();)
+    {
+        if (It->first.StartsWith(rkDir))
+            It = mStates.erase(It);
+        else
+            ++It;
+    }
+}
+
+void CFileStateCache::ProcessEvents()
+{
+#ifdef __linux__
+    alignas(inotify_event) char Buffer[16384];
+
+    while (mNotifyFD != -1)
+    {
+        const ssize_t Length = read(mNotifyFD, Buffer, sizeof(Buffer));
+
+        if (Length <= 0)
+        {
+            if (Length == -1 && errno == EINTR)
+                continue;
+
+            if (Length == -1 && errno != EAGAIN)
+            {
+                warnf("Lost track of changes to %s; file states won't be cached", *mRootDir);
+                StopWatching();
+            }
+
+            return;
+        }
+
+        for (ssize_t Offset = 0; Offset < Length && mNotifyFD != -1;)
+        {
+            const auto *pkEvent = reinterpret_cast<const inotify_event*>(Buffer + Offset);
+            Offset += sizeof(inotify_event) + pkEvent->len;
+
+            // Events were dropped, so we can't trust anything we have; start over on the next query
+            if (pkEvent->mask & IN_Q_OVERFLOW)
+            {
+                ForgetDirectory(mRootDir);
+                mPopulated = false;
+                continue;
+            }
+
+            const auto Dir = mWatchedDirs.find(pkEvent->wd);
+
+            if (Dir == mWatchedDirs.cend())
+                continue;
+
+            if (pkEvent->mask & IN_IGNORED)
+            {
+                mWatchedDirs.erase(Dir);
+                continue;
+            }
+
+            // Changes to the watched directory itself are reported by its parent
+            if (pkEvent->len == 0)
+                continue;
+
+            const TString Path = Dir->second + pkEvent->name;
+
+            if (pkEvent->mask & IN_ISDIR)
+            {
+                if (pkEvent->mask & (IN_CREATE | IN_MOVED_TO))
+                    ScanDirectory(Path + "/");
+                else if (pkEvent->mask & (IN_DELETE | IN_MOVED_FROM))
+                    ForgetDirectory(Path + "/");
+            }
+            else
+            {
+                mStates[Path].Known = EKnownState::Stale;
+            }
+        }
+    }
+#endif
+}
+
+void CFileStateCache::StopWatching()
+{
+#ifdef __linux__
+    if (mNotifyFD != -1)
+    {
+        close(mNotifyFD);
+        mNotifyFD = -1;
+    }
+#endif
+
+    mWatchedDirs.clear();
+    mStates.clear();
+    mPopulated = false;
+}
+
+CFileStateCache::SFileState CFileStateCache::StatFile(const TString& rkPath)
+{
+    mNumStatCalls++;
+
+#ifdef __linux__
+    struct stat Stat;
+
+    if (stat(*rkPath, &Stat) != 0 || !S_ISREG(Stat.st_mode))
+        return SFileState();
+
+    // st_mtime is in whole seconds, and FileUtil's file clock uses a different epoch and resolution. Every consumer
+    // compares these against FileUtil::LastModifiedTime, so the time comes from there to keep the units identical.
+    return SFileState{true, static_cast<uint64>(Stat.st_size), FileUtil::LastModifiedTime(rkPath)};
+#else
+    if (!FileUtil::Exists(rkPath))
+        return SFileState();
+
+    return SFileState{true, FileUtil::FileSize(rkPath), FileUtil::LastModifiedTime(rkPath)};
+#endif
+}
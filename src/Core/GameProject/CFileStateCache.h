@@ -0,0 +1,78 @@
+#ifndef CFILESTATECACHE_H
+#define CFILESTATECACHE_H
+
+#include <Common/BasicTypes.h>
+#include <Common/TString.h>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+
+// Caches whether the files under a directory exist, along with their sizes and last modified times, so resource
+// entries don't have to go to the filesystem every time they're queried. The cache is filled by a single scan of
+// the directory and kept up to date by watching it with inotify. On platforms without a watcher, nothing is cached
+// and every query goes straight to the filesystem. Safe to use from multiple threads.
+class CFileStateCache
+{
+public:
+    struct SFileState
+    {
+        bool Exists = false;
+        uint64 Size = 0;
+        uint64 ModifiedTime = 0;
+    };
+
+private:
+    enum class EKnownState
+    {
+        Stale,      // Changed since it was last looked at
+        Exists,     // Exists, but the size and modified time haven't been read yet
+        Full
+    };
+
+    struct SCachedState
+    {
+        EKnownState Known = EKnownState::Stale;
+        SFileState State;
+    };
+
+    struct SPathHash
+    {
+        size_t operator()(const TString& rkPath) const { return std::hash<std::string_view>()(std::string_view(*rkPath, rkPath.Size())); }
+    };
+
+    TString mRootDir;
+    std::unordered_map<TString, SCachedState, SPathHash> mStates;
+    std::unordered_map<int, TString> mWatchedDirs; // Watch descriptor -> directory path
+    int mNotifyFD = -1;
+    bool mPopulated = false;
+    uint32 mNumStatCalls = 0;
+    mutable std::mutex mMutex;
+
+public:
+    explicit CFileStateCache(TString RootDir);
+    ~CFileStateCache();
+
+    SFileState Query(const TString& rkPath, bool NeedSizeAndTime = true);
+    bool Exists(const TString& rkPath)                  { return Query(rkPath, false).Exists; }
+    uint64 FileSize(const TString& rkPath)              { return Query(rkPath).Size; }
+    uint64 LastModifiedTime(const TString& rkPath)      { return Query(rkPath).ModifiedTime; }
+
+    /** Forces the given file, or every file, to be read from the filesystem again the next time it's queried */
+    void Invalidate(const TString& rkPath);
+    void InvalidateAll();
+
+    // Accessors
+    TString RootDir() const         { return mRootDir; }
+    bool IsWatching() const         { return mNotifyFD != -1; }
+    uint32 NumStatCalls() const     { std::lock_guard Lock(mMutex); return mNumStatCalls; }
+
+private:
+    bool Populate();
+    void ScanDirectory(const TString& rkDir);
+    void ForgetDirectory(const TString& rkDir);
+    void ProcessEvents();
+    void StopWatching();
+    SFileState StatFile(const TString& rkPath);
+};
+
+#endif // CFILESTATECACHE_H
@@ -1,31 +1,193 @@
 #include "CGameExporter.h"
 #include "CGameInfo.h"
+#include "CResourceCache.h"
 #include "CResourceIterator.h"
+#include "CResourceMetadataStore.h"
 #include "CResourceStore.h"
 #include "Core/CompressionUtil.h"
+#include "Core/CThreadPool.h"
 #include "Core/Resource/CWorld.h"
 #include "Core/Resource/Script/CGameTemplate.h"
 #include <Common/Macros.h>
 #include <Common/CScopedTimer.h>
 #include <Common/FileIO.h>
 #include <Common/FileUtil.h>
+#include <Common/Hash/CCRC32.h>
 #include <Common/Serialization/CXMLWriter.h>
 
 #include <nod/nod.hpp>
 #include <nod/DiscBase.hpp>
 #include <tinyxml2.h>
 
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <optional>
+
 #define LOAD_PAKS 1
 #define SAVE_PACKAGE_DEFINITIONS 1
 #define USE_ASSET_NAME_MAP 1
 #define EXPORT_COOKED 1
 
+// Upper bound on pak data read ahead of the unpacking workers
+constexpr uint64 gkMaxBufferedPakBytes = 256 * 1024 * 1024;
+
+// Number of recently used resources kept loaded while generating editor data
+constexpr size_t gkEditorDataCacheSize = 2048;
+
 #if NOD_UCS2
 #define TStringToNodString(string) ToWChar(string)
 #else
 #define TStringToNodString(string) *string
 #endif
 
+// Amount read from the start of a pak at once while looking for the end of its header
+constexpr uint32 gkPakHeaderChunkSize = 0x10000;
+
+struct CGameExporter::SPakStreamContext
+{
+    CThreadPool Pool;
+    std::mutex BufferMutex;
+    std::condition_variable BufferCondition;
+    uint64 BufferedBytes = 0;
+    std::set<TString> OutputDirs;
+
+    // Resources each pak is responsible for unpacking, sorted by offset
+    std::map<TString, std::vector<SResourceInstance*>> PakResources;
+
+    explicit SPakStreamContext(uint32 NumJobs)
+        : Pool(NumJobs)
+    {}
+};
+
+namespace
+{
+/**
+ * Reads a file from the disc front to back, writing everything that's read to the extracted copy on the way.
+ * With no output path, the file is only read.
+ */
+class CDiscFileTee
+{
+    std::unique_ptr<nod::IPartReadStream> mpStream;
+    std::optional<CFileOutStream> mOut;
+    uint64 mSize;
+    uint64 mPos = 0;
+    std::vector<uint8> mSkipBuffer;
+
+public:
+    CDiscFileTee(const nod::Node& rkNode, const TString& rkOutPath)
+        : mpStream(rkNode.beginReadStream())
+        , mSize(rkNode.size())
+    {
+        if (!rkOutPath.IsEmpty())
+            mOut.emplace(rkOutPath, EEndian::BigEndian);
+    }
+
+    /** Reads the next Length bytes; fails if that goes past the end of the file */
+    bool Read(void *pDst, uint64 Length)
+    {
+        if (mPos + Length > mSize || mpStream->read(pDst, Length) != Length)
+            return false;
+
+        if (mOut)
+            mOut->WriteBytes(pDst, static_cast<uint32>(Length));
+        mPos += Length;
+        return true;
+    }
+
+    /** Copies everything up to the given offset through to the extracted file */
+    bool SkipTo(uint64 Offset)
+    {
+        if (mPos < Offset && mSkipBuffer.empty())
+            mSkipBuffer.resize(gkPakHeaderChunkSize * 16);
+
+        while (mPos < Offset)
+        {
+            if (!Read(mSkipBuffer.data(), std::min<uint64>(Offset - mPos, mSkipBuffer.size())))
+                return false;
+        }
+
+        return true;
+    }
+
+    bool IsValid() const    { return mpStream != nullptr && (!mOut || mOut->IsValid()); }
+    uint64 Size() const     { return mSize; }
+    uint64 Tell() const     { return mPos; }
+};
+
+/**
+ * Reads everything in front of the resource data in a pak. MP1/MP2 paks don't store the header size,
+ * so it's found by walking the name and resource tables, reading more of the pak as needed.
+ */
+bool ReadPakHeaderData(CDiscFileTee& rPak, EGame Game, std::vector<uint8>& rOut)
+{
+    bool Success = true;
+
+    const auto Require = [&](uint64 Size)
+    {
+        if (Size > rOut.size() && Success)
+        {
+            const uint64 OldSize = rOut.size();
+            const uint64 NewSize = std::min(std::max<uint64>(Size, OldSize + gkPakHeaderChunkSize), rPak.Size());
+            rOut.resize(NewSize);
+            Success = (NewSize >= Size) && rPak.Read(rOut.data() + OldSize, NewSize - OldSize);
+        }
+        return Success;
+    };
+
+    const auto ReadULong = [&](uint64 Offset) -> uint32
+    {
+        if (!Require(Offset + 4))
+            return 0;
+
+        const uint8 *pkData = rOut.data() + Offset;
+        return (pkData[0] << 24) | (pkData[1] << 16) | (pkData[2] << 8) | pkData[3];
+    };
+
+    const uint32 IDLength = (CAssetID::GameIDLength(Game) == EIDLength::k32Bit ? 4 : 8);
+
+    // MP1-MP3Proto
+    if (Game < EGame::Corruption)
+    {
+        // Echoes demo disc has a pak that ends after the version
+        if (rPak.Size() <= 8)
+            return Require(rPak.Size());
+
+        uint64 Pos = 8;
+        const uint32 NumNamedResources = ReadULong(Pos);
+        Pos += 4;
+
+        for (uint32 iName = 0; iName < NumNamedResources && Success; iName++)
+        {
+            Pos += 4 + IDLength;
+            Pos += 4 + ReadULong(Pos);
+        }
+
+        const uint32 NumResources = ReadULong(Pos);
+        Pos += 4 + static_cast<uint64>(NumResources) * (16 + IDLength);
+        return Require(Pos);
+    }
+    else // MP3 + DKCR
+    {
+        uint64 Pos = ReadULong(4);
+        const uint32 NumPakSections = ReadULong(Pos);
+        uint64 SectionPos = Pos + 4;
+        Pos = (SectionPos + NumPakSections * 8 + 63) & ~63ULL;
+
+        // Everything up to the data section
+        for (uint32 iSec = 0; iSec < NumPakSections && Success; iSec++, SectionPos += 8)
+        {
+            if (ReadULong(SectionPos) == FOURCC('DATA'))
+                break;
+
+            Pos += ReadULong(SectionPos + 4);
+        }
+
+        return Require(Pos);
+    }
+}
+} // anonymous namespace
+
 CGameExporter::CGameExporter(EDiscType DiscType, EGame Game, bool FrontEnd, ERegion Region, const TString& rkGameName, const TString& rkGameID, float BuildVersion)
     : mGame(Game)
     , mRegion(Region)
@@ -61,11 +223,7 @@ bool CGameExporter::Export(nod::DiscBase *pDisc, const TString& rkOutputDir, CAs
     mpProgress = pProgress;
     mpProgress->SetNumTasks(eES_NumSteps);
 
-    // Extract disc
-    if (!ExtractDiscData())
-        return false;
-
-    // Create project
+    // Create project. This happens before extracting the disc so paks can be unpacked as they're extracted.
     mpProject = CGameProject::CreateProjectForExport(
                 mExportDir,
                 mGame,
@@ -80,6 +238,14 @@ bool CGameExporter::Export(nod::DiscBase *pDisc, const TString& rkOutputDir, CAs
     CResourceStore *pOldStore = gpResourceStore;
     gpResourceStore = mpStore;
 
+    // Extract disc
+    if (!ExtractDiscData())
+    {
+        if (pOldStore != nullptr)
+            gpResourceStore = pOldStore;
+        return false;
+    }
+
     // Export cooked data
     LoadPaks();
     ExportCookedResources();
@@ -168,6 +334,142 @@ bool CGameExporter::ShouldExportDiscNode(const nod::Node *pkNode, bool IsInRoot)
     return true;
 }
 
+bool CGameExporter::IdentifyDisc(nod::DiscBase *pDisc, SDiscInfo& rOutInfo)
+{
+    if (!pDisc) return false;
+
+    const nod::Header& rkHeader = pDisc->getHeader();
+    rOutInfo.GameTitle = rkHeader.m_gameTitle;
+    rOutInfo.GameID = TString(6, 0);
+    memcpy(&rOutInfo.GameID[0], rkHeader.m_gameID, 6);
+    rOutInfo.DiscType = EDiscType::Normal;
+    rOutInfo.Game = EGame::Invalid;
+
+    // The MP2 ISO doesn't have a colon in the game name and it kinda annoys me
+    if (rOutInfo.GameTitle == "Metroid Prime 2 Echoes")
+        rOutInfo.GameTitle = "Metroid Prime 2: Echoes";
+
+    // Check region byte
+    switch (rOutInfo.GameID[3])
+    {
+    case 'E':
+        rOutInfo.Region = ERegion::NTSC;
+        break;
+
+    case 'P':
+        rOutInfo.Region = ERegion::PAL;
+        break;
+
+    case 'J':
+        rOutInfo.Region = ERegion::JPN;
+        break;
+
+    default:
+        return false;
+    }
+
+    // Set region byte to X so we don't need to compare every regional variant of the ID
+    // Then figure out what game this is
+    CFourCC GameID(&rOutInfo.GameID[0]);
+    GameID[3] = 'X';
+
+    switch (GameID.ToLong())
+    {
+    case FOURCC('GM8X'):
+        // This ID is normally MP1, but it's used by the MP1 NTSC demo and the MP2 bonus disc demo as well
+        if (strcmp(rkHeader.m_gameTitle, "Long Game Name") == 0)
+        {
+            // Calculate the CRC of the apploader to figure out which game this is.
+            std::unique_ptr<uint8_t[]> pApploaderData = pDisc->getDataPartition()->getApploaderBuf();
+            uint ApploaderSize = (uint) pDisc->getDataPartition()->getApploaderSize();
+            uint ApploaderHash = CCRC32::StaticHashData(pApploaderData.get(), ApploaderSize);
+
+            // 0x21B7AFF5 is the hash for the NTSC MP1 demo. Otherwise, this is most likely an Echoes demo build
+            rOutInfo.Game = (ApploaderHash == 0x21B7AFF5 ? EGame::PrimeDemo : EGame::EchoesDemo);
+        }
+        else
+        {
+            // This could be either Metroid Prime, or the PAL demo of it...
+            // In either case, the PAL demo is based on a later build of the game than the NTSC demo
+            // So the PAL demo should be configured the same way as the release build of the game anyway
+            rOutInfo.Game = EGame::Prime;
+        }
+        return true;
+
+    case FOURCC('G2MX'):
+        // Echoes, but also appears in the MP3 proto
+        if (rOutInfo.GameID[4] == 'A' && rOutInfo.GameID[5] == 'B')
+            rOutInfo.Game = EGame::CorruptionProto;
+        else
+            rOutInfo.Game = EGame::Echoes;
+        return true;
+
+    case FOURCC('RM3X'):
+        rOutInfo.Game = EGame::Corruption;
+        return true;
+
+    case FOURCC('SF8X'):
+        rOutInfo.Game = EGame::DKCReturns;
+        return true;
+
+    case FOURCC('R3MX'):
+        rOutInfo.DiscType = EDiscType::Trilogy;
+        return true;
+
+    case FOURCC('R3IX'):
+        // MP1 Wii de Asobu
+        rOutInfo.Game = EGame::Prime;
+        rOutInfo.DiscType = EDiscType::WiiDeAsobu;
+        return true;
+
+    case FOURCC('R32X'):
+        rOutInfo.Game = EGame::Echoes;
+        rOutInfo.DiscType = EDiscType::WiiDeAsobu;
+        return true;
+
+    default:
+        // Unrecognized game ID
+        return false;
+    }
+}
+
+float CGameExporter::FindBuildVersion(nod::DiscBase *pDisc, EGame Game)
+{
+    ASSERT(pDisc != nullptr);
+
+    // MP1 demo build doesn't have a build version
+    if (Game == EGame::PrimeDemo) return 0.f;
+
+    // Get DOL buffer
+    std::unique_ptr<uint8_t[]> pDolData = pDisc->getDataPartition()->getDOLBuf();
+    uint32 DolSize = (uint32) pDisc->getDataPartition()->getDOLSize();
+
+    // Find build info string
+    constexpr char pkSearchText[] = "!#$MetroidBuildInfo!#$";
+    const int SearchTextSize = strlen(pkSearchText);
+
+    for (uint32 SearchIdx = 0; SearchIdx < DolSize - SearchTextSize + 1; SearchIdx++)
+    {
+        int Match = 0;
+
+        while (pDolData[SearchIdx + Match] == pkSearchText[Match] && Match < SearchTextSize)
+            Match++;
+
+        if (Match == SearchTextSize)
+        {
+            // Found the build info string; extract version number
+            TString BuildInfo = (char*) &pDolData[SearchIdx + SearchTextSize];
+            int BuildVerStart = BuildInfo.IndexOfPhrase("Build v") + 7;
+            ASSERT(BuildVerStart != 6);
+
+            return BuildInfo.SubString(BuildVerStart, 5).ToFloat();
+        }
+    }
+
+    errorf("Failed to find MetroidBuildInfo string. Build Version will be set to 0.");
+    return 0.f;
+}
+
 // ************ PROTECTED ************
 bool CGameExporter::ExtractDiscData()
 {
@@ -194,7 +496,22 @@ bool CGameExporter::ExtractDiscData()
     TString FilesDir = AbsDiscDir + "files/";
     FileUtil::MakeDirectory(FilesDir);
 
-    bool Success = ExtractDiscNodeRecursive(&pDataPartition->getFSTRoot(), FilesDir, true, Context);
+    std::unique_ptr<SPakStreamContext> pStreamContext;
+
+    if (mStreamPaks)
+    {
+        pStreamContext = std::make_unique<SPakStreamContext>(mNumJobs);
+
+        if (!ReadStreamedPakHeaders(&pDataPartition->getFSTRoot(), FilesDir, *pStreamContext))
+            return false;
+    }
+
+    bool Success = ExtractDiscNodeRecursive(&pDataPartition->getFSTRoot(), FilesDir, true, Context, pStreamContext.get());
+
+    // Unpacking jobs reference the resource map, so they must finish before we return
+    if (pStreamContext)
+        pStreamContext->Pool.WaitForTasks();
+
     if (!Success) return false;
 
     if (!mpProgress->ShouldCancel())
@@ -222,7 +539,7 @@ bool CGameExporter::ExtractDiscData()
         return false;
 }
 
-bool CGameExporter::ExtractDiscNodeRecursive(const nod::Node *pkNode, const TString& rkDir, bool RootNode, const nod::ExtractionContext& rkContext)
+bool CGameExporter::ExtractDiscNodeRecursive(const nod::Node *pkNode, const TString& rkDir, bool RootNode, const nod::ExtractionContext& rkContext, SPakStreamContext *pStreamContext)
 {
     for (nod::Node::DirectoryIterator Iter = pkNode->begin(); Iter != pkNode->end(); ++Iter)
     {
@@ -232,16 +549,20 @@ bool CGameExporter::ExtractDiscNodeRecursive(const nod::Node *pkNode, const TStr
         if (Iter->getKind() == nod::Node::Kind::File)
         {
             TString FilePath = rkDir + Iter->getName().data();
-            bool Success = Iter->extractToDirectory(TStringToNodString(rkDir), rkContext);
+            const bool IsTracked = IsTrackedPak(pkNode, FilePath);
+
+            bool Success;
+
+            if (IsTracked && pStreamContext != nullptr)
+                Success = StreamPak(*Iter, FilePath, *pStreamContext);
+            else
+                Success = Iter->extractToDirectory(TStringToNodString(rkDir), rkContext);
+
             if (!Success)
                 return false;
 
-            if (FilePath.GetFileExtension().CaseInsensitiveCompare("pak"))
-            {
-                // For multi-game Wii discs, don't track packages for frontend unless we're exporting frontend
-                if (mDiscType == EDiscType::Normal || mFrontEnd || pkNode->getName() != "fe")
-                    mPaks.push_back(FilePath);
-            }
+            if (IsTracked)
+                mPaks.push_back(FilePath);
         }
 
         else
@@ -251,7 +572,7 @@ bool CGameExporter::ExtractDiscNodeRecursive(const nod::Node *pkNode, const TStr
             if (!Success)
                 return false;
 
-            Success = ExtractDiscNodeRecursive(&*Iter, Subdir, false, rkContext);
+            Success = ExtractDiscNodeRecursive(&*Iter, Subdir, false, rkContext, pStreamContext);
             if (!Success)
                 return false;
         }
@@ -260,6 +581,161 @@ bool CGameExporter::ExtractDiscNodeRecursive(const nod::Node *pkNode, const TStr
     return true;
 }
 
+bool CGameExporter::StreamPak(const nod::Node& rkNode, const TString& rkPakPath, SPakStreamContext& rContext)
+{
+    // Every byte of the pak is read from the disc once and written straight to the extracted file. Resources are
+    // copied out on the way past and unpacked on the worker threads while the rest of the disc is extracted.
+    CDiscFileTee Pak(rkNode, rkPakPath);
+
+    if (!Pak.IsValid())
+    {
+        errorf("Failed to extract pak: %s", *rkPakPath);
+        return false;
+    }
+
+    // The header is copied through with everything else in front of the first resource
+    const std::vector<SResourceInstance*>& rkResources = rContext.PakResources[rkPakPath];
+    const uint64 PakSize = Pak.Size();
+    const TString PakName = rkPakPath.GetFileName();
+
+    for (SResourceInstance *pRes : rkResources)
+    {
+        if (mpProgress->ShouldCancel())
+            return false;
+
+        // Resources that overlap data we've already gone past are left for ExportCookedResources to read from the extracted pak
+        if (pRes->PakOffset < Pak.Tell())
+            continue;
+
+        mpProgress->Report(static_cast<int>(Pak.Tell() * 10000 / PakSize), 10000, PakName);
+
+        const TString OutPath = RegisterResource(*pRes)->CookedAssetPath();
+        const TString OutDir = OutPath.GetFileDirectory();
+
+        if (rContext.OutputDirs.insert(OutDir).second)
+            FileUtil::MakeDirectory(OutDir);
+
+        // MP1/MP2 compressed resources are read with a trailing uncompressed size field on top of
+        // their listed size. Anything past the end of the pak is left zeroed, same as a file read.
+        const uint32 ReadSize = pRes->PakSize + (pRes->Compressed && mGame <= EGame::CorruptionProto ? 4 : 0);
+        const uint32 AvailableSize = (pRes->PakOffset < PakSize ? static_cast<uint32>(std::min<uint64>(ReadSize, PakSize - pRes->PakOffset)) : 0);
+
+        {
+            std::unique_lock Lock(rContext.BufferMutex);
+            rContext.BufferCondition.wait(Lock, [&]() { return rContext.BufferedBytes == 0 || rContext.BufferedBytes + ReadSize <= gkMaxBufferedPakBytes; });
+            rContext.BufferedBytes += ReadSize;
+        }
+
+        std::vector<uint8> PakData(ReadSize);
+
+        if (!Pak.SkipTo(std::min<uint64>(pRes->PakOffset, PakSize)) || !Pak.Read(PakData.data(), AvailableSize))
+        {
+            errorf("Failed to extract pak: %s", *rkPakPath);
+            return false;
+        }
+
+        rContext.Pool.AddTask([this, pRes, OutPath, PakData = std::move(PakData), &rContext]() mutable
+        {
+            const uint32 BufferSize = PakData.size();
+            UnpackResource(*pRes, OutPath, PakData);
+
+            {
+                std::lock_guard Lock(rContext.BufferMutex);
+                rContext.BufferedBytes -= BufferSize;
+            }
+            rContext.BufferCondition.notify_one();
+
+            pRes->Exported = true;
+        });
+    }
+
+    // Copy whatever's left after the last resource
+    if (!Pak.SkipTo(PakSize))
+    {
+        errorf("Failed to extract pak: %s", *rkPakPath);
+        return false;
+    }
+
+    return true;
+}
+
+bool CGameExporter::IsTrackedPak(const nod::Node *pkDir, const TString& rkFilePath) const
+{
+    // For multi-game Wii discs, don't track packages for frontend unless we're exporting frontend
+    return rkFilePath.GetFileExtension().CaseInsensitiveCompare("pak") &&
+           (mDiscType == EDiscType::Normal || mFrontEnd || pkDir->getName() != "fe");
+}
+
+bool CGameExporter::ReadStreamedPakHeaders(const nod::Node *pkRoot, const TString& rkFilesDir, SPakStreamContext& rContext)
+{
+    // Which pak a resource is unpacked from, and which areas are flagged as having duplicates, both depend on the order
+    // paks are added in. The disc lists files in a different order than LoadPaks adds them, so every header is read up
+    // front and the paks are added in LoadPaks' order before any data is streamed.
+    mpProgress->Report(-1, -1, "Reading pak headers");
+
+    std::list<std::pair<TString, SPakContents>> Headers;
+
+    const auto ReadHeaders = [&](const nod::Node *pkNode, const TString& rkDir, bool RootNode, const auto& rkRecurse) -> bool
+    {
+        for (nod::Node::DirectoryIterator Iter = pkNode->begin(); Iter != pkNode->end(); ++Iter)
+        {
+            if (!ShouldExportDiscNode(&*Iter, RootNode) || mpProgress->ShouldCancel())
+                continue;
+
+            if (Iter->getKind() != nod::Node::Kind::File)
+            {
+                if (!rkRecurse(&*Iter, rkDir + Iter->getName().data() + "/", false, rkRecurse))
+                    return false;
+
+                continue;
+            }
+
+            const TString FilePath = rkDir + Iter->getName().data();
+
+            if (!IsTrackedPak(pkNode, FilePath))
+                continue;
+
+            CDiscFileTee Pak(*Iter, TString());
+            std::vector<uint8> Header;
+
+            if (!Pak.IsValid() || !ReadPakHeaderData(Pak, mGame, Header))
+            {
+                errorf("Failed to read pak header: %s", *FilePath);
+                return false;
+            }
+
+            SPakContents Contents;
+            CMemoryInStream HeaderStream(Header.data(), Header.size(), EEndian::BigEndian);
+            ReadPakHeader(HeaderStream, FilePath, Contents);
+            Headers.emplace_back(FilePath, std::move(Contents));
+        }
+
+        return true;
+    };
+
+    if (!ReadHeaders(pkRoot, rkFilesDir, true, ReadHeaders) || mpProgress->ShouldCancel())
+        return false;
+
+    // Same order as LoadPaks; list::sort is stable, so paks with the same name stay in disc order as they do there
+    Headers.sort([](const auto& rkLeft, const auto& rkRight) -> bool {
+        return rkLeft.first.ToUpper() < rkRight.first.ToUpper();
+    });
+
+    for (const auto& [PakPath, Contents] : Headers)
+    {
+        std::vector<SResourceInstance*> NewResources;
+        mStreamedPackages.insert_or_assign(PakPath, AddPak(PakPath, Contents, &NewResources));
+
+        std::sort(NewResources.begin(), NewResources.end(), [](const SResourceInstance *pkLeft, const SResourceInstance *pkRight) {
+            return pkLeft->PakOffset < pkRight->PakOffset;
+        });
+
+        rContext.PakResources.insert_or_assign(PakPath, std::move(NewResources));
+    }
+
+    return true;
+}
+
 // ************ RESOURCE LOADING ************
 void CGameExporter::LoadPaks()
 {
@@ -270,171 +746,179 @@ void CGameExporter::LoadPaks()
         return rkLeft.ToUpper() < rkRight.ToUpper();
     });
 
-    for (auto It = mPaks.begin(); It != mPaks.end(); It++)
+    for (const TString& rkPakPath : mPaks)
     {
-        TString PakPath = *It;
-        CFileInStream Pak(PakPath, EEndian::BigEndian);
+        // Paks that were streamed from the disc have been loaded already
+        const auto Streamed = mStreamedPackages.find(rkPakPath);
 
-        if (!Pak.IsValid())
+        if (Streamed != mStreamedPackages.end())
         {
-            errorf("Couldn't open pak: %s", *PakPath);
+            mpProject->AddPackage(std::move(Streamed->second));
             continue;
         }
 
-        TString RelPakPath = FileUtil::MakeRelative(PakPath.GetFileDirectory(), mpProject->DiscFilesystemRoot(false));
-        auto pPackage = std::make_unique<CPackage>(mpProject.get(), PakPath.GetFileName(false), RelPakPath);
+        CFileInStream Pak(rkPakPath, EEndian::BigEndian);
 
-        // MP1-MP3Proto
-        if (mGame < EGame::Corruption)
+        if (!Pak.IsValid())
         {
-            [[maybe_unused]] const uint32 PakVersion = Pak.ReadULong();
-            Pak.Seek(0x4, SEEK_CUR);
-            ASSERT(PakVersion == 0x00030005);
+            errorf("Couldn't open pak: %s", *rkPakPath);
+            continue;
+        }
 
-            // Echoes demo disc has a pak that ends right here.
-            if (!Pak.EoF())
-            {
-                uint32 NumNamedResources = Pak.ReadULong();
-                ASSERT(NumNamedResources > 0);
+        SPakContents Contents;
+        ReadPakHeader(Pak, rkPakPath, Contents);
+        mpProject->AddPackage(AddPak(rkPakPath, Contents, nullptr));
+    }
 
-                for (uint32 iName = 0; iName < NumNamedResources; iName++)
-                {
-                    const CFourCC ResType = Pak.ReadULong();
-                    const CAssetID ResID(Pak, mGame);
-                    const uint32 NameLen = Pak.ReadULong();
-                    const TString Name = Pak.ReadString(NameLen);
-                    pPackage->AddResource(Name, ResID, ResType);
-                }
+    mStreamedPackages.clear();
+#endif
+}
 
-                uint32 NumResources = Pak.ReadLong();
+void CGameExporter::ReadPakHeader(IInputStream& rPak, const TString& rkPakPath, SPakContents& rOut) const
+{
+    // MP1-MP3Proto
+    if (mGame < EGame::Corruption)
+    {
+        [[maybe_unused]] const uint32 PakVersion = rPak.ReadULong();
+        rPak.Seek(0x4, SEEK_CUR);
+        ASSERT(PakVersion == 0x00030005);
 
-                // Keep track of which areas have duplicate resources
-                std::set<CAssetID> PakResourceSet;
-                bool AreaHasDuplicates = true; // Default to true so that first area is always considered as having duplicates
+        // Echoes demo disc has a pak that ends right here.
+        if (!rPak.EoF())
+        {
+            uint32 NumNamedResources = rPak.ReadULong();
+            ASSERT(NumNamedResources > 0);
 
-                for (uint32 iRes = 0; iRes < NumResources; iRes++)
-                {
-                    const bool Compressed = Pak.ReadULong() == 1;
-                    const CFourCC ResType = Pak.ReadULong();
-                    const CAssetID ResID(Pak, mGame);
-                    const uint32 ResSize = Pak.ReadULong();
-                    const uint32 ResOffset = Pak.ReadULong();
+            for (uint32 iName = 0; iName < NumNamedResources; iName++)
+            {
+                const CFourCC ResType = rPak.ReadULong();
+                const CAssetID ResID(rPak, mGame);
+                const uint32 NameLen = rPak.ReadULong();
+                const TString Name = rPak.ReadString(NameLen);
+                rOut.NamedResources.push_back(SPakContents::SNamedResource{Name, ResID, ResType});
+            }
 
-                    if (mResourceMap.find(ResID) == mResourceMap.cend())
-                        mResourceMap.insert_or_assign(ResID, SResourceInstance{PakPath, ResID, ResType, ResOffset, ResSize, Compressed, false});
+            uint32 NumResources = rPak.ReadLong();
 
-                    // Check for duplicate resources
-                    if (ResType == "MREA")
-                    {
-                        mAreaDuplicateMap[ResID] = AreaHasDuplicates;
-                        AreaHasDuplicates = false;
-                    }
-                    else if (!AreaHasDuplicates && PakResourceSet.find(ResID) != PakResourceSet.cend())
-                    {
-                        AreaHasDuplicates = true;
-                    }
-                    else
-                    {
-                        PakResourceSet.insert(ResID);
-                    }
-                }
+            for (uint32 iRes = 0; iRes < NumResources; iRes++)
+            {
+                const bool Compressed = rPak.ReadULong() == 1;
+                const CFourCC ResType = rPak.ReadULong();
+                const CAssetID ResID(rPak, mGame);
+                const uint32 ResSize = rPak.ReadULong();
+                const uint32 ResOffset = rPak.ReadULong();
+                rOut.Resources.push_back(SResourceInstance{rkPakPath, ResID, ResType, ResOffset, ResSize, Compressed, false});
             }
         }
-        else // MP3 + DKCR
-        {
-            [[maybe_unused]] const uint32 PakVersion = Pak.ReadULong();
-            const uint32 PakHeaderLen = Pak.ReadULong();
-            Pak.Seek(PakHeaderLen - 0x8, SEEK_CUR);
-            ASSERT(PakVersion == 2);
+    }
+    else // MP3 + DKCR
+    {
+        [[maybe_unused]] const uint32 PakVersion = rPak.ReadULong();
+        const uint32 PakHeaderLen = rPak.ReadULong();
+        rPak.Seek(PakHeaderLen - 0x8, SEEK_CUR);
+        ASSERT(PakVersion == 2);
 
-            struct SPakSection {
-                CFourCC Type;
-                uint32 Size;
-            };
-            std::vector<SPakSection> PakSections;
+        struct SPakSection {
+            CFourCC Type;
+            uint32 Size;
+        };
+        std::vector<SPakSection> PakSections;
 
-            const uint32 NumPakSections = Pak.ReadULong();
-            ASSERT(NumPakSections == 3);
+        const uint32 NumPakSections = rPak.ReadULong();
+        ASSERT(NumPakSections == 3);
 
-            for (uint32 iSec = 0; iSec < NumPakSections; iSec++)
-            {
-                const CFourCC Type = Pak.ReadULong();
-                const uint32 Size = Pak.ReadULong();
-                PakSections.push_back(SPakSection{Type, Size});
-            }
-            Pak.SeekToBoundary(64);
+        for (uint32 iSec = 0; iSec < NumPakSections; iSec++)
+        {
+            const CFourCC Type = rPak.ReadULong();
+            const uint32 Size = rPak.ReadULong();
+            PakSections.push_back(SPakSection{Type, Size});
+        }
+        rPak.SeekToBoundary(64);
 
-            for (uint32 iSec = 0; iSec < NumPakSections; iSec++)
+        for (uint32 iSec = 0; iSec < NumPakSections; iSec++)
+        {
+            const uint32 Next = rPak.Tell() + PakSections[iSec].Size;
+
+            // Named Resources
+            if (PakSections[iSec].Type == "STRG")
             {
-                const uint32 Next = Pak.Tell() + PakSections[iSec].Size;
+                const uint32 NumNamedResources = rPak.ReadULong();
 
-                // Named Resources
-                if (PakSections[iSec].Type == "STRG")
+                for (uint32 iName = 0; iName < NumNamedResources; iName++)
                 {
-                    const uint32 NumNamedResources = Pak.ReadULong();
-
-                    for (uint32 iName = 0; iName < NumNamedResources; iName++)
-                    {
-                        const TString Name = Pak.ReadString();
-                        const CFourCC ResType = Pak.ReadULong();
-                        const CAssetID ResID(Pak, mGame);
-                        pPackage->AddResource(Name, ResID, ResType);
-                    }
+                    const TString Name = rPak.ReadString();
+                    const CFourCC ResType = rPak.ReadULong();
+                    const CAssetID ResID(rPak, mGame);
+                    rOut.NamedResources.push_back(SPakContents::SNamedResource{Name, ResID, ResType});
                 }
-                else if (PakSections[iSec].Type == "RSHD")
+            }
+            else if (PakSections[iSec].Type == "RSHD")
+            {
+                ASSERT(PakSections[iSec + 1].Type == "DATA");
+                const uint32 DataStart = Next;
+                const uint32 NumResources = rPak.ReadULong();
+
+                for (uint32 iRes = 0; iRes < NumResources; iRes++)
                 {
-                    ASSERT(PakSections[iSec + 1].Type == "DATA");
-                    const uint32 DataStart = Next;
-                    const uint32 NumResources = Pak.ReadULong();
+                    const bool Compressed = rPak.ReadULong() == 1;
+                    const CFourCC Type = rPak.ReadULong();
+                    const CAssetID ResID(rPak, mGame);
+                    const uint32 Size = rPak.ReadULong();
+                    const uint32 Offset = DataStart + rPak.ReadULong();
+                    rOut.Resources.push_back(SResourceInstance{rkPakPath, ResID, Type, Offset, Size, Compressed, false});
+                }
+            }
 
-                    // Keep track of which areas have duplicate resources
-                    std::set<CAssetID> PakResourceSet;
-                    bool AreaHasDuplicates = true; // Default to true so that first area is always considered as having duplicates
+            rPak.Seek(Next, SEEK_SET);
+        }
+    }
+}
 
-                    for (uint32 iRes = 0; iRes < NumResources; iRes++)
-                    {
-                        const bool Compressed = Pak.ReadULong() == 1;
-                        const CFourCC Type = Pak.ReadULong();
-                        const CAssetID ResID(Pak, mGame);
-                        const uint32 Size = Pak.ReadULong();
-                        const uint32 Offset = DataStart + Pak.ReadULong();
-
-                        if (mResourceMap.find(ResID) == mResourceMap.cend())
-                            mResourceMap.insert_or_assign(ResID, SResourceInstance{PakPath, ResID, Type, Offset, Size, Compressed, false});
-
-                        // Check for duplicate resources (unnecessary for DKCR)
-                        if (mGame != EGame::DKCReturns)
-                        {
-                            if (Type == "MREA")
-                            {
-                                mAreaDuplicateMap.insert_or_assign(ResID, AreaHasDuplicates);
-                                AreaHasDuplicates = false;
-                            }
-                            else if (!AreaHasDuplicates && PakResourceSet.find(ResID) != PakResourceSet.cend())
-                            {
-                                AreaHasDuplicates = true;
-                            }
-                            else
-                            {
-                                PakResourceSet.insert(ResID);
-                            }
-                        }
-                    }
-                }
+std::unique_ptr<CPackage> CGameExporter::AddPak(const TString& rkPakPath, const SPakContents& rkContents, std::vector<SResourceInstance*> *pOutNewResources)
+{
+    TString RelPakPath = FileUtil::MakeRelative(rkPakPath.GetFileDirectory(), mpProject->DiscFilesystemRoot(false));
+    auto pPackage = std::make_unique<CPackage>(mpProject.get(), rkPakPath.GetFileName(false), RelPakPath);
 
-                Pak.Seek(Next, SEEK_SET);
-            }
+    for (const SPakContents::SNamedResource& rkNamed : rkContents.NamedResources)
+        pPackage->AddResource(rkNamed.Name, rkNamed.ID, rkNamed.Type);
+
+    // Keep track of which areas have duplicate resources
+    std::set<CAssetID> PakResourceSet;
+    bool AreaHasDuplicates = true; // Default to true so that first area is always considered as having duplicates
+
+    for (const SResourceInstance& rkRes : rkContents.Resources)
+    {
+        const auto [It, Inserted] = mResourceMap.try_emplace(rkRes.ResourceID, rkRes);
+
+        if (Inserted && pOutNewResources != nullptr)
+            pOutNewResources->push_back(&It->second);
+
+        // Check for duplicate resources (unnecessary for DKCR)
+        if (mGame == EGame::DKCReturns)
+            continue;
+
+        if (rkRes.ResourceType == "MREA")
+        {
+            mAreaDuplicateMap.insert_or_assign(rkRes.ResourceID, AreaHasDuplicates);
+            AreaHasDuplicates = false;
+        }
+        else if (!AreaHasDuplicates && PakResourceSet.find(rkRes.ResourceID) != PakResourceSet.cend())
+        {
+            AreaHasDuplicates = true;
         }
+        else
+        {
+            PakResourceSet.insert(rkRes.ResourceID);
+        }
+    }
 
-        // Add package to project and save
+    // Save package definition
 #if SAVE_PACKAGE_DEFINITIONS
-        [[maybe_unused]] const bool SaveSuccess = pPackage->Save();
-        ASSERT(SaveSuccess);
+    [[maybe_unused]] const bool SaveSuccess = pPackage->Save();
+    ASSERT(SaveSuccess);
 #endif
 
-        mpProject->AddPackage(std::move(pPackage));
-    }
-#endif
+    return pPackage;
 }
 
 void CGameExporter::LoadResource(const SResourceInstance& rkResource, std::vector<uint8>& rBuffer)
@@ -444,92 +928,107 @@ void CGameExporter::LoadResource(const SResourceInstance& rkResource, std::vecto
     if (Pak.IsValid())
     {
         Pak.Seek(rkResource.PakOffset, SEEK_SET);
+        LoadResource(Pak, rkResource, rBuffer);
+    }
+}
 
-        // Handle compression
-        if (rkResource.Compressed)
-        {
-            bool ZlibCompressed = (mGame <= EGame::EchoesDemo || mGame == EGame::DKCReturns);
+void CGameExporter::LoadResource(IInputStream& rPak, const SResourceInstance& rkResource, std::vector<uint8>& rBuffer)
+{
+    // Reads the resource from the current position of the input stream. The stream may be
+    // the pak file itself or an in-memory copy of the resource's bytes.
 
-            if (mGame <= EGame::CorruptionProto)
-            {
-                std::vector<uint8> CompressedData(rkResource.PakSize);
+    // Handle compression
+    if (rkResource.Compressed)
+    {
+        bool ZlibCompressed = (mGame <= EGame::EchoesDemo || mGame == EGame::DKCReturns);
 
-                const uint32 UncompressedSize = Pak.ReadULong();
-                rBuffer.resize(UncompressedSize);
-                Pak.ReadBytes(CompressedData.data(), CompressedData.size());
+        if (mGame <= EGame::CorruptionProto)
+        {
+            std::vector<uint8> CompressedData(rkResource.PakSize);
 
-                if (ZlibCompressed)
-                {
-                    uint32 TotalOut;
-                    CompressionUtil::DecompressZlib(CompressedData.data(), CompressedData.size(), rBuffer.data(), rBuffer.size(), TotalOut);
-                }
-                else
-                {
-                    CompressionUtil::DecompressSegmentedData(CompressedData.data(), CompressedData.size(), rBuffer.data(), rBuffer.size());
-                }
-            }
+            const uint32 UncompressedSize = rPak.ReadULong();
+            rBuffer.resize(UncompressedSize);
+            rPak.ReadBytes(CompressedData.data(), CompressedData.size());
 
+            if (ZlibCompressed)
+            {
+                uint32 TotalOut;
+                CompressionUtil::DecompressZlib(CompressedData.data(), CompressedData.size(), rBuffer.data(), rBuffer.size(), TotalOut);
+            }
             else
             {
-                [[maybe_unused]] const CFourCC Magic = Pak.ReadULong();
-                ASSERT(Magic == "CMPD");
+                CompressionUtil::DecompressSegmentedData(CompressedData.data(), CompressedData.size(), rBuffer.data(), rBuffer.size());
+            }
+        }
 
-                const uint32 NumBlocks = Pak.ReadULong();
+        else
+        {
+            [[maybe_unused]] const CFourCC Magic = rPak.ReadULong();
+            ASSERT(Magic == "CMPD");
 
-                struct SCompressedBlock {
-                    uint32 CompressedSize;
-                    uint32 UncompressedSize;
-                };
-                std::vector<SCompressedBlock> CompressedBlocks;
+            const uint32 NumBlocks = rPak.ReadULong();
 
-                uint32 TotalUncompressedSize = 0;
-                for (uint32 iBlock = 0; iBlock < NumBlocks; iBlock++)
-                {
-                    const uint32 CompressedSize = (Pak.ReadULong() & 0x00FFFFFF);
-                    const uint32 UncompressedSize = Pak.ReadULong();
+            struct SCompressedBlock {
+                uint32 CompressedSize;
+                uint32 UncompressedSize;
+            };
+            std::vector<SCompressedBlock> CompressedBlocks;
 
-                    TotalUncompressedSize += UncompressedSize;
-                    CompressedBlocks.push_back(SCompressedBlock{CompressedSize, UncompressedSize});
-                }
+            uint32 TotalUncompressedSize = 0;
+            for (uint32 iBlock = 0; iBlock < NumBlocks; iBlock++)
+            {
+                const uint32 CompressedSize = (rPak.ReadULong() & 0x00FFFFFF);
+                const uint32 UncompressedSize = rPak.ReadULong();
 
-                rBuffer.resize(TotalUncompressedSize);
-                uint32 Offset = 0;
+                TotalUncompressedSize += UncompressedSize;
+                CompressedBlocks.push_back(SCompressedBlock{CompressedSize, UncompressedSize});
+            }
 
-                for (uint32 iBlock = 0; iBlock < NumBlocks; iBlock++)
-                {
-                    const uint32 CompressedSize = CompressedBlocks[iBlock].CompressedSize;
-                    const uint32 UncompressedSize = CompressedBlocks[iBlock].UncompressedSize;
+            rBuffer.resize(TotalUncompressedSize);
+            uint32 Offset = 0;
 
-                    // Block is compressed
-                    if (CompressedSize != UncompressedSize)
-                    {
-                        std::vector<uint8> CompressedData(CompressedBlocks[iBlock].CompressedSize);
-                        Pak.ReadBytes(CompressedData.data(), CompressedData.size());
-
-                        if (ZlibCompressed)
-                        {
-                            uint32 TotalOut;
-                            CompressionUtil::DecompressZlib(CompressedData.data(), CompressedData.size(), rBuffer.data() + Offset, UncompressedSize, TotalOut);
-                        }
-                        else
-                        {
-                            CompressionUtil::DecompressSegmentedData(CompressedData.data(), CompressedData.size(), rBuffer.data() + Offset, UncompressedSize);
-                        }
-                    }
-                    else // Block is uncompressed
-                    {
-                        Pak.ReadBytes(rBuffer.data() + Offset, UncompressedSize);
-                    }
+            // Read all the blocks, then decompress them in parallel
+            uint32 TotalCompressedSize = 0;
+
+            for (const SCompressedBlock& rkBlock : CompressedBlocks)
+            {
+                if (rkBlock.CompressedSize != rkBlock.UncompressedSize)
+                    TotalCompressedSize += rkBlock.CompressedSize;
+            }
 
-                    Offset += UncompressedSize;
+            std::vector<uint8> CompressedData(TotalCompressedSize);
+            std::vector<CompressionUtil::SDecompressBlock> DecompressBlocks;
+            uint32 CompressedOffset = 0;
+
+            for (uint32 iBlock = 0; iBlock < NumBlocks; iBlock++)
+            {
+                const uint32 CompressedSize = CompressedBlocks[iBlock].CompressedSize;
+                const uint32 UncompressedSize = CompressedBlocks[iBlock].UncompressedSize;
+
+                // Block is compressed
+                if (CompressedSize != UncompressedSize)
+                {
+                    uint8 *pCompressed = CompressedData.data() + CompressedOffset;
+                    rPak.ReadBytes(pCompressed, CompressedSize);
+                    DecompressBlocks.push_back(CompressionUtil::SDecompressBlock{pCompressed, CompressedSize, rBuffer.data() + Offset, UncompressedSize, !ZlibCompressed});
+                    CompressedOffset += CompressedSize;
                 }
+                else // Block is uncompressed
+                {
+                    rPak.ReadBytes(rBuffer.data() + Offset, UncompressedSize);
+                }
+
+                Offset += UncompressedSize;
             }
+
+            if (!CompressionUtil::DecompressBlocks(DecompressBlocks))
+                errorf("Failed to decompress resource %s", *rkResource.ResourceID.ToString());
         }
-        else // Handle uncompressed
-        {
-            rBuffer.resize(rkResource.PakSize);
-            Pak.ReadBytes(rBuffer.data(), rBuffer.size());
-        }
+    }
+    else // Handle uncompressed
+    {
+        rBuffer.resize(rkResource.PakSize);
+        rPak.ReadBytes(rBuffer.data(), rBuffer.size());
     }
 }
 
@@ -539,6 +1038,15 @@ void CGameExporter::ExportCookedResources()
     FileUtil::MakeDirectory(mResourcesDir);
 
     mpProgress->SetTask(eES_ExportCooked, "Unpacking cooked assets");
+
+    const uint32 NumJobs = (mNumJobs == 0 ? CThreadPool::DefaultNumThreads() : mNumJobs);
+
+    if (NumJobs > 1)
+    {
+        ExportCookedResourcesParallel();
+        return;
+    }
+
     int ResIndex = 0;
 
     for (auto It = mResourceMap.begin(); It != mResourceMap.end() && !mpProgress->ShouldCancel(); ++It, ResIndex++)
@@ -554,8 +1062,154 @@ void CGameExporter::ExportCookedResources()
     }
 }
 
+void CGameExporter::ExportCookedResourcesParallel()
+{
+    // Each pak is read front-to-back exactly once on this thread, and the decompression and file
+    // writes for each resource are handed off to the worker threads. Resources are registered with
+    // the store on this thread as their jobs are queued, since the store isn't thread-safe; that way
+    // a cancelled export doesn't leave behind entries that never got a cooked file.
+    struct SExportJob
+    {
+        SResourceInstance *pRes;
+        TString OutPath;
+        std::vector<uint8> PakData;
+    };
+    std::map<TString, std::vector<SExportJob>> PakJobs;
+
+    for (auto& [ID, rRes] : mResourceMap)
+    {
+        if (!rRes.Exported)
+            PakJobs[rRes.PakFile].push_back(SExportJob{&rRes, {}, {}});
+    }
+
+    // Bound the amount of pak data buffered in memory while waiting on the workers. The workers
+    // signal BufferCondition whenever they finish a job, which also wakes up progress reporting.
+    const uint32 NumResources = mResourceMap.size();
+    uint32 NumQueued = 0;
+    std::atomic<uint32> NumFinished{0};
+    std::mutex BufferMutex;
+    std::condition_variable BufferCondition;
+    uint64 BufferedBytes = 0;
+    std::set<TString> OutputDirs;
+
+    CThreadPool Pool(mNumJobs);
+
+    for (auto& [PakPath, rJobs] : PakJobs)
+    {
+        if (mpProgress->ShouldCancel())
+            break;
+
+        std::sort(rJobs.begin(), rJobs.end(), [](const SExportJob& rkLeft, const SExportJob& rkRight) {
+            return rkLeft.pRes->PakOffset < rkRight.pRes->PakOffset;
+        });
+
+        CFileInStream Pak(PakPath, EEndian::BigEndian);
+
+        if (!Pak.IsValid())
+        {
+            errorf("Couldn't open pak: %s", *PakPath);
+            continue;
+        }
+
+        const uint32 PakSize = Pak.Size();
+
+        for (SExportJob& rJob : rJobs)
+        {
+            if (mpProgress->ShouldCancel())
+                break;
+
+            const uint32 Finished = NumFinished.load();
+
+            if ((Finished & 0x3) == 0)
+                mpProgress->Report(Finished, NumResources, TString::Format("Unpacking asset %d/%d", Finished, NumResources));
+
+            // MP1/MP2 compressed resources are read with a trailing uncompressed size field on top of
+            // their listed size. Anything past the end of the pak is left zeroed, same as a file read.
+            const SResourceInstance& rkRes = *rJob.pRes;
+            const uint32 ReadSize = rkRes.PakSize + (rkRes.Compressed && mGame <= EGame::CorruptionProto ? 4 : 0);
+            const uint32 AvailableSize = (rkRes.PakOffset < PakSize ? Math::Min(ReadSize, PakSize - rkRes.PakOffset) : 0);
+
+            {
+                std::unique_lock Lock(BufferMutex);
+                BufferCondition.wait(Lock, [&]() { return BufferedBytes == 0 || BufferedBytes + ReadSize <= gkMaxBufferedPakBytes; });
+                BufferedBytes += ReadSize;
+            }
+
+            rJob.PakData.resize(ReadSize);
+            Pak.Seek(rkRes.PakOffset, SEEK_SET);
+            Pak.ReadBytes(rJob.PakData.data(), AvailableSize);
+
+            rJob.OutPath = RegisterResource(rkRes)->CookedAssetPath();
+            const TString OutDir = rJob.OutPath.GetFileDirectory();
+
+            if (OutputDirs.insert(OutDir).second)
+                FileUtil::MakeDirectory(OutDir);
+
+            Pool.AddTask([this, &rJob, &NumFinished, &BufferMutex, &BufferCondition, &BufferedBytes]()
+            {
+                const uint32 BufferSize = rJob.PakData.size();
+                UnpackResource(*rJob.pRes, rJob.OutPath, rJob.PakData);
+                rJob.pRes->Exported = true;
+
+                {
+                    std::lock_guard Lock(BufferMutex);
+                    BufferedBytes -= BufferSize;
+                    NumFinished++;
+                }
+                BufferCondition.notify_one();
+            });
+
+            NumQueued++;
+        }
+    }
+
+    // Keep the progress bar moving while the workers finish off the queued jobs. Every queued job
+    // runs even after a cancel, since its resource has already been registered with the store.
+    {
+        std::unique_lock Lock(BufferMutex);
+
+        while (NumFinished.load() < NumQueued)
+        {
+            const uint32 Finished = NumFinished.load();
+            Lock.unlock();
+            mpProgress->Report(Finished, NumResources, TString::Format("Unpacking asset %d/%d", Finished, NumResources));
+            Lock.lock();
+
+            BufferCondition.wait(Lock, [&]() { return NumFinished.load() != Finished; });
+        }
+    }
+
+    // Jobs reference the job lists above, so they must all finish before we return
+    Pool.WaitForTasks();
+}
+
+void CGameExporter::UnpackResource(const SResourceInstance& rkRes, const TString& rkOutPath, std::vector<uint8>& rPakData)
+{
+    // Decompresses a resource from a copy of its pak data and writes it to the cooked asset path. The pak
+    // data is freed once it's been decompressed. Doesn't touch the resource store, so it's safe to run on a worker thread.
+    std::vector<uint8> ResourceData;
+    {
+        CMemoryInStream PakData(rPakData.data(), rPakData.size(), EEndian::BigEndian);
+        LoadResource(PakData, rkRes, ResourceData);
+    }
+    std::vector<uint8>().swap(rPakData);
+
+#if EXPORT_COOKED
+    CFileOutStream Out(rkOutPath, EEndian::BigEndian);
+
+    if (Out.IsValid())
+        Out.WriteBytes(ResourceData.data(), ResourceData.size());
+    else
+        errorf("Failed to write cooked asset: %s", *rkOutPath);
+#endif
+}
+
 void CGameExporter::ExportResourceEditorData()
 {
+    // Commit the metadata of every resource in one go, rather than once per resource
+    CResourceMetadataStore *pMetaStore = mpStore->MetadataStore();
+    pMetaStore->BeginBatch();
+
     {
         // Save raw versions of resources + resource cache data files
         // Note this has to be done after all cooked resources are exported
@@ -565,49 +1219,91 @@ void CGameExporter::ExportResourceEditorData()
         mpProgress->SetTask(eES_GenerateRaw, "Generating editor data");
         int ResIndex = 0;
 
-        // todo: we're wasting a ton of time loading the same resources over and over because most resources automatically
-        // load all their dependencies and then we just clear it out from memory even though we'll need it again later. we
-        // should really be doing this by dependency order instead of by ID order.
-        for (CResourceIterator It(mpStore); It && !mpProgress->ShouldCancel(); ++It, ++ResIndex)
+        // Resources are visited in dependency order (dependencies before the resources that use them) so that
+        // a resource that gets loaded as a dependency is processed while it's still in memory. Recently used
+        // resources are kept loaded in a bounded cache so shared dependencies only need to be decoded once.
+        struct SPendingResource
         {
-            // Update progress
-            if ((ResIndex & 0x3) == 0 || It->ResourceType() == EResourceType::Area)
-            {
-                mpProgress->Report(ResIndex, mpStore->NumTotalResources(), TString::Format("Processing asset %u/%u: %s", ResIndex, mpStore->NumTotalResources(), *It->CookedAssetPath(true).GetFileName()));
-            }
+            CResourceEntry *pEntry;
+            TResPtr<CResource> pResource;
+            bool Expanded;
+        };
+        std::vector<SPendingResource> Stack;
+        std::set<CAssetID> VisitedResources;
+        CResourceCache Cache(mpStore, gkEditorDataCacheSize);
+
+        for (CResourceIterator It(mpStore); It && !mpProgress->ShouldCancel(); ++It)
+        {
+            if (!VisitedResources.insert(It->ID()).second)
+                continue;
 
-            // Worlds need some info we can only get from the pak at export time; namely, which areas can
-            // have duplicates, as well as the world's internal name.
-            if (It->ResourceType() == EResourceType::World)
+            Stack.push_back(SPendingResource{*It, nullptr, false});
+
+            while (!Stack.empty() && !mpProgress->ShouldCancel())
             {
-                auto* pWorld = static_cast<CWorld*>(It->Load());
+                SPendingResource& rPending = Stack.back();
+                CResourceEntry *pEntry = rPending.pEntry;
 
-                // Set area duplicate flags
-                for (size_t iArea = 0; iArea < pWorld->NumAreas(); iArea++)
+                // First visit - load the resource and queue up any dependencies that haven't been processed yet
+                if (!rPending.Expanded)
                 {
-                    const CAssetID AreaID = pWorld->AreaResourceID(iArea);
-                    const auto Find = mAreaDuplicateMap.find(AreaID);
+                    rPending.Expanded = true;
+                    CResTypeInfo *pTypeInfo = pEntry->TypeInfo();
+
+                    if (!pTypeInfo->CanBeSerialized() && !pTypeInfo->CanHaveDependencies())
+                        continue;
+
+                    rPending.pResource = Cache.Acquire(pEntry);
+                    pEntry->UpdateDependencies();
+
+                    std::set<CAssetID> Dependencies;
+                    pEntry->Dependencies()->GetAllResourceReferences(Dependencies);
+
+                    for (const CAssetID& rkID : Dependencies)
+                    {
+                        CResourceEntry *pDependency = mpStore->FindEntry(rkID);
+
+                        if (pDependency && VisitedResources.insert(rkID).second)
+                            Stack.push_back(SPendingResource{pDependency, nullptr, false});
+                    }
 
-                    if (Find != mAreaDuplicateMap.cend())
-                        pWorld->SetAreaAllowsPakDuplicates(iArea, Find->second);
+                    continue;
                 }
 
-                // Set world name
-                TString WorldName = MakeWorldName(pWorld->ID());
-                pWorld->SetName(std::move(WorldName));
-            }
+                // All dependencies are done, so process this resource now
+                // Update progress
+                if ((ResIndex & 0x3) == 0 || pEntry->ResourceType() == EResourceType::Area)
+                {
+                    mpProgress->Report(ResIndex, mpStore->NumTotalResources(), TString::Format("Processing asset %u/%u: %s", ResIndex, mpStore->NumTotalResources(), *pEntry->CookedAssetPath(true).GetFileName()));
+                }
 
-            // Save raw resource + generate dependencies
-            if (It->TypeInfo()->CanBeSerialized())
-                It->Save(true);
-            else
-                It->UpdateDependencies();
+                ExportResourceEditorData(pEntry);
+                ResIndex++;
 
-            // Set flags, save metadata
-            It->SaveMetadata(true);
+                // Areas and worlds are never loaded by other resources, so don't keep them around
+                const EResourceType Type = pEntry->ResourceType();
+                const bool ShouldUnload = (Type == EResourceType::Area || Type == EResourceType::World);
+
+                if (ShouldUnload)
+                    Cache.Remove(pEntry->ID());
+
+                Stack.pop_back();
+
+                if (ShouldUnload)
+                    Cache.CollectGarbage();
+            }
         }
+
+        Stack.clear();
+        Cache.Clear();
+
+        debugf("Editor data: %d resources processed, %u cache hits, %u cache misses, %u resources decoded, %u evictions",
+               ResIndex, Cache.NumHits(), Cache.NumMisses(), Cache.NumDecodes(), Cache.NumEvictions());
     }
 
+    [[maybe_unused]] const bool MetadataSaveSuccess = pMetaStore->EndBatch();
+    ASSERT(MetadataSaveSuccess);
+
     if (!mpProgress->ShouldCancel())
     {
         // All resources should have dependencies generated, so save the project files
@@ -621,6 +1317,39 @@ void CGameExporter::ExportResourceEditorData()
     }
 }
 
+void CGameExporter::ExportResourceEditorData(CResourceEntry *pEntry)
+{
+    // Worlds need some info we can only get from the pak at export time; namely, which areas can
+    // have duplicates, as well as the world's internal name.
+    if (pEntry->ResourceType() == EResourceType::World)
+    {
+        auto* pWorld = static_cast<CWorld*>(pEntry->Load());
+
+        // Set area duplicate flags
+        for (size_t iArea = 0; iArea < pWorld->NumAreas(); iArea++)
+        {
+            const CAssetID AreaID = pWorld->AreaResourceID(iArea);
+            const auto Find = mAreaDuplicateMap.find(AreaID);
+
+            if (Find != mAreaDuplicateMap.cend())
+                pWorld->SetAreaAllowsPakDuplicates(iArea, Find->second);
+        }
+
+        // Set world name
+        TString WorldName = MakeWorldName(pWorld->ID());
+        pWorld->SetName(std::move(WorldName));
+    }
+
+    // Save raw resource + generate dependencies
+    if (pEntry->TypeInfo()->CanBeSerialized())
+        pEntry->Save(true);
+    else if (!pEntry->Dependencies())
+        pEntry->UpdateDependencies();
+
+    // Set flags, save metadata
+    pEntry->SaveMetadata(true);
+}
+
 void CGameExporter::ExportResource(SResourceInstance& rRes)
 {
     if (!rRes.Exported)
@@ -629,24 +1358,7 @@ void CGameExporter::ExportResource(SResourceInstance& rRes)
         LoadResource(rRes, ResourceData);
 
         // Register resource and write to file
-        TString Directory, Name;
-        bool AutoDir, AutoName;
-
-#if USE_ASSET_NAME_MAP
-        mpNameMap->GetNameInfo(rRes.ResourceID, Directory, Name, AutoDir, AutoName);
-#else
-        Directory = mpStore->DefaultAssetDirectoryPath(mpStore->Game());
-        Name = rRes.ResourceID.ToString();
-#endif
-
-        CResourceEntry *pEntry = mpStore->CreateNewResource(rRes.ResourceID,
-                                                            CResTypeInfo::TypeForCookedExtension(mGame, rRes.ResourceType)->Type(),
-                                                            Directory, Name, true);
-
-        // Set flags
-        pEntry->SetFlag(EResEntryFlag::IsBaseGameResource);
-        pEntry->SetFlagEnabled(EResEntryFlag::AutoResDir, AutoDir);
-        pEntry->SetFlagEnabled(EResEntryFlag::AutoResName, AutoName);
+        CResourceEntry *pEntry = RegisterResource(rRes);
 
 #if EXPORT_COOKED
         // Save cooked asset
@@ -664,6 +1376,29 @@ void CGameExporter::ExportResource(SResourceInstance& rRes)
     }
 }
 
+CResourceEntry* CGameExporter::RegisterResource(const SResourceInstance& rkRes)
+{
+    TString Directory, Name;
+    bool AutoDir, AutoName;
+
+#if USE_ASSET_NAME_MAP
+    mpNameMap->GetNameInfo(rkRes.ResourceID, Directory, Name, AutoDir, AutoName);
+#else
+    Directory = mpStore->DefaultAssetDirectoryPath(mpStore->Game());
+    Name = rkRes.ResourceID.ToString();
+#endif
+
+    CResourceEntry *pEntry = mpStore->CreateNewResource(rkRes.ResourceID,
+                                                        CResTypeInfo::TypeForCookedExtension(mGame, rkRes.ResourceType)->Type(),
+                                                        Directory, Name, true);
+
+    // Set flags
+    pEntry->SetFlag(EResEntryFlag::IsBaseGameResource);
+    pEntry->SetFlagEnabled(EResEntryFlag::AutoResDir, AutoDir);
+    pEntry->SetFlagEnabled(EResEntryFlag::AutoResName, AutoName);
+    return pEntry;
+}
+
 TString CGameExporter::MakeWorldName(CAssetID WorldID)
 {
     [[maybe_unused]] const CResourceEntry *pWorldEntry = mpStore->FindEntry(WorldID);
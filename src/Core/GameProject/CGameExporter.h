@@ -6,10 +6,12 @@
 #include "CGameProject.h"
 #include "CResourceStore.h"
 #include <Common/CAssetID.h>
+#include <Common/FileIO.h>
 #include <Common/Flags.h>
 #include <Common/TString.h>
 #include <map>
 #include <memory>
+#include <vector>
 #include <nod/DiscBase.hpp>
 
 enum class EDiscType
@@ -19,6 +21,16 @@ enum class EDiscType
     Trilogy
 };
 
+/** Identification info read from a disc header */
+struct SDiscInfo
+{
+    TString GameTitle;
+    TString GameID;
+    EDiscType DiscType{EDiscType::Normal};
+    EGame Game{EGame::Invalid};
+    ERegion Region{ERegion::Unknown};
+};
+
 class CGameExporter
 {
     // Project Data
@@ -64,6 +76,26 @@ class CGameExporter
     // Progress
     IProgressNotifier *mpProgress = nullptr;
 
+    // Worker threads used to unpack cooked assets; 0 uses every core, 1 uses the serial path
+    uint32 mNumJobs = 0;
+
+    // Unpack paks while they're extracted from the disc, rather than reading them back from disk afterwards
+    bool mStreamPaks = true;
+    std::map<TString, std::unique_ptr<CPackage>> mStreamedPackages;
+
+    struct SPakContents
+    {
+        struct SNamedResource
+        {
+            TString Name;
+            CAssetID ID;
+            CFourCC Type;
+        };
+        std::vector<SNamedResource> NamedResources;
+        std::vector<SResourceInstance> Resources;
+    };
+    struct SPakStreamContext;
+
 public:
     enum EExportStep
     {
@@ -79,16 +111,35 @@ public:
     void LoadResource(const CAssetID& rkID, std::vector<uint8>& rBuffer);
     bool ShouldExportDiscNode(const nod::Node *pkNode, bool IsInRoot) const;
 
+    /** Identify the game on a disc. For Trilogy discs the game is left invalid, as the caller needs to pick one. */
+    static bool IdentifyDisc(nod::DiscBase *pDisc, SDiscInfo& rOutInfo);
+    static float FindBuildVersion(nod::DiscBase *pDisc, EGame Game);
+
     TString ProjectPath() const  { return mProjectPath; }
+    uint32 NumJobs() const       { return mNumJobs; }
+    bool StreamPaks() const      { return mStreamPaks; }
+
+    void SetNumJobs(uint32 NumJobs)  { mNumJobs = NumJobs; }
+    void SetStreamPaks(bool Stream)  { mStreamPaks = Stream; }
 
 protected:
     bool ExtractDiscData();
-    bool ExtractDiscNodeRecursive(const nod::Node *pkNode, const TString& rkDir, bool RootNode, const nod::ExtractionContext& rkContext);
+    bool ExtractDiscNodeRecursive(const nod::Node *pkNode, const TString& rkDir, bool RootNode, const nod::ExtractionContext& rkContext, SPakStreamContext *pStreamContext);
+    bool IsTrackedPak(const nod::Node *pkDir, const TString& rkFilePath) const;
+    bool ReadStreamedPakHeaders(const nod::Node *pkRoot, const TString& rkFilesDir, SPakStreamContext& rContext);
+    bool StreamPak(const nod::Node& rkNode, const TString& rkPakPath, SPakStreamContext& rContext);
     void LoadPaks();
+    void ReadPakHeader(IInputStream& rPak, const TString& rkPakPath, SPakContents& rOut) const;
+    std::unique_ptr<CPackage> AddPak(const TString& rkPakPath, const SPakContents& rkContents, std::vector<SResourceInstance*> *pOutNewResources);
     void LoadResource(const SResourceInstance& rkResource, std::vector<uint8>& rBuffer);
+    void LoadResource(IInputStream& rPak, const SResourceInstance& rkResource, std::vector<uint8>& rBuffer);
     void ExportCookedResources();
+    void ExportCookedResourcesParallel();
+    void UnpackResource(const SResourceInstance& rkRes, const TString& rkOutPath, std::vector<uint8>& rPakData);
     void ExportResourceEditorData();
+    void ExportResourceEditorData(CResourceEntry *pEntry);
     void ExportResource(SResourceInstance& rRes);
+    CResourceEntry* RegisterResource(const SResourceInstance& rkRes);
     TString MakeWorldName(CAssetID WorldID);
 
     // Convenience Functions
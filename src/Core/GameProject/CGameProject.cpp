@@ -1,17 +1,76 @@
 #include "CGameProject.h"
 #include "CResourceIterator.h"
 #include "IUIRelay.h"
+#include "Core/CThreadPool.h"
 #include "Core/Resource/Script/CGameTemplate.h"
+#include <Common/CScopedTimer.h>
 #include <Common/Serialization/XML.h>
 #include <nod/DiscGCN.hpp>
 #include <nod/DiscWii.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
 #if NOD_UCS2
 #define TStringToNodString(string) ToWChar(string)
 #else
 #define TStringToNodString(string) *string
 #endif
 
+// State shared between CookPackages and its pak writer threads. Writers signal Changed whenever they make
+// progress or finish a pak; the owning thread wakes up on that to report progress and check for cancellation.
+struct SPakWriteState
+{
+    std::mutex Mutex;
+    std::condition_variable Changed;
+    bool ProgressChanged = false;
+    size_t NumWritten = 0;
+    std::atomic<bool> Cancel{false};
+
+    void Notify(bool Finished)
+    {
+        {
+            std::lock_guard Lock(Mutex);
+            ProgressChanged = true;
+            if (Finished) NumWritten++;
+        }
+        Changed.notify_one();
+    }
+};
+
+// Progress notifier handed to packages that are being written on another thread. IProgressNotifier
+// isn't thread-safe, so this records the latest progress value for the owning thread to forward, and
+// only reports a cancel once the owning thread has seen one on the real notifier.
+class CPackageWriteNotifier : public IProgressNotifier
+{
+    SPakWriteState *mpState;
+    std::atomic<float> mProgress{0.f};
+
+public:
+    explicit CPackageWriteNotifier(SPakWriteState *pState)
+        : mpState(pState)
+    {}
+
+    bool ShouldCancel() const override  { return mpState->Cancel.load(); }
+    float Progress() const              { return mProgress.load(); }
+
+    void SetFinished()
+    {
+        mProgress = 1.f;
+        mpState->Notify(true);
+    }
+
+protected:
+    void UpdateProgress(const TString&, const TString&, float ProgressPercent) override
+    {
+        mProgress = ProgressPercent;
+        mpState->Notify(false);
+    }
+};
+
 CGameProject::~CGameProject()
 {
     if (!mpResourceStore)
@@ -39,7 +98,9 @@ bool CGameProject::Serialize(IArchive& rArc)
     rArc << SerialParameter("Name", mProjectName)
          << SerialParameter("Region", mRegion)
          << SerialParameter("GameID", mGameID)
-         << SerialParameter("BuildVersion", mBuildVersion);
+         << SerialParameter("BuildVersion", mBuildVersion)
+         << SerialParameter("RawAssetFormat", mRawAssetFormat, SH_Optional, ERawAssetFormat::XML)
+         << SerialParameter("RawFilesFormat", mRawFilesFormat, SH_Optional, ERawAssetFormat::XML);
 
     // Serialize package list
     std::vector<TString> PackageList;
@@ -120,6 +181,100 @@ bool CGameProject::MergeISO(const TString& rkIsoPath, nod::DiscWii *pOriginalIso
     return Merger.mergeFromDirectory(TStringToNodString(DiscRoot)) == nod::EBuildResult::Success;
 }
 
+bool CGameProject::CookPackages(const std::vector<CPackage*>& rkPackages, IProgressNotifier *pProgress)
+{
+    SCOPED_TIMER(CookPackages);
+    const size_t NumPackages = rkPackages.size();
+    pProgress->SetNumTasks(2);
+
+    // Recooking assets touches the resource store, so this is done one package at a time on this thread.
+    std::vector<std::vector<CResourceEntry*>> PackageAssets(NumPackages);
+
+    for (size_t PkgIdx = 0; PkgIdx < NumPackages && !pProgress->ShouldCancel(); PkgIdx++)
+    {
+        CPackage *pPkg = rkPackages[PkgIdx];
+        pProgress->SetTask(0, "Cooking assets for " + pPkg->Name() + ".pak...");
+        pPkg->PrepareForCook(PackageAssets[PkgIdx], pProgress);
+    }
+
+    if (pProgress->ShouldCancel())
+    {
+        mpResourceStore->ConditionalSaveStore();
+        return false;
+    }
+
+    // Once every asset list is ready, the paks themselves can be written concurrently.
+    // Writer threads report to their own notifiers; this thread forwards the combined progress.
+    pProgress->SetTask(1, "Writing packages...");
+
+    SPakWriteState State;
+    std::vector<std::unique_ptr<CPackageWriteNotifier>> Notifiers;
+    Notifiers.reserve(NumPackages);
+
+    for (size_t PkgIdx = 0; PkgIdx < NumPackages; PkgIdx++)
+        Notifiers.push_back(std::make_unique<CPackageWriteNotifier>(&State));
+
+    std::atomic<size_t> NextPackage{0};
+
+    const auto WriterMain = [&]()
+    {
+        size_t PkgIdx;
+
+        while ((PkgIdx = NextPackage.fetch_add(1)) < NumPackages)
+        {
+            if (!State.Cancel.load())
+                rkPackages[PkgIdx]->WritePak(PackageAssets[PkgIdx], Notifiers[PkgIdx].get());
+
+            Notifiers[PkgIdx]->SetFinished();
+        }
+    };
+
+    std::vector<std::thread> Writers;
+    // Each writer compresses its assets on the shared pool, so half the pool's threads keeps it busy without
+    // loading too many paks' assets at once. A single-threaded pool writes one pak at a time.
+    const size_t PoolThreads = CThreadPool::Shared()->NumThreads();
+    const size_t NumWriters = std::max<size_t>(1, std::min(PoolThreads / 2, NumPackages));
+
+    for (size_t WriterIdx = 0; WriterIdx < NumWriters; WriterIdx++)
+        Writers.emplace_back(WriterMain);
+
+    // The parent notifier is only ever touched from this thread
+    std::unique_lock Lock(State.Mutex);
+
+    while (State.NumWritten < NumPackages)
+    {
+        State.Changed.wait(Lock, [&]() { return State.ProgressChanged; });
+        State.ProgressChanged = false;
+        const size_t Written = State.NumWritten;
+        Lock.unlock();
+
+        float TotalProgress = 0.f;
+        for (const auto& pNotifier : Notifiers)
+            TotalProgress += pNotifier->Progress();
+
+        pProgress->Report(static_cast<int>(TotalProgress * 10000), static_cast<int>(NumPackages * 10000),
+                          TString::Format("Written %d/%d packages", static_cast<int>(Written), static_cast<int>(NumPackages)));
+
+        if (pProgress->ShouldCancel())
+            State.Cancel = true;
+
+        Lock.lock();
+    }
+
+    Lock.unlock();
+
+    for (auto& Writer : Writers)
+        Writer.join();
+
+    // Update resource store in case we recooked any assets
+    mpResourceStore->ConditionalSaveStore();
+
+    if (mpCompressionCache)
+        mpCompressionCache->SaveIndex();
+
+    return !State.Cancel.load() && !pProgress->ShouldCancel();
+}
+
 void CGameProject::GetWorldList(std::list<CAssetID>& rOut) const
 {
     for (const auto& pPkg : mPackages)
@@ -175,6 +330,15 @@ CPackage* CGameProject::FindPackage(std::string_view name) const
     return iter->get();
 }
 
+void CGameProject::SetRawAssetFormat(ERawAssetFormat Format)
+{
+    if (mRawAssetFormat == Format && mRawFilesFormat == Format)
+        return;
+
+    mRawAssetFormat = Format;
+    ConvertRawAssets();
+}
+
 std::unique_ptr<CGameProject> CGameProject::CreateProjectForExport(
         const TString& rkProjRootDir,
         EGame Game,
@@ -298,7 +462,42 @@ std::unique_ptr<CGameProject> CGameProject::LoadProject(const TString& rkProjPat
         FileUtil::MarkHidden(HiddenDir, true);
     }
 
+    // RawAssetFormat may have been changed by editing the project file, so bring the raw files in line with it
+    if (pProj->mRawFilesFormat != pProj->mRawAssetFormat)
+    {
+        pProgress->Report("Converting raw assets");
+        pProj->ConvertRawAssets();
+    }
+
+    pProj->mpCompressionCache = std::make_unique<CCompressionCache>(pProj->CompressionCacheDir());
     pProj->mpAudioManager->LoadAssets();
     pProj->mpTweakManager->LoadTweaks();
     return pProj;
 }
+
+// ************ PRIVATE ************
+void CGameProject::ConvertRawAssets()
+{
+    // Re-save existing raw files in the current format so the project doesn't end up with a mix of formats
+    CResourceStore *pOldStore = gpResourceStore;
+    gpResourceStore = mpResourceStore.get();
+
+    for (CResourceIterator It(mpResourceStore.get()); It; ++It)
+    {
+        if (It->TypeInfo()->CanBeSerialized() && It->HasRawVersion())
+        {
+            const bool WasUpToDate = !It->NeedsRecook();
+            It->Save(true, false);
+
+            // The data hasn't changed, so keep the cooked file from looking outdated
+            if (WasUpToDate)
+                FileUtil::UpdateLastModifiedTime(It->CookedAssetPath());
+        }
+    }
+
+    mRawFilesFormat = mRawAssetFormat;
+    mpResourceStore->ConditionalSaveStore();
+    Save();
+
+    gpResourceStore = pOldStore;
+}
@@ -1,6 +1,7 @@
 #ifndef CGAMEPROJECT_H
 #define CGAMEPROJECT_H
 
+#include "CCompressionCache.h"
 #include "CGameInfo.h"
 #include "CPackage.h"
 #include "CResourceStore.h"
@@ -28,6 +29,13 @@ enum class EProjectVersion
     Current = Max - 1
 };
 
+/** On-disk format used for raw resources (.rsraw). Existing files are readable in either format. */
+enum class ERawAssetFormat
+{
+    XML,
+    Binary
+};
+
 class CGameProject
 {
     TString mProjectName{"Unnamed Project"};
@@ -35,6 +43,8 @@ class CGameProject
     ERegion mRegion{ERegion::Unknown};
     TString mGameID{"000000"};
     float mBuildVersion = 0.f;
+    ERawAssetFormat mRawAssetFormat{ERawAssetFormat::XML};
+    ERawAssetFormat mRawFilesFormat{ERawAssetFormat::XML}; // Format the existing raw files were last written in
 
     TString mProjectRoot;
     std::vector<std::unique_ptr<CPackage>> mPackages;
@@ -42,6 +52,7 @@ class CGameProject
     std::unique_ptr<CGameInfo> mpGameInfo = std::make_unique<CGameInfo>();
     std::unique_ptr<CAudioManager> mpAudioManager = std::make_unique<CAudioManager>(this);
     std::unique_ptr<CTweakManager> mpTweakManager = std::make_unique<CTweakManager>(this);
+    std::unique_ptr<CCompressionCache> mpCompressionCache;
 
     // Keep file handle open for the .prj file to prevent users from opening the same project
     // in multiple instances of PWE
@@ -50,6 +61,8 @@ class CGameProject
     // Private Constructor
     CGameProject() = default;
 
+    void ConvertRawAssets();
+
 public:
     ~CGameProject();
 
@@ -57,9 +70,11 @@ public:
     bool Serialize(IArchive& rArc);
     bool BuildISO(const TString& rkIsoPath, IProgressNotifier *pProgress);
     bool MergeISO(const TString& rkIsoPath, nod::DiscWii *pOriginalIso, IProgressNotifier *pProgress);
+    bool CookPackages(const std::vector<CPackage*>& rkPackages, IProgressNotifier *pProgress);
     void GetWorldList(std::list<CAssetID>& rOut) const;
     CAssetID FindNamedResource(std::string_view name) const;
     CPackage* FindPackage(std::string_view name) const;
+    void SetRawAssetFormat(ERawAssetFormat Format);
 
     // Static
     static std::unique_ptr<CGameProject> CreateProjectForExport(
@@ -76,6 +91,7 @@ public:
     TString ProjectRoot() const                      { return mProjectRoot; }
     TString ProjectPath() const                      { return mProjectRoot + FileUtil::SanitizeName(mProjectName, false) + ".prj"; }
     TString HiddenFilesDir() const                   { return mProjectRoot + ".project/"; }
+    TString CompressionCacheDir() const              { return HiddenFilesDir() + "CompressionCache/"; }
     TString DiscDir(bool Relative) const             { return Relative ? "Disc/" : mProjectRoot + "Disc/"; }
     TString PackagesDir(bool Relative) const         { return Relative ? "Packages/" : mProjectRoot + "Packages/"; }
     TString ResourcesDir(bool Relative) const        { return Relative ? "Resources/" : mProjectRoot + "Resources/"; }
@@ -94,10 +110,12 @@ public:
     CGameInfo* GameInfo() const                          { return mpGameInfo.get(); }
     CAudioManager* AudioManager() const                  { return mpAudioManager.get(); }
     CTweakManager* TweakManager() const                  { return mpTweakManager.get(); }
+    CCompressionCache* CompressionCache() const          { return mpCompressionCache.get(); }
     EGame Game() const                                   { return mGame; }
     ERegion Region() const                               { return mRegion; }
     TString GameID() const                               { return mGameID; }
     float BuildVersion() const                           { return mBuildVersion; }
+    ERawAssetFormat RawAssetFormat() const               { return mRawAssetFormat; }
     bool IsWiiBuild() const                              { return mBuildVersion >= 3.f; }
     bool IsTrilogy() const                               { return mGame <= EGame::Corruption && mBuildVersion >= 3.593f; }
     bool IsWiiDeAsobu() const                            { return mGame <= EGame::Corruption && mBuildVersion >= 3.570f && mBuildVersion < 3.593f; }
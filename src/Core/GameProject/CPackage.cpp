@@ -2,11 +2,22 @@
 #include "DependencyListBuilders.h"
 #include "CGameProject.h"
 #include "Core/CompressionUtil.h"
+#include "Core/CThreadPool.h"
 #include "Core/Resource/Cooker/CWorldCooker.h"
 #include <Common/Macros.h>
 #include <Common/FileIO.h>
 #include <Common/FileUtil.h>
+#include <Common/Hash/CFNV1A.h>
 #include <Common/Serialization/XML.h>
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
 
 using namespace tinyxml2;
 
@@ -38,6 +49,9 @@ bool CPackage::Save()
 void CPackage::Serialize(IArchive& rArc)
 {
     rArc << SerialParameter("NeedsRecook", mNeedsRecook)
+         << SerialParameter("CookedPakSize", mCookedPakSize, SH_Optional, static_cast<uint64>(0))
+         << SerialParameter("CookedTableHash", mCookedTableHash, SH_Optional, static_cast<uint64>(0))
+         << SerialParameter("CookedAssetHashes", mCookedAssetHashes, SH_Optional)
          << SerialParameter("NamedResources", mResources);
 }
 
@@ -70,11 +84,217 @@ void CPackage::MarkDirty()
     }
 }
 
+// Resource data as it will be written to the pak, minus the compression header and padding
+struct SPakAssetData
+{
+    std::vector<uint8> Data;
+    uint32 UncompressedSize = 0;
+    bool Compressed = false;
+    uint64 ContentHash = 0;    // Hash of the cooked file, used to tell whether the asset has changed since it was written
+};
+
+static uint64 HashCookedAsset(const std::vector<uint8>& rkData)
+{
+    CFNV1A Hash(CFNV1A::EHashLength::k64Bit);
+    Hash.HashData(rkData.data(), rkData.size());
+    return Hash.GetHash64();
+}
+
+static bool ShouldCompressAsset(EGame Game, EResourceType Type, uint32 ResourceSize)
+{
+    // Check if this asset should be compressed; there are a few resource types that are
+    // always compressed, and some types that are compressed if they're over a certain size
+    const uint32 CompressThreshold = (Game <= EGame::CorruptionProto ? 0x400 : 0x80);
+
+    bool ShouldAlwaysCompress = (Type == EResourceType::Texture || Type == EResourceType::Model ||
+                                 Type == EResourceType::Skin || Type == EResourceType::AnimSet ||
+                                 Type == EResourceType::Animation || Type == EResourceType::Font);
+
+    if (Game >= EGame::Corruption)
+    {
+        ShouldAlwaysCompress = ShouldAlwaysCompress ||
+                               (Type == EResourceType::Character || Type == EResourceType::SourceAnimData ||
+                                Type == EResourceType::Scan || Type == EResourceType::AudioSample ||
+                                Type == EResourceType::StringTable || Type == EResourceType::AudioAmplitudeData ||
+                                Type == EResourceType::DynamicCollision);
+    }
+
+    const bool ShouldCompressConditional = !ShouldAlwaysCompress &&
+                                           (Type == EResourceType::Particle || Type == EResourceType::ParticleElectric ||
+                                            Type == EResourceType::ParticleSwoosh || Type == EResourceType::ParticleWeapon ||
+                                            Type == EResourceType::ParticleDecal || Type == EResourceType::ParticleCollisionResponse ||
+                                            Type == EResourceType::ParticleSpawn || Type == EResourceType::ParticleSorted ||
+                                            Type == EResourceType::BurstFireData);
+
+    return ShouldAlwaysCompress || (ShouldCompressConditional && ResourceSize >= CompressThreshold);
+}
+
+// Reads a cooked asset and compresses it if needed. Doesn't touch the resource store, so it's safe to run on a worker thread.
+static SPakAssetData LoadPakAssetData(EGame Game, EResourceType Type, const TString& rkCookedPath, CCompressionCache *pCache)
+{
+    SPakAssetData Out;
+
+    // Load resource data
+    CFileInStream CookedAsset(rkCookedPath, EEndian::BigEndian);
+    ASSERT(CookedAsset.IsValid());
+    const uint32 ResourceSize = CookedAsset.Size();
+
+    std::vector<uint8> ResourceData(ResourceSize);
+    CookedAsset.ReadBytes(ResourceData.data(), ResourceData.size());
+    Out.UncompressedSize = ResourceSize;
+    Out.ContentHash = HashCookedAsset(ResourceData);
+
+    if (ShouldCompressAsset(Game, Type, ResourceSize))
+    {
+        const bool IsZlib = (Game <= EGame::EchoesDemo || Game == EGame::DKCReturns);
+        const ECompressionCodec Codec = (IsZlib ? ECompressionCodec::Zlib : ECompressionCodec::LZOSegmented);
+        CCompressionCache::SKey CacheKey;
+
+        // Check whether we've compressed this exact data before
+        if (pCache != nullptr)
+        {
+            CacheKey = CCompressionCache::MakeKey(ResourceData.data(), ResourceSize, Game, Codec);
+            std::vector<uint8> CachedData;
+            bool CachedCompressed = false;
+
+            if (pCache->Lookup(CacheKey, CachedData, CachedCompressed))
+            {
+                Out.Data = (CachedCompressed ? std::move(CachedData) : std::move(ResourceData));
+                Out.Compressed = CachedCompressed;
+                return Out;
+            }
+        }
+
+        uint32 CompressedSize;
+        const uint32 MaxSize = (IsZlib ? CompressionUtil::MaxCompressedSize(ResourceSize, true)
+                                       : CompressionUtil::MaxSegmentedCompressedSize(ResourceSize, false));
+        std::vector<uint8> CompressedData(MaxSize);
+        bool Success = false;
+
+        if (IsZlib)
+            Success = CompressionUtil::CompressZlib(ResourceData.data(), ResourceData.size(), CompressedData.data(), CompressedData.size(), CompressedSize);
+        else
+            Success = CompressionUtil::CompressLZOSegmented(ResourceData.data(), ResourceData.size(), CompressedData.data(), CompressedSize, false);
+
+        // Make sure that the compressed data is actually smaller, accounting for padding + uncompressed size value
+        if (Success)
+        {
+            const uint32 AlignmentMinusOne = (Game <= EGame::CorruptionProto ? 0x20 : 0x40) - 1;
+            const uint32 CompressionHeaderSize = (Game <= EGame::CorruptionProto ? 4 : 0x10);
+            const uint32 PaddedUncompressedSize = (ResourceSize + AlignmentMinusOne) & ~AlignmentMinusOne;
+            const uint32 PaddedCompressedSize = (CompressedSize + CompressionHeaderSize + AlignmentMinusOne) & ~AlignmentMinusOne;
+            Success = (PaddedCompressedSize < PaddedUncompressedSize);
+            CompressedData.resize(CompressedSize);
+
+            if (pCache != nullptr)
+                pCache->Store(CacheKey, CompressedData, Success);
+        }
+
+        if (Success)
+        {
+            Out.Data = std::move(CompressedData);
+            Out.Compressed = true;
+            return Out;
+        }
+    }
+
+    Out.Data = std::move(ResourceData);
+    return Out;
+}
+
+// Writes an asset to the pak as it's laid out in the resource data; the output must start on an aligned offset
+static void WritePakAsset(IOutputStream& rOut, EGame Game, const SPakAssetData& rkData, uint32 Alignment)
+{
+    if (rkData.Compressed)
+    {
+        // Write MP1/2 compressed asset
+        if (Game <= EGame::CorruptionProto)
+        {
+            rOut.WriteULong(rkData.UncompressedSize);
+        }
+        // Write MP3/DKCR compressed asset
+        else
+        {
+            // Note: Compressed asset data can be stored in multiple blocks. Normally, the only assets that make use of this are textures,
+            // which can store each separate component of the file (header, palette, image data) in separate blocks. However, some textures
+            // are stored in one block, and I've had no luck figuring out why. The game doesn't generally seem to care whether textures use
+            // multiple blocks or not, so for the sake of simplicity we compress everything to one block.
+            rOut.WriteFourCC( FOURCC('CMPD') );
+            rOut.WriteLong(1);
+            rOut.WriteULong(0xA0000000 | static_cast<uint32>(rkData.Data.size()));
+            rOut.WriteULong(rkData.UncompressedSize);
+        }
+    }
+
+    rOut.WriteBytes(rkData.Data.data(), rkData.Data.size());
+    rOut.WriteToBoundary(Alignment, 0xFF);
+}
+
+// Writes the entries of a pak's resource table, minus the resource count in front of them
+static std::vector<char> BuildResourceTable(const std::vector<SPakLayout::SResource>& rkResources)
+{
+    std::vector<char> TableData;
+    CVectorOutStream TableStream(&TableData, EEndian::BigEndian);
+
+    for (const SPakLayout::SResource& rkRes : rkResources)
+    {
+        TableStream.WriteLong(rkRes.Compressed ? 1 : 0);
+        rkRes.Type.Write(TableStream);
+        rkRes.ID.Write(TableStream);
+        TableStream.WriteULong(rkRes.Size);
+        TableStream.WriteULong(rkRes.Offset);
+    }
+
+    return TableData;
+}
+
+static uint64 HashResourceTable(const std::vector<char>& rkTableData)
+{
+    CFNV1A Hash(CFNV1A::EHashLength::k64Bit);
+    Hash.HashData(rkTableData.data(), rkTableData.size());
+    return Hash.GetHash64();
+}
+
+// Writes data over an existing part of a file opened for update
+static bool WriteFileAt(FILE *pFile, uint32 Offset, const std::vector<char>& rkData)
+{
+    return std::fseek(pFile, static_cast<long>(Offset), SEEK_SET) == 0 &&
+           std::fwrite(rkData.data(), 1, rkData.size(), pFile) == rkData.size();
+}
+
+// Flushes a file and waits for the data to reach the disk
+static bool SyncFile(FILE *pFile)
+{
+    if (std::fflush(pFile) != 0)
+        return false;
+
+#ifdef _WIN32
+    return _commit(_fileno(pFile)) == 0;
+#else
+    return fsync(fileno(pFile)) == 0;
+#endif
+}
+
 void CPackage::Cook(IProgressNotifier *pProgress)
 {
     SCOPED_TIMER(CookPackage);
 
-    // Build asset list
+    std::vector<CResourceEntry*> Assets;
+
+    if (PrepareForCook(Assets, pProgress))
+        WritePak(Assets, pProgress);
+
+    // Update resource store in case we recooked any assets
+    mpProject->ResourceStore()->ConditionalSaveStore();
+
+    if (CCompressionCache *pCache = mpProject->CompressionCache())
+        pCache->SaveIndex();
+}
+
+bool CPackage::PrepareForCook(std::vector<CResourceEntry*>& rOutAssets, IProgressNotifier *pProgress)
+{
+    // Builds the asset list and recooks any dirty assets. This accesses the resource store,
+    // so unlike WritePak, it must be run on the thread that owns the project.
     pProgress->Report(-1, -1, "Building dependency list");
 
     CPackageDependencyListBuilder Builder(this);
@@ -82,19 +302,65 @@ void CPackage::Cook(IProgressNotifier *pProgress)
     Builder.BuildDependencyList(true, AssetList);
     debugf("%d assets in %s.pak", AssetList.size(), *Name());
 
-    // Write new pak
+    rOutAssets.clear();
+    rOutAssets.reserve(AssetList.size());
+    uint32 ResIdx = 0;
+
+    for (auto Iter = AssetList.begin(); Iter != AssetList.end() && !pProgress->ShouldCancel(); Iter++, ResIdx++)
+    {
+        CResourceEntry *pEntry = gpResourceStore->FindEntry(*Iter);
+        ASSERT(pEntry != nullptr);
+
+        if (pEntry->NeedsRecook())
+        {
+            pProgress->Report(ResIdx, AssetList.size(), "Cooking asset: " + pEntry->Name() + "." + pEntry->CookedExtension());
+            pEntry->Cook();
+        }
+
+        rOutAssets.push_back(pEntry);
+    }
+
+    if (pProgress->ShouldCancel())
+    {
+        mNeedsRecook = true;
+        Save();
+        return false;
+    }
+
+    return true;
+}
+
+bool CPackage::WritePak(const std::vector<CResourceEntry*>& rkAssets, IProgressNotifier *pProgress, bool AllowPatch)
+{
+    // Writes out the pak for an asset list built by PrepareForCook. Only reads from resource entries,
+    // so several packages can be written at once. Asset compression runs on the shared thread pool
+    // while this thread writes the results to the pak in order.
+    if (AllowPatch && PatchPak(rkAssets, pProgress))
+    {
+        mNeedsRecook = false;
+        Save();
+        return true;
+    }
+
+    // A cancelled patch leaves the existing pak as it was
+    if (pProgress->ShouldCancel())
+    {
+        mNeedsRecook = true;
+        Save();
+        return false;
+    }
+
     const TString PakPath = CookedPackagePath(false);
     CFileOutStream Pak(PakPath, EEndian::BigEndian);
 
     if (!Pak.IsValid())
     {
         errorf("Couldn't cook package %s; unable to open package for writing", *CookedPackagePath(true));
-        return;
+        return false;
     }
 
     const EGame Game = mpProject->Game();
     const uint32 Alignment = (Game <= EGame::CorruptionProto ? 0x20 : 0x40);
-    const uint32 AlignmentMinusOne = Alignment - 1;
 
     uint32 TocOffset = 0;
     uint32 NamesSize = 0;
@@ -147,10 +413,10 @@ void CPackage::Cook(IProgressNotifier *pProgress)
 
     // Fill in resource table with junk, write later
     ResTableOffset = Pak.Tell();
-    Pak.WriteLong(AssetList.size());
+    Pak.WriteLong(rkAssets.size());
     const CAssetID Dummy = CAssetID::InvalidID(Game);
 
-    for (size_t iRes = 0; iRes < AssetList.size(); iRes++)
+    for (size_t iRes = 0; iRes < rkAssets.size(); iRes++)
     {
         Pak.WriteLongLong(0);
         Dummy.Write(Pak);
@@ -161,144 +427,71 @@ void CPackage::Cook(IProgressNotifier *pProgress)
     ResTableSize = Pak.Tell() - ResTableOffset;
 
     // Start writing resources
-    struct SResourceTableInfo
+    std::vector<SPakLayout::SResource> ResourceTable(rkAssets.size());
+    const uint32 ResDataOffset = Pak.Tell();
+
+    // Keep a limited number of assets in flight so memory use stays bounded
+    CThreadPool *pPool = CThreadPool::Shared();
+    CCompressionCache *pCache = mpProject->CompressionCache();
+    const size_t NumInFlight = std::max<size_t>(pPool->NumThreads() * 2, 1);
+    std::vector<std::future<SPakAssetData>> AssetData(rkAssets.size());
+    std::vector<uint64> AssetHashes(rkAssets.size());
+    size_t NumQueued = 0;
+
+    const auto QueueAssets = [&](size_t MaxIndex)
     {
-        CResourceEntry *pEntry;
-        uint32 Offset;
-        uint32 Size;
-        bool Compressed;
+        for (; NumQueued < rkAssets.size() && NumQueued <= MaxIndex; NumQueued++)
+        {
+            const CResourceEntry *pkEntry = rkAssets[NumQueued];
+            AssetData[NumQueued] = pPool->Submit([Game, pCache, Type = pkEntry->ResourceType(), Path = pkEntry->CookedAssetPath()]() {
+                return LoadPakAssetData(Game, Type, Path, pCache);
+            });
+        }
     };
-    std::vector<SResourceTableInfo> ResourceTableData(AssetList.size());
+
     uint32 ResIdx = 0;
-    const uint32 ResDataOffset = Pak.Tell();
 
-    for (auto Iter = AssetList.begin(); Iter != AssetList.end() && !pProgress->ShouldCancel(); Iter++, ResIdx++)
+    for (; ResIdx < rkAssets.size() && !pProgress->ShouldCancel(); ResIdx++)
     {
-        // Initialize entry, recook assets if needed
-        const uint32 AssetOffset = Pak.Tell();
-        const CAssetID ID = *Iter;
-        CResourceEntry *pEntry = gpResourceStore->FindEntry(ID);
-        ASSERT(pEntry != nullptr);
+        QueueAssets(ResIdx + NumInFlight);
 
-        if (pEntry->NeedsRecook())
-        {
-            pProgress->Report(ResIdx, AssetList.size(), "Cooking asset: " + pEntry->Name() + "." + pEntry->CookedExtension());
-            pEntry->Cook();
-        }
+        const uint32 AssetOffset = Pak.Tell();
+        CResourceEntry *pEntry = rkAssets[ResIdx];
 
         // Update progress bar
-        if ((ResIdx & 1) != 0 || ResIdx == AssetList.size() - 1)
+        if ((ResIdx & 1) != 0 || ResIdx == rkAssets.size() - 1)
         {
-            pProgress->Report(ResIdx, AssetList.size(), TString::Format("Writing asset %d/%d: %s", ResIdx+1, AssetList.size(), *(pEntry->Name() + "." + pEntry->CookedExtension())));
+            pProgress->Report(ResIdx, rkAssets.size(), TString::Format("Writing asset %d/%d: %s", ResIdx+1, rkAssets.size(), *(pEntry->Name() + "." + pEntry->CookedExtension())));
         }
 
         // Update table info
-        SResourceTableInfo& rTableInfo = ResourceTableData[ResIdx];
-        rTableInfo.pEntry = pEntry;
+        SPakLayout::SResource& rTableInfo = ResourceTable[ResIdx];
+        rTableInfo.Type = pEntry->CookedExtension();
+        rTableInfo.ID = pEntry->ID();
         rTableInfo.Offset = (Game <= EGame::Echoes ? AssetOffset : AssetOffset - ResDataOffset);
 
-        // Load resource data
-        CFileInStream CookedAsset(pEntry->CookedAssetPath(), EEndian::BigEndian);
-        ASSERT(CookedAsset.IsValid());
-        const uint32 ResourceSize = CookedAsset.Size();
-
-        std::vector<uint8> ResourceData(ResourceSize);
-        CookedAsset.ReadBytes(ResourceData.data(), ResourceData.size());
-
-        // Check if this asset should be compressed; there are a few resource types that are
-        // always compressed, and some types that are compressed if they're over a certain size
-        const EResourceType Type = pEntry->ResourceType();
-        const uint32 CompressThreshold = (Game <= EGame::CorruptionProto ? 0x400 : 0x80);
-
-        bool ShouldAlwaysCompress = (Type == EResourceType::Texture || Type == EResourceType::Model ||
-                                     Type == EResourceType::Skin || Type == EResourceType::AnimSet ||
-                                     Type == EResourceType::Animation || Type == EResourceType::Font);
-
-        if (Game >= EGame::Corruption)
-        {
-            ShouldAlwaysCompress = ShouldAlwaysCompress ||
-                                   (Type == EResourceType::Character || Type == EResourceType::SourceAnimData ||
-                                    Type == EResourceType::Scan || Type == EResourceType::AudioSample ||
-                                    Type == EResourceType::StringTable || Type == EResourceType::AudioAmplitudeData ||
-                                    Type == EResourceType::DynamicCollision);
-        }
-
-        const bool ShouldCompressConditional = !ShouldAlwaysCompress &&
-                                               (Type == EResourceType::Particle || Type == EResourceType::ParticleElectric ||
-                                                Type == EResourceType::ParticleSwoosh || Type == EResourceType::ParticleWeapon ||
-                                                Type == EResourceType::ParticleDecal || Type == EResourceType::ParticleCollisionResponse ||
-                                                Type == EResourceType::ParticleSpawn || Type == EResourceType::ParticleSorted ||
-                                                Type == EResourceType::BurstFireData);
-
-        const bool ShouldCompress = ShouldAlwaysCompress || (ShouldCompressConditional && ResourceSize >= CompressThreshold);
-
         // Write resource data to pak
-        if (!ShouldCompress)
-        {
-            Pak.WriteBytes(ResourceData.data(), ResourceSize);
-            rTableInfo.Compressed = false;
-        }
-        else
-        {
-            uint32 CompressedSize;
-            std::vector<uint8> CompressedData(ResourceData.size() * 2);
-            bool Success = false;
-
-            if (Game <= EGame::EchoesDemo || Game == EGame::DKCReturns)
-                Success = CompressionUtil::CompressZlib(ResourceData.data(), ResourceData.size(), CompressedData.data(), CompressedData.size(), CompressedSize);
-            else
-                Success = CompressionUtil::CompressLZOSegmented(ResourceData.data(), ResourceData.size(), CompressedData.data(), CompressedSize, false);
-
-            // Make sure that the compressed data is actually smaller, accounting for padding + uncompressed size value
-            if (Success)
-            {
-                const uint32 CompressionHeaderSize = (Game <= EGame::CorruptionProto ? 4 : 0x10);
-                const uint32 PaddedUncompressedSize = (ResourceSize + AlignmentMinusOne) & ~AlignmentMinusOne;
-                const uint32 PaddedCompressedSize = (CompressedSize + CompressionHeaderSize + AlignmentMinusOne) & ~AlignmentMinusOne;
-                Success = (PaddedCompressedSize < PaddedUncompressedSize);
-            }
-
-            // Write file to pak
-            if (Success)
-            {
-                // Write MP1/2 compressed asset
-                if (Game <= EGame::CorruptionProto)
-                {
-                    Pak.WriteULong(ResourceSize);
-                }
-                // Write MP3/DKCR compressed asset
-                else
-                {
-                    // Note: Compressed asset data can be stored in multiple blocks. Normally, the only assets that make use of this are textures,
-                    // which can store each separate component of the file (header, palette, image data) in separate blocks. However, some textures
-                    // are stored in one block, and I've had no luck figuring out why. The game doesn't generally seem to care whether textures use
-                    // multiple blocks or not, so for the sake of simplicity we compress everything to one block.
-                    Pak.WriteFourCC( FOURCC('CMPD') );
-                    Pak.WriteLong(1);
-                    Pak.WriteULong(0xA0000000 | CompressedSize);
-                    Pak.WriteULong(ResourceSize);
-                }
-                Pak.WriteBytes(CompressedData.data(), CompressedSize);
-            }
-            else
-            {
-                Pak.WriteBytes(ResourceData.data(), ResourceSize);
-            }
-
-            rTableInfo.Compressed = Success;
-        }
-
-        Pak.WriteToBoundary(Alignment, 0xFF);
+        const SPakAssetData Data = AssetData[ResIdx].get();
+        WritePakAsset(Pak, Game, Data, Alignment);
+        rTableInfo.Compressed = Data.Compressed;
         rTableInfo.Size = Pak.Tell() - AssetOffset;
+        AssetHashes[ResIdx] = Data.ContentHash;
     }
     ResDataSize = Pak.Tell() - ResDataOffset;
 
+    // Don't leave any tasks running that still reference our asset list
+    for (size_t iRes = ResIdx; iRes < NumQueued; iRes++)
+        AssetData[iRes].wait();
+
     // If we cancelled, don't finish writing the pak; delete the file instead and make sure the package is flagged for recook
     if (pProgress->ShouldCancel())
     {
         Pak.Close();
         FileUtil::DeleteFile(PakPath);
         mNeedsRecook = true;
+        mCookedPakSize = 0;
+        mCookedTableHash = 0;
+        mCookedAssetHashes.clear();
     }
     else
     {
@@ -316,29 +509,297 @@ void CPackage::Cook(IProgressNotifier *pProgress)
         }
 
         // Write resource table for real
+        const std::vector<char> TableData = BuildResourceTable(ResourceTable);
         Pak.Seek(ResTableOffset+4, SEEK_SET);
-
-        for (size_t iRes = 0; iRes < AssetList.size(); iRes++)
-        {
-            const SResourceTableInfo& rkInfo = ResourceTableData[iRes];
-            CResourceEntry *pEntry = rkInfo.pEntry;
-
-            Pak.WriteLong(rkInfo.Compressed ? 1 : 0);
-            pEntry->CookedExtension().Write(Pak);
-            pEntry->ID().Write(Pak);
-            Pak.WriteULong(rkInfo.Size);
-            Pak.WriteULong(rkInfo.Offset);
-        }
+        Pak.WriteBytes(TableData.data(), TableData.size());
 
         // Clear recook flag
+        Pak.Close();
         mNeedsRecook = false;
+        mCookedPakSize = FileUtil::FileSize(PakPath);
+        mCookedTableHash = HashResourceTable(TableData);
+        mCookedAssetHashes.clear();
+
+        for (size_t iRes = 0; iRes < rkAssets.size(); iRes++)
+            mCookedAssetHashes[rkAssets[iRes]->ID()] = AssetHashes[iRes];
+
         debugf("Finished writing %s", *PakPath);
     }
 
     Save();
+    return !mNeedsRecook;
+}
 
-    // Update resource store in case we recooked any assets
-    mpProject->ResourceStore()->ConditionalSaveStore();
+bool CPackage::PatchPak(const std::vector<CResourceEntry*>& rkAssets, IProgressNotifier *pProgress)
+{
+    // Updates the pak written by the last cook instead of writing a new one. Assets whose contents have changed since
+    // then are appended to the end of the pak, then the resource table is rewritten in place to point at them, so only
+    // the changed assets are loaded, compressed and written. Returns false without modifying the pak if it needs a full
+    // cook instead, or if the cook was cancelled.
+    const TString PakPath = CookedPackagePath(false);
+
+    if (mCookedPakSize == 0 || !FileUtil::Exists(PakPath) || FileUtil::FileSize(PakPath) != mCookedPakSize)
+        return false;
+
+    // The named resources have to match, since they aren't rewritten, and the resource table has to list the same
+    // assets in the same order, so it stays the same size
+    SPakLayout Layout;
+
+    if (!ReadPakLayout(PakPath, Layout) || Layout.NamedResources.size() != mResources.size() || Layout.Resources.size() != rkAssets.size())
+        return false;
+
+    for (size_t iName = 0; iName < mResources.size(); iName++)
+    {
+        const SNamedResource& rkOld = Layout.NamedResources[iName];
+        const SNamedResource& rkNew = mResources[iName];
+
+        if (rkOld.Name != rkNew.Name || rkOld.ID != rkNew.ID || rkOld.Type.ToLong() != rkNew.Type.ToLong())
+            return false;
+    }
+
+    for (size_t iRes = 0; iRes < rkAssets.size(); iRes++)
+    {
+        const SPakLayout::SResource& rkRes = Layout.Resources[iRes];
+
+        if (rkRes.ID != rkAssets[iRes]->ID() || rkRes.Type.ToLong() != rkAssets[iRes]->CookedExtension().ToLong())
+            return false;
+    }
+
+    // A pak that has been changed or replaced since we wrote it doesn't match our asset hashes anymore
+    if (HashResourceTable(BuildResourceTable(Layout.Resources)) != mCookedTableHash)
+        return false;
+
+    // Find the assets whose cooked file has changed since it was written to the pak. Every cooked file has to be
+    // read to hash it, but that's still much cheaper than compressing and writing the whole pak again.
+    const EGame Game = mpProject->Game();
+    const uint32 Alignment = (Game <= EGame::CorruptionProto ? 0x20 : 0x40);
+    CThreadPool *pPool = CThreadPool::Shared();
+    CCompressionCache *pCache = mpProject->CompressionCache();
+
+    pProgress->Report(-1, -1, "Checking for changed assets");
+    std::vector<std::future<uint64>> AssetHashes;
+    AssetHashes.reserve(rkAssets.size());
+
+    for (const CResourceEntry *pkEntry : rkAssets)
+    {
+        AssetHashes.push_back(pPool->Submit([Path = pkEntry->CookedAssetPath()]() {
+            std::vector<uint8> Data;
+            return FileUtil::LoadFileToBuffer(Path, Data) ? HashCookedAsset(Data) : 0;
+        }));
+    }
+
+    std::vector<size_t> DirtyAssets;
+
+    for (size_t iRes = 0; iRes < rkAssets.size(); iRes++)
+    {
+        const auto Find = mCookedAssetHashes.find(rkAssets[iRes]->ID());
+
+        if (Find == mCookedAssetHashes.cend() || Find->second != AssetHashes[iRes].get())
+            DirtyAssets.push_back(iRes);
+    }
+
+    // Patching only pays off when it's a small part of the pak
+    if (pProgress->ShouldCancel() || DirtyAssets.size() * 2 > rkAssets.size())
+        return false;
+
+    // Nothing has changed since the pak was written, so it's already up to date
+    if (DirtyAssets.empty())
+        return true;
+
+    pProgress->Report(-1, -1, TString::Format("Patching %d assets", static_cast<int>(DirtyAssets.size())));
+
+    std::vector<std::future<SPakAssetData>> AssetData;
+    AssetData.reserve(DirtyAssets.size());
+
+    for (const size_t iRes : DirtyAssets)
+    {
+        const CResourceEntry *pkEntry = rkAssets[iRes];
+        AssetData.push_back(pPool->Submit([Game, pCache, Type = pkEntry->ResourceType(), Path = pkEntry->CookedAssetPath()]() {
+            return LoadPakAssetData(Game, Type, Path, pCache);
+        }));
+    }
+
+    // Lay out the new data after everything that's in the pak now
+    const uint64 AppendOffset = (Layout.Size + Alignment - 1) & ~static_cast<uint64>(Alignment - 1);
+    std::vector<char> NewData;
+    CVectorOutStream NewDataStream(&NewData, EEndian::BigEndian);
+    std::vector<uint64> DirtyHashes(DirtyAssets.size());
+
+    for (size_t iDirty = 0; iDirty < DirtyAssets.size(); iDirty++)
+    {
+        if (pProgress->ShouldCancel())
+        {
+            // Don't leave any tasks running that still reference our asset list
+            for (; iDirty < AssetData.size(); iDirty++)
+                AssetData[iDirty].wait();
+
+            return false;
+        }
+
+        SPakLayout::SResource& rRes = Layout.Resources[DirtyAssets[iDirty]];
+        const SPakAssetData Data = AssetData[iDirty].get();
+        const uint64 AssetOffset = AppendOffset + NewDataStream.Tell();
+
+        WritePakAsset(NewDataStream, Game, Data, Alignment);
+        rRes.Compressed = Data.Compressed;
+        rRes.Size = static_cast<uint32>(AppendOffset + NewDataStream.Tell() - AssetOffset);
+        rRes.Offset = static_cast<uint32>(AssetOffset - Layout.OffsetBase);
+        DirtyHashes[iDirty] = Data.ContentHash;
+    }
+
+    // Space left behind by replaced assets is only reclaimed by a full cook, so do one once there's too much of it
+    const uint64 NewPakSize = AppendOffset + NewData.size();
+    uint64 LiveSize = 0;
+
+    for (const SPakLayout::SResource& rkRes : Layout.Resources)
+        LiveSize += rkRes.Size;
+
+    if (NewPakSize > UINT32_MAX || (NewPakSize - Layout.ResDataOffset - LiveSize) > (NewPakSize - Layout.ResDataOffset) / 4)
+        return false;
+
+    const std::vector<char> Padding(AppendOffset - Layout.Size, static_cast<char>(0xFF));
+    const std::vector<char> TableData = BuildResourceTable(Layout.Resources);
+    std::vector<char> DataSizeData;
+    CVectorOutStream DataSizeStream(&DataSizeData, EEndian::BigEndian);
+    DataSizeStream.WriteULong(static_cast<uint32>(NewPakSize - Layout.ResDataOffset));
+
+    // CFileOutStream always truncates, so the pak is opened for update directly. The new assets are appended and synced
+    // before the resource table is rewritten. Until then the old table still points at the old data, which hasn't moved,
+    // so an interrupted patch leaves a working pak behind, and its new size makes the next cook a full one.
+    const std::filesystem::path Path = std::filesystem::u8path(*PakPath);
+#ifdef _WIN32
+    FILE *pFile = _wfopen(Path.c_str(), L"r+b");
+#else
+    FILE *pFile = std::fopen(Path.c_str(), "r+b");
+#endif
+
+    if (!pFile)
+    {
+        errorf("Failed to patch package %s; unable to open package for writing", *CookedPackagePath(true));
+        return false;
+    }
+
+    bool Success = (std::fseek(pFile, 0, SEEK_END) == 0 &&
+                    std::fwrite(Padding.data(), 1, Padding.size(), pFile) == Padding.size() &&
+                    std::fwrite(NewData.data(), 1, NewData.size(), pFile) == NewData.size() &&
+                    SyncFile(pFile));
+
+    Success = Success && WriteFileAt(pFile, Layout.ResTableOffset + 4, TableData);
+
+    if (Game >= EGame::Corruption)
+        Success = Success && WriteFileAt(pFile, Layout.DataSizeOffset, DataSizeData);
+
+    Success = SyncFile(pFile) && Success;
+    Success = (std::fclose(pFile) == 0) && Success;
+
+    if (!Success)
+    {
+        // The full cook that follows rewrites the pak from scratch
+        errorf("Failed to patch package %s", *CookedPackagePath(true));
+        return false;
+    }
+
+    mCookedPakSize = NewPakSize;
+    mCookedTableHash = HashResourceTable(TableData);
+
+    for (size_t iDirty = 0; iDirty < DirtyAssets.size(); iDirty++)
+        mCookedAssetHashes[rkAssets[DirtyAssets[iDirty]]->ID()] = DirtyHashes[iDirty];
+
+    debugf("Patched %d assets into %s", static_cast<int>(DirtyAssets.size()), *PakPath);
+    return true;
+}
+
+bool CPackage::ReadPakLayout(const TString& rkPakPath, SPakLayout& rOut) const
+{
+    // Reads the header, named resources and resource table of a cooked pak
+    CFileInStream Pak(rkPakPath, EEndian::BigEndian);
+    if (!Pak.IsValid()) return false;
+
+    const EGame Game = mpProject->Game();
+    const uint32 Alignment = (Game <= EGame::CorruptionProto ? 0x20 : 0x40);
+    const uint32 IDLength = (CAssetID::GameIDLength(Game) == EIDLength::k32Bit ? 4 : 8);
+    rOut = SPakLayout();
+    rOut.Size = Pak.Size();
+
+    if (Game <= EGame::CorruptionProto)
+    {
+        if (Pak.ReadULong() != 0x00030005) return false;
+        Pak.Seek(0x4, SEEK_CUR);
+
+        const uint32 NumNamedResources = Pak.ReadULong();
+
+        for (uint32 iName = 0; iName < NumNamedResources; iName++)
+        {
+            const CFourCC Type = Pak.ReadULong();
+            const CAssetID ID(Pak, Game);
+            const uint32 NameLen = Pak.ReadULong();
+            rOut.NamedResources.push_back(SNamedResource{Pak.ReadString(NameLen), ID, Type});
+        }
+
+        rOut.ResTableOffset = Pak.Tell();
+    }
+    else
+    {
+        if (Pak.ReadULong() != 2) return false;
+        const uint32 HeaderLen = Pak.ReadULong();
+        Pak.Seek(HeaderLen, SEEK_SET);
+
+        const uint32 NumPakSections = Pak.ReadULong();
+        if (NumPakSections != 3) return false;
+
+        constexpr uint32 kSectionTypes[3] = { FOURCC('STRG'), FOURCC('RSHD'), FOURCC('DATA') };
+        uint32 SectionSizes[3];
+
+        for (uint32 iSec = 0; iSec < NumPakSections; iSec++)
+        {
+            const CFourCC Type = Pak.ReadULong();
+            SectionSizes[iSec] = Pak.ReadULong();
+
+            if (Type.ToLong() != kSectionTypes[iSec])
+                return false;
+        }
+
+        rOut.DataSizeOffset = HeaderLen + 0x18;
+        Pak.SeekToBoundary(64);
+
+        const uint32 NamesStart = Pak.Tell();
+        const uint32 NumNamedResources = Pak.ReadULong();
+
+        for (uint32 iName = 0; iName < NumNamedResources; iName++)
+        {
+            TString Name = Pak.ReadString();
+            const CFourCC Type = Pak.ReadULong();
+            const CAssetID ID(Pak, Game);
+            rOut.NamedResources.push_back(SNamedResource{std::move(Name), ID, Type});
+        }
+
+        rOut.ResTableOffset = NamesStart + SectionSizes[0];
+        rOut.ResDataOffset = rOut.ResTableOffset + SectionSizes[1];
+        rOut.OffsetBase = rOut.ResDataOffset;
+        Pak.Seek(rOut.ResTableOffset, SEEK_SET);
+    }
+
+    const uint32 NumResources = Pak.ReadULong();
+    rOut.Resources.resize(NumResources);
+
+    for (uint32 iRes = 0; iRes < NumResources; iRes++)
+    {
+        SPakLayout::SResource& rRes = rOut.Resources[iRes];
+        rRes.Compressed = (Pak.ReadULong() == 1);
+        rRes.Type = Pak.ReadULong();
+        rRes.ID = CAssetID(Pak, Game);
+        rRes.Size = Pak.ReadULong();
+        rRes.Offset = Pak.ReadULong();
+    }
+
+    if (Game <= EGame::CorruptionProto)
+    {
+        const uint32 TableSize = 4 + NumResources * (16 + IDLength);
+        rOut.ResDataOffset = (rOut.ResTableOffset + TableSize + Alignment - 1) & ~(Alignment - 1);
+        rOut.OffsetBase = (Game <= EGame::Echoes ? 0 : rOut.ResDataOffset);
+    }
+
+    return rOut.ResDataOffset <= rOut.Size;
 }
 
 void CPackage::CompareOriginalAssetList(const std::list<CAssetID>& rkNewList)
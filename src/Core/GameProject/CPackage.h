@@ -6,8 +6,10 @@
 #include <Common/TString.h>
 #include <Common/Serialization/IArchive.h>
 #include "Core/IProgressNotifier.h"
+#include <map>
 
 class CGameProject;
+class CResourceEntry;
 
 enum class EPackageDefinitionVersion
 {
@@ -32,6 +34,27 @@ struct SNamedResource
     }
 };
 
+// Layout of a cooked pak, as read back by CPackage::ReadPakLayout
+struct SPakLayout
+{
+    struct SResource
+    {
+        bool Compressed = false;
+        CFourCC Type;
+        CAssetID ID;
+        uint32 Size = 0;
+        uint32 Offset = 0;
+    };
+
+    std::vector<SNamedResource> NamedResources;
+    std::vector<SResource> Resources;
+    uint32 ResTableOffset = 0;
+    uint32 ResDataOffset = 0;
+    uint32 OffsetBase = 0;     // Resource offsets are relative to the start of the pak for MP1/MP2, and to the resource data after that
+    uint32 DataSizeOffset = 0; // MP3 only; location of the DATA section size in the table of contents
+    uint64 Size = 0;
+};
+
 class CPackage
 {
     CGameProject *mpProject = nullptr;
@@ -40,6 +63,13 @@ class CPackage
     std::vector<SNamedResource> mResources;
     bool mNeedsRecook = false;
 
+    // Size of the pak and hash of its resource table when it was last written. If the pak still matches, it can be patched.
+    uint64 mCookedPakSize = 0;
+    uint64 mCookedTableHash = 0;
+
+    // Hash of each cooked asset's contents when it was written to the pak; assets whose contents have changed since are patched in
+    std::map<CAssetID, uint64> mCookedAssetHashes;
+
     // Cached dependency list; used to figure out if a given resource is in this package
     mutable bool mCacheDirty = false;
     mutable std::set<CAssetID> mCachedDependencies;
@@ -61,6 +91,10 @@ public:
     void MarkDirty();
 
     void Cook(IProgressNotifier *pProgress);
+    bool PrepareForCook(std::vector<CResourceEntry*>& rOutAssets, IProgressNotifier *pProgress);
+    bool WritePak(const std::vector<CResourceEntry*>& rkAssets, IProgressNotifier *pProgress, bool AllowPatch = true);
+    bool PatchPak(const std::vector<CResourceEntry*>& rkAssets, IProgressNotifier *pProgress);
+    bool ReadPakLayout(const TString& rkPakPath, SPakLayout& rOut) const;
     void CompareOriginalAssetList(const std::list<CAssetID>& rkNewList);
     bool ContainsAsset(const CAssetID& rkID) const;
 
@@ -0,0 +1,94 @@
+#include "CResourceCache.h"
+#include "CResourceEntry.h"
+#include "CResourceStore.h"
+
+// Number of evictions to batch up before asking the store to unload unreferenced resources
+constexpr uint32 gkEvictionsPerCollect = 64;
+
+CResourceCache::CResourceCache(CResourceStore *pStore, size_t Capacity)
+    : mpStore(pStore)
+    , mCapacity(Capacity > 0 ? Capacity : 1)
+{
+}
+
+CResourceCache::~CResourceCache()
+{
+    Clear();
+}
+
+CResource* CResourceCache::Acquire(CResourceEntry *pEntry)
+{
+    CResource *pRes = pEntry->Resource();
+
+    if (pRes != nullptr)
+    {
+        mNumHits++;
+    }
+    else
+    {
+        // Loading a resource also loads everything it references, so count every resource that got decoded
+        mNumMisses++;
+        const uint32 NumLoadedBefore = mpStore->NumLoadedResources();
+        pRes = pEntry->Load();
+        const uint32 NumLoadedAfter = mpStore->NumLoadedResources();
+
+        if (NumLoadedAfter > NumLoadedBefore)
+            mNumDecodes += NumLoadedAfter - NumLoadedBefore;
+    }
+
+    if (pRes != nullptr)
+        Retain(pRes);
+
+    return pRes;
+}
+
+void CResourceCache::Retain(CResource *pRes)
+{
+    const CAssetID ID = pRes->ID();
+    const auto Find = mEntryMap.find(ID);
+
+    if (Find != mEntryMap.cend())
+    {
+        mEntries.splice(mEntries.begin(), mEntries, Find->second);
+        return;
+    }
+
+    mEntries.emplace_front(pRes);
+    mEntryMap.insert_or_assign(ID, mEntries.begin());
+
+    while (mEntries.size() > mCapacity)
+    {
+        mEntryMap.erase(mEntries.back()->ID());
+        mEntries.pop_back();
+        mNumEvictions++;
+        mNumEvictedSinceCollect++;
+    }
+
+    if (mNumEvictedSinceCollect >= gkEvictionsPerCollect)
+        CollectGarbage();
+}
+
+void CResourceCache::Remove(const CAssetID& rkID)
+{
+    const auto Find = mEntryMap.find(rkID);
+
+    if (Find != mEntryMap.cend())
+    {
+        mEntries.erase(Find->second);
+        mEntryMap.erase(Find);
+        mNumEvictedSinceCollect++;
+    }
+}
+
+void CResourceCache::Clear()
+{
+    mEntryMap.clear();
+    mEntries.clear();
+    CollectGarbage();
+}
+
+void CResourceCache::CollectGarbage()
+{
+    mpStore->DestroyUnreferencedResources();
+    mNumEvictedSinceCollect = 0;
+}
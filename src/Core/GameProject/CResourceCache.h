@@ -0,0 +1,50 @@
+#ifndef CRESOURCECACHE_H
+#define CRESOURCECACHE_H
+
+#include "Core/Resource/TResPtr.h"
+#include <Common/CAssetID.h>
+#include <list>
+#include <map>
+
+class CResourceEntry;
+class CResourceStore;
+
+// Bounded LRU of loaded resources. Holding a resource in the cache keeps it referenced,
+// so it survives CResourceStore::DestroyUnreferencedResources() until it is evicted.
+// Used to avoid decoding shared dependencies (textures, models, etc) over and over when
+// processing many resources in a row.
+class CResourceCache
+{
+    CResourceStore *mpStore;
+    size_t mCapacity;
+
+    std::list<TResPtr<CResource>> mEntries; // Most recently used first
+    std::map<CAssetID, std::list<TResPtr<CResource>>::iterator> mEntryMap;
+    uint32 mNumEvictedSinceCollect = 0;
+
+    // Statistics
+    uint32 mNumHits = 0;
+    uint32 mNumMisses = 0;
+    uint32 mNumDecodes = 0;
+    uint32 mNumEvictions = 0;
+
+public:
+    CResourceCache(CResourceStore *pStore, size_t Capacity);
+    ~CResourceCache();
+
+    CResource* Acquire(CResourceEntry *pEntry);
+    void Retain(CResource *pRes);
+    void Remove(const CAssetID& rkID);
+    void Clear();
+    void CollectGarbage();
+
+    // Accessors
+    size_t Capacity() const      { return mCapacity; }
+    size_t NumCached() const     { return mEntries.size(); }
+    uint32 NumHits() const       { return mNumHits; }
+    uint32 NumMisses() const     { return mNumMisses; }
+    uint32 NumDecodes() const    { return mNumDecodes; }
+    uint32 NumEvictions() const  { return mNumEvictions; }
+};
+
+#endif // CRESOURCECACHE_H
@@ -1,15 +1,74 @@
 #include "CResourceEntry.h"
+#include "CFileStateCache.h"
 #include "CGameProject.h"
+#include "CResourceLoadQueue.h"
+#include "CResourceMetadataStore.h"
 #include "CResourceStore.h"
 #include "Core/Resource/CResource.h"
 #include "Core/Resource/Cooker/CResourceCooker.h"
 #include "Core/Resource/Factory/CResourceFactory.h"
+#include <Common/CFourCC.h>
 #include <Common/FileIO.h>
 #include <Common/FileUtil.h>
 #include <Common/TString.h>
+#include <Common/Serialization/Binary.h>
 #include <Common/Serialization/CXMLReader.h>
 #include <Common/Serialization/CXMLWriter.h>
 
+// Binary raw files hold the same data as XML ones, written with CBasicBinaryWriter after a small header
+constexpr uint32 gkBinaryRawMagic = FOURCC('RSRB');
+constexpr uint32 gkBinaryRawHeaderSize = 10; // Magic, archive version, game
+
+namespace
+{
+bool IsBinaryRawFile(const TString& rkPath)
+{
+    CFileInStream File(rkPath, EEndian::BigEndian);
+    return File.IsValid() && File.Size() >= gkBinaryRawHeaderSize && File.ReadULong() == gkBinaryRawMagic;
+}
+
+bool ReadBinaryRaw(const TString& rkPath, CResource& rResource)
+{
+    std::vector<uint8> Data;
+
+    if (!FileUtil::LoadFileToBuffer(rkPath, Data) || Data.size() < gkBinaryRawHeaderSize)
+        return false;
+
+    CMemoryInStream Header(Data.data(), gkBinaryRawHeaderSize, EEndian::BigEndian);
+    const uint32 Magic = Header.ReadULong();
+    const uint16 ArchiveVersion = Header.ReadUShort();
+    const auto Game = static_cast<EGame>(Header.ReadULong());
+
+    if (Magic != gkBinaryRawMagic || ArchiveVersion > IArchive::skCurrentArchiveVersion)
+        return false;
+
+    CBasicBinaryReader Reader(Data.data() + gkBinaryRawHeaderSize, Data.size() - gkBinaryRawHeaderSize,
+                              CSerialVersion(ArchiveVersion, 0, Game));
+    rResource.Serialize(Reader);
+    return true;
+}
+
+bool WriteBinaryRaw(const TString& rkPath, CResource& rResource, EGame Game)
+{
+    std::vector<char> Data;
+    {
+        CVectorOutStream DataStream(&Data, EEndian::BigEndian);
+        CBasicBinaryWriter Writer(&DataStream, CSerialVersion(IArchive::skCurrentArchiveVersion, 0, Game));
+        rResource.Serialize(Writer);
+    }
+
+    CFileOutStream File(rkPath, EEndian::BigEndian);
+    if (!File.IsValid())
+        return false;
+
+    File.WriteULong(gkBinaryRawMagic);
+    File.WriteUShort(IArchive::skCurrentArchiveVersion);
+    File.WriteULong(static_cast<uint32>(Game));
+    File.WriteBytes(Data.data(), Data.size());
+    return true;
+}
+} // anonymous namespace
+
 CResourceEntry::CResourceEntry(CResourceStore *pStore)
     : mpStore(pStore)
     , mID(CAssetID::InvalidID(pStore->Game()))
@@ -112,6 +171,14 @@ bool CResourceEntry::SaveMetadata(bool ForceSave /*= false*/)
 
     if (mMetadataDirty || ForceSave)
     {
+        // Game projects keep their metadata in the metadata store instead of a file next to the asset
+        if (CResourceMetadataStore *pMetaStore = mpStore->MetadataStore())
+        {
+            pMetaStore->StoreEntry(this);
+            mMetadataDirty = false;
+            return true;
+        }
+
         TString Path = MetadataFilePath();
         TString Dir = Path.GetFileDirectory();
         FileUtil::MakeDirectory(Dir);
@@ -152,15 +219,16 @@ void CResourceEntry::SerializeEntryInfo(IArchive& rArc, bool MetadataOnly)
 
         if (rArc.IsReader())
         {
+            mCachedUppercaseName = mName.ToUpper();
             mpDirectory = mpStore->GetVirtualDirectory(Dir, true);
             mpDirectory->AddChild("", this);
-            mCachedUppercaseName = mName.ToUpper();
         }
     }
 }
 
 void CResourceEntry::UpdateDependencies()
 {
+    mpStore->RemoveReferences(this);
     mpDependencies.reset();
 
     if (!mpTypeInfo->CanHaveDependencies())
@@ -182,20 +250,28 @@ void CResourceEntry::UpdateDependencies()
     }
 
     mpDependencies = mpResource->BuildDependencyTree();
+    mpStore->AddReferences(this);
     mpStore->SetCacheDirty();
 
+    // The metadata store keeps a copy of the dependency tree, so it needs updating too
+    if (mpStore->MetadataStore() && !IsMarkedForDeletion())
+    {
+        mMetadataDirty = true;
+        SaveMetadata();
+    }
+
     if (!WasLoaded)
         mpStore->DestroyUnreferencedResources();
 }
 
 bool CResourceEntry::HasRawVersion() const
 {
-    return FileUtil::Exists(RawAssetPath());
+    return mpStore->FileStates()->Exists(RawAssetPath());
 }
 
 bool CResourceEntry::HasCookedVersion() const
 {
-    return FileUtil::Exists(CookedAssetPath());
+    return mpStore->FileStates()->Exists(CookedAssetPath());
 }
 
 TString CResourceEntry::RawAssetPath(bool Relative) const
@@ -241,15 +317,7 @@ bool CResourceEntry::IsInDirectory(CVirtualDirectory *pDir) const
 
 uint64 CResourceEntry::Size() const
 {
-    if (mCachedSize == UINT64_MAX)
-    {
-        if (HasCookedVersion())
-            mCachedSize = FileUtil::FileSize(CookedAssetPath());
-        else
-            return 0;
-    }
-
-    return mCachedSize;
+    return mpStore->FileStates()->FileSize(CookedAssetPath());
 }
 
 bool CResourceEntry::NeedsRecook() const
@@ -257,10 +325,18 @@ bool CResourceEntry::NeedsRecook() const
     // Assets that do not have a raw version can't be recooked since they will always just be saved cooked to begin with.
     // We will recook any asset where the raw version has been updated but not recooked yet. eREF_NeedsRecook can also be
     // toggled to arbitrarily flag any asset for recook.
-    if (!HasRawVersion()) return false;
-    if (!HasCookedVersion()) return true;
+    CFileStateCache *pFileStates = mpStore->FileStates();
+    const TString CookedPath = CookedAssetPath();
+    const TString RawPath = CookedPath + ".rsraw";
+
+    const CFileStateCache::SFileState RawState = pFileStates->Query(RawPath);
+    if (!RawState.Exists) return false;
+
+    const CFileStateCache::SFileState CookedState = pFileStates->Query(CookedPath);
+    if (!CookedState.Exists) return true;
+
     if (HasFlag(EResEntryFlag::NeedsRecook)) return true;
-    return (FileUtil::LastModifiedTime(CookedAssetPath()) < FileUtil::LastModifiedTime(RawAssetPath()));
+    return (CookedState.ModifiedTime < RawState.ModifiedTime);
 }
 
 bool CResourceEntry::Save(bool SkipCacheSave /*= false*/, bool FlagForRecook /*= true*/)
@@ -287,16 +363,30 @@ bool CResourceEntry::Save(bool SkipCacheSave /*= false*/, bool FlagForRecook /*=
         TString Dir = Path.GetFileDirectory();
         FileUtil::MakeDirectory(Dir);
 
-        TString SerialName = mpTypeInfo->TypeName();
-        SerialName.RemoveWhitespace();
-
-        CXMLWriter Writer(Path, SerialName, 0, Game());
-        mpResource->Serialize(Writer);
+        // The editor store has no project, and always uses XML
+        const CGameProject *pkProj = mpStore->Project();
 
-        if (!Writer.Save())
+        if (pkProj && pkProj->RawAssetFormat() == ERawAssetFormat::Binary)
         {
-            errorf("Failed to save raw resource: %s", *Path);
-            return false;
+            if (!WriteBinaryRaw(Path, *mpResource, Game()))
+            {
+                errorf("Failed to save raw resource: %s", *Path);
+                return false;
+            }
+        }
+        else
+        {
+            TString SerialName = mpTypeInfo->TypeName();
+            SerialName.RemoveWhitespace();
+
+            CXMLWriter Writer(Path, SerialName, 0, Game());
+            mpResource->Serialize(Writer);
+
+            if (!Writer.Save())
+            {
+                errorf("Failed to save raw resource: %s", *Path);
+                return false;
+            }
         }
 
         if (FlagForRecook)
@@ -318,9 +408,10 @@ bool CResourceEntry::Save(bool SkipCacheSave /*= false*/, bool FlagForRecook /*=
     }
 
     // Resource has been saved; now make sure metadata, dependencies, and packages are all up to date
+    // In game projects, UpdateDependencies already stores the metadata, so SaveMetadata has nothing left to write
     SetFlag(EResEntryFlag::HasBeenModified);
-    SaveMetadata();
     UpdateDependencies();
+    SaveMetadata();
 
     if (!SkipCacheSave)
     {
@@ -393,20 +484,37 @@ CResource* CResourceEntry::Load()
             CResourceStore *pOldStore = gpResourceStore;
             gpResourceStore = mpStore;
 
-            CXMLReader Reader(RawAssetPath());
+            // Raw files may be in either format, regardless of what the project is currently set to
+            const TString RawPath = RawAssetPath();
+            bool LoadSuccess = false;
+
+            if (IsBinaryRawFile(RawPath))
+            {
+                LoadSuccess = ReadBinaryRaw(RawPath, *mpResource);
+            }
+            else
+            {
+                CXMLReader Reader(RawPath);
+
+                if (Reader.IsValid())
+                {
+                    mpResource->Serialize(Reader);
+                    LoadSuccess = true;
+                }
+            }
 
-            if (!Reader.IsValid())
+            if (!LoadSuccess)
             {
-                errorf("Failed to load raw resource; falling back on cooked. Raw path: %s", *RawAssetPath());
+                errorf("Failed to load raw resource; falling back on cooked. Raw path: %s", *RawPath);
                 mpResource.reset();
             }
 
             else
             {
-                mpResource->Serialize(Reader);
                 mpStore->TrackLoadedResource(this);
-                gpResourceStore = pOldStore;
             }
+
+            gpResourceStore = pOldStore;
         }
 
         if (mpResource)
@@ -414,6 +522,24 @@ CResource* CResourceEntry::Load()
     }
 
     ASSERT(!mpResource);
+
+    // Use the data from an asynchronous load if there is one
+    if (const auto pPrefetch = mpStore->LoadQueue()->Take(mID))
+    {
+        if (pPrefetch->pResource)
+        {
+            mpResource = std::move(pPrefetch->pResource);
+            mpStore->TrackLoadedResource(this);
+            return mpResource.get();
+        }
+
+        if (!pPrefetch->Data.empty())
+        {
+            CMemoryInStream Input(pPrefetch->Data.data(), pPrefetch->Data.size(), EEndian::BigEndian);
+            return LoadCooked(Input);
+        }
+    }
+
     if (HasCookedVersion())
     {
         CFileInStream File(CookedAssetPath(), EEndian::BigEndian);
@@ -587,13 +713,22 @@ bool CResourceEntry::MoveAndRename(const TString& rkDir, const TString& rkName,
     // If we succeeded, finish the move
     if (FSMoveSuccess)
     {
+        // Directories look up their resources by uppercase name, so update it between leaving the old directory and joining the new one
+        const TString OldUppercaseName = mCachedUppercaseName;
+
         if (mpDirectory != pOldDir && pOldDir != nullptr)
         {
             FSMoveSuccess = pOldDir->RemoveChildResource(this);
             ASSERT(FSMoveSuccess == true); // this shouldn't be able to fail
+            mCachedUppercaseName = rkName.ToUpper();
             mpDirectory->AddChild("", this);
             SetFlagEnabled(EResEntryFlag::AutoResDir, IsAutoGenDir);
         }
+        else
+        {
+            mCachedUppercaseName = rkName.ToUpper();
+            mpDirectory->ChildResourceRenamed(this, OldUppercaseName);
+        }
 
         if (mName != OldName)
         {
@@ -601,7 +736,6 @@ bool CResourceEntry::MoveAndRename(const TString& rkDir, const TString& rkName,
         }
 
         mpStore->SetCacheDirty();
-        mCachedUppercaseName = rkName.ToUpper();
         SaveMetadata();
         return true;
     }
@@ -723,6 +857,14 @@ void CResourceEntry::MarkDeleted(bool InDeleted)
             }
         }
 
+        if (CResourceMetadataStore *pMetaStore = mpStore->MetadataStore())
+        {
+            if (InDeleted)
+                pMetaStore->EraseEntry(mID);
+            else
+                pMetaStore->StoreEntry(this);
+        }
+
         mpStore->SetCacheDirty();
         debugf("%s FOR DELETION: [%s] %s", InDeleted ? "MARKED" : "UNMARKED", *ID().ToString(), *CookedPath.GetFileName());
     }
@@ -39,7 +39,6 @@ class CResourceEntry
     FResEntryFlags mFlags;
 
     mutable bool mMetadataDirty = false;
-    mutable uint64 mCachedSize = UINT64_MAX;
     mutable TString mCachedUppercaseName; // This is used to speed up case-insensitive sorting and filtering.
 
     // Private constructor
@@ -0,0 +1,204 @@
+#include "CResourceLoadQueue.h"
+#include "CDependencyTree.h"
+#include "CResourceEntry.h"
+#include "CResourceStore.h"
+#include "Core/CThreadPool.h"
+#include "Core/Resource/CResource.h"
+#include "Core/Resource/Factory/CResourceFactory.h"
+#include <Common/FileIO.h>
+#include <Common/FileUtil.h>
+#include <Common/Log.h>
+#include <algorithm>
+#include <deque>
+#include <set>
+
+bool CResourceLoadRequest::IsReady() const
+{
+    return std::all_of(mPrefetches.cbegin(), mPrefetches.cend(), [](const auto& pkPrefetch) {
+        return pkPrefetch->Done.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    });
+}
+
+CResource* CResourceLoadRequest::Wait()
+{
+    if (!mFinished)
+    {
+        // Dependencies are pulled in by the loaders as they're needed, and those loads pick up their prefetched data
+        mpResource = mpEntry->Load();
+        mFinished = true;
+
+        // Drop anything that ended up not being needed
+        mPrefetches.clear();
+    }
+
+    return mpResource;
+}
+
+CResourceLoadQueue::CResourceLoadQueue(CResourceStore *pStore)
+    : mpStore(pStore)
+{
+}
+
+CResourceLoadQueue::~CResourceLoadQueue()
+{
+    CancelAll();
+}
+
+std::shared_ptr<CResourceLoadRequest> CResourceLoadQueue::Load(CResourceEntry *pEntry)
+{
+    auto pRequest = std::make_shared<CResourceLoadRequest>(pEntry);
+
+    // Prefetch the resource along with everything it depends on, directly or indirectly
+    std::deque<CResourceEntry*> Queue{pEntry};
+    std::set<CAssetID> Visited{pEntry->ID()};
+
+    while (!Queue.empty())
+    {
+        CResourceEntry *pCurEntry = Queue.front();
+        Queue.pop_front();
+
+        if (pCurEntry->IsLoaded())
+            continue;
+
+        if (auto pPrefetch = Prefetch(pCurEntry))
+            pRequest->mPrefetches.push_back(std::move(pPrefetch));
+
+        if (CDependencyTree *pTree = pCurEntry->Dependencies())
+        {
+            std::set<CAssetID> Dependencies;
+            pTree->GetAllResourceReferences(Dependencies);
+
+            for (const CAssetID& rkID : Dependencies)
+            {
+                if (!Visited.insert(rkID).second)
+                    continue;
+
+                if (CResourceEntry *pDependency = mpStore->FindEntry(rkID))
+                    Queue.push_back(pDependency);
+            }
+        }
+    }
+
+    mPendingRequests.push_back(pRequest);
+    return pRequest;
+}
+
+void CResourceLoadQueue::Update()
+{
+    // Finishing a request can start loads of its own, so work on a copy of the list
+    std::vector<std::shared_ptr<CResourceLoadRequest>> Requests;
+    Requests.swap(mPendingRequests);
+
+    for (auto& pRequest : Requests)
+    {
+        if (!pRequest->IsFinished() && pRequest->IsReady())
+            pRequest->Wait();
+
+        if (!pRequest->IsFinished())
+            mPendingRequests.push_back(std::move(pRequest));
+    }
+
+    // Clean up entries for prefetches that have been discarded
+    for (auto It = mPrefetches.begin(); It != mPrefetches.end();)
+    {
+        if (It->second.expired())
+            It = mPrefetches.erase(It);
+        else
+            ++It;
+    }
+}
+
+std::shared_ptr<SResourcePrefetch> CResourceLoadQueue::Take(const CAssetID& rkID)
+{
+    const auto Find = mPrefetches.find(rkID);
+
+    if (Find == mPrefetches.cend())
+        return nullptr;
+
+    std::shared_ptr<SResourcePrefetch> pPrefetch = Find->second.lock();
+    mPrefetches.erase(Find);
+
+    if (pPrefetch)
+        pPrefetch->Done.wait();
+
+    return pPrefetch;
+}
+
+void CResourceLoadQueue::Cancel(const CAssetID& rkID)
+{
+    Take(rkID);
+}
+
+void CResourceLoadQueue::CancelAll()
+{
+    // Outstanding jobs hold on to their prefetch, so anything that hasn't expired may still be running
+    for (const auto& [ID, pWeakPrefetch] : mPrefetches)
+    {
+        if (auto pPrefetch = pWeakPrefetch.lock())
+            pPrefetch->Done.wait();
+    }
+
+    mPrefetches.clear();
+    mPendingRequests.clear();
+}
+
+bool CResourceLoadQueue::CanDecodeOnWorker(EResourceType Type)
+{
+    // Types whose loaders only read from the input stream, and never load other resources through the store
+    switch (Type)
+    {
+    case EResourceType::DynamicCollision:
+    case EResourceType::Skeleton:
+    case EResourceType::Skin:
+    case EResourceType::StringTable:
+    case EResourceType::Texture:
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+// ************ PRIVATE ************
+std::shared_ptr<SResourcePrefetch> CResourceLoadQueue::Prefetch(CResourceEntry *pEntry)
+{
+    const auto Find = mPrefetches.find(pEntry->ID());
+
+    if (Find != mPrefetches.cend())
+    {
+        if (auto pExisting = Find->second.lock())
+            return pExisting;
+    }
+
+    // Raw resources are loaded on the owning thread
+    if (pEntry->HasRawVersion() || !pEntry->HasCookedVersion())
+        return nullptr;
+
+    auto pPrefetch = std::make_shared<SResourcePrefetch>();
+    pPrefetch->pEntry = pEntry;
+    mPrefetches.insert_or_assign(pEntry->ID(), pPrefetch);
+
+    // The path is built here because walking the directory tree isn't safe from other threads
+    const bool Decode = CanDecodeOnWorker(pEntry->ResourceType());
+
+    pPrefetch->Done = CThreadPool::Shared()->Submit([pPrefetch, Path = pEntry->CookedAssetPath(), Decode]()
+    {
+        if (!FileUtil::LoadFileToBuffer(Path, pPrefetch->Data))
+        {
+            warnf("Failed to prefetch resource: %s", *Path);
+            pPrefetch->Data.clear();
+            return;
+        }
+
+        if (Decode)
+        {
+            CMemoryInStream Input(pPrefetch->Data.data(), pPrefetch->Data.size(), EEndian::BigEndian);
+            pPrefetch->pResource = CResourceFactory::LoadCookedResource(pPrefetch->pEntry, Input);
+
+            if (pPrefetch->pResource)
+                std::vector<uint8>().swap(pPrefetch->Data);
+        }
+    });
+
+    return pPrefetch;
+}
@@ -0,0 +1,88 @@
+#ifndef CRESOURCELOADQUEUE_H
+#define CRESOURCELOADQUEUE_H
+
+#include "Core/Resource/EResType.h"
+#include "Core/Resource/TResPtr.h"
+#include <Common/BasicTypes.h>
+#include <Common/CAssetID.h>
+#include <future>
+#include <map>
+#include <memory>
+#include <vector>
+
+class CResource;
+class CResourceEntry;
+class CResourceStore;
+
+/** Cooked data for a single resource, read (and for some types decoded) on a worker thread */
+struct SResourcePrefetch
+{
+    CResourceEntry *pEntry;
+    std::future<void> Done;
+    std::vector<uint8> Data;                // Empty if the file couldn't be read, or was decoded on the worker
+    std::unique_ptr<CResource> pResource;   // Set if the resource was decoded on the worker
+};
+
+/** Handle to a resource being loaded by CResourceStore::LoadResourceAsync */
+class CResourceLoadRequest
+{
+    friend class CResourceLoadQueue;
+
+    CResourceEntry *mpEntry;
+    std::vector<std::shared_ptr<SResourcePrefetch>> mPrefetches;
+    TResPtr<CResource> mpResource; // Keeps the resource from being unloaded while the request is held
+    bool mFinished = false;
+
+public:
+    explicit CResourceLoadRequest(CResourceEntry *pEntry)
+        : mpEntry(pEntry)
+    {}
+
+    /** Returns whether all the background work is done, so finishing the load won't block */
+    bool IsReady() const;
+
+    /** Finishes the load, blocking until any outstanding background work is done. Must be called from the thread that owns the store. */
+    CResource* Wait();
+
+    // Accessors
+    CResourceEntry* Entry() const   { return mpEntry; }
+    CResource* Resource() const     { return mpResource; }
+    bool IsFinished() const         { return mFinished; }
+};
+
+/**
+ * Runs the thread-safe parts of resource loading on the shared thread pool. A request reads the cooked data
+ * of a resource and everything it depends on in parallel, and fully decodes the types whose loaders don't
+ * need the resource store. The remaining decoding runs on the owning thread when the request is finished,
+ * and picks up the prefetched data through CResourceEntry::Load. OpenGL objects are still created on first
+ * use on the render thread, so workers never touch GL state.
+ */
+class CResourceLoadQueue
+{
+    CResourceStore *mpStore;
+    std::map<CAssetID, std::weak_ptr<SResourcePrefetch>> mPrefetches;
+    std::vector<std::shared_ptr<CResourceLoadRequest>> mPendingRequests;
+
+public:
+    explicit CResourceLoadQueue(CResourceStore *pStore);
+    ~CResourceLoadQueue();
+
+    std::shared_ptr<CResourceLoadRequest> Load(CResourceEntry *pEntry);
+
+    /** Finishes any requests whose background work is done */
+    void Update();
+
+    /** Removes and returns the prefetched data for a resource, waiting for it if it's still being read */
+    std::shared_ptr<SResourcePrefetch> Take(const CAssetID& rkID);
+
+    /** Waits for background work on a resource, or on every resource, and discards the results */
+    void Cancel(const CAssetID& rkID);
+    void CancelAll();
+
+    static bool CanDecodeOnWorker(EResourceType Type);
+
+private:
+    std::shared_ptr<SResourcePrefetch> Prefetch(CResourceEntry *pEntry);
+};
+
+#endif // CRESOURCELOADQUEUE_H
@@ -0,0 +1,459 @@
+#include "CResourceMetadataStore.h"
+#include "CResourceEntry.h"
+#include "CResourceIterator.h"
+#include <Common/CFourCC.h>
+#include <Common/FileIO.h>
+#include <Common/FileUtil.h>
+#include <Common/Log.h>
+#include <Common/Hash/CFNV1A.h>
+#include <Common/Serialization/Binary.h>
+#include <cstdio>
+#include <filesystem>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+constexpr uint32 gkStoreMagic = FOURCC('RMDB');
+constexpr uint32 gkEntryRecord = FOURCC('ENTR');
+constexpr uint32 gkEraseRecord = FOURCC('ERAS');
+constexpr uint32 gkCommitRecord = FOURCC('CMIT');
+constexpr uint32 gkHeaderSize = 12;
+constexpr uint32 gkRecordHeaderSize = 12;
+
+// Don't bother compacting small files
+constexpr uint64 gkMinCompactSize = 1024 * 1024;
+
+namespace
+{
+void WriteHeader(IOutputStream& rOut, EGame Game)
+{
+    rOut.WriteFourCC(gkStoreMagic);
+    rOut.WriteULong(static_cast<uint32>(EMetadataStoreVersion::Current));
+    rOut.WriteULong(static_cast<uint32>(Game));
+}
+
+void WriteRecord(IOutputStream& rOut, uint32 Type, const std::vector<char>& rkPayload)
+{
+    CFNV1A Hash(CFNV1A::EHashLength::k32Bit);
+    Hash.HashData(rkPayload.data(), rkPayload.size());
+
+    rOut.WriteULong(Type);
+    rOut.WriteULong(static_cast<uint32>(rkPayload.size()));
+    rOut.WriteULong(Hash.GetHash32());
+    rOut.WriteBytes(rkPayload.data(), rkPayload.size());
+}
+
+void WriteEntryRecord(IOutputStream& rOut, const CAssetID& rkID, const CResourceMetadataStore::SEntryData& rkData)
+{
+    std::vector<char> Payload;
+    CVectorOutStream PayloadStream(&Payload, EEndian::BigEndian);
+    rkID.Write(PayloadStream);
+    PayloadStream.WriteUShort(rkData.ArchiveVersion);
+    PayloadStream.WriteBytes(rkData.Data.data(), rkData.Data.size());
+    WriteRecord(rOut, gkEntryRecord, Payload);
+}
+
+void WriteEraseRecord(IOutputStream& rOut, const CAssetID& rkID)
+{
+    std::vector<char> Payload;
+    CVectorOutStream PayloadStream(&Payload, EEndian::BigEndian);
+    rkID.Write(PayloadStream);
+    WriteRecord(rOut, gkEraseRecord, Payload);
+}
+
+void WriteCommitRecord(IOutputStream& rOut, uint32 NumRecords)
+{
+    std::vector<char> Payload;
+    CVectorOutStream PayloadStream(&Payload, EEndian::BigEndian);
+    PayloadStream.WriteULong(NumRecords);
+    WriteRecord(rOut, gkCommitRecord, Payload);
+}
+
+bool WriteToFile(const TString& rkPath, const std::vector<char>& rkBuffer, bool Append)
+{
+    // The data has to be on disk before the write counts as committed, so sync it rather than just flushing
+    const std::filesystem::path Path = std::filesystem::u8path(*rkPath);
+#ifdef _WIN32
+    FILE *pFile = _wfopen(Path.c_str(), Append ? L"ab" : L"wb");
+#else
+    FILE *pFile = std::fopen(Path.c_str(), Append ? "ab" : "wb");
+#endif
+
+    if (!pFile)
+        return false;
+
+    bool Success = (std::fwrite(rkBuffer.data(), 1, rkBuffer.size(), pFile) == rkBuffer.size() && std::fflush(pFile) == 0);
+#ifdef _WIN32
+    Success = Success && (_commit(_fileno(pFile)) == 0);
+#else
+    Success = Success && (fsync(fileno(pFile)) == 0);
+#endif
+    return (std::fclose(pFile) == 0) && Success;
+}
+}
+
+CResourceMetadataStore::CResourceMetadataStore(TString Path, EGame Game)
+    : mPath(std::move(Path))
+    , mGame(Game)
+{
+}
+
+CResourceMetadataStore::~CResourceMetadataStore()
+{
+    Commit();
+}
+
+void CResourceMetadataStore::StoreEntry(CResourceEntry *pEntry)
+{
+    ASSERT(!pEntry->IsMarkedForDeletion());
+
+    if (!mLoaded)
+        Load();
+
+    SEntryData Data = SerializeEntry(pEntry);
+    mPendingEntries.insert_or_assign(pEntry->ID(), Data);
+    SetEntry(pEntry->ID(), std::move(Data));
+
+    if (mBatchDepth == 0)
+        Commit();
+}
+
+void CResourceMetadataStore::EraseEntry(const CAssetID& rkID)
+{
+    if (!mLoaded)
+        Load();
+
+    if (mEntries.find(rkID) == mEntries.cend())
+    {
+        // Nothing to erase on disk; just drop any uncommitted changes
+        mPendingEntries.erase(rkID);
+        return;
+    }
+
+    mPendingEntries.insert_or_assign(rkID, std::nullopt);
+    RemoveEntry(rkID);
+
+    if (mBatchDepth == 0)
+        Commit();
+}
+
+void CResourceMetadataStore::BeginBatch()
+{
+    mBatchDepth++;
+}
+
+bool CResourceMetadataStore::EndBatch()
+{
+    ASSERT(mBatchDepth > 0);
+    mBatchDepth--;
+    return mBatchDepth > 0 || Commit();
+}
+
+bool CResourceMetadataStore::Commit()
+{
+    if (mPendingEntries.empty())
+        return true;
+
+    // Appending to a recovered store would make it look complete; hold the changes until it's rebuilt
+    if (mRecovered)
+        return false;
+
+    std::vector<char> Buffer;
+    CVectorOutStream Out(&Buffer, EEndian::BigEndian);
+
+    if (mFileSize == 0)
+    {
+        FileUtil::MakeDirectory(mPath.GetFileDirectory());
+        WriteHeader(Out, mGame);
+    }
+
+    for (const auto& [ID, Data] : mPendingEntries)
+    {
+        if (Data)
+            WriteEntryRecord(Out, ID, *Data);
+        else
+            WriteEraseRecord(Out, ID);
+    }
+
+    WriteCommitRecord(Out, static_cast<uint32>(mPendingEntries.size()));
+
+    if (!WriteToFile(mPath, Buffer, mFileSize > 0))
+    {
+        // Cut off whatever part of the batch made it into the file, so later batches can still be appended
+        errorf("Failed to write resource metadata store: %s", *mPath);
+        std::error_code Error;
+        std::filesystem::resize_file(std::filesystem::u8path(*mPath), mFileSize, Error);
+        return false;
+    }
+
+    mFileSize += Buffer.size();
+    mPendingEntries.clear();
+
+    if (mFileSize > gkMinCompactSize && mFileSize > mLiveSize * 3)
+        Compact();
+
+    return true;
+}
+
+bool CResourceMetadataStore::Compact()
+{
+    if (!mLoaded)
+        Load();
+
+    // A recovered store may be missing entries, so it's only rewritten by Rebuild
+    if (mRecovered)
+        return false;
+
+    std::vector<char> Buffer;
+    CVectorOutStream Out(&Buffer, EEndian::BigEndian);
+    WriteHeader(Out, mGame);
+
+    for (const auto& [ID, Data] : mEntries)
+        WriteEntryRecord(Out, ID, Data);
+
+    WriteCommitRecord(Out, static_cast<uint32>(mEntries.size()));
+
+    // Write the new file next to the old one, then swap it in, so the store is never left half-written
+    const TString TempPath = mPath + ".tmp";
+    std::error_code Error;
+    FileUtil::MakeDirectory(mPath.GetFileDirectory());
+
+    if (WriteToFile(TempPath, Buffer, false))
+        std::filesystem::rename(std::filesystem::u8path(*TempPath), std::filesystem::u8path(*mPath), Error);
+    else
+        Error = std::make_error_code(std::errc::io_error);
+
+    if (Error)
+    {
+        errorf("Failed to compact resource metadata store: %s", *mPath);
+        FileUtil::DeleteFile(TempPath);
+        return false;
+    }
+
+    // The new file holds the current state of every entry, so any pending changes are committed now too
+    mFileSize = Buffer.size();
+    mPendingEntries.clear();
+    return true;
+}
+
+bool CResourceMetadataStore::Rebuild(CResourceStore *pStore)
+{
+    if (!mLoaded)
+        Load();
+
+    mEntries.clear();
+    mPendingEntries.clear();
+    mLiveSize = 0;
+
+    for (CResourceIterator It(pStore); It; ++It)
+        SetEntry(It->ID(), SerializeEntry(*It));
+
+    mRecovered = false;
+
+    if (!Compact())
+    {
+        mRecovered = true;
+        return false;
+    }
+
+    return true;
+}
+
+bool CResourceMetadataStore::IsRecovered()
+{
+    if (!mLoaded)
+        Load();
+
+    return mRecovered;
+}
+
+bool CResourceMetadataStore::HasFile() const
+{
+    return mFileSize > 0 || FileUtil::Exists(mPath);
+}
+
+const std::map<CAssetID, CResourceMetadataStore::SEntryData>& CResourceMetadataStore::Entries()
+{
+    if (!mLoaded)
+        Load();
+
+    return mEntries;
+}
+
+// ************ PRIVATE ************
+bool CResourceMetadataStore::Load()
+{
+    mLoaded = true;
+    std::vector<uint8> Buffer;
+
+    if (!FileUtil::Exists(mPath) || !FileUtil::LoadFileToBuffer(mPath, Buffer))
+        return false;
+
+    CMemoryInStream File(Buffer.data(), Buffer.size(), EEndian::BigEndian);
+    bool Valid = (Buffer.size() >= gkHeaderSize);
+
+    if (Valid)
+    {
+        const uint32 Magic = File.ReadULong();
+        const uint32 Version = File.ReadULong();
+        const uint32 Game = File.ReadULong();
+        Valid = (Magic == gkStoreMagic && Version == static_cast<uint32>(EMetadataStoreVersion::Current) && Game == static_cast<uint32>(mGame));
+    }
+
+    if (!Valid)
+    {
+        // This may be a store from a newer version of the editor, or a damaged one that could still be recovered,
+        // so move it out of the way rather than deleting it. The entries will be rebuilt from the resources directory.
+        errorf("Invalid resource metadata store; moving it to %s.bad", *mPath);
+        Quarantine(false);
+        mRecovered = true;
+        return false;
+    }
+
+    // Records only take effect once the commit record that ends their batch has been read
+    const EIDLength IDLength = CAssetID::GameIDLength(mGame);
+    const uint32 IDSize = static_cast<uint32>(IDLength);
+    std::vector<std::pair<CAssetID, std::optional<SEntryData>>> Batch;
+    uint32 CommittedSize = gkHeaderSize;
+    bool BatchCorrupt = false;
+    bool FoundCorruption = false;
+
+    while (File.Size() - File.Tell() >= gkRecordHeaderSize)
+    {
+        const uint32 Type = File.ReadULong();
+        const uint32 Size = File.ReadULong();
+        const uint32 Checksum = File.ReadULong();
+        const uint32 PayloadOffset = File.Tell();
+
+        if (Size > File.Size() - PayloadOffset)
+            break;
+
+        CFNV1A Hash(CFNV1A::EHashLength::k32Bit);
+        Hash.HashData(Buffer.data() + PayloadOffset, Size);
+
+        if (Hash.GetHash32() != Checksum)
+        {
+            // The record's size still lines up with the rest of the file, so skip past it. Only the batch it
+            // belongs to is lost; the batches committed after it are still good.
+            BatchCorrupt = true;
+            Batch.emplace_back(CAssetID(), std::nullopt);
+        }
+        else if (Type == gkEntryRecord && Size >= IDSize + 2)
+        {
+            const CAssetID ID(File, IDLength);
+            SEntryData Data;
+            Data.ArchiveVersion = File.ReadUShort();
+            Data.Data.resize(Size - IDSize - 2);
+            File.ReadBytes(Data.Data.data(), Data.Data.size());
+            Batch.emplace_back(ID, std::move(Data));
+        }
+        else if (Type == gkEraseRecord && Size == IDSize)
+        {
+            Batch.emplace_back(CAssetID(File, IDLength), std::nullopt);
+        }
+        else if (Type == gkCommitRecord && Size == 4 && File.ReadULong() == Batch.size())
+        {
+            if (BatchCorrupt)
+            {
+                warnf("Discarding a damaged batch of %u records from resource metadata store: %s", static_cast<uint32>(Batch.size()), *mPath);
+                FoundCorruption = true;
+            }
+            else
+            {
+                for (auto& [ID, Data] : Batch)
+                {
+                    if (Data)
+                        SetEntry(ID, std::move(*Data));
+                    else
+                        RemoveEntry(ID);
+                }
+            }
+
+            Batch.clear();
+            BatchCorrupt = false;
+            CommittedSize = PayloadOffset + Size;
+        }
+        else
+        {
+            break;
+        }
+
+        File.Seek(PayloadOffset + Size, SEEK_SET);
+    }
+
+    mFileSize = CommittedSize;
+
+    if (FoundCorruption)
+    {
+        // Keep a copy of the damaged file. The file itself is left alone until the store is rebuilt, since the
+        // entries from the dropped batch aren't anywhere else on disk.
+        errorf("Resource metadata store is damaged; keeping a copy at %s.bad", *mPath);
+        Quarantine(true);
+        mRecovered = true;
+    }
+    else if (CommittedSize < Buffer.size())
+    {
+        // Anything past the last commit is usually left over from an interrupted write. Keep a copy in case it
+        // isn't, then cut it off so new batches follow on cleanly.
+        warnf("Discarding %u bytes of uncommitted data from resource metadata store: %s", static_cast<uint32>(Buffer.size() - CommittedSize), *mPath);
+        Quarantine(true);
+        mRecovered = true;
+        std::error_code Error;
+        std::filesystem::resize_file(std::filesystem::u8path(*mPath), CommittedSize, Error);
+    }
+
+    return true;
+}
+
+void CResourceMetadataStore::Quarantine(bool KeepOriginal)
+{
+    const std::filesystem::path Path = std::filesystem::u8path(*mPath);
+    const std::filesystem::path BadPath = std::filesystem::u8path(*(mPath + ".bad"));
+    std::error_code Error;
+
+    if (KeepOriginal)
+        std::filesystem::copy_file(Path, BadPath, std::filesystem::copy_options::overwrite_existing, Error);
+    else
+        std::filesystem::rename(Path, BadPath, Error);
+
+    if (Error)
+        errorf("Failed to back up resource metadata store to %s.bad", *mPath);
+}
+
+CResourceMetadataStore::SEntryData CResourceMetadataStore::SerializeEntry(CResourceEntry *pEntry) const
+{
+    SEntryData Data;
+    Data.ArchiveVersion = IArchive::skCurrentArchiveVersion;
+    {
+        CVectorOutStream DataStream(&Data.Data, EEndian::BigEndian);
+        CBasicBinaryWriter Writer(&DataStream, CSerialVersion(IArchive::skCurrentArchiveVersion, 0, mGame));
+        pEntry->SerializeEntryInfo(Writer, false);
+    }
+    return Data;
+}
+
+void CResourceMetadataStore::SetEntry(const CAssetID& rkID, SEntryData&& rData)
+{
+    RemoveEntry(rkID);
+    mLiveSize += EntryRecordSize(rkID, rData);
+    mEntries.insert_or_assign(rkID, std::move(rData));
+}
+
+void CResourceMetadataStore::RemoveEntry(const CAssetID& rkID)
+{
+    const auto Find = mEntries.find(rkID);
+
+    if (Find != mEntries.cend())
+    {
+        mLiveSize -= EntryRecordSize(Find->first, Find->second);
+        mEntries.erase(Find);
+    }
+}
+
+uint64 CResourceMetadataStore::EntryRecordSize(const CAssetID& rkID, const SEntryData& rkData) const
+{
+    return gkRecordHeaderSize + static_cast<uint32>(rkID.Length()) + 2 + rkData.Data.size();
+}
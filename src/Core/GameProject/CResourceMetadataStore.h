@@ -0,0 +1,89 @@
+#ifndef CRESOURCEMETADATASTORE_H
+#define CRESOURCEMETADATASTORE_H
+
+#include <Common/BasicTypes.h>
+#include <Common/CAssetID.h>
+#include <Common/EGame.h>
+#include <Common/TString.h>
+#include <map>
+#include <optional>
+#include <vector>
+
+class CResourceEntry;
+class CResourceStore;
+
+enum class EMetadataStoreVersion
+{
+    Initial,
+    // Add new versions before this line
+
+    Max,
+    Current = Max - 1
+};
+
+// Single file holding the metadata of every resource in a game project, replacing the per-asset .rsmeta files.
+// The file is an append-only log of checksummed records. Changes are written in batches that end with a commit
+// record, and batches that didn't finish committing are discarded on load, so a crash partway through a write
+// can't corrupt anything that was already committed. A damaged file is never deleted; a copy is kept next to it
+// with a .bad extension, and every batch that's still intact is loaded. The store is then marked as recovered:
+// it may be missing entries, so nothing more is written to it until Rebuild replaces its contents with the
+// resource store's entries. Once most of the log is made up of superseded records, it's rewritten from scratch.
+class CResourceMetadataStore
+{
+public:
+    struct SEntryData
+    {
+        uint16 ArchiveVersion;
+        std::vector<char> Data; // Entry info as written by CResourceEntry::SerializeEntryInfo
+    };
+
+private:
+    TString mPath;
+    EGame mGame;
+
+    std::map<CAssetID, SEntryData> mEntries;
+    std::map<CAssetID, std::optional<SEntryData>> mPendingEntries; // Uncommitted changes; erased entries have no data
+    uint32 mBatchDepth = 0;
+    uint64 mFileSize = 0;
+    uint64 mLiveSize = 0;
+    bool mLoaded = false;
+    bool mRecovered = false;
+
+public:
+    CResourceMetadataStore(TString Path, EGame Game);
+    ~CResourceMetadataStore();
+
+    void StoreEntry(CResourceEntry *pEntry);
+    void EraseEntry(const CAssetID& rkID);
+
+    /** Changes made between BeginBatch and the matching EndBatch are committed together */
+    void BeginBatch();
+    bool EndBatch();
+    bool Commit();
+
+    /** Rewrites the file with only the current state of each entry. This commits any pending changes. */
+    bool Compact();
+
+    /** Replaces every entry with the current metadata of the store's resources, and rewrites the file */
+    bool Rebuild(CResourceStore *pStore);
+
+    /** Whether the file was damaged when it was loaded, so the store may be missing entries until it's rebuilt */
+    bool IsRecovered();
+
+    bool HasFile() const;
+    const std::map<CAssetID, SEntryData>& Entries();
+
+    // Accessors
+    TString Path() const    { return mPath; }
+    size_t NumEntries()     { return Entries().size(); }
+
+private:
+    bool Load();
+    void Quarantine(bool KeepOriginal);
+    SEntryData SerializeEntry(CResourceEntry *pEntry) const;
+    void SetEntry(const CAssetID& rkID, SEntryData&& rData);
+    void RemoveEntry(const CAssetID& rkID);
+    uint64 EntryRecordSize(const CAssetID& rkID, const SEntryData& rkData) const;
+};
+
+#endif // CRESOURCEMETADATASTORE_H
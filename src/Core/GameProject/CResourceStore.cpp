@@ -2,6 +2,10 @@
 #include "CGameExporter.h"
 #include "CGameProject.h"
 #include "CResourceIterator.h"
+#include "CResourceLoadQueue.h"
+#include "CDependencyTree.h"
+#include "CFileStateCache.h"
+#include "CResourceMetadataStore.h"
 #include "Core/IUIRelay.h"
 #include "Core/Resource/CResource.h"
 #include <Common/Macros.h>
@@ -10,6 +14,7 @@
 #include <Common/Serialization/Binary.h>
 #include <Common/Serialization/XML.h>
 #include <tinyxml2.h>
+#include <algorithm>
 
 using namespace tinyxml2;
 TString gDataDir;
@@ -23,6 +28,8 @@ CResourceStore::CResourceStore(const TString& rkDatabasePath)
 {
     mpDatabaseRoot = new CVirtualDirectory(this);
     mDatabasePath = FileUtil::MakeAbsolute(rkDatabasePath.GetFileDirectory());
+    mpFileStates = std::make_unique<CFileStateCache>(ResourcesDir());
+    mpLoadQueue = std::make_unique<CResourceLoadQueue>(this);
     if ((mDatabasePathExists = FileUtil::IsDirectory(mDatabasePath)))
         LoadDatabaseCache();
 }
@@ -30,6 +37,7 @@ CResourceStore::CResourceStore(const TString& rkDatabasePath)
 // Main constructor for game projects and game exporter
 CResourceStore::CResourceStore(CGameProject *pProject)
     : mGame(EGame::Invalid)
+    , mpLoadQueue(std::make_unique<CResourceLoadQueue>(this))
 {
     SetProject(pProject);
 }
@@ -127,6 +135,10 @@ bool CResourceStore::SerializeDatabaseCache(IArchive& rArc)
         }
     }
 
+    // The reverse dependency index is derived from the dependency trees loaded above
+    if (rArc.IsReader())
+        RebuildReferencerIndex();
+
     return true;
 }
 
@@ -162,6 +174,11 @@ bool CResourceStore::LoadDatabaseCache()
         }
 
         mGame = Reader.Game();
+
+        // Projects from before the metadata store was added still have their metadata in .rsmeta files. A damaged
+        // store is rebuilt the same way; the database cache has every entry, including any the store lost.
+        if (mpMetadataStore && (!mpMetadataStore->HasFile() || mpMetadataStore->IsRecovered()))
+            MigrateMetadataFiles();
     }
 
     return true;
@@ -172,7 +189,7 @@ bool CResourceStore::SaveDatabaseCache()
     TString Path = DatabasePath();
     debugf("Saving database cache...");
 
-    CBasicBinaryWriter Writer(Path, FOURCC('CACH'), 0, mGame);
+    CBasicBinaryWriter Writer(Path, FOURCC('CACH'), static_cast<uint16>(EDatabaseVersion::Current), mGame);
 
     if (!Writer.IsValid())
         return false;
@@ -204,6 +221,8 @@ void CResourceStore::SetProject(CGameProject *pProj)
     mDatabasePath = mpProj->ProjectRoot();
     mpDatabaseRoot = new CVirtualDirectory(this);
     mGame = mpProj->Game();
+    mpMetadataStore = std::make_unique<CResourceMetadataStore>(mpProj->HiddenFilesDir() + "ResourceMetadata.bin", mGame);
+    mpFileStates = std::make_unique<CFileStateCache>(ResourcesDir());
 
     // Clear deleted files from previous runs
     const TString DeletedPath = DeletedResourcePath();
@@ -216,6 +235,9 @@ void CResourceStore::SetProject(CGameProject *pProj)
 
 void CResourceStore::CloseProject()
 {
+    // Background loads refer to entries that are about to be deleted
+    mpLoadQueue->CancelAll();
+
     // Destroy unreferenced resources first. (This is necessary to avoid invalid memory accesses when
     // various TResPtrs are destroyed. There might be a cleaner solution than this.)
     DestroyUnreferencedResources();
@@ -237,6 +259,7 @@ void CResourceStore::CloseProject()
 
     // Delete all entries from old project
     mResourceEntries.clear();
+    mReferencers.clear();
 
     // Clear deleted files from previous runs
     const TString DeletedPath = DeletedResourcePath();
@@ -248,6 +271,8 @@ void CResourceStore::CloseProject()
 
     delete mpDatabaseRoot;
     mpDatabaseRoot = nullptr;
+    mpMetadataStore.reset();
+    mpFileStates.reset();
     mpProj = nullptr;
     mGame = EGame::Invalid;
 }
@@ -330,6 +355,7 @@ bool CResourceStore::AreAllEntriesValid() const
 void CResourceStore::ClearDatabase()
 {
     // THIS OPERATION REQUIRES THAT ALL RESOURCES ARE UNREFERENCED
+    mpLoadQueue->CancelAll();
     DestroyUnreferencedResources();
 
     if (!mLoadedResources.empty())
@@ -342,6 +368,7 @@ void CResourceStore::ClearDatabase()
 
     // Clear out existing resource entries and directories
     mResourceEntries.clear();
+    mReferencers.clear();
 
     delete mpDatabaseRoot;
     mpDatabaseRoot = new CVirtualDirectory(this);
@@ -353,46 +380,85 @@ bool CResourceStore::BuildFromDirectory(bool ShouldGenerateCacheFile)
 {
     ASSERT(mResourceEntries.empty());
 
-    // Get list of resources
-    TString ResDir = ResourcesDir();
-    TStringList ResourceList;
-    FileUtil::GetDirectoryContents(ResDir, ResourceList);
+    // Game projects keep all their metadata in one file, so there's no need to scan the resources directory.
+    // A store that was damaged may be missing entries though, so it can't be the only source.
+    const bool MetadataRecovered = (mpMetadataStore && mpMetadataStore->IsRecovered());
+    const bool UseMetadataStore = (mpMetadataStore && !MetadataRecovered && mpMetadataStore->NumEntries() > 0);
 
-    for (const auto& Path : ResourceList)
+    if (UseMetadataStore)
     {
-        TString RelPath = Path.ChopFront(ResDir.Size());
-
-        if (FileUtil::IsFile(Path) && Path.EndsWith(".rsmeta"))
+        for (const auto& [ID, rkEntryData] : mpMetadataStore->Entries())
         {
-            // Determine resource name
-            TString DirPath = RelPath.GetFileDirectory();
-            TString CookedFilename = RelPath.GetFileName(false); // This call removes the .rsmeta extension
-            TString ResName = CookedFilename.GetFileName(false); // This call removes the cooked extension
-            ASSERT(IsValidResourcePath(DirPath, ResName));
+            CBasicBinaryReader Reader(rkEntryData.Data.data(), rkEntryData.Data.size(), CSerialVersion(rkEntryData.ArchiveVersion, 0, mGame));
+            auto pEntry = CResourceEntry::BuildFromArchive(this, Reader);
+            ASSERT(pEntry->ID() == ID);
+            mResourceEntries.insert_or_assign(ID, std::move(pEntry));
+        }
+
+        RebuildReferencerIndex();
+    }
+    else
+    {
+        // Get list of resources
+        TString ResDir = ResourcesDir();
+        TStringList ResourceList;
+        FileUtil::GetDirectoryContents(ResDir, ResourceList);
 
-            // Determine resource type
-            TString CookedExtension = CookedFilename.GetFileExtension();
-            CResTypeInfo* pTypeInfo = CResTypeInfo::TypeForCookedExtension(Game(), CFourCC(CookedExtension));
+        for (const auto& Path : ResourceList)
+        {
+            TString RelPath = Path.ChopFront(ResDir.Size());
 
-            if (!pTypeInfo)
+            if (FileUtil::IsFile(Path) && Path.EndsWith(".rsmeta"))
             {
-                errorf("Found resource but couldn't register because failed to identify resource type: %s", *RelPath);
-                continue;
-            }
+                // Determine resource name
+                TString DirPath = RelPath.GetFileDirectory();
+                TString CookedFilename = RelPath.GetFileName(false); // This call removes the .rsmeta extension
+                TString ResName = CookedFilename.GetFileName(false); // This call removes the cooked extension
+                ASSERT(IsValidResourcePath(DirPath, ResName));
+
+                // Determine resource type
+                TString CookedExtension = CookedFilename.GetFileExtension();
+                CResTypeInfo* pTypeInfo = CResTypeInfo::TypeForCookedExtension(Game(), CFourCC(CookedExtension));
+
+                if (!pTypeInfo)
+                {
+                    errorf("Found resource but couldn't register because failed to identify resource type: %s", *RelPath);
+                    continue;
+                }
 
-            // Create resource entry
-            auto pEntry = CResourceEntry::BuildFromDirectory(this, pTypeInfo, DirPath, ResName);
+                // Create resource entry
+                auto pEntry = CResourceEntry::BuildFromDirectory(this, pTypeInfo, DirPath, ResName);
 
-            // Validate the entry
-            const CAssetID ID = pEntry->ID();
-            ASSERT(mResourceEntries.find(ID) == mResourceEntries.cend());
-            ASSERT(ID.Length() == CAssetID::GameIDLength(mGame));
+                // Validate the entry
+                const CAssetID ID = pEntry->ID();
+                ASSERT(mResourceEntries.find(ID) == mResourceEntries.cend());
+                ASSERT(ID.Length() == CAssetID::GameIDLength(mGame));
 
-            mResourceEntries.insert_or_assign(ID, std::move(pEntry));
+                mResourceEntries.insert_or_assign(ID, std::move(pEntry));
+            }
+            else if (FileUtil::IsDirectory(Path))
+            {
+                CreateVirtualDirectory(RelPath);
+            }
         }
-        else if (FileUtil::IsDirectory(Path))
+
+        // The .rsmeta files of a migrated project are gone, so the entries a damaged store still has are the only
+        // record of those resources. Keep the ones that weren't found above and whose files still exist.
+        if (MetadataRecovered)
         {
-            CreateVirtualDirectory(RelPath);
+            for (const auto& [ID, rkEntryData] : mpMetadataStore->Entries())
+            {
+                if (mResourceEntries.find(ID) != mResourceEntries.cend())
+                    continue;
+
+                CBasicBinaryReader Reader(rkEntryData.Data.data(), rkEntryData.Data.size(), CSerialVersion(rkEntryData.ArchiveVersion, 0, mGame));
+                auto pEntry = CResourceEntry::BuildFromArchive(this, Reader);
+
+                if (pEntry->ID() == ID && (pEntry->HasCookedVersion() || pEntry->HasRawVersion()))
+                    mResourceEntries.insert_or_assign(ID, std::move(pEntry));
+                else
+                    pEntry->Directory()->RemoveChildResource(pEntry.get());
+            }
         }
     }
 
@@ -407,9 +473,23 @@ bool CResourceStore::BuildFromDirectory(bool ShouldGenerateCacheFile)
         if (mpProj)
             mpProj->AudioManager()->LoadAssets();
 
-        // Update dependencies
+        // Update dependencies. Entries from the metadata store already have theirs unless they were never built.
+        // Each update stores the entry's metadata, so commit them all together rather than once per entry.
+        if (mpMetadataStore)
+            mpMetadataStore->BeginBatch();
+
         for (CResourceIterator It(this); It; ++It)
-            It->UpdateDependencies();
+        {
+            if (!UseMetadataStore || !It->Dependencies())
+                It->UpdateDependencies();
+        }
+
+        // This batch has to be committed before migrating, which deletes the .rsmeta files once its own batch is written
+        if (mpMetadataStore)
+            mpMetadataStore->EndBatch();
+
+        if (mpMetadataStore && !UseMetadataStore)
+            MigrateMetadataFiles();
 
         // Update database file
         mDatabaseCacheDirty = true;
@@ -427,10 +507,32 @@ void CResourceStore::RebuildFromDirectory()
     if (mpProj)
         mpProj->AudioManager()->ClearAssets();
 
+    mpFileStates->InvalidateAll();
     ClearDatabase();
     BuildFromDirectory(true);
 }
 
+void CResourceStore::MigrateMetadataFiles()
+{
+    // Replace the metadata store's contents with every entry, then remove the .rsmeta files it replaces
+    ASSERT(mpMetadataStore);
+    debugf("Migrating resource metadata to %s", *mpMetadataStore->Path());
+
+    if (!mpMetadataStore->Rebuild(this))
+    {
+        errorf("Failed to migrate resource metadata; keeping the existing metadata files");
+        return;
+    }
+
+    for (CResourceIterator It(this); It; ++It)
+    {
+        const TString MetaPath = It->MetadataFilePath();
+
+        if (FileUtil::Exists(MetaPath))
+            FileUtil::DeleteFile(MetaPath);
+    }
+}
+
 bool CResourceStore::IsResourceRegistered(const CAssetID& rkID) const
 {
     return FindEntry(rkID) != nullptr;
@@ -542,6 +644,26 @@ CResource* CResourceStore::LoadResource(const TString& rkPath)
     return nullptr;
 }
 
+std::shared_ptr<CResourceLoadRequest> CResourceStore::LoadResourceAsync(const CAssetID& rkID)
+{
+    if (!rkID.IsValid())
+        return nullptr;
+
+    CResourceEntry *pEntry = FindEntry(rkID);
+    if (!pEntry)
+    {
+        warnf("Can't find requested resource with ID \"%s\"", *rkID.ToString());
+        return nullptr;
+    }
+
+    return mpLoadQueue->Load(pEntry);
+}
+
+void CResourceStore::UpdateAsyncLoads()
+{
+    mpLoadQueue->Update();
+}
+
 void CResourceStore::TrackLoadedResource(CResourceEntry *pEntry)
 {
     ASSERT(pEntry->IsLoaded());
@@ -593,6 +715,12 @@ bool CResourceStore::DeleteResourceEntry(CResourceEntry *pEntry)
     if (pEntry->Directory())
         pEntry->Directory()->RemoveChildResource(pEntry);
 
+    RemoveReferences(pEntry);
+    mpLoadQueue->Cancel(ID);
+
+    if (mpMetadataStore)
+        mpMetadataStore->EraseEntry(ID);
+
     const auto It = mResourceEntries.find(ID);
     ASSERT(It != mResourceEntries.end());
     mResourceEntries.erase(It);
@@ -601,6 +729,74 @@ bool CResourceStore::DeleteResourceEntry(CResourceEntry *pEntry)
     return true;
 }
 
+void CResourceStore::AddReferences(const CResourceEntry *pEntry)
+{
+    if (!pEntry->Dependencies())
+        return;
+
+    std::set<CAssetID> Dependencies;
+    pEntry->Dependencies()->GetAllResourceReferences(Dependencies);
+
+    for (const CAssetID& rkID : Dependencies)
+    {
+        if (rkID.IsValid())
+            mReferencers[rkID].insert(pEntry->ID());
+    }
+}
+
+void CResourceStore::RemoveReferences(const CResourceEntry *pEntry)
+{
+    if (!pEntry->Dependencies())
+        return;
+
+    std::set<CAssetID> Dependencies;
+    pEntry->Dependencies()->GetAllResourceReferences(Dependencies);
+
+    for (const CAssetID& rkID : Dependencies)
+    {
+        const auto Find = mReferencers.find(rkID);
+
+        if (Find != mReferencers.cend())
+        {
+            Find->second.erase(pEntry->ID());
+
+            if (Find->second.empty())
+                mReferencers.erase(Find);
+        }
+    }
+}
+
+void CResourceStore::RebuildReferencerIndex()
+{
+    // Include entries marked for deletion, so their references are still indexed if the deletion is undone
+    mReferencers.clear();
+
+    for (const auto& [ID, pEntry] : mResourceEntries)
+        AddReferences(pEntry.get());
+}
+
+std::vector<CResourceEntry*> CResourceStore::FindReferencers(const CAssetID& rkID, EResourceType Type) const
+{
+    std::vector<CResourceEntry*> Out;
+    const auto Find = mReferencers.find(rkID);
+
+    if (Find == mReferencers.cend())
+        return Out;
+
+    Out.reserve(Find->second.size());
+
+    for (const CAssetID& rkReferencerID : Find->second)
+    {
+        // FindEntry skips entries that are marked for deletion
+        CResourceEntry *pEntry = FindEntry(rkReferencerID);
+
+        if (pEntry && (Type == EResourceType::Invalid || pEntry->ResourceType() == Type))
+            Out.push_back(pEntry);
+    }
+
+    return Out;
+}
+
 #ifdef _WIN32
 static int wrap_fopen(FILE** pFile, const char *filename, const char *mode)
 {
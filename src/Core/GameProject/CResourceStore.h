@@ -10,10 +10,15 @@
 #include <map>
 #include <memory>
 #include <set>
+#include <vector>
 
 class CGameExporter;
 class CGameProject;
+class CFileStateCache;
 class CResource;
+class CResourceLoadQueue;
+class CResourceLoadRequest;
+class CResourceMetadataStore;
 
 enum class EDatabaseVersion
 {
@@ -33,6 +38,10 @@ class CResourceStore
     CVirtualDirectory *mpDatabaseRoot = nullptr;
     std::map<CAssetID, std::unique_ptr<CResourceEntry>> mResourceEntries;
     std::map<CAssetID, CResourceEntry*> mLoadedResources;
+    std::map<CAssetID, std::set<CAssetID>> mReferencers; // Asset ID -> IDs of the entries that depend on it
+    std::unique_ptr<CResourceMetadataStore> mpMetadataStore; // Game projects only; the editor store uses .rsmeta files
+    std::unique_ptr<CFileStateCache> mpFileStates;
+    std::unique_ptr<CResourceLoadQueue> mpLoadQueue;
     bool mDatabaseCacheDirty = false;
 
     // Directory paths
@@ -64,15 +73,24 @@ public:
     void ClearDatabase();
     bool BuildFromDirectory(bool ShouldGenerateCacheFile);
     void RebuildFromDirectory();
+    void MigrateMetadataFiles();
 
     template<typename ResType> ResType* LoadResource(const CAssetID& rkID)  { return static_cast<ResType*>(LoadResource(rkID, ResType::StaticType())); }
     CResource* LoadResource(const CAssetID& rkID);
     CResource* LoadResource(const CAssetID& rkID, EResourceType Type);
     CResource* LoadResource(const TString& rkPath);
+    std::shared_ptr<CResourceLoadRequest> LoadResourceAsync(const CAssetID& rkID);
+    void UpdateAsyncLoads();
     void TrackLoadedResource(CResourceEntry *pEntry);
     void DestroyUnreferencedResources();
     bool DeleteResourceEntry(CResourceEntry *pEntry);
 
+    /** Reverse dependency index. Entries register their dependencies whenever they are rebuilt. */
+    void AddReferences(const CResourceEntry *pEntry);
+    void RemoveReferences(const CResourceEntry *pEntry);
+    void RebuildReferencerIndex();
+    std::vector<CResourceEntry*> FindReferencers(const CAssetID& rkID, EResourceType Type = EResourceType::Invalid) const;
+
     void ImportNamesFromPakContentsTxt(const TString& rkTxtPath, bool UnnamedOnly);
 
     static bool IsValidResourcePath(const TString& rkPath, const TString& rkName);
@@ -86,6 +104,9 @@ public:
     TString ResourcesDir() const             { return IsEditorStore() ? DatabaseRootPath() : DatabaseRootPath() + "Resources/"; }
     TString DatabasePath() const             { return DatabaseRootPath() + "ResourceDatabaseCache.bin"; }
     CVirtualDirectory* RootDirectory() const { return mpDatabaseRoot; }
+    CResourceMetadataStore* MetadataStore() const { return mpMetadataStore.get(); }
+    CFileStateCache* FileStates() const      { return mpFileStates.get(); }
+    CResourceLoadQueue* LoadQueue() const    { return mpLoadQueue.get(); }
     uint32 NumTotalResources() const         { return mResourceEntries.size(); }
     uint32 NumLoadedResources() const        { return mLoadedResources.size(); }
     bool IsCacheDirty() const                { return mDatabaseCacheDirty; }
@@ -93,20 +93,21 @@ CVirtualDirectory* CVirtualDirectory::FindChildDirectory(const TString& rkName,
     const uint32 SlashIdx = rkName.IndexOf("\\/");
     const TString DirName = (SlashIdx == UINT32_MAX ? static_cast<TString::BaseClass>(rkName) : rkName.SubString(0, SlashIdx));
 
-    for (auto* child : mSubdirectories)
+    const auto Find = mSubdirectoryLookup.find(DirName.ToUpper());
+
+    if (Find != mSubdirectoryLookup.cend())
     {
-        if (child->Name().CaseInsensitiveCompare(DirName))
-        {
-            if (SlashIdx == UINT32_MAX)
-                return child;
+        CVirtualDirectory *pChild = Find->second;
 
-            const TString Remaining = rkName.SubString(SlashIdx + 1, rkName.Size() - SlashIdx);
+        if (SlashIdx == UINT32_MAX)
+            return pChild;
 
-            if (Remaining.IsEmpty())
-                return child;
+        const TString Remaining = rkName.SubString(SlashIdx + 1, rkName.Size() - SlashIdx);
 
-            return child->FindChildDirectory(Remaining, AllowCreate);
-        }
+        if (Remaining.IsEmpty())
+            return pChild;
+
+        return pChild->FindChildDirectory(Remaining, AllowCreate);
     }
 
     if (AllowCreate)
@@ -145,14 +146,12 @@ CResourceEntry* CVirtualDirectory::FindChildResource(const TString& rkPath)
 
 CResourceEntry* CVirtualDirectory::FindChildResource(const TString& rkName, EResourceType Type)
 {
-    const auto it = std::find_if(mResources.begin(), mResources.end(), [&](const auto* resource) {
-        return rkName.CaseInsensitiveCompare(resource->Name()) && resource->ResourceType() == Type;
-    });
+    const auto Find = mResourceLookup.find(SResourceKey{rkName.ToUpper(), Type});
 
-    if (it == mResources.cend())
+    if (Find == mResourceLookup.cend())
         return nullptr;
 
-    return *it;
+    return Find->second;
 }
 
 bool CVirtualDirectory::AddChild(const TString &rkPath, CResourceEntry *pEntry)
@@ -161,7 +160,7 @@ bool CVirtualDirectory::AddChild(const TString &rkPath, CResourceEntry *pEntry)
     {
         if (pEntry != nullptr)
         {
-            mResources.push_back(pEntry);
+            AddResource(pEntry);
             return true;
         }
 
@@ -175,16 +174,8 @@ bool CVirtualDirectory::AddChild(const TString &rkPath, CResourceEntry *pEntry)
         const TString Remaining = (SlashIdx == UINT32_MAX ? "" : rkPath.SubString(SlashIdx + 1, rkPath.Size() - SlashIdx));
 
         // Check if this subdirectory already exists
-        CVirtualDirectory* pSubdir = nullptr;
-
-        for (auto* subdirectory : mSubdirectories)
-        {
-            if (subdirectory->Name() == DirName)
-            {
-                pSubdir = subdirectory;
-                break;
-            }
-        }
+        const auto Find = mSubdirectoryLookup.find(DirName.ToUpper());
+        CVirtualDirectory* pSubdir = (Find != mSubdirectoryLookup.cend() ? Find->second : nullptr);
 
         if (pSubdir == nullptr)
         {
@@ -197,7 +188,7 @@ bool CVirtualDirectory::AddChild(const TString &rkPath, CResourceEntry *pEntry)
                 return false;
             }
 
-            mSubdirectories.push_back(pSubdir);
+            AddSubdirectory(pSubdir);
             SortSubdirectories();
 
             // As an optimization, don't recurse here. We've already verified the full path is valid, so we don't need to do it again.
@@ -214,11 +205,11 @@ bool CVirtualDirectory::AddChild(const TString &rkPath, CResourceEntry *pEntry)
                     return false;
                 }
 
-                pSubdir->Parent()->mSubdirectories.push_back(pSubdir);
+                pSubdir->Parent()->AddSubdirectory(pSubdir);
             }
 
             if (pEntry != nullptr)
-                pSubdir->mResources.push_back(pEntry);
+                pSubdir->AddResource(pEntry);
 
             return true;
         }
@@ -242,7 +233,7 @@ bool CVirtualDirectory::AddChild(CVirtualDirectory *pDir)
     if (FindChildDirectory(pDir->Name(), false) != nullptr)
         return false;
 
-    mSubdirectories.push_back(pDir);
+    AddSubdirectory(pDir);
     SortSubdirectories();
 
     return true;
@@ -257,6 +248,10 @@ bool CVirtualDirectory::RemoveChildDirectory(CVirtualDirectory *pSubdir)
         return false;
 
     mSubdirectories.erase(it);
+
+    if (const auto Find = mSubdirectoryLookup.find(pSubdir->Name().ToUpper()); Find != mSubdirectoryLookup.cend() && Find->second == pSubdir)
+        mSubdirectoryLookup.erase(Find);
+
     return true;
 }
 
@@ -269,9 +264,17 @@ bool CVirtualDirectory::RemoveChildResource(CResourceEntry *pEntry)
         return false;
 
     mResources.erase(it);
+    RemoveResourceLookup(pEntry, pEntry->UppercaseName());
     return true;
 }
 
+void CVirtualDirectory::ChildResourceRenamed(CResourceEntry *pEntry, const TString& rkOldUppercaseName)
+{
+    // Only re-key entries that are actually in this directory
+    if (RemoveResourceLookup(pEntry, rkOldUppercaseName))
+        mResourceLookup.emplace(SResourceKey{pEntry->UppercaseName(), pEntry->ResourceType()}, pEntry);
+}
+
 void CVirtualDirectory::SortSubdirectories()
 {
     std::sort(mSubdirectories.begin(), mSubdirectories.end(), [](const auto* pLeft, const auto* pRight) {
@@ -292,7 +295,9 @@ bool CVirtualDirectory::Rename(const TString& rkNewName)
 
             if (FileUtil::MoveDirectory(AbsPath, NewPath))
             {
+                mpParent->mSubdirectoryLookup.erase(mName.ToUpper());
                 mName = rkNewName;
+                mpParent->mSubdirectoryLookup.insert_or_assign(mName.ToUpper(), this);
                 mpStore->SetCacheDirty();
                 mpParent->SortSubdirectories();
                 return true;
@@ -395,6 +400,45 @@ bool CVirtualDirectory::SetParent(CVirtualDirectory *pParent)
     }
 }
 
+// ************ PRIVATE ************
+void CVirtualDirectory::AddSubdirectory(CVirtualDirectory *pSubdir)
+{
+    mSubdirectories.push_back(pSubdir);
+    mSubdirectoryLookup.insert_or_assign(pSubdir->Name().ToUpper(), pSubdir);
+}
+
+void CVirtualDirectory::AddResource(CResourceEntry *pEntry)
+{
+    mResources.push_back(pEntry);
+    mResourceLookup.emplace(SResourceKey{pEntry->UppercaseName(), pEntry->ResourceType()}, pEntry);
+}
+
+bool CVirtualDirectory::RemoveResourceLookup(CResourceEntry *pEntry, const TString& rkUpperName)
+{
+    const auto [Begin, End] = mResourceLookup.equal_range(SResourceKey{rkUpperName, pEntry->ResourceType()});
+
+    for (auto It = Begin; It != End; ++It)
+    {
+        if (It->second == pEntry)
+        {
+            mResourceLookup.erase(It);
+            return true;
+        }
+    }
+
+    // The entry's name was changed without telling us; fall back to searching the whole index
+    for (auto It = mResourceLookup.begin(); It != mResourceLookup.end(); ++It)
+    {
+        if (It->second == pEntry)
+        {
+            mResourceLookup.erase(It);
+            return true;
+        }
+    }
+
+    return false;
+}
+
 // ************ STATIC ************
 bool CVirtualDirectory::IsValidDirectoryName(const TString& rkName)
 {
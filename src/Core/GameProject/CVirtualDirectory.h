@@ -5,6 +5,8 @@
 #include "Core/Resource/EResType.h"
 #include <Common/Macros.h>
 #include <Common/TString.h>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
 class CResourceEntry;
@@ -12,11 +14,32 @@ class CResourceStore;
 
 class CVirtualDirectory
 {
+    // Children are indexed by their uppercase name, so lookups are case-insensitive
+    struct SNameHash
+    {
+        size_t operator()(const TString& rkName) const { return std::hash<std::string_view>()(std::string_view(*rkName, rkName.Size())); }
+    };
+
+    struct SResourceKey
+    {
+        TString UpperName;
+        EResourceType Type;
+
+        bool operator==(const SResourceKey& rkOther) const { return Type == rkOther.Type && UpperName == rkOther.UpperName; }
+    };
+
+    struct SResourceKeyHash
+    {
+        size_t operator()(const SResourceKey& rkKey) const { return SNameHash()(rkKey.UpperName) * 31 + static_cast<size_t>(rkKey.Type); }
+    };
+
     CVirtualDirectory *mpParent = nullptr;
     CResourceStore *mpStore;
     TString mName;
     std::vector<CVirtualDirectory*> mSubdirectories;
     std::vector<CResourceEntry*> mResources;
+    std::unordered_map<TString, CVirtualDirectory*, SNameHash> mSubdirectoryLookup;
+    std::unordered_multimap<SResourceKey, CResourceEntry*, SResourceKeyHash> mResourceLookup;
 
 public:
     explicit CVirtualDirectory(CResourceStore *pStore);
@@ -37,6 +60,7 @@ public:
     bool AddChild(CVirtualDirectory *pDir);
     bool RemoveChildDirectory(CVirtualDirectory *pSubdir);
     bool RemoveChildResource(CResourceEntry *pEntry);
+    void ChildResourceRenamed(CResourceEntry *pEntry, const TString& rkOldUppercaseName);
     void SortSubdirectories();
     bool Rename(const TString& rkNewName);
     bool Delete();
@@ -58,6 +82,11 @@ public:
     size_t NumResources() const                                      { return mResources.size(); }
     CResourceEntry* ResourceByIndex(size_t Index)                    { return mResources[Index]; }
     const CResourceEntry* ResourceByIndex(size_t Index) const        { return mResources[Index]; }
+
+private:
+    void AddSubdirectory(CVirtualDirectory *pSubdir);
+    void AddResource(CResourceEntry *pEntry);
+    bool RemoveResourceLookup(CResourceEntry *pEntry, const TString& rkUpperName);
 };
 
 #endif // CVIRTUALDIRECTORY
@@ -1,9 +1,39 @@
 #include "NCoreTests.h"
+#include "CThreadPool.h"
+#include "CompressionUtil.h"
 #include "IUIRelay.h"
 #include "Core/GameProject/CGameProject.h"
+#include "Core/GameProject/CPackage.h"
 #include "Core/GameProject/CResourceEntry.h"
 #include "Core/GameProject/CResourceIterator.h"
+#include "Core/GameProject/CResourceLoadQueue.h"
+#include "Core/OpenGL/CVertexBuffer.h"
+#include "Core/Resource/Area/CGameArea.h"
 #include "Core/Resource/Cooker/CResourceCooker.h"
+#include "Core/Resource/Factory/CResourceFactory.h"
+#include "Core/Resource/Script/CScriptLayer.h"
+#include "Core/Resource/Script/CScriptObject.h"
+#include "Core/Scene/CScene.h"
+#include "Core/Scene/CSceneIterator.h"
+#include <Common/CTimer.h>
+#include <Common/FileUtil.h>
+#include <Common/Math/MathUtil.h>
+#include <Common/Serialization/Binary.h>
+#include <Common/Serialization/XML.h>
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <future>
+#include <numeric>
+#include <set>
+
+#if USE_LZOKAY
+#include <lzokay.hpp>
+#else
+#include <lzo/lzo1x.h>
+#endif
+
+#include <zlib.h>
 
 namespace NCoreTests
 {
@@ -54,15 +84,90 @@ bool RunTests(int argc, char* argv[])
         // Fetch parameters
         const char* pkType = ParseParameter("-type", argc, argv);
         EResourceType Type = TEnumReflection<EResourceType>::ConvertStringToValue(pkType);
-        bool AllowDump = ParseToken("-allowdump", argc, argv);
+        const char* pkJobs = ParseParameter("-jobs", argc, argv);
+        const char* pkShard = ParseParameter("-shard", argc, argv);
+        const char* pkReport = ParseParameter("-report", argc, argv);
+
+        SValidateCookerOptions Options;
+        Options.DumpFileContents = ParseToken("-allowdump", argc, argv);
+        Options.NumJobs = (pkJobs ? static_cast<uint32>(strtoul(pkJobs, nullptr, 10)) : 0);
+        Options.ReportPath = (pkReport ? pkReport : "");
+        Options.Resume = ParseToken("-resume", argc, argv);
+
+        if( pkShard && sscanf(pkShard, "%u/%u", &Options.ShardIndex, &Options.NumShards) != 2 )
+            Options.NumShards = 0;
 
-        if( Type == EResourceType::Invalid )
+        if( Type == EResourceType::Invalid || Options.NumShards == 0 || Options.ShardIndex >= Options.NumShards )
         {
-            gpUIRelay->ShowMessageBox("ValidateCooker", "Usage: ValidateCooker -type=<ResourceType> [-allowdump] [-project=<Project>]");
+            gpUIRelay->ShowMessageBox("ValidateCooker", "Usage: ValidateCooker -type=<ResourceType> [-allowdump] [-project=<Project>] "
+                                                        "[-jobs=<N>] [-shard=<Index>/<Count>] [-report=<Path> [-resume]]");
         }
         else if( gpUIRelay->OpenProject(ParseParameter("-project", argc, argv)) )
         {
-            ValidateCooker(Type, AllowDump);
+            ValidateCooker(Type, Options);
+        }
+        return true;
+    }
+
+    if( ParseToken("ValidateRawFormat", argc, argv) )
+    {
+        if( gpUIRelay->OpenProject(ParseParameter("-project", argc, argv)) )
+        {
+            ValidateRawFormat();
+        }
+        return true;
+    }
+
+    if( ParseToken("ValidatePakPatching", argc, argv) )
+    {
+        if( gpUIRelay->OpenProject(ParseParameter("-project", argc, argv)) )
+        {
+            ValidatePakPatching();
+        }
+        return true;
+    }
+
+    if( ParseToken("BenchmarkVertexWelding", argc, argv) )
+    {
+        if( gpUIRelay->OpenProject(ParseParameter("-project", argc, argv)) )
+        {
+            BenchmarkVertexWelding();
+        }
+        return true;
+    }
+
+    if( ParseToken("BenchmarkCollisionRayCasts", argc, argv) )
+    {
+        if( gpUIRelay->OpenProject(ParseParameter("-project", argc, argv)) )
+        {
+            BenchmarkCollisionRayCasts();
+        }
+        return true;
+    }
+
+    if( ParseToken("BenchmarkSceneLoad", argc, argv) )
+    {
+        if( gpUIRelay->OpenProject(ParseParameter("-project", argc, argv)) )
+        {
+            BenchmarkSceneLoad();
+        }
+        return true;
+    }
+
+    if( ParseToken("BenchmarkScriptLoad", argc, argv) )
+    {
+        if( gpUIRelay->OpenProject(ParseParameter("-project", argc, argv)) )
+        {
+            BenchmarkScriptLoad();
+        }
+        return true;
+    }
+
+    if( ParseToken("BenchmarkCompression", argc, argv) )
+    {
+        if( gpUIRelay->OpenProject(ParseParameter("-project", argc, argv)) )
+        {
+            BenchmarkCompression();
         }
         return true;
     }
@@ -71,11 +176,150 @@ bool RunTests(int argc, char* argv[])
     return false;
 }
 
+namespace
+{
+
+/** Outcome of validating one resource */
+struct SCookerValidationResult
+{
+    CAssetID ID;
+    TString Path;
+    bool Valid = false;
+    TString Reason;
+    uint32 OriginalSize = 0;
+    uint32 NewSize = 0;
+    uint32 MismatchOffset = UINT32_MAX;
+    float CompareTime = 0.f;
+
+    void Serialize(IArchive& rArc)
+    {
+        rArc << SerialParameter("ID", ID)
+             << SerialParameter("Path", Path)
+             << SerialParameter("Valid", Valid)
+             << SerialParameter("Reason", Reason, SH_Optional, TString())
+             << SerialParameter("OriginalSize", OriginalSize)
+             << SerialParameter("NewSize", NewSize)
+             << SerialParameter("MismatchOffset", MismatchOffset, SH_Optional, static_cast<uint32>(UINT32_MAX));
+    }
+};
+
+/** Results of a ValidateCooker run. Saved as it goes, so an interrupted run can pick up where it left off. */
+struct SCookerValidationReport
+{
+    EResourceType ResourceType = EResourceType::Invalid;
+    uint32 ShardIndex = 0;
+    uint32 NumShards = 1;
+    uint32 NumValid = 0;
+    uint32 NumInvalid = 0;
+    uint32 NumRemaining = 0;
+    float Seconds = 0.f;
+    float ResourcesPerSecond = 0.f;
+    float CookedMBPerSecond = 0.f;
+    std::vector<SCookerValidationResult> Results;
+
+    void Serialize(IArchive& rArc)
+    {
+        rArc << SerialParameter("ResourceType", ResourceType)
+             << SerialParameter("ShardIndex", ShardIndex)
+             << SerialParameter("NumShards", NumShards)
+             << SerialParameter("NumValid", NumValid)
+             << SerialParameter("NumInvalid", NumInvalid)
+             << SerialParameter("NumRemaining", NumRemaining)
+             << SerialParameter("Seconds", Seconds)
+             << SerialParameter("ResourcesPerSecond", ResourcesPerSecond)
+             << SerialParameter("CookedMBPerSecond", CookedMBPerSecond)
+             << SerialParameter("Results", Results);
+    }
+};
+
+/** Compares recooked data against the original file. Only touches its arguments, so it can run on a worker thread. */
+SCookerValidationResult CompareCookedData(const TString& rkOriginalPath, const std::vector<char>& rkNewData, EGame Game, SCookerValidationResult Result)
+{
+    const double StartTime = CTimer::GlobalTime();
+    Result.NewSize = static_cast<uint32>(rkNewData.size());
+
+    std::vector<uint8> OriginalData;
+
+    if (!FileUtil::LoadFileToBuffer(rkOriginalPath, OriginalData))
+    {
+        Result.Reason = "failed to read original";
+        return Result;
+    }
+
+    Result.OriginalSize = static_cast<uint32>(OriginalData.size());
+
+    // Start our comparison by making sure the sizes match up
+    const uint kAlignment           = (Game >= EGame::Corruption ? 64 : 32);
+    const uint kAlignedOriginalSize = VAL_ALIGN( (uint) OriginalData.size(), kAlignment );
+    const uint kAlignedNewSize      = VAL_ALIGN( (uint) rkNewData.size(), kAlignment );
+
+    // Note where the data first differs, even if the sizes don't match, as it's the most useful hint when debugging a cooker
+    const size_t DataSize = std::min(OriginalData.size(), rkNewData.size());
+    const auto Mismatch = std::mismatch(OriginalData.cbegin(), OriginalData.cbegin() + DataSize, rkNewData.cbegin(),
+                                        [](uint8 Original, char New) { return Original == static_cast<uint8>(New); });
+
+    if (Mismatch.first != OriginalData.cbegin() + DataSize)
+        Result.MismatchOffset = static_cast<uint32>(Mismatch.first - OriginalData.cbegin());
+
+    if( kAlignedOriginalSize != kAlignedNewSize ||
+        OriginalData.size() < rkNewData.size() )
+    {
+        Result.Reason = "size mismatch";
+    }
+    else if( Result.MismatchOffset != UINT32_MAX )
+    {
+        Result.Reason = "data mismatch";
+    }
+    else
+    {
+        // Note that the original asset can have alignment padding at the end, which is applied
+        // by the pak but usually preserved in extracted files. We do not include this in the
+        // comparison as missing padding does not indicate malformed data.
+        const bool MissingData = std::any_of(OriginalData.cbegin() + DataSize, OriginalData.cend(),
+                                             [](uint8 Byte) { return Byte != 0xFF; });
+
+        if (MissingData)
+            Result.Reason = "missing data";
+        else
+            Result.Valid = true;
+    }
+
+    Result.CompareTime = static_cast<float>(CTimer::GlobalTime() - StartTime);
+    return Result;
+}
+
+bool SaveValidationReport(const TString& rkPath, EGame Game, SCookerValidationReport& rReport)
+{
+    // Write to a temporary file and swap it in, so an interrupted save can't cost us the results of the last one
+    const TString TempPath = rkPath + ".tmp";
+    {
+        CXMLWriter Writer(TempPath, "CookerValidation", 0, Game);
+        rReport.Serialize(Writer);
+
+        if (!Writer.Save())
+            return false;
+    }
+
+    if (FileUtil::Exists(rkPath) && !FileUtil::DeleteFile(rkPath))
+        return false;
+
+    return FileUtil::MoveFile(TempPath, rkPath);
+}
+
+}
+
 /** Validate all cooker output for the given resource type matches the original asset data */
 bool ValidateCooker(EResourceType ResourceType, bool DumpInvalidFileContents)
 {
-    debugf( "Validating output of %s cooker...",
-            TEnumReflection<EResourceType>::ConvertValueToString(ResourceType) );
+    SValidateCookerOptions Options;
+    Options.DumpFileContents = DumpInvalidFileContents;
+    return ValidateCooker(ResourceType, Options);
+}
+
+bool ValidateCooker(EResourceType ResourceType, const SValidateCookerOptions& rkOptions)
+{
+    const char *pkTypeName = TEnumReflection<EResourceType>::ConvertValueToString(ResourceType);
+    debugf("Validating output of %s cooker...", pkTypeName);
 
     // There must be a project loaded
     CResourceStore* pStore = gpResourceStore;
@@ -87,119 +331,972 @@ bool ValidateCooker(EResourceType ResourceType, bool DumpInvalidFileContents)
         return false;
     }
 
-    TString ResourcesDir = pProject->ResourcesDir(false);
-    uint NumValid = 0, NumInvalid = 0;
+    if (rkOptions.NumShards == 0 || rkOptions.ShardIndex >= rkOptions.NumShards)
+    {
+        errorf("Cooker unit test failed; invalid shard %d/%d", rkOptions.ShardIndex, rkOptions.NumShards);
+        return false;
+    }
+
+    SCookerValidationReport Report;
+    Report.ResourceType = ResourceType;
+    Report.ShardIndex = rkOptions.ShardIndex;
+    Report.NumShards = rkOptions.NumShards;
+
+    const bool WriteReport = !rkOptions.ReportPath.IsEmpty();
+
+    // Pick up the results of an earlier run of the same shard
+    if (WriteReport && rkOptions.Resume && FileUtil::Exists(rkOptions.ReportPath))
+    {
+        CXMLReader Reader(rkOptions.ReportPath);
+
+        if (!Reader.IsValid())
+        {
+            warnf("Ignoring %s; the file couldn't be read", *rkOptions.ReportPath);
+        }
+        else
+        {
+            SCookerValidationReport Previous;
+            Previous.Serialize(Reader);
+
+            if (Previous.ResourceType == ResourceType && Previous.ShardIndex == Report.ShardIndex && Previous.NumShards == Report.NumShards)
+            {
+                Report.Results = std::move(Previous.Results);
+                debugf("Resuming from %s; %d resources already checked", *rkOptions.ReportPath, (uint) Report.Results.size());
+            }
+            else
+            {
+                warnf("Ignoring %s; it was written by a different test", *rkOptions.ReportPath);
+            }
+        }
+    }
+
+    std::set<CAssetID> Checked;
+
+    for (const SCookerValidationResult& rkResult : Report.Results)
+    {
+        Checked.insert(rkResult.ID);
+        (rkResult.Valid ? Report.NumValid : Report.NumInvalid)++;
+    }
+
+    // The iterator walks resources in ID order, so every run splits them into the same shards
+    const TString ResourcesDir = pProject->ResourcesDir(false);
+    std::vector<CResourceEntry*> Entries;
+    uint32 NumMatching = 0;
 
-    // Iterate through all resources
     for (CResourceIterator It(pStore); It; ++It)
     {
         if (It->ResourceType() != ResourceType || !It->HasCookedVersion())
             continue;
 
-        // Get original cooked data
-        TString CookedPath = It->CookedAssetPath(true);
-        CFileInStream FileStream(ResourcesDir / CookedPath, EEndian::BigEndian);
-
-        if (!FileStream.IsValid())
+        if (NumMatching++ % rkOptions.NumShards != rkOptions.ShardIndex || Checked.find(It->ID()) != Checked.cend())
             continue;
 
-        std::vector<uint8> OriginalData( FileStream.Size() );
-        FileStream.ReadBytes(OriginalData.data(), OriginalData.size());
-        FileStream.Close();
+        if (FileUtil::Exists(ResourcesDir / It->CookedAssetPath(true)))
+            Entries.push_back(*It);
+    }
+
+    // Recooking loads resources through the store, so it stays on this thread. Loads are started a few resources
+    // ahead so the queue can read and decode their data in the background, and the comparisons run on the workers.
+    constexpr size_t kLoadAhead = 8;
+    constexpr size_t kUnloadInterval = 64;
+    constexpr size_t kReportSaveInterval = 256;
+    constexpr uint32 kMaxInvalid = 100;
+
+    CThreadPool Pool(rkOptions.NumJobs);
+    const size_t MaxPendingCompares = std::max<size_t>(Pool.NumThreads() * 2, 1);
+    std::deque<std::shared_ptr<CResourceLoadRequest>> Loads;
+    std::deque<std::future<SCookerValidationResult>> Compares;
+    size_t NextLoad = 0;
+
+    double LoadTime = 0.0, CookTime = 0.0, CompareTime = 0.0;
+    uint64 CookedBytes = 0;
+    uint32 NumChecked = 0;
+    const double StartTime = CTimer::GlobalTime();
+
+    const auto FinishCompare = [&]()
+    {
+        SCookerValidationResult Result = Compares.front().get();
+        Compares.pop_front();
+
+        if (Result.Valid)
+        {
+            debugf("[SUCCESS] %s", *Result.Path);
+            Report.NumValid++;
+        }
+        else
+        {
+            debugf("[FAILED: %s] %s", *Result.Reason, *Result.Path);
+            Report.NumInvalid++;
+        }
+
+        CompareTime += Result.CompareTime;
+        Report.Results.push_back(std::move(Result));
+
+        if (++NumChecked % kReportSaveInterval == 0 && WriteReport)
+        {
+            Report.NumRemaining = static_cast<uint32>(Entries.size() - NumChecked);
+            SaveValidationReport(rkOptions.ReportPath, pProject->Game(), Report);
+        }
+    };
+
+    for (size_t EntryIdx = 0; EntryIdx < Entries.size() && Report.NumInvalid < kMaxInvalid; EntryIdx++)
+    {
+        for (; NextLoad < Entries.size() && NextLoad < EntryIdx + kLoadAhead; NextLoad++)
+            Loads.push_back(pStore->LoadResourceAsync(Entries[NextLoad]->ID()));
+
+        CResourceEntry *pEntry = Entries[EntryIdx];
+        std::shared_ptr<CResourceLoadRequest> pLoad = std::move(Loads.front());
+        Loads.pop_front();
 
         // Generate new cooked data
+        double StepTime = CTimer::GlobalTime();
+
+        if (pLoad)
+            pLoad->Wait();
+
+        LoadTime += CTimer::GlobalTime() - StepTime;
+        StepTime = CTimer::GlobalTime();
+
         std::vector<char> NewData;
         CVectorOutStream MemoryStream(&NewData, EEndian::BigEndian);
-        CResourceCooker::CookResource(*It, MemoryStream);
+        CResourceCooker::CookResource(pEntry, MemoryStream);
+
+        CookTime += CTimer::GlobalTime() - StepTime;
+        CookedBytes += NewData.size();
+
+        SCookerValidationResult Result;
+        Result.ID = pEntry->ID();
+        Result.Path = pEntry->CookedAssetPath(true);
+
+        Compares.push_back(Pool.Submit(
+            [OriginalPath = ResourcesDir / Result.Path, NewData = std::move(NewData), Game = pEntry->Game(),
+             Dump = rkOptions.DumpFileContents, Result = std::move(Result)]()
+        {
+            if (Dump)
+            {
+                TString DumpPath = "dump" / Result.Path;
+                FileUtil::MakeDirectory( DumpPath.GetFileDirectory() );
+
+                CFileOutStream DumpFile(DumpPath, EEndian::BigEndian);
+                DumpFile.WriteBytes( NewData.data(), NewData.size() );
+                DumpFile.Close();
+            }
+
+            return CompareCookedData(OriginalPath, NewData, Game, Result);
+        }));
+
+        while (Compares.size() > MaxPendingCompares)
+            FinishCompare();
+
+        // Keep memory use flat on large projects. Done with this resource, so let go of it first; look-ahead requests
+        // that have already finished keep their resources loaded until they're popped, so only cooked resources are unloaded.
+        pLoad = nullptr;
+
+        if ((EntryIdx + 1) % kUnloadInterval == 0)
+            pStore->DestroyUnreferencedResources();
+    }
+
+    while (!Compares.empty())
+        FinishCompare();
+
+    const double TotalTime = CTimer::GlobalTime() - StartTime;
+    Report.NumRemaining = static_cast<uint32>(Entries.size() - NumChecked);
+    Report.Seconds = static_cast<float>(TotalTime);
+    Report.ResourcesPerSecond = (TotalTime > 0.0 ? static_cast<float>(NumChecked / TotalTime) : 0.f);
+    Report.CookedMBPerSecond = (TotalTime > 0.0 ? static_cast<float>(CookedBytes / TotalTime / (1024.0 * 1024.0)) : 0.f);
+
+    if (WriteReport && !SaveValidationReport(rkOptions.ReportPath, pProject->Game(), Report))
+        errorf("Failed to write cooker validation report: %s", *rkOptions.ReportPath);
+
+    debugf("%s: checked %d resources in %.2fs (%.1f resources/s, %.2f MB/s cooked) on %d threads; load %.2fs, cook %.2fs, compare %.2fs",
+           pkTypeName, NumChecked, TotalTime, Report.ResourcesPerSecond, Report.CookedMBPerSecond,
+           Pool.NumThreads(), LoadTime, CookTime, CompareTime);
+
+    if (Report.NumInvalid >= kMaxInvalid)
+    {
+        debugf("Test aborted; at least %d invalid resources. Checked %d resources, %d passed, %d failed",
+               kMaxInvalid, Report.NumValid + Report.NumInvalid, Report.NumValid, Report.NumInvalid);
+        return false;
+    }
+
+    // Test complete
+    const bool TestSuccess = (Report.NumInvalid == 0);
+    debugf("Test %s; checked %d resources, %d passed, %d failed",
+           TestSuccess ? "SUCCEEDED" : "FAILED",
+           Report.NumValid + Report.NumInvalid, Report.NumValid, Report.NumInvalid);
+
+    return TestSuccess;
+}
+
+/** Round trip every serializable raw resource through the binary raw format, and check its XML comes out unchanged */
+bool ValidateRawFormat()
+{
+    debugf("Validating binary raw format...");
+
+    // There must be a project loaded
+    CResourceStore* pStore = gpResourceStore;
+    CGameProject* pProject = (pStore ? pStore->Project() : nullptr);
+
+    if (!pProject)
+    {
+        errorf("Raw format test failed; no project loaded");
+        return false;
+    }
+
+    // CXMLWriter only writes to files, so both versions of the XML go through the hidden files directory
+    const TString OriginalPath = pProject->HiddenFilesDir() + "RawFormatOriginal.xml";
+    const TString RoundTripPath = pProject->HiddenFilesDir() + "RawFormatRoundTrip.xml";
+    const CSerialVersion Version(IArchive::skCurrentArchiveVersion, 0, pProject->Game());
+
+    const auto SaveXML = [&pProject](const TString& rkPath, const TString& rkSerialName, CResource& rResource)
+    {
+        CXMLWriter Writer(rkPath, rkSerialName, 0, pProject->Game());
+        rResource.Serialize(Writer);
+        return Writer.Save();
+    };
+
+    constexpr uint kUnloadInterval = 64;
+    uint NumResources = 0, NumFailures = 0;
+
+    for (CResourceIterator It(pStore); It; ++It)
+    {
+        if (!It->TypeInfo()->CanBeSerialized() || !It->HasRawVersion())
+            continue;
+
+        CResource* pResource = It->Load();
+
+        if (!pResource)
+        {
+            errorf("[FAILED: load] %s", *It->RawAssetPath(true));
+            NumFailures++;
+            continue;
+        }
+
+        TString SerialName = It->TypeInfo()->TypeName();
+        SerialName.RemoveWhitespace();
+
+        // Write the binary data the same way a binary raw file stores it, then read it into a fresh resource
+        std::vector<char> BinaryData;
+        {
+            CVectorOutStream BinaryStream(&BinaryData, EEndian::BigEndian);
+            CBasicBinaryWriter Writer(&BinaryStream, Version);
+            pResource->Serialize(Writer);
+        }
+
+        std::unique_ptr<CResource> pRoundTrip = CResourceFactory::CreateResource(*It);
+        CBasicBinaryReader Reader(BinaryData.data(), BinaryData.size(), Version);
+        pRoundTrip->Serialize(Reader);
+
+        std::vector<uint8> OriginalXML, RoundTripXML;
+        const bool Saved = SaveXML(OriginalPath, SerialName, *pResource) && SaveXML(RoundTripPath, SerialName, *pRoundTrip) &&
+                           FileUtil::LoadFileToBuffer(OriginalPath, OriginalXML) && FileUtil::LoadFileToBuffer(RoundTripPath, RoundTripXML);
+
+        if (!Saved)
+        {
+            errorf("[FAILED: couldn't write XML] %s", *It->RawAssetPath(true));
+            NumFailures++;
+        }
+        else if (OriginalXML != RoundTripXML)
+        {
+            errorf("[FAILED: XML mismatch] %s", *It->RawAssetPath(true));
+            NumFailures++;
+        }
+
+        pRoundTrip.reset();
+        NumResources++;
+
+        if (NumResources % kUnloadInterval == 0)
+            pStore->DestroyUnreferencedResources();
+    }
+
+    FileUtil::DeleteFile(OriginalPath);
+    FileUtil::DeleteFile(RoundTripPath);
+    pStore->DestroyUnreferencedResources();
+
+    // Test complete
+    const bool TestSuccess = (NumFailures == 0);
+    debugf( "Test %s; checked %d resources, %d failed",
+            TestSuccess ? "SUCCEEDED" : "FAILED",
+            NumResources, NumFailures );
+
+    return TestSuccess;
+}
+
+/** Patch every package's pak after changing some of its cooked assets, and check it stores the same resource data as a full cook */
+bool ValidatePakPatching()
+{
+    debugf("Validating pak patching...");
+
+    // There must be a project loaded
+    CResourceStore* pStore = gpResourceStore;
+    CGameProject* pProject = (pStore ? pStore->Project() : nullptr);
+
+    if (!pProject)
+    {
+        errorf("Pak patching test failed; no project loaded");
+        return false;
+    }
+
+    // Reads each resource's data as it's stored in the pak, including compression headers and padding
+    const auto ReadPak = [](const CPackage* pkPackage, const TString& rkPakPath, SPakLayout& rLayout, std::vector<std::vector<uint8>>& rPayloads)
+    {
+        if (!pkPackage->ReadPakLayout(rkPakPath, rLayout))
+            return false;
+
+        CFileInStream Pak(rkPakPath, EEndian::BigEndian);
+
+        if (!Pak.IsValid())
+            return false;
+
+        rPayloads.resize(rLayout.Resources.size());
+
+        for (size_t iRes = 0; iRes < rLayout.Resources.size(); iRes++)
+        {
+            const SPakLayout::SResource& rkRes = rLayout.Resources[iRes];
+
+            if (static_cast<uint64>(rLayout.OffsetBase) + rkRes.Offset + rkRes.Size > rLayout.Size)
+                return false;
+
+            rPayloads[iRes].resize(rkRes.Size);
+            Pak.Seek(rLayout.OffsetBase + rkRes.Offset, SEEK_SET);
+            Pak.ReadBytes(rPayloads[iRes].data(), rkRes.Size);
+        }
+
+        return true;
+    };
+
+    const auto WriteFile = [](const TString& rkPath, const std::vector<uint8>& rkData)
+    {
+        CFileOutStream File(rkPath, EEndian::BigEndian);
+        File.WriteBytes(rkData.data(), rkData.size());
+    };
+
+    uint NumPackages = 0, NumFailures = 0;
+    double PatchTime = 0.0, CookTime = 0.0;
 
-        // Start our comparison by making sure the sizes match up
-        const uint kAlignment           = (It->Game() >= EGame::Corruption ? 64 : 32);
-        const uint kAlignedOriginalSize = VAL_ALIGN( (uint) OriginalData.size(), kAlignment );
-        const uint kAlignedNewSize      = VAL_ALIGN( (uint) NewData.size(), kAlignment );
-        const char* pkInvalidReason     = "";
-        bool IsValid                    = false;
+    for (size_t iPkg = 0; iPkg < pProject->NumPackages(); iPkg++)
+    {
+        CPackage* pPackage = pProject->PackageByIndex(iPkg);
+        const TString PakPath = pPackage->CookedPackagePath(false);
+        std::vector<CResourceEntry*> Assets;
 
-        if( kAlignedOriginalSize == kAlignedNewSize &&
-            OriginalData.size() >= NewData.size() )
+        if (!pPackage->PrepareForCook(Assets, gpNullProgress) || !pPackage->WritePak(Assets, gpNullProgress, false))
         {
-            // Compare actual data. Note that the original asset can have alignment padding
-            // at the end, which is applied by the pak but usually preserved in extracted
-            // files. We do not include this in the comparison as missing padding does not
-            // indicate malformed data.
-            uint DataSize = Math::Min(OriginalData.size(), NewData.size());
+            errorf("[FAILED: couldn't cook] %s", *pPackage->CookedPackagePath(true));
+            NumFailures++;
+            continue;
+        }
+
+        // Change the smallest sixteenth of the cooked assets, so the dead space they leave behind stays small enough to patch
+        std::vector<uint64> AssetSizes(Assets.size());
+        std::vector<size_t> Changed(Assets.size());
+        std::iota(Changed.begin(), Changed.end(), 0);
+
+        for (size_t iRes = 0; iRes < Assets.size(); iRes++)
+            AssetSizes[iRes] = FileUtil::FileSize(Assets[iRes]->CookedAssetPath());
+
+        std::sort(Changed.begin(), Changed.end(), [&AssetSizes](size_t Left, size_t Right) {
+            return AssetSizes[Left] < AssetSizes[Right];
+        });
+        Changed.resize(std::min<size_t>(Changed.size(), (Assets.size() + 15) / 16));
+
+        if (Changed.empty() || Changed.size() * 2 > Assets.size())
+            continue;
+
+        std::vector<std::vector<uint8>> Originals(Changed.size());
+
+        for (size_t iChange = 0; iChange < Changed.size(); iChange++)
+        {
+            const TString Path = Assets[Changed[iChange]]->CookedAssetPath();
+            FileUtil::LoadFileToBuffer(Path, Originals[iChange]);
+
+            std::vector<uint8> NewData = Originals[iChange];
+            NewData.resize(NewData.size() + 0x40, 0xFF);
+            WriteFile(Path, NewData);
+        }
+
+        double StartTime = CTimer::GlobalTime();
+        const bool Patched = pPackage->PatchPak(Assets, gpNullProgress);
+        PatchTime += CTimer::GlobalTime() - StartTime;
+
+        SPakLayout PatchedLayout, CookedLayout;
+        std::vector<std::vector<uint8>> PatchedData, CookedData;
+        bool Success = Patched && ReadPak(pPackage, PakPath, PatchedLayout, PatchedData);
 
-            if( memcmp(OriginalData.data(), NewData.data(), DataSize) == 0 )
+        StartTime = CTimer::GlobalTime();
+        Success = pPackage->WritePak(Assets, gpNullProgress, false) && Success;
+        CookTime += CTimer::GlobalTime() - StartTime;
+        Success = Success && ReadPak(pPackage, PakPath, CookedLayout, CookedData);
+
+        if (!Patched)
+        {
+            errorf("[FAILED: pak wasn't patched] %s", *pPackage->CookedPackagePath(true));
+        }
+        else if (!Success || PatchedLayout.Resources.size() != CookedLayout.Resources.size())
+        {
+            errorf("[FAILED: couldn't read pak] %s", *pPackage->CookedPackagePath(true));
+        }
+        else
+        {
+            for (size_t iRes = 0; iRes < CookedLayout.Resources.size(); iRes++)
             {
-                // Verify any missing data at the end is padding.
-                bool MissingData = false;
+                const SPakLayout::SResource& rkPatched = PatchedLayout.Resources[iRes];
+                const SPakLayout::SResource& rkCooked = CookedLayout.Resources[iRes];
 
-                if( OriginalData.size() > NewData.size() )
+                if (rkPatched.ID != rkCooked.ID || rkPatched.Type.ToLong() != rkCooked.Type.ToLong() ||
+                    rkPatched.Compressed != rkCooked.Compressed || PatchedData[iRes] != CookedData[iRes])
                 {
-                    for( uint i=DataSize; i<OriginalData.size(); i++ )
-                    {
-                        if( OriginalData[i] != 0xFF )
-                        {
-                            MissingData = true;
-                            break;
-                        }
-                    }
+                    errorf("[FAILED: resource mismatch] %s: %s", *pPackage->CookedPackagePath(true), *rkCooked.ID.ToString());
+                    Success = false;
+                }
+            }
+        }
+
+        if (!Patched || !Success)
+            NumFailures++;
+
+        // Put the original assets back and cook the pak again, so the project is left the way we found it
+        for (size_t iChange = 0; iChange < Changed.size(); iChange++)
+            WriteFile(Assets[Changed[iChange]]->CookedAssetPath(), Originals[iChange]);
+
+        pPackage->WritePak(Assets, gpNullProgress, false);
+        NumPackages++;
+    }
+
+    // Test complete
+    const bool TestSuccess = (NumFailures == 0);
+    debugf( "Test %s; checked %d packages, %d failed; patching took %.3fs, full cooks took %.3fs",
+            TestSuccess ? "SUCCEEDED" : "FAILED",
+            NumPackages, NumFailures, PatchTime, CookTime );
+
+    return TestSuccess;
+}
+
+namespace
+{
+
+/** Returns the loaded project's resource store, or logs that the named benchmark can't run if no project is loaded */
+CResourceStore* GetBenchmarkStore(const char* pkBenchmarkName)
+{
+    CResourceStore* pStore = gpResourceStore;
+    CGameProject* pProject = (pStore ? pStore->Project() : nullptr);
+
+    if (!pProject)
+    {
+        errorf("%s benchmark failed; no project loaded", pkBenchmarkName);
+        return nullptr;
+    }
+
+    return pStore;
+}
+
+/** Loads every area in the store one at a time and unloads each one again after passing it to the callback. Returns the time spent loading. */
+double ForEachArea(CResourceStore* pStore, const std::function<void(CResourceEntry*, CGameArea*)>& rkFunc)
+{
+    double LoadTime = 0.0;
+
+    for (TResourceIterator<EResourceType::Area> It(pStore); It; ++It)
+    {
+        const double StartTime = CTimer::GlobalTime();
+        TResPtr<CGameArea> pArea = It->Load();
+        LoadTime += CTimer::GlobalTime() - StartTime;
+
+        if (pArea)
+            rkFunc(*It, pArea);
+
+        pArea = nullptr;
+        pStore->DestroyUnreferencedResources();
+    }
+
+    return LoadTime;
+}
+
+}
+
+/** Compare hashed vertex welding against a linear search on every area surface in the project */
+bool BenchmarkVertexWelding()
+{
+    debugf("Benchmarking vertex welding...");
+
+    CResourceStore* pStore = GetBenchmarkStore("Vertex welding");
+
+    if (!pStore)
+        return false;
+
+    uint NumSurfaces = 0, NumVertices = 0, NumMismatches = 0;
+    double LinearTime = 0.0, HashedTime = 0.0;
+
+    ForEachArea(pStore, [&](CResourceEntry* pEntry, CGameArea* pArea)
+    {
+        for (uint ModelIdx = 0; ModelIdx < pArea->NumWorldModels(); ModelIdx++)
+        {
+            CModel* pModel = pArea->TerrainModel(ModelIdx);
+
+            for (uint SurfIdx = 0; SurfIdx < pModel->GetSurfaceCount(); SurfIdx++)
+            {
+                // Weld each surface into its own buffer, the same way CModel::BufferGL does
+                const SSurface* pkSurf = pModel->GetSurface(SurfIdx);
+                CVertexBuffer LinearVBO, HashedVBO;
+                std::vector<uint16> LinearIndices, HashedIndices;
+                LinearIndices.reserve(pkSurf->VertexCount);
+                HashedIndices.reserve(pkSurf->VertexCount);
+
+                double StartTime = CTimer::GlobalTime();
+
+                for (const SSurface::SPrimitive& rkPrim : pkSurf->Primitives)
+                {
+                    for (const CVertex& rkVtx : rkPrim.Vertices)
+                        LinearIndices.push_back( LinearVBO.AddIfUniqueLinear(rkVtx, 0) );
                 }
 
-                if( !MissingData )
+                LinearTime += CTimer::GlobalTime() - StartTime;
+                StartTime = CTimer::GlobalTime();
+
+                for (const SSurface::SPrimitive& rkPrim : pkSurf->Primitives)
                 {
-                    // All tests passed!
-                    IsValid = true;
+                    for (const CVertex& rkVtx : rkPrim.Vertices)
+                        HashedIndices.push_back( HashedVBO.AddIfUnique(rkVtx, 0) );
                 }
-                else
+
+                HashedTime += CTimer::GlobalTime() - StartTime;
+
+                if( LinearIndices != HashedIndices || LinearVBO.Size() != HashedVBO.Size() )
                 {
-                    pkInvalidReason = "missing data";
+                    debugf( "[FAILED: index mismatch] %s model %d surface %d", *pEntry->CookedAssetPath(true), ModelIdx, SurfIdx );
+                    NumMismatches++;
                 }
+
+                NumSurfaces++;
+                NumVertices += LinearIndices.size();
             }
-            else
+        }
+    });
+
+    // Test complete
+    bool TestSuccess = (NumMismatches == 0);
+    debugf( "Benchmark %s; welded %d vertices in %d surfaces, %d mismatched",
+            TestSuccess ? "SUCCEEDED" : "FAILED",
+            NumVertices, NumSurfaces, NumMismatches );
+    debugf( "Linear search: %.3fs, hash index: %.3fs (%.1fx faster)",
+            LinearTime, HashedTime, (HashedTime > 0.0 ? LinearTime / HashedTime : 0.0) );
+
+    return TestSuccess;
+}
+
+/** Cast a grid of rays against every area's collision and compare the BVH against testing every triangle */
+bool BenchmarkCollisionRayCasts()
+{
+    debugf("Benchmarking collision ray casts...");
+
+    CResourceStore* pStore = GetBenchmarkStore("Collision ray cast");
+
+    if (!pStore)
+        return false;
+
+    // Rays are cast down onto each mesh from above, tilted slightly so they aren't axis-aligned
+    constexpr uint kGridSize = 64;
+    const CVector3f kRayDir = CVector3f(0.1f, 0.2f, -1.f).Normalized();
+
+    uint NumMeshes = 0, NumTriangles = 0, NumRays = 0, NumHits = 0, NumMismatches = 0;
+    double BuildTime = 0.0, BVHTime = 0.0, BruteForceTime = 0.0;
+
+    ForEachArea(pStore, [&](CResourceEntry*, CGameArea* pArea)
+    {
+        if (!pArea->Collision())
+            return;
+
+        CCollisionMeshGroup* pCollision = pArea->Collision();
+
+        for (size_t MeshIdx = 0; MeshIdx < pCollision->NumMeshes(); MeshIdx++)
+        {
+            CCollisionMesh* pMesh = pCollision->MeshByIndex(MeshIdx);
+            const SCollisionIndexData& kIndexData = pMesh->GetIndexData();
+
+            double StartTime = CTimer::GlobalTime();
+            pMesh->BuildBVH();
+            BuildTime += CTimer::GlobalTime() - StartTime;
+
+            const CCollisionBVH& kBVH = pMesh->GetBVH();
+
+            if (!kBVH.IsBuilt())
+                continue;
+
+            const CAABox kBounds = kBVH.Bounds();
+            const CVector3f kSize = kBounds.Size();
+
+            for (uint GridY = 0; GridY < kGridSize; GridY++)
             {
-                pkInvalidReason = "data mismatch";
+                for (uint GridX = 0; GridX < kGridSize; GridX++)
+                {
+                    const CVector3f Origin(kBounds.Min().X + kSize.X * ((GridX + 0.5f) / kGridSize),
+                                           kBounds.Min().Y + kSize.Y * ((GridY + 0.5f) / kGridSize),
+                                           kBounds.Max().Z + 1.f);
+                    CRay Ray;
+                    Ray.SetOrigin(Origin);
+                    Ray.SetDirection(kRayDir);
+
+                    StartTime = CTimer::GlobalTime();
+                    const auto [BVHHit, BVHDist] = kBVH.IntersectsRay(Ray, true);
+                    BVHTime += CTimer::GlobalTime() - StartTime;
+
+                    StartTime = CTimer::GlobalTime();
+                    bool Hit = false;
+                    float HitDist = 0.f;
+
+                    for (size_t TriIdx = 0; TriIdx < kIndexData.NumTriangles(); TriIdx++)
+                    {
+                        const std::array<uint16, 3> kVerts = kIndexData.TriangleVertexIndices(TriIdx);
+                        const auto [TriHit, TriDist] = Math::RayTriangleIntersection(Ray, kIndexData.Vertices[kVerts[0]],
+                                                                                     kIndexData.Vertices[kVerts[1]],
+                                                                                     kIndexData.Vertices[kVerts[2]], true);
+                        if (TriHit && (!Hit || TriDist < HitDist))
+                        {
+                            Hit = true;
+                            HitDist = TriDist;
+                        }
+                    }
+
+                    BruteForceTime += CTimer::GlobalTime() - StartTime;
+
+                    if (BVHHit != Hit || (Hit && BVHDist != HitDist))
+                        NumMismatches++;
+
+                    NumRays++;
+                    NumHits += (Hit ? 1 : 0);
+                }
             }
+
+            NumMeshes++;
+            NumTriangles += kBVH.NumTriangles();
         }
-        else
+    });
+
+    // Test complete
+    bool TestSuccess = (NumMismatches == 0);
+    debugf( "Benchmark %s; cast %d rays against %d meshes (%d triangles), %d hits, %d mismatched",
+            TestSuccess ? "SUCCEEDED" : "FAILED",
+            NumRays, NumMeshes, NumTriangles, NumHits, NumMismatches );
+    debugf( "BVH build: %.3fs, BVH queries: %.3fs, brute force: %.3fs (%.1fx faster)",
+            BuildTime, BVHTime, BruteForceTime, (BVHTime > 0.0 ? BruteForceTime / BVHTime : 0.0) );
+
+    return TestSuccess;
+}
+
+/** Time building a scene for every area in the project, and check node IDs are allocated densely and recycled */
+bool BenchmarkSceneLoad()
+{
+    debugf("Benchmarking scene load...");
+
+    CResourceStore* pStore = GetBenchmarkStore("Scene load");
+
+    if (!pStore)
+        return false;
+
+    struct SAreaResult
+    {
+        TString Name;
+        uint NumNodes;
+        double LoadTime;
+    };
+    std::vector<SAreaResult> Results;
+    uint NumAreas = 0, NumNodes = 0, NumFailures = 0;
+    double TotalTime = 0.0;
+
+    // Returns whether the scene's node IDs are exactly 0 to NumNodes-1
+    const auto HasDenseIDs = [](CScene& rScene, uint& rOutNumNodes)
+    {
+        rOutNumNodes = 0;
+        uint32 MaxID = 0;
+
+        for (CSceneIterator It(&rScene, ENodeType::All, true); It; ++It)
         {
-            pkInvalidReason = "size mismatch";
+            MaxID = std::max(MaxID, It->ID());
+            rOutNumNodes++;
         }
 
-        // Print test results
-        if( IsValid )
+        return rOutNumNodes == 0 || MaxID == rOutNumNodes - 1;
+    };
+
+    ForEachArea(pStore, [&](CResourceEntry* pEntry, CGameArea* pArea)
+    {
+        CScene Scene;
+        const double StartTime = CTimer::GlobalTime();
+        Scene.SetActiveArea(nullptr, pArea);
+        const double LoadTime = CTimer::GlobalTime() - StartTime;
+
+        uint AreaNodes = 0;
+        bool Valid = HasDenseIDs(Scene, AreaNodes);
+
+        // Delete every other script node and recreate it; the freed IDs should be handed out again
+        std::vector<CScriptNode*> ScriptNodes;
+
+        for (CSceneIterator ScriptIt(&Scene, ENodeType::Script, true); ScriptIt; ++ScriptIt)
+            ScriptNodes.push_back(static_cast<CScriptNode*>(*ScriptIt));
+
+        std::vector<CScriptObject*> DeletedObjects;
+
+        for (size_t NodeIdx = 0; NodeIdx < ScriptNodes.size(); NodeIdx += 2)
         {
-            debugf( "[SUCCESS] %s", *CookedPath );
-            NumValid++;
+            DeletedObjects.push_back(ScriptNodes[NodeIdx]->Instance());
+            Scene.DeleteNode(ScriptNodes[NodeIdx]);
         }
-        else
+
+        for (CScriptObject* pObj : DeletedObjects)
+            Scene.CreateScriptNode(pObj);
+
+        uint RecycledNodes = 0;
+        Valid = HasDenseIDs(Scene, RecycledNodes) && RecycledNodes == AreaNodes && Valid;
+
+        if (!Valid)
         {
-            debugf( "[FAILED: %s] %s", pkInvalidReason, *CookedPath );
-            NumInvalid++;
+            errorf("%s: node IDs are not densely allocated", *pEntry->Name());
+            NumFailures++;
         }
 
-        if( DumpInvalidFileContents )
+        Results.push_back(SAreaResult{pEntry->Name(), AreaNodes, LoadTime});
+        NumAreas++;
+        NumNodes += AreaNodes;
+        TotalTime += LoadTime;
+
+        Scene.ClearScene();
+    });
+
+    // Report the largest areas, since those are the ones that scale badly
+    std::sort(Results.begin(), Results.end(), [](const SAreaResult& rkLeft, const SAreaResult& rkRight) {
+        return rkLeft.NumNodes > rkRight.NumNodes;
+    });
+
+    const size_t NumReported = std::min<size_t>(Results.size(), 5);
+
+    for (size_t ResultIdx = 0; ResultIdx < NumReported; ResultIdx++)
+    {
+        const SAreaResult& rkResult = Results[ResultIdx];
+        debugf("%s: %d nodes in %.3fs", *rkResult.Name, rkResult.NumNodes, rkResult.LoadTime);
+    }
+
+    // Test complete
+    bool TestSuccess = (NumFailures == 0);
+    debugf( "Benchmark %s; loaded %d areas (%d nodes) in %.3fs, %d failed",
+            TestSuccess ? "SUCCEEDED" : "FAILED",
+            NumAreas, NumNodes, TotalTime, NumFailures );
+
+    return TestSuccess;
+}
+
+/** Time loading every area's script layers, then time indexed property lookups on their own against a linear search and check they agree */
+bool BenchmarkScriptLoad()
+{
+    debugf("Benchmarking script load...");
+
+    CResourceStore* pStore = GetBenchmarkStore("Script load");
+
+    if (!pStore)
+        return false;
+
+    std::set<CScriptTemplate*> Templates;
+    uint NumAreas = 0, NumInstances = 0;
+
+    // Script layers make up most of the load time for MP2 and later areas, since every property is looked up by ID
+    const double LoadTime = ForEachArea(pStore, [&](CResourceEntry*, CGameArea* pArea)
+    {
+        for (size_t LayerIdx = 0; LayerIdx < pArea->NumScriptLayers(); LayerIdx++)
         {
-            TString DumpPath = "dump" / CookedPath;
-            FileUtil::MakeDirectory( DumpPath.GetFileDirectory() );
+            CScriptLayer* pLayer = pArea->ScriptLayer(LayerIdx);
+
+            for (size_t InstIdx = 0; InstIdx < pLayer->NumInstances(); InstIdx++)
+                Templates.insert(pLayer->InstanceByIndex(InstIdx)->Template());
 
-            CFileOutStream DumpFile(DumpPath, EEndian::BigEndian);
-            DumpFile.WriteBytes( NewData.data(), NewData.size() );
-            DumpFile.Close();
+            NumInstances += pLayer->NumInstances();
         }
 
-        if( NumInvalid >= 100 )
+        NumAreas++;
+    });
+
+    // Then time the child ID lookups on their own. Look up every child of every struct used by the loaded objects,
+    // with the index and without it
+    std::vector<std::pair<IProperty*, IProperty*>> Lookups;
+
+    const auto GatherLookups = [&Lookups](IProperty* pProperty, const auto& rkRecurse) -> void
+    {
+        for (size_t ChildIdx = 0; ChildIdx < pProperty->NumChildren(); ChildIdx++)
         {
-            debugf( "Test aborted; at least 100 invalid resources. Checked %d resources, %d passed, %d failed",
-                    NumValid + NumInvalid, NumValid, NumInvalid );
-            return false;
+            IProperty* pChild = pProperty->ChildByIndex(ChildIdx);
+            Lookups.emplace_back(pProperty, pChild);
+            rkRecurse(pChild, rkRecurse);
+        }
+    };
+
+    for (CScriptTemplate* pTemplate : Templates)
+        GatherLookups(pTemplate->Properties(), GatherLookups);
+
+    const uint kNumPasses = 100;
+    uint NumMismatches = 0;
+
+    double StartTime = CTimer::GlobalTime();
+
+    for (uint Pass = 0; Pass < kNumPasses; Pass++)
+    {
+        for (const auto& [pParent, pChild] : Lookups)
+        {
+            IProperty* pFound = nullptr;
+
+            for (size_t ChildIdx = 0; ChildIdx < pParent->NumChildren() && !pFound; ChildIdx++)
+            {
+                if (pParent->ChildByIndex(ChildIdx)->ID() == pChild->ID())
+                    pFound = pParent->ChildByIndex(ChildIdx);
+            }
+
+            if (Pass == 0 && pFound != pParent->ChildByID(pChild->ID()))
+                NumMismatches++;
+        }
+    }
+
+    const double LinearTime = CTimer::GlobalTime() - StartTime;
+    StartTime = CTimer::GlobalTime();
+
+    for (uint Pass = 0; Pass < kNumPasses; Pass++)
+    {
+        for (const auto& [pParent, pChild] : Lookups)
+            pParent->ChildByID(pChild->ID());
+    }
+
+    const double IndexedTime = CTimer::GlobalTime() - StartTime;
+
+    if (NumMismatches > 0)
+        errorf("%d indexed property lookups returned a different property than a linear search", NumMismatches);
+
+    debugf("%d lookups x %d: linear search %.3fs, indexed %.3fs", Lookups.size(), kNumPasses, LinearTime, IndexedTime);
+
+    // Test complete
+    bool TestSuccess = (NumMismatches == 0);
+    debugf( "Benchmark %s; loaded %d areas (%d script instances, %d templates) in %.3fs",
+            TestSuccess ? "SUCCEEDED" : "FAILED",
+            NumAreas, NumInstances, Templates.size(), LoadTime );
+
+    return TestSuccess;
+}
+
+/** Compress every cooked area with both segmented codecs, and compare against compressing one segment at a time */
+bool BenchmarkCompression()
+{
+    debugf("Benchmarking segmented compression...");
+
+    CResourceStore* pStore = GetBenchmarkStore("Compression");
+
+    if (!pStore)
+        return false;
+
+    // Reference implementation; compresses one segment at a time with freshly initialized compressor state, the way
+    // segmented compression worked before CCompressionContext, so a bug in the contexts can't hide in both outputs
+    const auto CompressSerial = [](std::vector<uint8>& rData, bool IsZlib, std::vector<uint8>& rOut)
+    {
+        const uint32 kSegmentSize = 0x4000;
+        std::vector<uint8> Compressed(CompressionUtil::MaxCompressedSize(kSegmentSize, IsZlib));
+        rOut.clear();
+
+        for (uint32 Offset = 0; Offset < rData.size(); Offset += kSegmentSize)
+        {
+            const uint16 Size = (uint16) std::min<uint32>(rData.size() - Offset, kSegmentSize);
+            uint32 TotalOut = 0;
+
+            if (IsZlib)
+            {
+                z_stream z{};
+                z.zalloc = Z_NULL;
+                z.zfree = Z_NULL;
+                z.opaque = Z_NULL;
+
+                if (deflateInit(&z, 9) != Z_OK)
+                    return false;
+
+                z.avail_in = Size;
+                z.next_in = &rData[Offset];
+                z.avail_out = static_cast<uInt>(Compressed.size());
+                z.next_out = Compressed.data();
+
+                const int Error = deflate(&z, Z_FINISH);
+                TotalOut = static_cast<uint32>(z.total_out);
+                deflateEnd(&z);
+
+                if (Error != Z_STREAM_END)
+                    return false;
+            }
+            else
+            {
+#if USE_LZOKAY
+                size_t LzoOut = 0;
+
+                if (lzokay::compress(&rData[Offset], Size, Compressed.data(), Compressed.size(), LzoOut) < lzokay::EResult::Success)
+                    return false;
+#else
+                lzo_init();
+                std::vector<uint8> WorkMem(LZO1X_999_MEM_COMPRESS);
+                lzo_uint LzoOut = 0;
+
+                if (lzo1x_999_compress(&rData[Offset], Size, Compressed.data(), &LzoOut, WorkMem.data()) != LZO_E_OK)
+                    return false;
+#endif
+                TotalOut = static_cast<uint32>(LzoOut);
+            }
+
+            if (TotalOut >= Size)
+            {
+                rOut.push_back(-Size >> 8);
+                rOut.push_back(-Size & 0xFF);
+                rOut.insert(rOut.end(), rData.begin() + Offset, rData.begin() + Offset + Size);
+            }
+            else
+            {
+                rOut.push_back((TotalOut >> 8) & 0xFF);
+                rOut.push_back(TotalOut & 0xFF);
+                rOut.insert(rOut.end(), Compressed.begin(), Compressed.begin() + TotalOut);
+            }
+        }
+
+        return true;
+    };
+
+    uint NumFiles = 0, NumMismatches = 0;
+    uint64 TotalSize = 0;
+    double SerialTime = 0.0, ParallelTime = 0.0;
+    std::vector<uint8> Data, SerialOut, ParallelOut;
+
+    for (TResourceIterator<EResourceType::Area> It(pStore); It; ++It)
+    {
+        if (!FileUtil::LoadFileToBuffer(It->CookedAssetPath(), Data) || Data.empty())
+            continue;
+
+        for (bool IsZlib : {true, false})
+        {
+            double StartTime = CTimer::GlobalTime();
+            const bool SerialSuccess = CompressSerial(Data, IsZlib, SerialOut);
+            SerialTime += CTimer::GlobalTime() - StartTime;
+
+            ParallelOut.resize(CompressionUtil::MaxSegmentedCompressedSize(Data.size(), IsZlib));
+            uint32 ParallelSize = 0;
+
+            StartTime = CTimer::GlobalTime();
+            const bool Success = CompressionUtil::CompressSegmentedData(Data.data(), Data.size(), ParallelOut.data(), ParallelSize, IsZlib, true);
+            ParallelTime += CTimer::GlobalTime() - StartTime;
+
+            ParallelOut.resize(ParallelSize);
+
+            if (!SerialSuccess || !Success || ParallelOut != SerialOut)
+            {
+                errorf("%s: %s compression output doesn't match", *It->CookedAssetPath(true), IsZlib ? "zlib" : "LZO");
+                NumMismatches++;
+            }
         }
+
+        TotalSize += Data.size();
+        NumFiles++;
     }
 
     // Test complete
-    bool TestSuccess = (NumInvalid == 0);
-    debugf( "Test %s; checked %d resources, %d passed, %d failed",
+    bool TestSuccess = (NumMismatches == 0);
+    debugf( "Benchmark %s; compressed %d areas (%d MB) twice: serial %.3fs, parallel %.3fs",
             TestSuccess ? "SUCCEEDED" : "FAILED",
-            NumValid + NumInvalid, NumValid, NumInvalid );
+            NumFiles, static_cast<uint>(TotalSize / 0x100000), SerialTime, ParallelTime );
 
     return TestSuccess;
 }
@@ -2,6 +2,8 @@
 #define NCORETESTS_H
 
 #include "Core/Resource/EResType.h"
+#include <Common/BasicTypes.h>
+#include <Common/TString.h>
 
 /** Unit tests for Core */
 namespace NCoreTests
@@ -10,8 +12,48 @@ namespace NCoreTests
 /** Check commandline input to see if the user is running a unit test */
 bool RunTests(int argc, char *argv[]);
 
+/** Settings for ValidateCooker */
+struct SValidateCookerOptions
+{
+    /** Write the recooked data of every resource to the dump directory */
+    bool DumpFileContents = false;
+
+    /** Worker threads used to compare cooked data; 0 uses every core */
+    uint32 NumJobs = 0;
+
+    /** Only check every NumShards'th resource starting at ShardIndex, so several processes can split up a project */
+    uint32 ShardIndex = 0;
+    uint32 NumShards = 1;
+
+    /** XML report of each resource's result and the cooker's throughput. It is saved periodically, and Resume skips the resources it already lists. */
+    TString ReportPath;
+    bool Resume = false;
+};
+
 /** Validate all cooker output for the given resource type matches the original asset data */
 bool ValidateCooker(EResourceType ResourceType, bool DumpInvalidFileContents);
+bool ValidateCooker(EResourceType ResourceType, const SValidateCookerOptions& rkOptions);
+
+/** Round trip every serializable raw resource through the binary raw format, and check its XML comes out unchanged */
+bool ValidateRawFormat();
+
+/** Patch every package's pak after changing some of its cooked assets, and check it stores the same resource data as a full cook */
+bool ValidatePakPatching();
+
+/** Compare hashed vertex welding against a linear search on every area surface in the project */
+bool BenchmarkVertexWelding();
+
+/** Cast a grid of rays against every area's collision and compare the BVH against testing every triangle */
+bool BenchmarkCollisionRayCasts();
+
+/** Time building a scene for every area in the project, and check node IDs are allocated densely and recycled */
+bool BenchmarkSceneLoad();
+
+/** Time loading every area's script layers, then time indexed property lookups on their own against a linear search and check they agree */
+bool BenchmarkScriptLoad();
+
+/** Time segmented compression of every cooked area, and check it matches compressing one segment at a time */
+bool BenchmarkCompression();
 
 }
 
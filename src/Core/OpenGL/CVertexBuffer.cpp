@@ -1,5 +1,57 @@
 #include "CVertexBuffer.h"
 #include "CVertexArrayManager.h"
+#include <cstring>
+
+namespace
+{
+// Hashes vertex attributes for AddIfUnique. Attributes are compared with ==, so the hash
+// has to treat values that compare equal the same way (namely +0 and -0).
+class CVertexHasher
+{
+    uint64 mHash = 0xCBF29CE484222325;
+
+    void AddBits(uint32 Bits)
+    {
+        mHash = (mHash ^ Bits) * 0x100000001B3;
+    }
+
+public:
+    void Add(float Value)
+    {
+        uint32 Bits = 0;
+
+        if (Value != 0.f)
+            std::memcpy(&Bits, &Value, sizeof(Bits));
+
+        AddBits(Bits);
+    }
+
+    void Add(const CVector2f& rkVec)  { Add(rkVec.X); Add(rkVec.Y); }
+    void Add(const CVector3f& rkVec)  { Add(rkVec.X); Add(rkVec.Y); Add(rkVec.Z); }
+    void Add(const CColor& rkColor)   { Add(rkColor.R); Add(rkColor.G); Add(rkColor.B); Add(rkColor.A); }
+
+    void Add(const TBoneIndices& rkIndices)
+    {
+        AddBits(rkIndices[0] | (rkIndices[1] << 8) | (rkIndices[2] << 16) | (static_cast<uint32>(rkIndices[3]) << 24));
+    }
+
+    void Add(const TBoneWeights& rkWeights)
+    {
+        for (const float Weight : rkWeights)
+            Add(Weight);
+    }
+
+    uint64 Hash() const
+    {
+        // FNV-1a doesn't mix the high bits well on its own
+        uint64 Out = mHash;
+        Out ^= Out >> 33;
+        Out *= 0xFF51AFD7ED558CCD;
+        Out ^= Out >> 33;
+        return Out;
+    }
+};
+} // Anonymous namespace
 
 CVertexBuffer::CVertexBuffer()
 {
@@ -64,75 +116,63 @@ uint16 CVertexBuffer::AddVertex(const CVertex& rkVtx)
 
 uint16 CVertexBuffer::AddIfUnique(const CVertex& rkVtx, uint16 Start)
 {
-    if (Start < mPositions.size())
+    // Only vertices added since Start can be reused, so start a new lookup table whenever Start changes
+    if (Start != mUniqueIndexStart || mUniqueIndexEnd < Start || mUniqueIndexEnd > mPositions.size())
     {
-        for (size_t iVert = Start; iVert < mPositions.size(); iVert++)
-        {
-            // I use a bool because "continue" doesn't work properly within the iTex loop
-            bool Unique = false;
+        mUniqueIndex.clear();
+        mUniqueIndexStart = Start;
+        mUniqueIndexEnd = Start;
+    }
 
-            if ((mVtxDesc & EVertexAttribute::Position) != 0)
-            {
-                if (rkVtx.Position != mPositions[iVert])
-                    Unique = true;
-            }
+    // Catch up on any vertices that were added without going through this function
+    for (; mUniqueIndexEnd < mPositions.size(); mUniqueIndexEnd++)
+        mUniqueIndex.emplace(HashVertex(mUniqueIndexEnd), static_cast<uint16>(mUniqueIndexEnd));
 
-            if (!Unique && (mVtxDesc & EVertexAttribute::Normal) != 0)
-            {
-                if (rkVtx.Normal != mNormals[iVert])
-                    Unique = true;
-            }
+    // Return the first matching vertex, same as a linear search would
+    const uint64 Hash = HashVertex(rkVtx);
+    const auto Range = mUniqueIndex.equal_range(Hash);
+    uint32 Match = UINT32_MAX;
 
-            if (!Unique && (mVtxDesc & EVertexAttribute::Color0) != 0)
-            {
-                if (rkVtx.Color[0] != mColors[0][iVert])
-                    Unique = true;
-            }
+    for (auto It = Range.first; It != Range.second; ++It)
+    {
+        if (It->second < Match && IsSameVertex(rkVtx, It->second))
+            Match = It->second;
+    }
 
-            if (!Unique && (mVtxDesc & EVertexAttribute::Color1) != 0)
-            {
-                if (rkVtx.Color[1] != mColors[1][iVert])
-                    Unique = true;
-            }
+    if (Match != UINT32_MAX)
+        return static_cast<uint16>(Match);
 
-            if (!Unique)
-            {
-                for (size_t iTex = 0; iTex < mTexCoords.size(); iTex++)
-                {
-                    if ((mVtxDesc & (EVertexAttribute::Tex0 << iTex)) != 0)
-                    {
-                        if (rkVtx.Tex[iTex] != mTexCoords[iTex][iVert])
-                        {
-                            Unique = true;
-                            break;
-                        }
-                    }
-                }
-            }
+    const uint16 Index = AddVertex(rkVtx);
 
-            if (!Unique && mpSkin != nullptr && (mVtxDesc.HasAnyFlags(EVertexAttribute::BoneIndices | EVertexAttribute::BoneWeights)))
-            {
-                const SVertexWeights& rkWeights = mpSkin->WeightsForVertex(rkVtx.ArrayPosition);
-
-                for (uint32 iWgt = 0; iWgt < 4; iWgt++)
-                {
-                    if (((mVtxDesc & EVertexAttribute::BoneIndices) != 0 && (rkWeights.Indices[iWgt] != mBoneIndices[iVert][iWgt])) ||
-                        ((mVtxDesc & EVertexAttribute::BoneWeights) != 0 && (rkWeights.Weights[iWgt] != mBoneWeights[iVert][iWgt])))
-                    {
-                        Unique = true;
-                        break;
-                    }
-                }
-            }
+    if (Index == mUniqueIndexEnd)
+    {
+        mUniqueIndex.emplace(Hash, Index);
+        mUniqueIndexEnd++;
+    }
 
-            if (!Unique)
-                return static_cast<uint16>(iVert);
-        }
+    return Index;
+}
+
+uint16 CVertexBuffer::AddIfUniqueLinear(const CVertex& rkVtx, uint16 Start)
+{
+    // Reference implementation of AddIfUnique; scans every vertex since Start
+    for (size_t iVert = Start; iVert < mPositions.size(); iVert++)
+    {
+        if (IsSameVertex(rkVtx, iVert))
+            return static_cast<uint16>(iVert);
     }
 
     return AddVertex(rkVtx);
 }
 
+void CVertexBuffer::ClearUniqueIndex()
+{
+    // Swap rather than clear() so the bucket array is released too
+    std::unordered_multimap<uint64, uint16>().swap(mUniqueIndex);
+    mUniqueIndexStart = 0;
+    mUniqueIndexEnd = 0;
+}
+
 void CVertexBuffer::Reserve(size_t Size)
 {
     const size_t ReserveSize = mPositions.size() + Size;
@@ -178,6 +218,10 @@ void CVertexBuffer::Clear()
 
     mBoneIndices.clear();
     mBoneWeights.clear();
+
+    mUniqueIndex.clear();
+    mUniqueIndexStart = 0;
+    mUniqueIndexEnd = 0;
 }
 
 void CVertexBuffer::Buffer()
@@ -322,3 +366,100 @@ GLuint CVertexBuffer::CreateVAO()
     glBindVertexArray(0);
     return VertexArray;
 }
+
+// ************ PRIVATE ************
+uint64 CVertexBuffer::HashVertex(const CVertex& rkVtx) const
+{
+    CVertexHasher Hasher;
+
+    if ((mVtxDesc & EVertexAttribute::Position) != 0)
+        Hasher.Add(rkVtx.Position);
+    if ((mVtxDesc & EVertexAttribute::Normal) != 0)
+        Hasher.Add(rkVtx.Normal);
+    if ((mVtxDesc & EVertexAttribute::Color0) != 0)
+        Hasher.Add(rkVtx.Color[0]);
+    if ((mVtxDesc & EVertexAttribute::Color1) != 0)
+        Hasher.Add(rkVtx.Color[1]);
+
+    for (size_t iTex = 0; iTex < mTexCoords.size(); iTex++)
+    {
+        if ((mVtxDesc & (EVertexAttribute::Tex0 << iTex)) != 0)
+            Hasher.Add(rkVtx.Tex[iTex]);
+    }
+
+    if (mpSkin != nullptr && mVtxDesc.HasAnyFlags(EVertexAttribute::BoneIndices | EVertexAttribute::BoneWeights))
+    {
+        const SVertexWeights& rkWeights = mpSkin->WeightsForVertex(rkVtx.ArrayPosition);
+        if ((mVtxDesc & EVertexAttribute::BoneIndices) != 0)
+            Hasher.Add(rkWeights.Indices);
+        if ((mVtxDesc & EVertexAttribute::BoneWeights) != 0)
+            Hasher.Add(rkWeights.Weights);
+    }
+
+    return Hasher.Hash();
+}
+
+uint64 CVertexBuffer::HashVertex(size_t Index) const
+{
+    // Must hash the same attributes in the same order as the CVertex overload
+    CVertexHasher Hasher;
+
+    if ((mVtxDesc & EVertexAttribute::Position) != 0)
+        Hasher.Add(mPositions[Index]);
+    if ((mVtxDesc & EVertexAttribute::Normal) != 0)
+        Hasher.Add(mNormals[Index]);
+    if ((mVtxDesc & EVertexAttribute::Color0) != 0)
+        Hasher.Add(mColors[0][Index]);
+    if ((mVtxDesc & EVertexAttribute::Color1) != 0)
+        Hasher.Add(mColors[1][Index]);
+
+    for (size_t iTex = 0; iTex < mTexCoords.size(); iTex++)
+    {
+        if ((mVtxDesc & (EVertexAttribute::Tex0 << iTex)) != 0)
+            Hasher.Add(mTexCoords[iTex][Index]);
+    }
+
+    if (mpSkin != nullptr && mVtxDesc.HasAnyFlags(EVertexAttribute::BoneIndices | EVertexAttribute::BoneWeights))
+    {
+        if ((mVtxDesc & EVertexAttribute::BoneIndices) != 0)
+            Hasher.Add(mBoneIndices[Index]);
+        if ((mVtxDesc & EVertexAttribute::BoneWeights) != 0)
+            Hasher.Add(mBoneWeights[Index]);
+    }
+
+    return Hasher.Hash();
+}
+
+bool CVertexBuffer::IsSameVertex(const CVertex& rkVtx, size_t Index) const
+{
+    if ((mVtxDesc & EVertexAttribute::Position) != 0 && rkVtx.Position != mPositions[Index])
+        return false;
+    if ((mVtxDesc & EVertexAttribute::Normal) != 0 && rkVtx.Normal != mNormals[Index])
+        return false;
+    if ((mVtxDesc & EVertexAttribute::Color0) != 0 && rkVtx.Color[0] != mColors[0][Index])
+        return false;
+    if ((mVtxDesc & EVertexAttribute::Color1) != 0 && rkVtx.Color[1] != mColors[1][Index])
+        return false;
+
+    for (size_t iTex = 0; iTex < mTexCoords.size(); iTex++)
+    {
+        if ((mVtxDesc & (EVertexAttribute::Tex0 << iTex)) != 0 && rkVtx.Tex[iTex] != mTexCoords[iTex][Index])
+            return false;
+    }
+
+    if (mpSkin != nullptr && mVtxDesc.HasAnyFlags(EVertexAttribute::BoneIndices | EVertexAttribute::BoneWeights))
+    {
+        const SVertexWeights& rkWeights = mpSkin->WeightsForVertex(rkVtx.ArrayPosition);
+
+        for (uint32 iWgt = 0; iWgt < 4; iWgt++)
+        {
+            if (((mVtxDesc & EVertexAttribute::BoneIndices) != 0 && (rkWeights.Indices[iWgt] != mBoneIndices[Index][iWgt])) ||
+                ((mVtxDesc & EVertexAttribute::BoneWeights) != 0 && (rkWeights.Weights[iWgt] != mBoneWeights[Index][iWgt])))
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
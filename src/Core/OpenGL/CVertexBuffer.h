@@ -6,6 +6,7 @@
 #include "Core/Resource/Model/CVertex.h"
 #include "Core/Resource/Model/EVertexAttribute.h"
 #include <array>
+#include <unordered_map>
 #include <vector>
 #include <GL/glew.h>
 
@@ -22,12 +23,18 @@ class CVertexBuffer
     std::vector<TBoneWeights> mBoneWeights;           // Vectors of bone weights
     bool mBuffered = false;                           // Bool value that indicates whether the attributes have been buffered.
 
+    std::unordered_multimap<uint64, uint16> mUniqueIndex; // Vertex hash -> vertex index, used by AddIfUnique
+    uint32 mUniqueIndexStart = 0;                         // First vertex covered by mUniqueIndex
+    uint32 mUniqueIndexEnd = 0;                           // One past the last vertex covered by mUniqueIndex
+
 public:
     CVertexBuffer();
     explicit CVertexBuffer(FVertexDescription Desc);
     ~CVertexBuffer();
     uint16 AddVertex(const CVertex& rkVtx);
     uint16 AddIfUnique(const CVertex& rkVtx, uint16 Start);
+    uint16 AddIfUniqueLinear(const CVertex& rkVtx, uint16 Start);
+    void ClearUniqueIndex();
     void Reserve(size_t Size);
     void Clear();
     void Buffer();
@@ -39,6 +46,11 @@ public:
     void SetSkin(CSkin *pSkin);
     size_t Size() const;
     GLuint CreateVAO();
+
+private:
+    uint64 HashVertex(const CVertex& rkVtx) const;
+    uint64 HashVertex(size_t Index) const;
+    bool IsSameVertex(const CVertex& rkVtx, size_t Index) const;
 };
 
 #endif // CVERTEXBUFFER_H
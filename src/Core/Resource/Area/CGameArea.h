@@ -6,6 +6,7 @@
 #include "Core/Resource/CMaterialSet.h"
 #include "Core/Resource/CPoiToWorld.h"
 #include "Core/Resource/Collision/CCollisionMeshGroup.h"
+#include "Core/Resource/Factory/CSectionMgrIn.h"
 #include "Core/Resource/Model/CModel.h"
 #include "Core/Resource/Model/CStaticModel.h"
 #include <Common/BasicTypes.h>
@@ -33,8 +34,9 @@ class CGameArea : public CResource
     CTransform4f mTransform;
     CAABox mAABox;
 
-    // Data saved from the original file to help on recook
-    std::vector<std::vector<uint8>> mSectionDataBuffers;
+    // Data saved from the original file to help on recook. Each section is a view into the one buffer holding them all.
+    std::vector<uint8> mSectionData;
+    std::vector<SSectionView> mSections;
     uint32 mOriginalWorldMeshCount = 0;
     bool mUsesCompression = false;
 
@@ -4,11 +4,20 @@ void CCollidableOBBTree::BuildRenderData()
 {
     if (!mRenderData.IsBuilt())
     {
+        BuildOBBTree();
         mRenderData.BuildRenderData(mIndexData);
-        mRenderData.BuildBoundingHierarchyRenderData(mpOBBTree.get());
+
+        if (mpOBBTree)
+            mRenderData.BuildBoundingHierarchyRenderData(mpOBBTree.get());
     }
 }
 
 void CCollidableOBBTree::BuildOBBTree()
 {
+    // Ray queries go through the flattened BVH, which is much faster to traverse than the OBB tree.
+    // The OBB tree is only kept for display, so generate one from the BVH if the file didn't have one.
+    BuildBVH();
+
+    if (!mpOBBTree)
+        mpOBBTree = mBVH.CreateOBBTree();
 }
@@ -0,0 +1,184 @@
+#include "CCollisionBVH.h"
+#include "Core/BVHUtil.h"
+#include <Common/Math/MathUtil.h>
+#include <cfloat>
+
+void CCollisionBVH::Build(const SCollisionIndexData& rkIndexData)
+{
+    Clear();
+
+    const uint32 NumTris = static_cast<uint32>(rkIndexData.NumTriangles());
+
+    if (NumTris == 0)
+        return;
+
+    std::vector<STriangle> SourceTris(NumTris);
+    std::vector<CAABox> TriBounds(NumTris, CAABox::Infinite());
+
+    for (uint32 TriIdx = 0; TriIdx < NumTris; TriIdx++)
+    {
+        const std::array<uint16, 3> kVertIndices = rkIndexData.TriangleVertexIndices(TriIdx);
+        STriangle& rTri = SourceTris[TriIdx];
+
+        for (size_t VertIdx = 0; VertIdx < 3; VertIdx++)
+        {
+            rTri.Vertices[VertIdx] = rkIndexData.Vertices[kVertIndices[VertIdx]];
+            TriBounds[TriIdx].ExpandBounds(rTri.Vertices[VertIdx]);
+        }
+
+        rTri.TriangleIndex = TriIdx;
+        rTri.MaterialIndex = rkIndexData.TriangleMaterialIndices[TriIdx];
+    }
+
+    std::vector<uint32> TriOrder;
+    const std::vector<BVHUtil::SBuildNode> kBuildNodes = BVHUtil::Build(TriBounds, TriOrder, skMaxLeafTriangles);
+    mNodes.reserve(kBuildNodes.size());
+
+    for (const BVHUtil::SBuildNode& rkBuildNode : kBuildNodes)
+        mNodes.push_back(SNode{rkBuildNode.Bounds.Min(), rkBuildNode.Index, rkBuildNode.Bounds.Max(), rkBuildNode.NumPrimitives});
+
+    // Store the triangles in leaf order so each leaf references a contiguous range
+    mTriangles.reserve(NumTris);
+
+    for (const uint32 TriIdx : TriOrder)
+        mTriangles.push_back(SourceTris[TriIdx]);
+}
+
+void CCollisionBVH::Clear()
+{
+    mNodes.clear();
+    mTriangles.clear();
+}
+
+std::pair<bool, float> CCollisionBVH::IntersectsRay(const CRay& rkRay, bool AllowBackfaces,
+                                                    const std::vector<bool> *pkHiddenMaterials,
+                                                    uint32 *pOutTriangleIndex) const
+{
+    bool Hit = false;
+    float HitDist = FLT_MAX;
+
+    if (mNodes.empty())
+        return {false, 0.f};
+
+    const CVector3f Origin = rkRay.Origin();
+    const CVector3f Direction = rkRay.Direction();
+    const CVector3f InvDirection(BVHUtil::SafeInverse(Direction.X), BVHUtil::SafeInverse(Direction.Y), BVHUtil::SafeInverse(Direction.Z));
+
+    float NodeDist;
+
+    if (!BVHUtil::RayIntersectsBox(mNodes[0].Min, mNodes[0].Max, Origin, InvDirection, HitDist, NodeDist))
+        return {false, 0.f};
+
+    // Depth is capped while building, and each level pushes at most one node
+    std::array<std::pair<uint32, float>, BVHUtil::gkMaxDepth + 1> Stack;
+    uint32 StackSize = 0;
+    uint32 NodeIdx = 0;
+
+    while (true)
+    {
+        const SNode& rkNode = mNodes[NodeIdx];
+
+        if (rkNode.NumTriangles > 0)
+        {
+            for (uint32 TriIdx = rkNode.Index; TriIdx < rkNode.Index + rkNode.NumTriangles; TriIdx++)
+            {
+                const STriangle& rkTri = mTriangles[TriIdx];
+
+                if (pkHiddenMaterials && rkTri.MaterialIndex < pkHiddenMaterials->size() && (*pkHiddenMaterials)[rkTri.MaterialIndex])
+                    continue;
+
+                const auto [Intersects, Distance] = Math::RayTriangleIntersection(rkRay, rkTri.Vertices[0], rkTri.Vertices[1], rkTri.Vertices[2], AllowBackfaces);
+
+                if (Intersects && Distance < HitDist)
+                {
+                    Hit = true;
+                    HitDist = Distance;
+
+                    if (pOutTriangleIndex)
+                        *pOutTriangleIndex = rkTri.TriangleIndex;
+                }
+            }
+        }
+        else
+        {
+            const uint32 LeftIdx = NodeIdx + 1;
+            const uint32 RightIdx = rkNode.Index;
+            float LeftDist, RightDist;
+            const bool HitLeft = BVHUtil::RayIntersectsBox(mNodes[LeftIdx].Min, mNodes[LeftIdx].Max, Origin, InvDirection, HitDist, LeftDist);
+            const bool HitRight = BVHUtil::RayIntersectsBox(mNodes[RightIdx].Min, mNodes[RightIdx].Max, Origin, InvDirection, HitDist, RightDist);
+
+            // Visit the closer child first; the farther one can often be culled by then
+            if (HitLeft && HitRight)
+            {
+                if (RightDist < LeftDist)
+                {
+                    Stack[StackSize++] = {LeftIdx, LeftDist};
+                    NodeIdx = RightIdx;
+                }
+                else
+                {
+                    Stack[StackSize++] = {RightIdx, RightDist};
+                    NodeIdx = LeftIdx;
+                }
+
+                continue;
+            }
+
+            if (HitLeft || HitRight)
+            {
+                NodeIdx = (HitLeft ? LeftIdx : RightIdx);
+                continue;
+            }
+        }
+
+        // Pop the next node, skipping any that are farther away than the closest hit found since they were pushed
+        while (StackSize > 0 && Stack[StackSize - 1].second > HitDist)
+            StackSize--;
+
+        if (StackSize == 0)
+            break;
+
+        NodeIdx = Stack[--StackSize].first;
+    }
+
+    return {Hit, Hit ? HitDist : 0.f};
+}
+
+std::unique_ptr<SOBBTreeNode> CCollisionBVH::CreateOBBTree() const
+{
+    if (mNodes.empty())
+        return nullptr;
+
+    return CreateOBBNode(0);
+}
+
+// ************ PRIVATE ************
+std::unique_ptr<SOBBTreeNode> CCollisionBVH::CreateOBBNode(uint32 NodeIdx) const
+{
+    const SNode& rkNode = mNodes[NodeIdx];
+    std::unique_ptr<SOBBTreeNode> pOut;
+
+    if (rkNode.NumTriangles > 0)
+    {
+        auto pLeaf = std::make_unique<SOBBTreeLeaf>();
+        pLeaf->TriangleIndices.reserve(rkNode.NumTriangles);
+
+        for (uint32 TriIdx = rkNode.Index; TriIdx < rkNode.Index + rkNode.NumTriangles; TriIdx++)
+            pLeaf->TriangleIndices.push_back(static_cast<uint16>(mTriangles[TriIdx].TriangleIndex));
+
+        pOut = std::move(pLeaf);
+    }
+    else
+    {
+        auto pBranch = std::make_unique<SOBBTreeBranch>();
+        pBranch->pLeft = CreateOBBNode(NodeIdx + 1);
+        pBranch->pRight = CreateOBBNode(rkNode.Index);
+        pOut = std::move(pBranch);
+    }
+
+    // The boxes are axis-aligned, so the OBB is just a translation to the box center
+    const CVector3f HalfSize = (rkNode.Max - rkNode.Min) * 0.5f;
+    pOut->Transform = CTransform4f::TranslationMatrix(rkNode.Min + HalfSize);
+    pOut->Radii = HalfSize;
+    return pOut;
+}
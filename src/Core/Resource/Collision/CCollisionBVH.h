@@ -0,0 +1,69 @@
+#ifndef CCOLLISIONBVH_H
+#define CCOLLISIONBVH_H
+
+#include "SCollisionIndexData.h"
+#include "SOBBTreeNode.h"
+#include <Common/BasicTypes.h>
+#include <Common/Math/CAABox.h>
+#include <Common/Math/CRay.h>
+#include <Common/Math/CVector3f.h>
+#include <array>
+#include <memory>
+#include <utility>
+#include <vector>
+
+/** Bounding volume hierarchy over the triangles of a collision mesh, used for ray queries.
+ *  The tree is flattened into a single array in depth-first order (see BVHUtil::SBuildNode). */
+class CCollisionBVH
+{
+public:
+    struct SNode
+    {
+        CVector3f Min;
+        uint32 Index;          // Branch: index of the right child. Leaf: index of the first triangle
+        CVector3f Max;
+        uint32 NumTriangles;   // Zero for branches
+    };
+
+    struct STriangle
+    {
+        std::array<CVector3f, 3> Vertices;
+        uint32 TriangleIndex;  // Index of the triangle in the source index data
+        uint8 MaterialIndex;
+    };
+
+    static constexpr uint32 skMaxLeafTriangles = 4;
+
+private:
+    std::vector<SNode> mNodes;
+    std::vector<STriangle> mTriangles;
+
+public:
+    void Build(const SCollisionIndexData& rkIndexData);
+    void Clear();
+
+    /** Returns whether the ray hits any triangle, and the distance to the closest hit.
+     *  Triangles with a material flagged in pkHiddenMaterials are ignored. */
+    std::pair<bool, float> IntersectsRay(const CRay& rkRay, bool AllowBackfaces,
+                                         const std::vector<bool> *pkHiddenMaterials = nullptr,
+                                         uint32 *pOutTriangleIndex = nullptr) const;
+
+    /** Creates an OBB tree matching the hierarchy, for meshes that don't come with one */
+    std::unique_ptr<SOBBTreeNode> CreateOBBTree() const;
+
+    /** Accessors */
+    bool IsBuilt() const                            { return !mNodes.empty(); }
+    size_t NumNodes() const                         { return mNodes.size(); }
+    size_t NumTriangles() const                     { return mTriangles.size(); }
+    const SNode& NodeByIndex(size_t Index) const    { return mNodes[Index]; }
+
+    CAABox Bounds() const
+    {
+        return mNodes.empty() ? CAABox::Infinite() : CAABox(mNodes[0].Min, mNodes[0].Max);
+    }
+
+private:
+    std::unique_ptr<SOBBTreeNode> CreateOBBNode(uint32 NodeIdx) const;
+};
+
+#endif // CCOLLISIONBVH_H
@@ -7,3 +7,11 @@ void CCollisionMesh::BuildRenderData()
         mRenderData.BuildRenderData(mIndexData);
     }
 }
+
+void CCollisionMesh::BuildBVH()
+{
+    if (!mBVH.IsBuilt())
+    {
+        mBVH.Build(mIndexData);
+    }
+}
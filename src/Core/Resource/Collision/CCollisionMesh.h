@@ -1,6 +1,7 @@
 #ifndef CCOLLISIONMESH_H
 #define CCOLLISIONMESH_H
 
+#include "CCollisionBVH.h"
 #include "CCollisionMaterial.h"
 #include "CCollisionRenderData.h"
 #include "SCollisionIndexData.h"
@@ -15,10 +16,12 @@ protected:
     CAABox                  mAABox;
     SCollisionIndexData     mIndexData;
     CCollisionRenderData    mRenderData;
+    CCollisionBVH           mBVH;
 
 public:
     virtual ~CCollisionMesh() = default;
     virtual void BuildRenderData();
+    void BuildBVH();
 
     /** Accessors */
     CAABox Bounds() const
@@ -40,6 +43,11 @@ public:
     {
         return mRenderData;
     }
+
+    const CCollisionBVH& GetBVH() const
+    {
+        return mBVH;
+    }
 };
 
 #endif // CCOLLISIONMESH_H
@@ -27,6 +27,12 @@ public:
             mesh->BuildRenderData();
     }
 
+    void BuildBVH()
+    {
+        for (auto& mesh : mMeshes)
+            mesh->BuildBVH();
+    }
+
     void Draw()
     {
         for (auto& mesh : mMeshes)
@@ -22,8 +22,7 @@ void CCollisionRenderData::BuildRenderData(const SCollisionIndexData& kIndexData
     mWireframeIndexBuffer.SetPrimitiveType(GL_LINES);
 
     // Build list of triangle indices sorted by material index
-    // Apparently some collision meshes have more triangle indices than actual triangles
-    const uint NumTris = std::min(kIndexData.TriangleIndices.size() / 3, kIndexData.TriangleMaterialIndices.size());
+    const uint NumTris = kIndexData.NumTriangles();
     std::vector<uint16> SortedTris(NumTris);
 
     for (uint16 i = 0; i < SortedTris.size(); i++)
@@ -44,7 +43,6 @@ void CCollisionRenderData::BuildRenderData(const SCollisionIndexData& kIndexData
     for (const size_t TriIdx : SortedTris)
     {
         const uint8 MaterialIdx = kIndexData.TriangleMaterialIndices[TriIdx];
-        const CCollisionMaterial& kMaterial = kIndexData.Materials[MaterialIdx];
 
         if (MaterialIdx != CurrentMatIdx)
         {
@@ -59,21 +57,7 @@ void CCollisionRenderData::BuildRenderData(const SCollisionIndexData& kIndexData
             }
         }
 
-        const size_t LineA = kIndexData.TriangleIndices[(TriIdx * 3) + 0];
-        const size_t LineB = kIndexData.TriangleIndices[(TriIdx * 3) + 1];
-        const uint16 LineAVertA = kIndexData.EdgeIndices[(LineA * 2) + 0];
-        const uint16 LineAVertB = kIndexData.EdgeIndices[(LineA * 2) + 1];
-        const uint16 LineBVertA = kIndexData.EdgeIndices[(LineB * 2) + 0];
-        const uint16 LineBVertB = kIndexData.EdgeIndices[(LineB * 2) + 1];
-        uint16 VertIdx0 = LineAVertA;
-        uint16 VertIdx1 = LineAVertB;
-        uint16 VertIdx2 = (LineBVertA != LineAVertA && LineBVertA != LineAVertB ? LineBVertA : LineBVertB);
-
-        // Reverse vertex order if material indicates tri is flipped
-        if (kMaterial & eCF_FlippedTri)
-        {
-            std::swap(VertIdx0, VertIdx2);
-        }
+        const auto [VertIdx0, VertIdx1, VertIdx2] = kIndexData.TriangleVertexIndices(TriIdx);
 
         // Generate vertex data
         const CVector3f& kVert0 = kIndexData.Vertices[VertIdx0];
@@ -3,6 +3,8 @@
 
 #include "CCollisionMaterial.h"
 #include <Common/Math/CVector3f.h>
+#include <algorithm>
+#include <array>
 
 /** Common index data found in all collision file formats */
 struct SCollisionIndexData
@@ -15,6 +17,37 @@ struct SCollisionIndexData
     std::vector<uint16>             TriangleIndices;
     std::vector<uint16>             UnknownData;
     std::vector<CVector3f>          Vertices;
+
+    /** Number of triangles in the mesh.
+     *  Apparently some collision meshes have more triangle indices than actual triangles */
+    size_t NumTriangles() const
+    {
+        return std::min(TriangleIndices.size() / 3, TriangleMaterialIndices.size());
+    }
+
+    /** Returns the vertex indices of a triangle, in winding order.
+     *  Triangles are stored as edges, so the vertices are recovered from the first two edges. */
+    std::array<uint16, 3> TriangleVertexIndices(size_t TriIdx) const
+    {
+        const size_t LineA = TriangleIndices[(TriIdx * 3) + 0];
+        const size_t LineB = TriangleIndices[(TriIdx * 3) + 1];
+        const uint16 LineAVertA = EdgeIndices[(LineA * 2) + 0];
+        const uint16 LineAVertB = EdgeIndices[(LineA * 2) + 1];
+        const uint16 LineBVertA = EdgeIndices[(LineB * 2) + 0];
+        const uint16 LineBVertB = EdgeIndices[(LineB * 2) + 1];
+
+        std::array<uint16, 3> Out{
+            LineAVertA,
+            LineAVertB,
+            (LineBVertA != LineAVertA && LineBVertA != LineAVertB ? LineBVertA : LineBVertB)
+        };
+
+        // Reverse vertex order if material indicates tri is flipped
+        if (Materials[TriangleMaterialIndices[TriIdx]] & eCF_FlippedTri)
+            std::swap(Out[0], Out[2]);
+
+        return Out;
+    }
 };
 
 #endif // SCOLLISIONINDEXDATA_H
@@ -93,7 +93,7 @@ void CAreaCooker::WritePrimeHeader(IOutputStream& rOut)
     rOut.WriteULong(mpArea->mOriginalWorldMeshCount);
     if (mVersion >= EGame::Echoes)
         rOut.WriteULong(static_cast<uint32>(mpArea->mScriptLayers.size()));
-    rOut.WriteULong(static_cast<uint32>(mpArea->mSectionDataBuffers.size()));
+    rOut.WriteULong(static_cast<uint32>(mpArea->mSections.size()));
 
     rOut.WriteULong(mGeometrySecNum);
     rOut.WriteULong(mSCLYSecNum);
@@ -136,7 +136,7 @@ void CAreaCooker::WriteCorruptionHeader(IOutputStream& rOut)
     mpArea->mTransform.Write(rOut);
     rOut.WriteULong(mpArea->mOriginalWorldMeshCount);
     rOut.WriteULong(static_cast<uint32>(mpArea->mScriptLayers.size()));
-    rOut.WriteULong(static_cast<uint32>(mpArea->mSectionDataBuffers.size()));
+    rOut.WriteULong(static_cast<uint32>(mpArea->mSections.size()));
     rOut.WriteULong(static_cast<uint32>(mCompressedBlocks.size()));
     rOut.WriteULong(static_cast<uint32>(mpArea->mSectionNumbers.size()));
     rOut.WriteToBoundary(32, 0);
@@ -345,7 +345,7 @@ void CAreaCooker::FinishBlock()
 {
     if (mCurBlock.NumSections == 0) return;
 
-    std::vector<uint8> CompressedBuf(mCompressedData.Size() * 2);
+    std::vector<uint8> CompressedBuf;
     const bool EnableCompression = (mVersion >= EGame::Echoes) && mpArea->mUsesCompression && !gkForceDisableCompression;
     const bool UseZlib = (mVersion == EGame::DKCReturns);
 
@@ -354,6 +354,7 @@ void CAreaCooker::FinishBlock()
 
     if (EnableCompression)
     {
+        CompressedBuf.resize(CompressionUtil::MaxSegmentedCompressedSize(static_cast<uint32>(mCompressedData.Size()), UseZlib));
         const bool Success = CompressionUtil::CompressSegmentedData(static_cast<uint8*>(mCompressedData.Data()), mCompressedData.Size(), CompressedBuf.data(), CompressedSize, UseZlib, true);
         const uint32 PadBytes = (32 - (CompressedSize % 32)) & 0x1F;
         WriteCompressedData = Success && (CompressedSize + PadBytes < static_cast<uint32>(mCompressedData.Size()));
@@ -403,7 +404,7 @@ bool CAreaCooker::CookMREA(CGameArea *pArea, IOutputStream& rOut)
 
         else
         {
-            Cooker.mSectionData.WriteBytes(pArea->mSectionDataBuffers[iSec].data(), pArea->mSectionDataBuffers[iSec].size());
+            Cooker.mSectionData.WriteBytes(pArea->mSections[iSec].pData, pArea->mSections[iSec].Size);
             Cooker.FinishSection(false);
         }
     }
@@ -416,7 +417,7 @@ bool CAreaCooker::CookMREA(CGameArea *pArea, IOutputStream& rOut)
 
     // Write post-SCLY data sections
     const uint32 PostSCLY = (Cooker.mVersion <= EGame::Prime ? Cooker.mSCLYSecNum + 1 : Cooker.mSCGNSecNum + 1);
-    for (size_t iSec = PostSCLY; iSec < pArea->mSectionDataBuffers.size(); iSec++)
+    for (size_t iSec = PostSCLY; iSec < pArea->mSections.size(); iSec++)
     {
         if (iSec == Cooker.mModulesSecNum)
         {
@@ -424,7 +425,7 @@ bool CAreaCooker::CookMREA(CGameArea *pArea, IOutputStream& rOut)
         }
         else
         {
-            Cooker.mSectionData.WriteBytes(pArea->mSectionDataBuffers[iSec].data(), pArea->mSectionDataBuffers[iSec].size());
+            Cooker.mSectionData.WriteBytes(pArea->mSections[iSec].pData, pArea->mSections[iSec].Size);
             Cooker.FinishSection(false);
         }
     }
@@ -15,11 +15,8 @@ CAreaLoader::CAreaLoader() = default;
 
 CAreaLoader::~CAreaLoader()
 {
-    if (mHasDecompressedBuffer)
-    {
+    if (mOwnsStream)
         delete mpMREA;
-        delete[] mpDecmpBuffer;
-    }
 }
 
 // ************ PRIME ************
@@ -537,10 +534,21 @@ void CAreaLoader::Decompress()
     // It should be called at the beginning of the first compressed cluster.
     if (mVersion < EGame::Echoes) return;
 
-    // Decompress clusters
-    mpDecmpBuffer = new uint8[mTotalDecmpSize];
+    // Decompress clusters straight into the area's section data, which is kept for recooking
+    std::vector<uint8>& rDecmpBuffer = mpArea->mSectionData;
+    rDecmpBuffer.resize(mTotalDecmpSize);
     uint32 Offset = 0;
 
+    // Every cluster's sizes are known up front, so read them all, then decompress them in parallel
+    uint32 TotalCompressedSize = 0;
+
+    for (const auto& cluster : mClusters)
+        TotalCompressedSize += cluster.CompressedSize;
+
+    std::vector<uint8> CompressedBuf(TotalCompressedSize);
+    std::vector<CompressionUtil::SDecompressBlock> Blocks;
+    uint32 CompressedOffset = 0;
+
     for (auto& cluster : mClusters)
     {
         SCompressedCluster *pClust = &cluster;
@@ -548,7 +556,7 @@ void CAreaLoader::Decompress()
         // Is it decompressed already?
         if (cluster.CompressedSize == 0)
         {
-            mpMREA->ReadBytes(mpDecmpBuffer + Offset, pClust->DecompressedSize);
+            mpMREA->ReadBytes(rDecmpBuffer.data() + Offset, pClust->DecompressedSize);
             Offset += pClust->DecompressedSize;
         }
         else
@@ -557,36 +565,51 @@ void CAreaLoader::Decompress()
             if (StartOffset != 32)
                 mpMREA->Seek(StartOffset, SEEK_CUR);
 
-            std::vector<uint8> CompressedBuf(cluster.CompressedSize);
-            mpMREA->ReadBytes(CompressedBuf.data(), CompressedBuf.size());
-
-            const bool Success = CompressionUtil::DecompressSegmentedData(CompressedBuf.data(), CompressedBuf.size(), mpDecmpBuffer + Offset, pClust->DecompressedSize);
-            if (!Success)
-                throw "Failed to decompress MREA!";
+            uint8 *pCompressed = CompressedBuf.data() + CompressedOffset;
+            mpMREA->ReadBytes(pCompressed, pClust->CompressedSize);
+            Blocks.push_back(CompressionUtil::SDecompressBlock{pCompressed, pClust->CompressedSize, rDecmpBuffer.data() + Offset, pClust->DecompressedSize, true});
 
+            CompressedOffset += pClust->CompressedSize;
             Offset += pClust->DecompressedSize;
         }
     }
 
-    const TString Source = mpMREA->GetSourceString();
-    mpMREA = new CMemoryInStream(mpDecmpBuffer, mTotalDecmpSize, EEndian::BigEndian);
-    mpMREA->SetSourceString(Source);
-    mpSectionMgr->SetInputStream(mpMREA);
-    mHasDecompressedBuffer = true;
+    if (!CompressionUtil::DecompressBlocks(Blocks))
+        throw "Failed to decompress MREA!";
+
+    ReadFromSectionData();
 }
 
 void CAreaLoader::LoadSectionDataBuffers()
 {
-   mpArea->mSectionDataBuffers.resize(mpSectionMgr->NumSections());
-   mpSectionMgr->ToSection(0);
-
-   for (size_t iSec = 0; iSec < mpSectionMgr->NumSections(); iSec++)
-   {
-       const uint32 Size = mpSectionMgr->CurrentSectionSize();
-       mpArea->mSectionDataBuffers[iSec].resize(Size);
-       mpMREA->ReadBytes(mpArea->mSectionDataBuffers[iSec].data(), mpArea->mSectionDataBuffers[iSec].size());
-       mpSectionMgr->ToNextSection();
-   }
+    // This function should be called right after the section manager is initialized.
+    // Uncompressed areas are read into a single buffer here; compressed ones were already decompressed into it.
+    if (!mOwnsStream)
+    {
+        mpArea->mSectionData.resize(mpSectionMgr->TotalSize());
+        mpMREA->ReadBytes(mpArea->mSectionData.data(), mpArea->mSectionData.size());
+        ReadFromSectionData();
+        mpSectionMgr->Init();
+    }
+
+    // The retained sections don't copy anything; they just point into the buffer
+    mpSectionMgr->SetSectionData(mpArea->mSectionData.data(), static_cast<uint32>(mpArea->mSectionData.size()));
+    mpArea->mSections.resize(mpSectionMgr->NumSections());
+
+    for (uint32 iSec = 0; iSec < mpSectionMgr->NumSections(); iSec++)
+        mpArea->mSections[iSec] = mpSectionMgr->Section(iSec);
+
+    mpSectionMgr->ToSection(0);
+}
+
+void CAreaLoader::ReadFromSectionData()
+{
+    // Switch the rest of the load over to parsing the area's section data in memory
+    const TString Source = mpMREA->GetSourceString();
+    mpMREA = new CMemoryInStream(mpArea->mSectionData.data(), mpArea->mSectionData.size(), EEndian::BigEndian);
+    mpMREA->SetSourceString(Source);
+    mpSectionMgr->SetInputStream(mpMREA);
+    mOwnsStream = true;
 }
 
 void CAreaLoader::ReadCollision()
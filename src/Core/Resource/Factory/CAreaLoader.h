@@ -25,8 +25,7 @@ class CAreaLoader
     std::unordered_map<uint32, std::vector<CLink*>> mConnectionMap;
 
     // Compression
-    uint8 *mpDecmpBuffer = nullptr;
-    bool mHasDecompressedBuffer = false;
+    bool mOwnsStream = false; // Set once parsing has switched over to reading the area's section data from memory
     std::vector<SCompressedCluster> mClusters;
     uint32 mTotalDecmpSize = 0;
 
@@ -78,6 +77,7 @@ class CAreaLoader
     void ReadCompressedBlocks();
     void Decompress();
     void LoadSectionDataBuffers();
+    void ReadFromSectionData();
     void ReadCollision();
     void ReadPATH();
     void ReadPTLA();
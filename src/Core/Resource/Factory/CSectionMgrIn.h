@@ -2,24 +2,39 @@
 #define CSECTIONMGRIN_H
 
 #include <Common/BasicTypes.h>
+#include <Common/Macros.h>
 #include <Common/FileIO/IInputStream.h>
+#include <algorithm>
 #include <vector>
 
+// Non-owning view of a section's data in memory
+struct SSectionView
+{
+    const uint8 *pData = nullptr;
+    uint32 Size = 0;
+};
+
 // The purpose of this class is to keep track of data block navigation - required to read CMDL and MREA files correctly
 class CSectionMgrIn
 {
     IInputStream *mpInputStream;
     std::vector<uint32> mSectionSizes;
+    std::vector<uint32> mSectionOffsets; // Relative to the start of the first section; has one extra entry for the end of the last section
     uint32 mCurSec = 0;
     uint32 mCurSecStart = 0;
     uint32 mSecsStart = 0;
+    const uint8 *mpkSectionData = nullptr;
+    uint32 mSectionDataSize = 0;
 
 public:
     CSectionMgrIn(size_t Count, IInputStream* pSrc)
-        : mpInputStream(pSrc), mSectionSizes(Count)
+        : mpInputStream(pSrc), mSectionSizes(Count), mSectionOffsets(Count + 1, 0)
     {
-        for (auto& size : mSectionSizes)
-            size = pSrc->ReadULong();
+        for (size_t iSec = 0; iSec < Count; iSec++)
+        {
+            mSectionSizes[iSec] = pSrc->ReadULong();
+            mSectionOffsets[iSec + 1] = mSectionOffsets[iSec] + mSectionSizes[iSec];
+        }
     }
 
     void Init()
@@ -32,11 +47,7 @@ public:
 
     void ToSection(uint32 SecNum)
     {
-        uint32 Offset = mSecsStart;
-        for (uint32 iSec = 0; iSec < SecNum; iSec++)
-            Offset += mSectionSizes[iSec];
-
-        mpInputStream->Seek(Offset, SEEK_SET);
+        mpInputStream->Seek(mSecsStart + mSectionOffsets[SecNum], SEEK_SET);
         mCurSec = SecNum;
         mCurSecStart = mpInputStream->Tell();
     }
@@ -48,10 +59,26 @@ public:
         mCurSec++;
     }
 
+    // Marks where the section data is held in memory, so sections can be accessed without copying them
+    void SetSectionData(const uint8 *pkData, uint32 Size)
+    {
+        mpkSectionData = pkData;
+        mSectionDataSize = Size;
+    }
+
+    SSectionView Section(uint32 SecNum) const
+    {
+        ASSERT(mpkSectionData != nullptr);
+        const uint32 Start = std::min(mSectionOffsets[SecNum], mSectionDataSize);
+        const uint32 End = std::min(mSectionOffsets[SecNum + 1], mSectionDataSize);
+        return SSectionView{mpkSectionData + Start, End - Start};
+    }
+
     uint32 NextOffset() const                { return mCurSecStart + mSectionSizes[mCurSec]; }
     uint32 CurrentSection() const            { return mCurSec; }
     uint32 CurrentSectionSize() const        { return mSectionSizes[mCurSec]; }
     size_t NumSections() const               { return mSectionSizes.size(); }
+    uint32 TotalSize() const                 { return mSectionOffsets.back(); }
     void SetInputStream(IInputStream *pIn)   { mpInputStream = pIn; }
 };
 
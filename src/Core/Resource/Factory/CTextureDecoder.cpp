@@ -1,7 +1,9 @@
 #include "CTextureDecoder.h"
 #include <Common/Log.h>
 #include <Common/CColor.h>
+#include <algorithm>
 #include <array>
+#include <cstring>
 
 // A cleanup is warranted at some point. Trying to support both partial + full decode ended up really messy.
 namespace
@@ -144,6 +146,310 @@ constexpr uint32 CalculateMaskBitCount(uint32 BitMask)
     }
     return Count;
 }
+
+// Size of one block of source data in bytes for each GX texture format
+// (CMPR is counted as 2x2 subblocks, matching the block size above)
+constexpr std::array gskBlockSourceSize{
+    32U,
+    32U,
+    32U,
+    32U,
+    32U,
+    32U,
+    32U,
+    32U,
+    32U,
+    64U,
+    32U,
+};
+
+// Extra zeroed bytes after the image data so a block cut off by the end of the file can still be read as a whole
+constexpr uint32 gkImagePadding = 64;
+
+template <size_t Count>
+constexpr std::array<uint8, Count> MakeExtendTable(uint8 (*Extend)(uint8))
+{
+    std::array<uint8, Count> Table{};
+
+    for (size_t Idx = 0; Idx < Count; Idx++)
+        Table[Idx] = Extend(static_cast<uint8>(Idx));
+
+    return Table;
+}
+
+constexpr std::array<uint8, 256> MakeCMPRIndexTable()
+{
+    std::array<uint8, 256> Table{};
+
+    for (uint32 Byte = 0; Byte < 256; Byte++)
+        Table[Byte] = static_cast<uint8>(((Byte & 0x3) << 6) | ((Byte & 0xC) << 2) | ((Byte & 0x30) >> 2) | ((Byte & 0xC0) >> 6));
+
+    return Table;
+}
+
+constexpr std::array<uint32, 16> MakeC4ColorTable()
+{
+    std::array<uint32, 16> Table{};
+
+    for (uint32 Index = 0; Index < 16; Index++)
+    {
+        const uint32 R = ((Index >> 3) & 0x1) ? 0xFF : 0x0;
+        const uint32 G = ((Index >> 2) & 0x1) ? 0xFF : 0x0;
+        const uint32 B = ((Index >> 1) & 0x1) ? 0xFF : 0x0;
+        const uint32 A = ((Index >> 0) & 0x1) ? 0xFF : 0x0;
+        Table[Index] = (R << 24) | (G << 16) | (B << 8) | A;
+    }
+
+    return Table;
+}
+
+// Lookup tables for expanding 3/4/5-bit channels to 8 bits
+constexpr auto gskExtend3to8 = MakeExtendTable<8>(Extend3to8);
+constexpr auto gskExtend4to8 = MakeExtendTable<16>(Extend4to8);
+constexpr auto gskExtend5to8 = MakeExtendTable<32>(Extend5to8);
+
+// CMPR stores its 2-bit pixel indices in the opposite order to DXT1
+constexpr auto gskCMPRIndexSwap = MakeCMPRIndexTable();
+
+// Colors for each C4 index; see DecodeBlockC4
+constexpr auto gskC4Colors = MakeC4ColorTable();
+
+uint16 ReadBigEndian16(const uint8 *pkSrc)
+{
+    return static_cast<uint16>((pkSrc[0] << 8) | pkSrc[1]);
+}
+
+template <typename T>
+void WriteNative(uint8 *pDst, T Value)
+{
+    std::memcpy(pDst, &Value, sizeof(T));
+}
+
+uint32 RGB5A3ToARGB(uint16 Pixel)
+{
+    if (Pixel & 0x8000) // RGB5
+    {
+        const uint32 B = gskExtend5to8[(Pixel >> 10) & 0x1F];
+        const uint32 G = gskExtend5to8[(Pixel >>  5) & 0x1F];
+        const uint32 R = gskExtend5to8[(Pixel >>  0) & 0x1F];
+        return 0xFF000000 | (R << 16) | (G << 8) | B;
+    }
+    else // RGB4A3
+    {
+        const uint32 A = gskExtend3to8[(Pixel >> 12) & 0x7];
+        const uint32 B = gskExtend4to8[(Pixel >>  8) & 0xF];
+        const uint32 G = gskExtend4to8[(Pixel >>  4) & 0xF];
+        const uint32 R = gskExtend4to8[(Pixel >>  0) & 0xF];
+        return (A << 24) | (R << 16) | (G << 8) | B;
+    }
+}
+
+// ************ BLOCK KERNELS (PARTIAL DECODE) ************
+// Each kernel decodes one block of source data straight into the output buffer.
+// Output is written in system endianness with the same layout the per-pixel stream decode used to produce.
+struct SGXBlockParams
+{
+    uint32 DstPitch;         // Bytes between rows in the output mipmap
+    uint32 DstStride;        // Bytes between pixels in the output mipmap
+    uint32 NumRows;          // Rows to decode; less than the block height only when the image data is cut off
+    const uint32 *pkPalette; // Decoded palette for C8
+};
+
+using GXBlockKernel = void (*)(const uint8*, uint8*, const SGXBlockParams&);
+
+void DecodeBlockI4(const uint8 *pkSrc, uint8 *pDst, const SGXBlockParams& rkParams)
+{
+    for (uint32 Row = 0; Row < rkParams.NumRows; Row++, pkSrc += 4, pDst += rkParams.DstPitch)
+    {
+        for (uint32 Col = 0; Col < 4; Col++)
+        {
+            const uint8 High = gskExtend4to8[pkSrc[Col] >> 4];
+            const uint8 Low = gskExtend4to8[pkSrc[Col] & 0xF];
+            uint8 *pOut = pDst + (Col * 4);
+            pOut[0] = High;
+            pOut[1] = High;
+            pOut[2] = Low;
+            pOut[3] = Low;
+        }
+    }
+}
+
+void DecodeBlockI8(const uint8 *pkSrc, uint8 *pDst, const SGXBlockParams& rkParams)
+{
+    for (uint32 Row = 0; Row < rkParams.NumRows; Row++, pkSrc += 8, pDst += rkParams.DstPitch)
+    {
+        for (uint32 Col = 0; Col < 8; Col++)
+        {
+            pDst[Col * 2 + 0] = pkSrc[Col];
+            pDst[Col * 2 + 1] = pkSrc[Col];
+        }
+    }
+}
+
+void DecodeBlockIA4(const uint8 *pkSrc, uint8 *pDst, const SGXBlockParams& rkParams)
+{
+    // this can be left as-is for DDS conversion, but opengl doesn't support two components in one byte...
+    for (uint32 Row = 0; Row < rkParams.NumRows; Row++, pkSrc += 8, pDst += rkParams.DstPitch)
+    {
+        for (uint32 Col = 0; Col < 8; Col++)
+        {
+            const uint32 Alpha = gskExtend4to8[pkSrc[Col] >> 4];
+            const uint32 Lum = gskExtend4to8[pkSrc[Col] & 0xF];
+            WriteNative(pDst + (Col * 2), static_cast<uint16>((Lum << 8) | Alpha));
+        }
+    }
+}
+
+// IA8 and RGB565 can be used as-is once they're byte swapped
+void DecodeBlock16(const uint8 *pkSrc, uint8 *pDst, const SGXBlockParams& rkParams)
+{
+    for (uint32 Row = 0; Row < rkParams.NumRows; Row++, pkSrc += 8, pDst += rkParams.DstPitch)
+    {
+        for (uint32 Col = 0; Col < 4; Col++)
+            WriteNative(pDst + (Col * 2), ReadBigEndian16(pkSrc + (Col * 2)));
+    }
+}
+
+void DecodeBlockRGB5A3(const uint8 *pkSrc, uint8 *pDst, const SGXBlockParams& rkParams)
+{
+    for (uint32 Row = 0; Row < rkParams.NumRows; Row++, pkSrc += 8, pDst += rkParams.DstPitch)
+    {
+        for (uint32 Col = 0; Col < 4; Col++)
+            WriteNative(pDst + (Col * 4), RGB5A3ToARGB(ReadBigEndian16(pkSrc + (Col * 2))));
+    }
+}
+
+void DecodeBlockRGBA8(const uint8 *pkSrc, uint8 *pDst, const SGXBlockParams& rkParams)
+{
+    // RGBA8 blocks store the AR values for all 16 pixels first, followed by the GB values
+    for (uint32 Row = 0; Row < rkParams.NumRows; Row++, pkSrc += 8, pDst += rkParams.DstPitch)
+    {
+        for (uint32 Col = 0; Col < 4; Col++)
+        {
+            const uint32 AR = ReadBigEndian16(pkSrc + (Col * 2));
+            const uint32 GB = ReadBigEndian16(pkSrc + (Col * 2) + 0x20);
+            WriteNative(pDst + (Col * 4), (AR << 16) | GB);
+        }
+    }
+}
+
+void DecodeBlockC4(const uint8 *pkSrc, uint8 *pDst, const SGXBlockParams& rkParams)
+{
+    // This isn't how C4 works, but due to the way Retro packed font textures (which use C4)
+    // this is the only way to get them to decode correctly for now.
+    // Dedicated font texture-decoding function is probably going to be necessary in the future.
+    // Each pair of pixels writes 8 bytes regardless of the output stride, so with a 2-byte stride
+    // the pairs overlap and have to be written in order.
+    const uint32 PairStride = rkParams.DstStride * 2;
+
+    for (uint32 Row = 0; Row < rkParams.NumRows; Row++, pkSrc += 4, pDst += rkParams.DstPitch)
+    {
+        for (uint32 Col = 0; Col < 4; Col++)
+        {
+            uint8 *pOut = pDst + (Col * PairStride);
+            WriteNative(pOut + 0, gskC4Colors[pkSrc[Col] >> 4]);
+            WriteNative(pOut + 4, gskC4Colors[pkSrc[Col] & 0xF]);
+        }
+    }
+}
+
+// C8 with an IA8 or RGB565 palette
+void DecodeBlockC8Palette16(const uint8 *pkSrc, uint8 *pDst, const SGXBlockParams& rkParams)
+{
+    for (uint32 Row = 0; Row < rkParams.NumRows; Row++, pkSrc += 8, pDst += rkParams.DstPitch)
+    {
+        for (uint32 Col = 0; Col < 8; Col++)
+            WriteNative(pDst + (Col * 2), static_cast<uint16>(rkParams.pkPalette[pkSrc[Col]]));
+    }
+}
+
+// C8 with an RGB5A3 palette
+void DecodeBlockC8Palette32(const uint8 *pkSrc, uint8 *pDst, const SGXBlockParams& rkParams)
+{
+    for (uint32 Row = 0; Row < rkParams.NumRows; Row++, pkSrc += 8, pDst += rkParams.DstPitch)
+    {
+        for (uint32 Col = 0; Col < 8; Col++)
+            WriteNative(pDst + (Col * 4), rkParams.pkPalette[pkSrc[Col]]);
+    }
+}
+
+void DecodeBlockCMPR(const uint8 *pkSrc, uint8 *pDst, const SGXBlockParams& rkParams)
+{
+    // Each "pixel" is a 4x4 subblock. Converting to DXT1 only requires byte swapping the colors and reordering the indices.
+    for (uint32 Row = 0; Row < rkParams.NumRows; Row++, pkSrc += 16, pDst += rkParams.DstPitch)
+    {
+        for (uint32 Col = 0; Col < 2; Col++)
+        {
+            const uint8 *pkSubBlock = pkSrc + (Col * 8);
+            uint8 *pOut = pDst + (Col * 8);
+            WriteNative(pOut + 0, ReadBigEndian16(pkSubBlock + 0));
+            WriteNative(pOut + 2, ReadBigEndian16(pkSubBlock + 2));
+
+            for (uint32 Byte = 4; Byte < 8; Byte++)
+                pOut[Byte] = gskCMPRIndexSwap[pkSubBlock[Byte]];
+        }
+    }
+}
+
+GXBlockKernel SelectBlockKernel(ETexelFormat Format, EGXPaletteFormat PaletteFormat)
+{
+    switch (Format)
+    {
+    case ETexelFormat::GX_I4:     return &DecodeBlockI4;
+    case ETexelFormat::GX_I8:     return &DecodeBlockI8;
+    case ETexelFormat::GX_IA4:    return &DecodeBlockIA4;
+    case ETexelFormat::GX_IA8:    return &DecodeBlock16;
+    case ETexelFormat::GX_C4:     return &DecodeBlockC4;
+    case ETexelFormat::GX_RGB565: return &DecodeBlock16;
+    case ETexelFormat::GX_RGB5A3: return &DecodeBlockRGB5A3;
+    case ETexelFormat::GX_RGBA8:  return &DecodeBlockRGBA8;
+    case ETexelFormat::GX_CMPR:   return &DecodeBlockCMPR;
+
+    case ETexelFormat::GX_C8:
+        if (PaletteFormat == EGXPaletteFormat::IA8 || PaletteFormat == EGXPaletteFormat::RGB565)
+            return &DecodeBlockC8Palette16;
+        if (PaletteFormat == EGXPaletteFormat::RGB5A3)
+            return &DecodeBlockC8Palette32;
+        return nullptr;
+
+    default:
+        return nullptr;
+    }
+}
+
+// Reads big endian image data from memory. Reads past the end return zero instead of leaving the buffer.
+class CGXImageReader
+{
+    const uint8 *mpkData;
+    uint32 mSize;
+    uint32 mPos = 0;
+
+public:
+    CGXImageReader(const uint8 *pkData, uint32 Size)
+        : mpkData(pkData), mSize(Size)
+    {}
+
+    uint8 ReadUByte()
+    {
+        const uint8 Out = (mPos < mSize ? mpkData[mPos] : 0);
+        mPos++;
+        return Out;
+    }
+
+    uint16 ReadUShort()
+    {
+        const uint32 High = ReadUByte();
+        return static_cast<uint16>((High << 8) | ReadUByte());
+    }
+
+    void ReadBytes(uint8 *pDst, uint32 Count)
+    {
+        for (uint32 Idx = 0; Idx < Count; Idx++)
+            pDst[Idx] = ReadUByte();
+    }
+
+    void Skip(uint32 Count) { mPos += Count; }
+};
 } // Anonymous namespace
 
 CTextureDecoder::CTextureDecoder()
@@ -255,8 +561,6 @@ void CTextureDecoder::ReadTXTR(IInputStream& rTXTR)
         const uint32 PaletteEntryCount = (mTexelFormat == ETexelFormat::GX_C4) ? 16 : 256;
         mPalettes.resize(PaletteEntryCount * 2);
         rTXTR.ReadBytes(mPalettes.data(), mPalettes.size());
-
-        mPaletteInput.SetData(mPalettes.data(), mPalettes.size(), EEndian::BigEndian);
     }
     else
     {
@@ -315,52 +619,125 @@ void CTextureDecoder::ReadDDS(IInputStream& rDDS)
 }
 
 // ************ DECODE ************
-void CTextureDecoder::PartialDecodeGXTexture(IInputStream& TXTR)
+void CTextureDecoder::PartialDecodeGXTexture(IInputStream& rTXTR)
 {
     // TODO: This function doesn't handle very small mipmaps correctly.
     // The format applies padding when the size of a mipmap is less than the block size for that format.
     // The decode needs to be adjusted to account for the padding and skip over it (since we don't have padding in OpenGL).
 
     // Get image data size, create output buffer
-    const uint32 ImageStart = TXTR.Tell();
-    TXTR.Seek(0x0, SEEK_END);
-    const uint32 ImageSize = TXTR.Tell() - ImageStart;
-    TXTR.Seek(ImageStart, SEEK_SET);
+    const uint32 ImageStart = rTXTR.Tell();
+    rTXTR.Seek(0x0, SEEK_END);
+    const uint32 ImageSize = rTXTR.Tell() - ImageStart;
+    rTXTR.Seek(ImageStart, SEEK_SET);
 
-    mDataBufferSize = ImageSize * (gskOutputBpp[static_cast<size_t>(mTexelFormat)] / gskSourceBpp[static_cast<size_t>(mTexelFormat)]);
+    const auto FormatIdx = static_cast<size_t>(mTexelFormat);
+    mDataBufferSize = ImageSize * (gskOutputBpp[FormatIdx] / gskSourceBpp[FormatIdx]);
     if (mHasPalettes && mPaletteFormat == EGXPaletteFormat::RGB5A3)
         mDataBufferSize *= 2;
-    mpDataBuffer = new uint8[mDataBufferSize];
 
-    CMemoryOutStream Out(mpDataBuffer, mDataBufferSize, EEndian::SystemEndian);
+    // Read the image data in one go so the block kernels can work on raw memory
+    std::vector<uint8> ImageData(ImageSize + gkImagePadding, 0);
+    rTXTR.ReadBytes(ImageData.data(), ImageSize);
 
-    // Initializing more stuff before we start the mipmap loop
-    uint32 MipW = mWidth;
-    uint32 MipH = mHeight;
-    uint32 MipOffset = 0;
-
-    const uint32 BWidth = gskBlockWidth[static_cast<size_t>(mTexelFormat)];
-    const uint32 BHeight = gskBlockHeight[static_cast<size_t>(mTexelFormat)];
+    const uint32 BWidth = gskBlockWidth[FormatIdx];
+    const uint32 BHeight = gskBlockHeight[FormatIdx];
+    const uint32 BlockSize = gskBlockSourceSize[FormatIdx];
 
-    uint32 PixelStride = gskOutputPixelStride[static_cast<size_t>(mTexelFormat)];
+    uint32 PixelStride = gskOutputPixelStride[FormatIdx];
     if (mHasPalettes && mPaletteFormat == EGXPaletteFormat::RGB5A3)
         PixelStride = 4;
 
+    // C4 writes two 4-byte pixels per step even when the stride is 2, so it can write past the end of a row
+    const uint32 WriteOverhang = (mTexelFormat == ETexelFormat::GX_C4 ? 8 - (PixelStride * 2) : 0);
+
+    // How far into a block the source has been read by the time its last pixel is read, and the same per row.
+    // RGBA8 reads the GB half of each block with a lookahead, so it's only halfway through at that point.
+    const uint32 BlockReadSize = (mTexelFormat == ETexelFormat::GX_RGBA8 ? BlockSize / 2 : BlockSize);
+    const uint32 RowReadSize = BlockReadSize / BHeight;
+
+    // Decode the C8 palette once up front
+    std::array<uint32, 256> Palette{};
+
+    if (mTexelFormat == ETexelFormat::GX_C8)
+    {
+        for (uint32 EntryIdx = 0; EntryIdx < Palette.size(); EntryIdx++)
+        {
+            const uint16 Entry = ReadBigEndian16(&mPalettes[EntryIdx * 2]);
+            Palette[EntryIdx] = (mPaletteFormat == EGXPaletteFormat::RGB5A3 ? RGB5A3ToARGB(Entry) : Entry);
+        }
+    }
+
+    const GXBlockKernel Kernel = SelectBlockKernel(mTexelFormat, mPaletteFormat);
+    SGXBlockParams Params{};
+    Params.DstStride = PixelStride;
+    Params.pkPalette = Palette.data();
+
     // With CMPR, we're using a little trick.
     // CMPR stores pixels in 8x8 blocks, with four 4x4 subblocks.
     // An easy way to convert it is to pretend each block is 2x2 and each subblock is one pixel.
     // So to do that we need to calculate the "new" dimensions of the image, 1/4 the size of the original.
-    if (mTexelFormat == ETexelFormat::GX_CMPR) {
-        MipW /= 4;
-        MipH /= 4;
+    const uint32 BaseMipW = (mTexelFormat == ETexelFormat::GX_CMPR ? mWidth / 4 : mWidth);
+    const uint32 BaseMipH = (mTexelFormat == ETexelFormat::GX_CMPR ? mHeight / 4 : mHeight);
+
+    const auto CalcMipSize = [this, FormatIdx](uint32 MipW, uint32 MipH)
+    {
+        uint32 MipSize = static_cast<uint32>(MipW * MipH * gskPixelsToBytes[FormatIdx]);
+
+        // Since we're pretending CMPR images are 1/4 their actual size, we have to multiply the size by 16 to get the correct offset
+        if (mTexelFormat == ETexelFormat::GX_CMPR)
+            MipSize *= 16;
+
+        return MipSize;
+    };
+
+    // The kernels write whole blocks without bounds checks, so work out how much of the buffer will actually be written.
+    // Small mipmaps are padded out to the block size, so this can be a bit more than the data size suggests.
+    uint64 AllocSize = mDataBufferSize;
+    {
+        uint32 MipW = BaseMipW;
+        uint32 MipH = BaseMipH;
+        uint64 MipOffset = 0;
+        uint64 SrcEnd = 0;
+
+        for (uint32 iMip = 0; iMip < mNumMipMaps && Kernel != nullptr; iMip++)
+        {
+            MipW = std::max(MipW, BWidth);
+            MipH = std::max(MipH, BHeight);
+
+            const uint64 BlocksX = (MipW + BWidth - 1) / BWidth;
+            const uint64 BlocksY = (MipH + BHeight - 1) / BHeight;
+            const uint64 LastRow = (BlocksY * BHeight) - 1;
+            AllocSize = std::max(AllocSize, MipOffset + ((LastRow * MipW) + (BlocksX * BWidth)) * PixelStride + WriteOverhang);
+
+            // Stop once we reach the mip where the decode runs out of data
+            SrcEnd += BlocksX * BlocksY * BlockSize;
+            if (SrcEnd - BlockSize + BlockReadSize >= ImageSize)
+                break;
+
+            MipOffset += CalcMipSize(MipW, MipH);
+            MipW /= 2;
+            MipH /= 2;
+        }
     }
+    mpDataBuffer = new uint8[AllocSize];
+
+    if (Kernel == nullptr)
+        return;
+
+    // Initializing more stuff before we start the mipmap loop
+    uint32 MipW = BaseMipW;
+    uint32 MipH = BaseMipH;
+    uint32 MipOffset = 0;
+    uint32 SrcPos = 0;
 
     // This value set to true if we hit the end of the file earlier than expected.
-    // This is necessary due to a mistake Retro made in their cooker for I8 textures where very small mipmaps are cut off early, resulting in an out-of-bounds memory access.
+    // This is necessary due to a mistake Retro made in their cooker for I8 textures where very small mipmaps are cut off early.
     // This affects one texture that I know of - Echoes 3bb2c034.TXTR
+    // The rest of the last row is decoded from the zero padding after the image data.
     bool BreakEarly = false;
 
-    for (uint32 iMip = 0; iMip < mNumMipMaps; iMip++)
+    for (uint32 iMip = 0; iMip < mNumMipMaps && !BreakEarly; iMip++)
     {
         if (MipW < BWidth)
             MipW = BWidth;
@@ -368,64 +745,31 @@ void CTextureDecoder::PartialDecodeGXTexture(IInputStream& TXTR)
         if (MipH < BHeight)
             MipH = BHeight;
 
-        for (uint32 iBlockY = 0; iBlockY < MipH; iBlockY += BHeight)
+        Params.DstPitch = MipW * PixelStride;
+
+        for (uint32 iBlockY = 0; iBlockY < MipH && !BreakEarly; iBlockY += BHeight)
         {
-            for (uint32 iBlockX = 0; iBlockX < MipW; iBlockX += BWidth)
+            for (uint32 iBlockX = 0; iBlockX < MipW && !BreakEarly; iBlockX += BWidth)
             {
-                for (uint32 iImgY = iBlockY; iImgY < iBlockY + BHeight; iImgY++)
+                const uint32 Remaining = (SrcPos < ImageSize ? ImageSize - SrcPos : 0);
+                Params.NumRows = BHeight;
+
+                // The original stream decode stopped after finishing the row where it reached the end of the file
+                if (Remaining <= BlockReadSize)
                 {
-                    for (uint32 iImgX = iBlockX; iImgX < iBlockX + BWidth; iImgX++)
-                    {
-                        const uint32 DstPos = ((iImgY * MipW) + iImgX) * PixelStride;
-                        Out.Seek(MipOffset + DstPos, SEEK_SET);
-
-                        if (mTexelFormat == ETexelFormat::GX_I4)          ReadPixelsI4(TXTR, Out);
-                        else if (mTexelFormat == ETexelFormat::GX_I8)     ReadPixelI8(TXTR, Out);
-                        else if (mTexelFormat == ETexelFormat::GX_IA4)    ReadPixelIA4(TXTR, Out);
-                        else if (mTexelFormat == ETexelFormat::GX_IA8)    ReadPixelIA8(TXTR, Out);
-                        else if (mTexelFormat == ETexelFormat::GX_C4)     ReadPixelsC4(TXTR, Out);
-                        else if (mTexelFormat == ETexelFormat::GX_C8)     ReadPixelC8(TXTR, Out);
-                        else if (mTexelFormat == ETexelFormat::GX_RGB565) ReadPixelRGB565(TXTR, Out);
-                        else if (mTexelFormat == ETexelFormat::GX_RGB5A3) ReadPixelRGB5A3(TXTR, Out);
-                        else if (mTexelFormat == ETexelFormat::GX_RGBA8)  ReadPixelRGBA8(TXTR, Out);
-                        else if (mTexelFormat == ETexelFormat::GX_CMPR)   ReadSubBlockCMPR(TXTR, Out);
-
-                        // I4 and C4 have 4bpp images, so I'm forced to read two pixels at a time.
-                        if (mTexelFormat == ETexelFormat::GX_I4 || mTexelFormat == ETexelFormat::GX_C4)
-                            iImgX++;
-
-                        // Check if we're at the end of the file.
-                        if (TXTR.EoF())
-                            BreakEarly = true;
-                    }
-                    if (BreakEarly)
-                        break;
+                    Params.NumRows = std::clamp((Remaining + RowReadSize - 1) / RowReadSize, 1U, BHeight);
+                    BreakEarly = true;
                 }
 
-                if (mTexelFormat == ETexelFormat::GX_RGBA8)
-                    TXTR.Seek(0x20, SEEK_CUR);
-
-                if (BreakEarly)
-                    break;
+                const uint32 DstPos = ((iBlockY * MipW) + iBlockX) * PixelStride;
+                Kernel(&ImageData[std::min(SrcPos, ImageSize)], mpDataBuffer + MipOffset + DstPos, Params);
+                SrcPos += BlockSize;
             }
-
-            if (BreakEarly)
-                break;
         }
 
-        uint32 MipSize = static_cast<uint32>(MipW * MipH * gskPixelsToBytes[static_cast<size_t>(mTexelFormat)]);
-        if (mTexelFormat == ETexelFormat::GX_CMPR)
-        {
-            // Since we're pretending the image is 1/4 its actual size, we have to multiply the size by 16 to get the correct offset
-            MipSize *= 16;
-        }
-
-        MipOffset += MipSize;
+        MipOffset += CalcMipSize(MipW, MipH);
         MipW /= 2;
         MipH /= 2;
-
-        if (BreakEarly)
-            break;
     }
 }
 
@@ -437,77 +781,111 @@ void CTextureDecoder::FullDecodeGXTexture(IInputStream& rTXTR)
     const uint32 ImageSize = rTXTR.Tell() - ImageStart;
     rTXTR.Seek(ImageStart, SEEK_SET);
 
-    mDataBufferSize = ImageSize * (32 / gskSourceBpp[static_cast<size_t>(mTexelFormat)]);
-    mpDataBuffer = new uint8[mDataBufferSize];
+    const auto FormatIdx = static_cast<size_t>(mTexelFormat);
+    mDataBufferSize = ImageSize * (32 / gskSourceBpp[FormatIdx]);
 
-    CMemoryOutStream Out(mpDataBuffer, mDataBufferSize, EEndian::SystemEndian);
+    std::vector<uint8> ImageData(ImageSize);
+    rTXTR.ReadBytes(ImageData.data(), ImageData.size());
+    CGXImageReader Src(ImageData.data(), ImageSize);
 
-    // Initializing more stuff before we start the mipmap loop
-    uint32 MipW = mWidth;
-    uint32 MipH = mHeight;
-    uint32 MipOffset = 0;
-
-    const uint32 BWidth = gskBlockWidth[static_cast<size_t>(mTexelFormat)];
-    const uint32 BHeight = gskBlockHeight[static_cast<size_t>(mTexelFormat)];
+    const uint32 BWidth = gskBlockWidth[FormatIdx];
+    const uint32 BHeight = gskBlockHeight[FormatIdx];
+    const bool IsCMPR = (mTexelFormat == ETexelFormat::GX_CMPR);
+    const bool IsFourBit = (mTexelFormat == ETexelFormat::GX_I4 || mTexelFormat == ETexelFormat::GX_C4);
 
     // With CMPR, we're using a little trick.
     // CMPR stores pixels in 8x8 blocks, with four 4x4 subblocks.
     // An easy way to convert it is to pretend each block is 2x2 and each subblock is one pixel.
     // So to do that we need to calculate the "new" dimensions of the image, 1/4 the size of the original.
-    if (mTexelFormat == ETexelFormat::GX_CMPR)
+    const uint32 BaseMipW = (IsCMPR ? mWidth / 4 : mWidth);
+    const uint32 BaseMipH = (IsCMPR ? mHeight / 4 : mHeight);
+
+    // Pixels are written straight to the buffer, so make sure it covers everything the decode will write
+    uint64 AllocSize = mDataBufferSize;
     {
-        MipW /= 4;
-        MipH /= 4;
+        uint32 MipW = BaseMipW;
+        uint32 MipH = BaseMipH;
+        uint64 MipOffset = 0;
+
+        for (uint32 iMip = 0; iMip < mNumMipMaps; iMip++)
+        {
+            if (MipW > 0 && MipH > 0)
+            {
+                const uint64 LastX = (((MipW + BWidth - 1) / BWidth) * BWidth) - 1;
+                const uint64 LastY = (((MipH + BHeight - 1) / BHeight) * BHeight) - 1;
+                const uint64 LastPos = (IsCMPR ? ((LastY * (MipW * 4)) + LastX) * 16 + (3 * MipW * 16) + 16
+                                               : ((LastY * MipW) + LastX) * 4 + (IsFourBit ? 8 : 4));
+                AllocSize = std::max(AllocSize, MipOffset + LastPos);
+            }
+
+            MipOffset += uint64(MipW) * MipH * (IsCMPR ? 64 : 4);
+            MipW = std::max(MipW / 2, BWidth);
+            MipH = std::max(MipH / 2, BHeight);
+        }
     }
+    mpDataBuffer = new uint8[AllocSize];
+
+    // Initializing more stuff before we start the mipmap loop
+    uint32 MipW = BaseMipW;
+    uint32 MipH = BaseMipH;
+    uint32 MipOffset = 0;
 
     for (uint32 iMip = 0; iMip < mNumMipMaps; iMip++) {
         for (uint32 iBlockY = 0; iBlockY < MipH; iBlockY += BHeight) {
             for (uint32 iBlockX = 0; iBlockX < MipW; iBlockX += BWidth) {
                 for (uint32 iImgY = iBlockY; iImgY < iBlockY + BHeight; iImgY++) {
                     for (uint32 iImgX = iBlockX; iImgX < iBlockX + BWidth; iImgX++) {
-                        const uint32 DstPos = (mTexelFormat == ETexelFormat::GX_CMPR) ? ((iImgY * (MipW * 4)) + iImgX) * 16 : ((iImgY * MipW) + iImgX) * 4;
-                        Out.Seek(MipOffset + DstPos, SEEK_SET);
+                        const uint32 DstPos = IsCMPR ? ((iImgY * (MipW * 4)) + iImgX) * 16 : ((iImgY * MipW) + iImgX) * 4;
+                        uint8 *pDst = mpDataBuffer + MipOffset + DstPos;
 
                         // I4/C4/CMPR require reading more than one pixel at a time
                         if (mTexelFormat == ETexelFormat::GX_I4)
                         {
-                            const uint8 Byte = rTXTR.ReadUByte();
-                            Out.WriteLong(DecodePixelI4(Byte, 0).ToLongARGB());
-                            Out.WriteLong(DecodePixelI4(Byte, 1).ToLongARGB());
+                            const uint8 Byte = Src.ReadUByte();
+                            WriteNative<uint32>(pDst + 0, DecodePixelI4(Byte, 0).ToLongARGB());
+                            WriteNative<uint32>(pDst + 4, DecodePixelI4(Byte, 1).ToLongARGB());
                         }
                         else if (mTexelFormat == ETexelFormat::GX_C4)
                         {
-                            const uint8 Byte = rTXTR.ReadUByte();
-                            Out.WriteLong(DecodePixelC4(Byte, 0, mPaletteInput).ToLongARGB());
-                            Out.WriteLong(DecodePixelC4(Byte, 1, mPaletteInput).ToLongARGB());
+                            const uint8 Byte = Src.ReadUByte();
+                            WriteNative<uint32>(pDst + 0, DecodePixelC4(Byte, 0).ToLongARGB());
+                            WriteNative<uint32>(pDst + 4, DecodePixelC4(Byte, 1).ToLongARGB());
                         }
-                        else if (mTexelFormat == ETexelFormat::GX_CMPR)
+                        else if (IsCMPR)
                         {
-                            DecodeSubBlockCMPR(rTXTR, Out, static_cast<uint16>(MipW * 4));
+                            std::array<uint8, 8> SubBlock;
+                            Src.ReadBytes(SubBlock.data(), SubBlock.size());
+                            DecodeSubBlockCMPR(SubBlock.data(), pDst, MipW * 4);
                         }
                         else
                         {
                             CColor Pixel;
 
-                            if (mTexelFormat == ETexelFormat::GX_I8)          Pixel = DecodePixelI8(rTXTR.ReadByte());
-                            else if (mTexelFormat == ETexelFormat::GX_IA4)    Pixel = DecodePixelIA4(rTXTR.ReadByte());
-                            else if (mTexelFormat == ETexelFormat::GX_IA8)    Pixel = DecodePixelIA8(rTXTR.ReadShort());
-                            else if (mTexelFormat == ETexelFormat::GX_C8)     Pixel = DecodePixelC8(rTXTR.ReadByte(), mPaletteInput);
-                            else if (mTexelFormat == ETexelFormat::GX_RGB565) Pixel = DecodePixelRGB565(rTXTR.ReadShort());
-                            else if (mTexelFormat == ETexelFormat::GX_RGB5A3) Pixel = DecodePixelRGB5A3(rTXTR.ReadShort());
-                            else if (mTexelFormat == ETexelFormat::GX_RGBA8)  Pixel = CColor(rTXTR, true);
-
-                            Out.WriteLong(Pixel.ToLongARGB());
+                            if (mTexelFormat == ETexelFormat::GX_I8)          Pixel = DecodePixelI8(Src.ReadUByte());
+                            else if (mTexelFormat == ETexelFormat::GX_IA4)    Pixel = DecodePixelIA4(Src.ReadUByte());
+                            else if (mTexelFormat == ETexelFormat::GX_IA8)    Pixel = DecodePixelIA8(Src.ReadUShort());
+                            else if (mTexelFormat == ETexelFormat::GX_C8)     Pixel = DecodePixelC8(Src.ReadUByte());
+                            else if (mTexelFormat == ETexelFormat::GX_RGB565) Pixel = DecodePixelRGB565(Src.ReadUShort());
+                            else if (mTexelFormat == ETexelFormat::GX_RGB5A3) Pixel = DecodePixelRGB5A3(Src.ReadUShort());
+                            else if (mTexelFormat == ETexelFormat::GX_RGBA8)
+                            {
+                                std::array<uint8, 4> Color;
+                                Src.ReadBytes(Color.data(), Color.size());
+                                CMemoryInStream ColorStream(Color.data(), Color.size(), EEndian::BigEndian);
+                                Pixel = CColor(ColorStream, true);
+                            }
+
+                            WriteNative<uint32>(pDst, Pixel.ToLongARGB());
                         }
                     }
                 }
                 if (mTexelFormat == ETexelFormat::GX_RGBA8)
-                    rTXTR.Seek(0x20, SEEK_CUR);
+                    Src.Skip(0x20);
             }
         }
 
         uint32 MipSize = MipW * MipH * 4;
-        if (mTexelFormat == ETexelFormat::GX_CMPR)
+        if (IsCMPR)
             MipSize *= 16;
 
         MipOffset += MipSize;
@@ -638,139 +1016,6 @@ void CTextureDecoder::DecodeDDS(IInputStream& rDDS)
         mTexelFormat = ETexelFormat::GX_RGBA8;
 }
 
-// ************ READ PIXELS (PARTIAL DECODE) ************
-void CTextureDecoder::ReadPixelsI4(IInputStream& rSrc, IOutputStream& rDst)
-{
-    const uint8 Pixels = rSrc.ReadByte();
-    rDst.WriteUByte(Extend4to8(Pixels >> 4));
-    rDst.WriteUByte(Extend4to8(Pixels >> 4));
-    rDst.WriteUByte(Extend4to8(Pixels));
-    rDst.WriteUByte(Extend4to8(Pixels));
-}
-
-void CTextureDecoder::ReadPixelI8(IInputStream& rSrc, IOutputStream& rDst)
-{
-    const uint8 Pixel = rSrc.ReadUByte();
-    rDst.WriteUByte(Pixel);
-    rDst.WriteUByte(Pixel);
-}
-
-void CTextureDecoder::ReadPixelIA4(IInputStream& rSrc, IOutputStream& rDst)
-{
-    // this can be left as-is for DDS conversion, but opengl doesn't support two components in one byte...
-    const uint8 Byte = rSrc.ReadUByte();
-    const uint8 Alpha = Extend4to8(Byte >> 4);
-    const uint8 Lum = Extend4to8(Byte);
-    rDst.WriteShort((Lum << 8) | Alpha);
-}
-
-void CTextureDecoder::ReadPixelIA8(IInputStream& rSrc, IOutputStream& rDst)
-{
-    rDst.WriteShort(rSrc.ReadShort());
-}
-
-void CTextureDecoder::ReadPixelsC4(IInputStream& rSrc, IOutputStream& rDst)
-{
-    // This isn't how C4 works, but due to the way Retro packed font textures (which use C4)
-    // this is the only way to get them to decode correctly for now.
-    // Commented-out code is proper C4 decoding. Dedicated font texture-decoding function
-    // is probably going to be necessary in the future.
-    const uint8 Byte = rSrc.ReadUByte();
-    std::array<uint8, 2> Indices;
-    Indices[0] = (Byte >> 4) & 0xF;
-    Indices[1] = Byte & 0xF;
-
-    for (uint32 iIdx = 0; iIdx < 2; iIdx++)
-    {
-        uint8 R, G, B, A;
-        ((Indices[iIdx] >> 3) & 0x1) ? R = 0xFF : R = 0x0;
-        ((Indices[iIdx] >> 2) & 0x1) ? G = 0xFF : G = 0x0;
-        ((Indices[iIdx] >> 1) & 0x1) ? B = 0xFF : B = 0x0;
-        ((Indices[iIdx] >> 0) & 0x1) ? A = 0xFF : A = 0x0;
-        const uint32 RGBA = (R << 24) | (G << 16) | (B << 8) | (A);
-        rDst.WriteLong(RGBA);
-
-      /*mPaletteInput.Seek(indices[i] * 2, SEEK_SET);
-
-             if (mPaletteFormat == ePalette_IA8)    readPixelIA8(mPaletteInput, rDst);
-        else if (mPaletteFormat == ePalette_RGB565) readPixelRGB565(mPaletteInput, rDst);
-        else if (mPaletteFormat == ePalette_RGB5A3) readPixelRGB5A3(mPaletteInput, rDst);*/
-    }
-}
-
-void CTextureDecoder::ReadPixelC8(IInputStream& rSrc, IOutputStream& rDst)
-{
-    // DKCR fonts use C8 :|
-    const uint8 Index = rSrc.ReadByte();
-
-    /*u8 R, G, B, A;
-    ((Index >> 3) & 0x1) ? R = 0xFF : R = 0x0;
-    ((Index >> 2) & 0x1) ? G = 0xFF : G = 0x0;
-    ((Index >> 1) & 0x1) ? B = 0xFF : B = 0x0;
-    ((Index >> 0) & 0x1) ? A = 0xFF : A = 0x0;
-    uint32 RGBA = (R << 24) | (G << 16) | (B << 8) | (A);
-    dst.WriteLong(RGBA);*/
-
-    mPaletteInput.Seek(Index * 2, SEEK_SET);
-
-         if (mPaletteFormat == EGXPaletteFormat::IA8)    ReadPixelIA8(mPaletteInput, rDst);
-    else if (mPaletteFormat == EGXPaletteFormat::RGB565) ReadPixelRGB565(mPaletteInput, rDst);
-    else if (mPaletteFormat == EGXPaletteFormat::RGB5A3) ReadPixelRGB5A3(mPaletteInput, rDst);
-}
-
-void CTextureDecoder::ReadPixelRGB565(IInputStream& rSrc, IOutputStream& rDst)
-{
-    // RGB565 can be used as-is.
-    rDst.WriteShort(rSrc.ReadShort());
-}
-
-void CTextureDecoder::ReadPixelRGB5A3(IInputStream& rSrc, IOutputStream& rDst)
-{
-    const uint16 Pixel = rSrc.ReadUShort();
-    uint8 R, G, B, A;
-
-    if (Pixel & 0x8000) // RGB5
-    {
-        B = Extend5to8(Pixel >> 10);
-        G = Extend5to8(Pixel >>  5);
-        R = Extend5to8(Pixel >>  0);
-        A = 255;
-    }
-    else // RGB4A3
-    {
-        A = Extend3to8(Pixel >> 12);
-        B = Extend4to8(Pixel >>  8);
-        G = Extend4to8(Pixel >>  4);
-        R = Extend4to8(Pixel >>  0);
-    }
-
-    const uint32 Color = (A << 24) | (R << 16) | (G << 8) | B;
-    rDst.WriteLong(Color);
-}
-
-void CTextureDecoder::ReadPixelRGBA8(IInputStream& rSrc, IOutputStream& rDst)
-{
-    const uint16 AR = rSrc.ReadUShort();
-    rSrc.Seek(0x1E, SEEK_CUR);
-    const uint16 GB = rSrc.ReadUShort();
-    rSrc.Seek(-0x20, SEEK_CUR);
-    const uint32 Pixel = (AR << 16) | GB;
-    rDst.WriteULong(Pixel);
-}
-
-void CTextureDecoder::ReadSubBlockCMPR(IInputStream& rSrc, IOutputStream& rDst)
-{
-    rDst.WriteShort(rSrc.ReadShort());
-    rDst.WriteShort(rSrc.ReadShort());
-
-    for (uint32 iByte = 0; iByte < 4; iByte++)
-    {
-        uint8 Byte = rSrc.ReadUByte();
-        Byte = ((Byte & 0x3) << 6) | ((Byte & 0xC) << 2) | ((Byte & 0x30) >> 2) | ((Byte & 0xC0) >> 6);
-        rDst.WriteUByte(Byte);
-    }
-}
-
 // ************ DECODE PIXELS (FULL DECODE TO RGBA8) ************
 CColor CTextureDecoder::DecodePixelI4(uint8 Byte, uint8 WhichPixel)
 {
@@ -800,39 +1045,39 @@ CColor CTextureDecoder::DecodePixelIA8(uint16 Short)
     return CColor::Integral(Lum, Lum, Lum, Alpha);
 }
 
-CColor CTextureDecoder::DecodePixelC4(uint8 Byte, uint8 WhichPixel, IInputStream& rPaletteStream)
+CColor CTextureDecoder::DecodePixelC4(uint8 Byte, uint8 WhichPixel)
 {
     if (WhichPixel == 1)
         Byte >>= 4;
 
     Byte &= 0xF;
 
-    rPaletteStream.Seek(Byte * 2, SEEK_SET);
+    const uint16 Entry = ReadBigEndian16(&mPalettes[Byte * 2]);
 
     if (mPaletteFormat == EGXPaletteFormat::IA8)
-        return DecodePixelIA8(rPaletteStream.ReadShort());
+        return DecodePixelIA8(Entry);
 
     if (mPaletteFormat == EGXPaletteFormat::RGB565)
-        return DecodePixelIA8(rPaletteStream.ReadShort());
+        return DecodePixelIA8(Entry);
 
     if (mPaletteFormat == EGXPaletteFormat::RGB5A3)
-        return DecodePixelIA8(rPaletteStream.ReadShort());
+        return DecodePixelIA8(Entry);
 
     return CColor::TransparentBlack();
 }
 
-CColor CTextureDecoder::DecodePixelC8(uint8 Byte, IInputStream& rPaletteStream)
+CColor CTextureDecoder::DecodePixelC8(uint8 Byte)
 {
-    rPaletteStream.Seek(Byte * 2, SEEK_SET);
+    const uint16 Entry = ReadBigEndian16(&mPalettes[Byte * 2]);
 
     if (mPaletteFormat == EGXPaletteFormat::IA8)
-        return DecodePixelIA8(rPaletteStream.ReadShort());
+        return DecodePixelIA8(Entry);
 
     if (mPaletteFormat == EGXPaletteFormat::RGB565)
-        return DecodePixelIA8(rPaletteStream.ReadShort());
+        return DecodePixelIA8(Entry);
 
     if (mPaletteFormat == EGXPaletteFormat::RGB5A3)
-        return DecodePixelIA8(rPaletteStream.ReadShort());
+        return DecodePixelIA8(Entry);
 
     return CColor::TransparentBlack();
 }
@@ -864,10 +1109,10 @@ CColor CTextureDecoder::DecodePixelRGB5A3(uint16 Short)
     }
 }
 
-void CTextureDecoder::DecodeSubBlockCMPR(IInputStream& rSrc, IOutputStream& rDst, uint16 Width)
+void CTextureDecoder::DecodeSubBlockCMPR(const uint8 *pkSrc, uint8 *pDst, uint32 Width)
 {
-    const uint16 PaletteA = rSrc.ReadUShort();
-    const uint16 PaletteB = rSrc.ReadUShort();
+    const uint16 PaletteA = ReadBigEndian16(pkSrc + 0);
+    const uint16 PaletteB = ReadBigEndian16(pkSrc + 2);
 
     std::array<CColor, 4> Palettes{
         DecodePixelRGB565(PaletteA),
@@ -885,19 +1130,24 @@ void CTextureDecoder::DecodeSubBlockCMPR(IInputStream& rSrc, IOutputStream& rDst
         Palettes[3] = CColor::TransparentBlack();
     }
 
+    const std::array<uint32, 4> Colors{
+        Palettes[0].ToLongARGB(),
+        Palettes[1].ToLongARGB(),
+        Palettes[2].ToLongARGB(),
+        Palettes[3].ToLongARGB(),
+    };
+
     for (uint32 iBlockY = 0; iBlockY < 4; iBlockY++)
     {
-        const uint8 Byte = rSrc.ReadUByte();
+        const uint8 Byte = pkSrc[4 + iBlockY];
+        uint8 *pRow = pDst + (iBlockY * Width * 4);
 
         for (uint32 iBlockX = 0; iBlockX < 4; iBlockX++)
         {
             const uint8 Shift = static_cast<uint8>(6 - (iBlockX * 2));
             const uint8 PaletteIndex = (Byte >> Shift) & 0x3;
-            const CColor& Pixel = Palettes[PaletteIndex];
-            rDst.WriteLong(Pixel.ToLongARGB());
+            WriteNative(pRow + (iBlockX * 4), Colors[PaletteIndex]);
         }
-
-        rDst.Seek((Width - 4) * 4, SEEK_CUR);
     }
 }
 
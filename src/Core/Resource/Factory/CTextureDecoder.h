@@ -19,7 +19,6 @@ class CTextureDecoder
     bool mHasPalettes;
     EGXPaletteFormat mPaletteFormat;
     std::vector<uint8> mPalettes;
-    CMemoryInStream mPaletteInput;
 
     struct SDDSInfo
     {
@@ -48,28 +47,16 @@ class CTextureDecoder
     void FullDecodeGXTexture(IInputStream& rTXTR);
     void DecodeDDS(IInputStream& rDDS);
 
-    // Decode Pixels (preserve compression)
-    void ReadPixelsI4(IInputStream& rSrc, IOutputStream& rDst);
-    void ReadPixelI8(IInputStream& rSrc, IOutputStream& rDst);
-    void ReadPixelIA4(IInputStream& rSrc, IOutputStream& rDst);
-    void ReadPixelIA8(IInputStream& rSrc, IOutputStream& rDst);
-    void ReadPixelsC4(IInputStream& rSrc, IOutputStream& rDst);
-    void ReadPixelC8(IInputStream& rSrc, IOutputStream& rDst);
-    void ReadPixelRGB565(IInputStream& rSrc, IOutputStream& rDst);
-    void ReadPixelRGB5A3(IInputStream& rSrc, IOutputStream& rDst);
-    void ReadPixelRGBA8(IInputStream& rSrc, IOutputStream& rDst);
-    void ReadSubBlockCMPR(IInputStream& rSrc, IOutputStream& rDst);
-
     // Decode Pixels (convert to RGBA8)
     CColor DecodePixelI4(uint8 Byte, uint8 WhichPixel);
     CColor DecodePixelI8(uint8 Byte);
     CColor DecodePixelIA4(uint8 Byte);
     CColor DecodePixelIA8(uint16 Short);
-    CColor DecodePixelC4(uint8 Byte, uint8 WhichPixel, IInputStream& rPaletteStream);
-    CColor DecodePixelC8(uint8 Byte, IInputStream& rPaletteStream);
+    CColor DecodePixelC4(uint8 Byte, uint8 WhichPixel);
+    CColor DecodePixelC8(uint8 Byte);
     CColor DecodePixelRGB565(uint16 Short);
     CColor DecodePixelRGB5A3(uint16 Short);
-    void DecodeSubBlockCMPR(IInputStream& rSrc, IOutputStream& rDst, uint16 Width);
+    void DecodeSubBlockCMPR(const uint8 *pkSrc, uint8 *pDst, uint32 Width);
 
     void DecodeBlockBC1(IInputStream& rSrc, IOutputStream& rDst, uint32 Width);
     void DecodeBlockBC2(IInputStream& rSrc, IOutputStream& rDst, uint32 Width);
@@ -96,6 +96,7 @@ void CModel::BufferGL()
                 ibo.Buffer();
         }
 
+        mVBO.ClearUniqueIndex();
         mBuffered = true;
     }
 }
@@ -117,6 +118,9 @@ void CModel::ClearGLBuffer()
     mVBO.Clear();
     mSurfaceIndexBuffers.clear();
     mBuffered = false;
+
+    for (SSurface* pSurf : mSurfaces)
+        pSurf->ClearBVH();
 }
 
 void CModel::Draw(FRenderOptions Options, size_t MatSet)
@@ -78,6 +78,7 @@ void CStaticModel::BufferGL()
             mSurfaceEndOffsets[iIBO][iSurf] = mIBOs[iIBO].GetSize();
     }
 
+    mVBO.ClearUniqueIndex();
     mVBO.Buffer();
 
     for (auto& ibo : mIBOs)
@@ -100,6 +101,9 @@ void CStaticModel::ClearGLBuffer()
     mIBOs.clear();
     mSurfaceEndOffsets.clear();
     mBuffered = false;
+
+    for (SSurface* pSurf : mSurfaces)
+        pSurf->ClearBVH();
 }
 
 void CStaticModel::Draw(FRenderOptions Options)
@@ -0,0 +1,143 @@
+#include "CSurfaceBVH.h"
+#include "SSurface.h"
+#include "Core/BVHUtil.h"
+#include <Common/Math/MathUtil.h>
+#include <array>
+#include <cfloat>
+
+CSurfaceBVH::CSurfaceBVH(const SSurface& rkSurface)
+{
+    // Triangulate the surface
+    std::vector<std::array<CVector3f, 3>> Triangles;
+    Triangles.reserve(rkSurface.TriangleCount);
+
+    for (const SSurface::SPrimitive& rkPrim : rkSurface.Primitives)
+    {
+        const size_t NumTris = rkPrim.NumTriangles();
+
+        for (size_t TriIdx = 0; TriIdx < NumTris; TriIdx++)
+            Triangles.push_back(rkPrim.TrianglePositions(TriIdx));
+    }
+
+    std::vector<CAABox> TriBounds(Triangles.size(), CAABox::Infinite());
+
+    for (size_t TriIdx = 0; TriIdx < Triangles.size(); TriIdx++)
+    {
+        for (const CVector3f& rkVert : Triangles[TriIdx])
+            TriBounds[TriIdx].ExpandBounds(rkVert);
+    }
+
+    // Build the tree and split it out into arrays
+    std::vector<uint32> TriOrder;
+    const std::vector<BVHUtil::SBuildNode> kBuildNodes = BVHUtil::Build(TriBounds, TriOrder, skMaxLeafTriangles);
+
+    mNodeMin.reserve(kBuildNodes.size());
+    mNodeMax.reserve(kBuildNodes.size());
+    mNodeIndex.reserve(kBuildNodes.size());
+    mNodeNumTriangles.reserve(kBuildNodes.size());
+
+    for (const BVHUtil::SBuildNode& rkNode : kBuildNodes)
+    {
+        mNodeMin.push_back(rkNode.Bounds.Min());
+        mNodeMax.push_back(rkNode.Bounds.Max());
+        mNodeIndex.push_back(rkNode.Index);
+        mNodeNumTriangles.push_back(rkNode.NumPrimitives);
+    }
+
+    mVertexA.reserve(TriOrder.size());
+    mVertexB.reserve(TriOrder.size());
+    mVertexC.reserve(TriOrder.size());
+
+    for (const uint32 TriIdx : TriOrder)
+    {
+        mVertexA.push_back(Triangles[TriIdx][0]);
+        mVertexB.push_back(Triangles[TriIdx][1]);
+        mVertexC.push_back(Triangles[TriIdx][2]);
+    }
+}
+
+std::pair<bool, float> CSurfaceBVH::IntersectsRay(const CRay& rkRay, bool AllowBackfaces) const
+{
+    bool Hit = false;
+    float HitDist = FLT_MAX;
+
+    if (mNodeMin.empty())
+        return {false, 0.f};
+
+    const CVector3f Origin = rkRay.Origin();
+    const CVector3f Direction = rkRay.Direction();
+    const CVector3f InvDirection(BVHUtil::SafeInverse(Direction.X), BVHUtil::SafeInverse(Direction.Y), BVHUtil::SafeInverse(Direction.Z));
+
+    float NodeDist;
+
+    if (!BVHUtil::RayIntersectsBox(mNodeMin[0], mNodeMax[0], Origin, InvDirection, HitDist, NodeDist))
+        return {false, 0.f};
+
+    // Depth is capped while building, and each level pushes at most one node
+    std::array<std::pair<uint32, float>, BVHUtil::gkMaxDepth + 1> Stack;
+    uint32 StackSize = 0;
+    uint32 NodeIdx = 0;
+
+    while (true)
+    {
+        const uint32 NumTris = mNodeNumTriangles[NodeIdx];
+
+        if (NumTris > 0)
+        {
+            const uint32 FirstTri = mNodeIndex[NodeIdx];
+
+            for (uint32 TriIdx = FirstTri; TriIdx < FirstTri + NumTris; TriIdx++)
+            {
+                const auto [Intersects, Distance] = Math::RayTriangleIntersection(rkRay, mVertexA[TriIdx], mVertexB[TriIdx], mVertexC[TriIdx], AllowBackfaces);
+
+                if (Intersects && Distance < HitDist)
+                {
+                    Hit = true;
+                    HitDist = Distance;
+                }
+            }
+        }
+        else
+        {
+            const uint32 LeftIdx = NodeIdx + 1;
+            const uint32 RightIdx = mNodeIndex[NodeIdx];
+            float LeftDist, RightDist;
+            const bool HitLeft = BVHUtil::RayIntersectsBox(mNodeMin[LeftIdx], mNodeMax[LeftIdx], Origin, InvDirection, HitDist, LeftDist);
+            const bool HitRight = BVHUtil::RayIntersectsBox(mNodeMin[RightIdx], mNodeMax[RightIdx], Origin, InvDirection, HitDist, RightDist);
+
+            // Visit the closer child first; the farther one can often be culled by then
+            if (HitLeft && HitRight)
+            {
+                if (RightDist < LeftDist)
+                {
+                    Stack[StackSize++] = {LeftIdx, LeftDist};
+                    NodeIdx = RightIdx;
+                }
+                else
+                {
+                    Stack[StackSize++] = {RightIdx, RightDist};
+                    NodeIdx = LeftIdx;
+                }
+
+                continue;
+            }
+
+            if (HitLeft || HitRight)
+            {
+                NodeIdx = (HitLeft ? LeftIdx : RightIdx);
+                continue;
+            }
+        }
+
+        // Pop the next node, skipping any that are farther away than the closest hit found since they were pushed
+        while (StackSize > 0 && Stack[StackSize - 1].second > HitDist)
+            StackSize--;
+
+        if (StackSize == 0)
+            break;
+
+        NodeIdx = Stack[--StackSize].first;
+    }
+
+    return {Hit, Hit ? HitDist : 0.f};
+}
@@ -0,0 +1,38 @@
+#ifndef CSURFACEBVH_H
+#define CSURFACEBVH_H
+
+#include <Common/BasicTypes.h>
+#include <Common/Math/CRay.h>
+#include <Common/Math/CVector3f.h>
+#include <utility>
+#include <vector>
+
+struct SSurface;
+
+/** Bounding volume hierarchy over the triangles of a model surface, used to speed up ray picking.
+ *  Nodes and triangles are each stored as a structure of arrays in depth-first/leaf order,
+ *  so traversal only pulls in the data it actually reads. */
+class CSurfaceBVH
+{
+    // Nodes; a branch's left child always immediately follows it
+    std::vector<CVector3f> mNodeMin;
+    std::vector<CVector3f> mNodeMax;
+    std::vector<uint32> mNodeIndex;         // Branch: index of the right child. Leaf: index of the first triangle
+    std::vector<uint32> mNodeNumTriangles;  // Zero for branches
+
+    // Triangles, in leaf order
+    std::vector<CVector3f> mVertexA;
+    std::vector<CVector3f> mVertexB;
+    std::vector<CVector3f> mVertexC;
+
+public:
+    static constexpr uint32 skMaxLeafTriangles = 4;
+
+    explicit CSurfaceBVH(const SSurface& rkSurface);
+    std::pair<bool, float> IntersectsRay(const CRay& rkRay, bool AllowBackfaces) const;
+
+    size_t NumNodes() const         { return mNodeMin.size(); }
+    size_t NumTriangles() const     { return mVertexA.size(); }
+};
+
+#endif // CSURFACEBVH_H
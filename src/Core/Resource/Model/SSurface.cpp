@@ -1,60 +1,84 @@
 #include "SSurface.h"
+#include "CSurfaceBVH.h"
 #include "Core/Render/CDrawUtil.h"
 #include "Core/CRayCollisionTester.h"
 #include <Common/Math/MathUtil.h>
+#include <tuple>
+
+SSurface::SSurface() = default;
+SSurface::~SSurface() = default;
+
+size_t SSurface::SPrimitive::NumTriangles() const
+{
+    const size_t NumVerts = Vertices.size();
+
+    if (Type == EPrimitiveType::Triangles)
+        return NumVerts / 3;
+    else if (Type == EPrimitiveType::TriangleFan || Type == EPrimitiveType::TriangleStrip)
+        return (NumVerts >= 3 ? NumVerts - 2 : 0);
+    else
+        return 0;
+}
+
+std::array<CVector3f, 3> SSurface::SPrimitive::TrianglePositions(size_t TriIdx) const
+{
+    // Get the three vertices that make up the tri
+    if (Type == EPrimitiveType::Triangles)
+    {
+        const size_t VertIndex = TriIdx * 3;
+        return {Vertices[VertIndex + 0].Position, Vertices[VertIndex + 1].Position, Vertices[VertIndex + 2].Position};
+    }
+    else if (Type == EPrimitiveType::TriangleFan)
+    {
+        return {Vertices[0].Position, Vertices[TriIdx + 1].Position, Vertices[TriIdx + 2].Position};
+    }
+    else if ((TriIdx & 1) != 0)
+    {
+        // Odd strip tris have reversed winding
+        return {Vertices[TriIdx + 2].Position, Vertices[TriIdx + 1].Position, Vertices[TriIdx + 0].Position};
+    }
+    else
+    {
+        return {Vertices[TriIdx + 0].Position, Vertices[TriIdx + 1].Position, Vertices[TriIdx + 2].Position};
+    }
+}
 
 std::pair<bool,float> SSurface::IntersectsRay(const CRay& rkRay, bool AllowBackfaces, float LineThreshold) const
 {
     bool Hit = false;
     float HitDist = 0.0f;
 
+    // Dense surfaces test their triangles through a BVH instead of one at a time
+    const bool UseBVH = (TriangleCount >= skMinBVHTriangles);
+
+    if (UseBVH)
+    {
+        const CSurfaceBVH* pkBVH = nullptr;
+        {
+            // Ray tests can run on several threads, so only one of them builds the tree
+            std::lock_guard Lock(BVHMutex);
+
+            if (!BVH)
+                BVH = std::make_unique<CSurfaceBVH>(*this);
+
+            pkBVH = BVH.get();
+        }
+
+        std::tie(Hit, HitDist) = pkBVH->IntersectsRay(rkRay, AllowBackfaces);
+    }
+
     for (const auto& prim : Primitives)
     {
         const size_t NumVerts = prim.Vertices.size();
 
         // Triangles
-        if (prim.Type == EPrimitiveType::Triangles || prim.Type == EPrimitiveType::TriangleFan || prim.Type == EPrimitiveType::TriangleStrip)
+        if (!UseBVH)
         {
-            size_t NumTris;
-
-            if (prim.Type == EPrimitiveType::Triangles)
-                NumTris = NumVerts / 3;
-            else
-                NumTris = NumVerts - 2;
+            const size_t NumTris = prim.NumTriangles();
 
             for (size_t iTri = 0; iTri < NumTris; iTri++)
             {
-                CVector3f VtxA, VtxB, VtxC;
-
-                // Get the three vertices that make up the current tri
-                if (prim.Type == EPrimitiveType::Triangles)
-                {
-                    const size_t VertIndex = iTri * 3;
-                    VtxA = prim.Vertices[VertIndex + 0].Position;
-                    VtxB = prim.Vertices[VertIndex + 1].Position;
-                    VtxC = prim.Vertices[VertIndex + 2].Position;
-                }
-                else if (prim.Type == EPrimitiveType::TriangleFan)
-                {
-                    VtxA = prim.Vertices[0].Position;
-                    VtxB = prim.Vertices[iTri + 1].Position;
-                    VtxC = prim.Vertices[iTri + 2].Position;
-                }
-                else if (prim.Type == EPrimitiveType::TriangleStrip)
-                {
-                    if ((iTri & 1) != 0)
-                    {
-                        VtxA = prim.Vertices[iTri + 2].Position;
-                        VtxB = prim.Vertices[iTri + 1].Position;
-                        VtxC = prim.Vertices[iTri + 0].Position;
-                    }
-                    else
-                    {
-                        VtxA = prim.Vertices[iTri + 0].Position;
-                        VtxB = prim.Vertices[iTri + 1].Position;
-                        VtxC = prim.Vertices[iTri + 2].Position;
-                    }
-                }
+                const auto [VtxA, VtxB, VtxC] = prim.TrianglePositions(iTri);
 
                 // Intersection test
                 const auto [intersects, distance] = Math::RayTriangleIntersection(rkRay, VtxA, VtxB, VtxC, AllowBackfaces);
@@ -106,3 +130,9 @@ std::pair<bool,float> SSurface::IntersectsRay(const CRay& rkRay, bool AllowBackf
 
     return {Hit, HitDist};
 }
+
+void SSurface::ClearBVH()
+{
+    std::lock_guard Lock(BVHMutex);
+    BVH.reset();
+}
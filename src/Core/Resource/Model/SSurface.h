@@ -10,8 +10,13 @@
 #include <Common/Math/CRay.h>
 #include <Common/Math/CTransform4f.h>
 #include <Common/Math/CVector3f.h>
+#include <array>
+#include <memory>
+#include <mutex>
 #include <vector>
 
+class CSurfaceBVH;
+
 // Should prolly be a class
 struct SSurface
 {
@@ -27,12 +32,22 @@ struct SSurface
     {
         EPrimitiveType Type;
         std::vector<CVertex> Vertices;
+
+        size_t NumTriangles() const;
+        std::array<CVector3f, 3> TrianglePositions(size_t TriIdx) const;
     };
     std::vector<SPrimitive> Primitives;
 
-    SSurface() = default;
+    // Ray test acceleration structure for dense surfaces. Built on the first ray test, freed with the GL buffers.
+    mutable std::unique_ptr<CSurfaceBVH> BVH;
+    mutable std::mutex BVHMutex;
+    static constexpr uint32 skMinBVHTriangles = 32;
+
+    SSurface();
+    ~SSurface();
 
     std::pair<bool,float> IntersectsRay(const CRay& rkRay, bool AllowBackfaces = false, float LineThreshold = 0.02f) const;
+    void ClearBVH();
 };
 
 #endif // SSURFACE_H
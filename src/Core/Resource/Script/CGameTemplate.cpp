@@ -1,7 +1,23 @@
 #include "CGameTemplate.h"
 #include "NPropertyMap.h"
+#include "Core/GameProject/CResourceStore.h"
 #include "Core/Resource/Factory/CWorldLoader.h"
+#include <Common/FileIO.h>
+#include <Common/FileUtil.h>
 #include <Common/Log.h>
+#include <Common/Serialization/Binary.h>
+
+namespace
+{
+enum class ETemplateCacheVersion
+{
+    Initial,
+    // Add new versions before this line
+
+    Max,
+    Current = Max - 1
+};
+}
 
 CGameTemplate::CGameTemplate() = default;
 
@@ -25,13 +41,16 @@ void CGameTemplate::Load(const TString& kFilePath)
     mSourceFile = kFilePath;
     mFullyLoaded = true;
 
-    // Load all sub-templates
+    // Load all sub-templates, from the compiled cache if it's up to date
     const TString gkGameRoot = GetGameDirectory();
+    const bool UseCache = Internal_LoadTemplateCache();
 
     for (auto& [id, path] : mScriptTemplates)
     {
         TString AbsPath = gkGameRoot + path.Path;
-        path.pTemplate = std::make_shared<CScriptTemplate>(this, id, AbsPath);
+
+        if (!Internal_ReadCachedTemplate(path.Path, [&](IArchive& Arc) { path.pTemplate = std::make_shared<CScriptTemplate>(this, id, AbsPath, &Arc); }))
+            path.pTemplate = std::make_shared<CScriptTemplate>(this, id, AbsPath);
     }
 
     for (auto& entry : mPropertyTemplates)
@@ -52,8 +71,16 @@ void CGameTemplate::Load(const TString& kFilePath)
     {
         SScriptTemplatePath& MiscPath = entry.second;
         TString AbsPath = gkGameRoot + MiscPath.Path;
-        MiscPath.pTemplate = std::make_shared<CScriptTemplate>(this, UINT32_MAX, AbsPath);
+
+        if (!Internal_ReadCachedTemplate(MiscPath.Path, [&](IArchive& Arc) { MiscPath.pTemplate = std::make_shared<CScriptTemplate>(this, UINT32_MAX, AbsPath, &Arc); }))
+            MiscPath.pTemplate = std::make_shared<CScriptTemplate>(this, UINT32_MAX, AbsPath);
     }
+
+    // Templates are only loaded from the cache during Load, so it doesn't need to stay in memory
+    mCachedTemplates.clear();
+
+    if (!UseCache)
+        Internal_SaveTemplateCache();
 }
 
 void CGameTemplate::Save()
@@ -71,17 +98,163 @@ void CGameTemplate::Internal_LoadPropertyTemplate(SPropertyTemplatePath& Path)
     if (Path.pTemplate != nullptr) // don't load twice
         return;
 
-    const TString kGameDir = GetGameDirectory();
-    const TString kTemplateFilePath = kGameDir + Path.Path;
-    CXMLReader Reader(kTemplateFilePath);
-    ASSERT(Reader.IsValid());
+    const auto LoadArchetype = [&Path](IArchive& Arc)
+    {
+        Arc << SerialParameter("PropertyArchetype", Path.pTemplate);
+    };
+
+    if (!Internal_ReadCachedTemplate(Path.Path, LoadArchetype))
+    {
+        const TString kGameDir = GetGameDirectory();
+        const TString kTemplateFilePath = kGameDir + Path.Path;
+        CXMLReader Reader(kTemplateFilePath);
+        ASSERT(Reader.IsValid());
+        LoadArchetype(Reader);
+    }
 
-    Reader << SerialParameter("PropertyArchetype", Path.pTemplate);
     ASSERT(Path.pTemplate != nullptr);
 
     Path.pTemplate->Initialize(nullptr, nullptr, 0);
 }
 
+/** Internal: Path to the compiled template cache, which sits next to the game template */
+TString CGameTemplate::Internal_TemplateCachePath() const
+{
+    return mSourceFile.GetFilePathWithoutExtension() + ".bin";
+}
+
+/** Internal: Loads the compiled templates. Fails if any template file has changed since the cache was built. */
+bool CGameTemplate::Internal_LoadTemplateCache()
+{
+    const TString kCachePath = Internal_TemplateCachePath();
+    std::vector<uint8> Buffer;
+
+    if (!FileUtil::Exists(kCachePath) || !FileUtil::LoadFileToBuffer(kCachePath, Buffer))
+        return false;
+
+    CMemoryInStream Cache(Buffer.data(), Buffer.size(), EEndian::BigEndian);
+    const uint32 Magic = Cache.ReadULong();
+    const uint32 Version = Cache.ReadULong();
+    const uint32 ArchiveVersion = Cache.ReadULong();
+    const uint32 Game = Cache.ReadULong();
+    const uint64 SourceSize = Cache.ReadULongLong();
+    const uint64 SourceModifiedTime = Cache.ReadULongLong();
+
+    if (Magic != FOURCC('GTMP') || Version != static_cast<uint32>(ETemplateCacheVersion::Current) ||
+        ArchiveVersion != static_cast<uint32>(IArchive::skCurrentArchiveVersion) || Game != static_cast<uint32>(mGame) ||
+        SourceSize != FileUtil::FileSize(mSourceFile) || SourceModifiedTime != FileUtil::LastModifiedTime(mSourceFile))
+    {
+        return false;
+    }
+
+    const TString kGameDir = GetGameDirectory();
+    const uint32 NumTemplates = Cache.ReadULong();
+
+    for (uint32 TemplateIdx = 0; TemplateIdx < NumTemplates && !Cache.EoF(); TemplateIdx++)
+    {
+        const uint32 PathLength = Cache.ReadULong();
+        const TString Path = Cache.ReadString(PathLength);
+        const uint64 Size = Cache.ReadULongLong();
+        const uint64 ModifiedTime = Cache.ReadULongLong();
+        const uint32 DataSize = Cache.ReadULong();
+
+        if (Size != FileUtil::FileSize(kGameDir + Path) || ModifiedTime != FileUtil::LastModifiedTime(kGameDir + Path) ||
+            DataSize > Cache.Size() - Cache.Tell())
+        {
+            mCachedTemplates.clear();
+            return false;
+        }
+
+        std::vector<char>& rData = mCachedTemplates[Path];
+        rData.resize(DataSize);
+        Cache.ReadBytes(rData.data(), DataSize);
+    }
+
+    // A truncated cache is treated the same as a missing one
+    if (mCachedTemplates.size() != NumTemplates)
+    {
+        warnf("Discarding invalid template cache: %s", *kCachePath);
+        mCachedTemplates.clear();
+        return false;
+    }
+
+    return true;
+}
+
+/** Internal: Writes every loaded template to the compiled cache, tagged with the size and modified time of its XML */
+void CGameTemplate::Internal_SaveTemplateCache() const
+{
+    if (!gTemplatesWritable)
+        return;
+
+    const TString kCachePath = Internal_TemplateCachePath();
+    const TString kGameDir = GetGameDirectory();
+    const CSerialVersion kVersion(IArchive::skCurrentArchiveVersion, 0, mGame);
+    std::vector<std::pair<TString, std::vector<char>>> Templates;
+
+    const auto AddTemplate = [&](const TString& kPath, const std::function<void(IArchive&)>& kFunc)
+    {
+        std::vector<char> Data;
+        {
+            CVectorOutStream DataStream(&Data, EEndian::BigEndian);
+            CBinaryWriter Writer(&DataStream, kVersion);
+            kFunc(Writer);
+        }
+        Templates.emplace_back(kPath, std::move(Data));
+    };
+
+    for (const auto& [id, path] : mScriptTemplates)
+        AddTemplate(path.Path, [&path](IArchive& Arc) { path.pTemplate->Serialize(Arc); });
+
+    for (const auto& [name, path] : mPropertyTemplates)
+    {
+        std::shared_ptr<IProperty> pTemplate = path.pTemplate;
+        AddTemplate(path.Path, [&pTemplate](IArchive& Arc) { Arc << SerialParameter("PropertyArchetype", pTemplate); });
+    }
+
+    for (const auto& [name, path] : mMiscTemplates)
+        AddTemplate(path.Path, [&path](IArchive& Arc) { path.pTemplate->Serialize(Arc); });
+
+    CFileOutStream Cache(kCachePath, EEndian::BigEndian);
+
+    if (!Cache.IsValid())
+    {
+        warnf("Failed to save template cache: %s", *kCachePath);
+        return;
+    }
+
+    Cache.WriteULong(FOURCC('GTMP'));
+    Cache.WriteULong(static_cast<uint32>(ETemplateCacheVersion::Current));
+    Cache.WriteULong(static_cast<uint32>(IArchive::skCurrentArchiveVersion));
+    Cache.WriteULong(static_cast<uint32>(mGame));
+    Cache.WriteULongLong(FileUtil::FileSize(mSourceFile));
+    Cache.WriteULongLong(FileUtil::LastModifiedTime(mSourceFile));
+    Cache.WriteULong(static_cast<uint32>(Templates.size()));
+
+    for (const auto& [Path, Data] : Templates)
+    {
+        Cache.WriteSizedString(Path);
+        Cache.WriteULongLong(FileUtil::FileSize(kGameDir + Path));
+        Cache.WriteULongLong(FileUtil::LastModifiedTime(kGameDir + Path));
+        Cache.WriteULong(static_cast<uint32>(Data.size()));
+        Cache.WriteBytes(Data.data(), Data.size());
+    }
+}
+
+/** Internal: Passes the compiled copy of a template file to the callback. Returns false if the cache doesn't have one. */
+bool CGameTemplate::Internal_ReadCachedTemplate(const TString& kPath, const std::function<void(IArchive&)>& kFunc) const
+{
+    const auto Iter = mCachedTemplates.find(kPath);
+
+    if (Iter == mCachedTemplates.cend())
+        return false;
+
+    CMemoryInStream DataStream(Iter->second.data(), Iter->second.size(), EEndian::BigEndian);
+    CBinaryReader Reader(&DataStream, CSerialVersion(IArchive::skCurrentArchiveVersion, 0, mGame));
+    kFunc(Reader);
+    return true;
+}
+
 void CGameTemplate::SaveGameTemplates(bool ForceAll)
 {
     const TString kGameDir = GetGameDirectory();
@@ -6,6 +6,7 @@
 #include "Core/Resource/Script/Property/Properties.h"
 #include <Common/BasicTypes.h>
 #include <Common/EGame.h>
+#include <functional>
 #include <map>
 
 /** Serialization aid
@@ -80,9 +81,18 @@ class CGameTemplate
     std::map<SObjId, TString> mStates;
     std::map<SObjId, TString> mMessages;
 
+    /** Compiled copies of the template files, keyed by path. Only filled in while loading from the template cache. */
+    std::map<TString, std::vector<char>> mCachedTemplates;
+
     /** Internal function for loading a property template from a file. */
     void Internal_LoadPropertyTemplate(SPropertyTemplatePath& Path);
 
+    /** Internal functions for the compiled template cache, which replaces parsing every template XML when none of them have changed. */
+    TString Internal_TemplateCachePath() const;
+    bool Internal_LoadTemplateCache();
+    void Internal_SaveTemplateCache() const;
+    bool Internal_ReadCachedTemplate(const TString& kPath, const std::function<void(IArchive&)>& kFunc) const;
+
 public:
     CGameTemplate();
     void Serialize(IArchive& Arc);
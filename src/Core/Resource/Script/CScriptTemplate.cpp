@@ -15,15 +15,22 @@ CScriptTemplate::CScriptTemplate(CGameTemplate *pGame)
 }
 
 // New constructor
-CScriptTemplate::CScriptTemplate(CGameTemplate* pInGame, uint32 InObjectID, const TString& kInFilePath)
+CScriptTemplate::CScriptTemplate(CGameTemplate* pInGame, uint32 InObjectID, const TString& kInFilePath, IArchive* pCachedData)
     : mSourceFile(kInFilePath)
     , mObjectID(InObjectID)
     , mpGame(pInGame)
 {
     // Load
-    CXMLReader Reader(kInFilePath);
-    ASSERT(Reader.IsValid());
-    Serialize(Reader);
+    if (pCachedData)
+    {
+        Serialize(*pCachedData);
+    }
+    else
+    {
+        CXMLReader Reader(kInFilePath);
+        ASSERT(Reader.IsValid());
+        Serialize(Reader);
+    }
 
     // Post load initialization
     mSourceFile = kInFilePath;
@@ -130,8 +130,8 @@ public:
     CScriptTemplate() { ASSERT(false); }
     // Old constructor
     explicit CScriptTemplate(CGameTemplate *pGame);
-    // New constructor
-    CScriptTemplate(CGameTemplate* pGame, uint32 ObjectID, const TString& kFilePath);
+    // New constructor; loads from pCachedData instead of the file if it's provided
+    CScriptTemplate(CGameTemplate* pGame, uint32 ObjectID, const TString& kFilePath, IArchive* pCachedData = nullptr);
     ~CScriptTemplate();
     void Serialize(IArchive& rArc);
     void Save(bool Force = false);
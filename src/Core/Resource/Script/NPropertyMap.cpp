@@ -1,5 +1,7 @@
 #include "NPropertyMap.h"
 #include "NGameList.h"
+#include <Common/FileIO.h>
+#include <Common/FileUtil.h>
 #include <Common/NBasics.h>
 #include <Common/Serialization/XML.h>
 
@@ -12,6 +14,18 @@ namespace
 constexpr char gpkLegacyMapPath[] = "templates/PropertyMapLegacy.xml";
 constexpr char gpkMapPath[] = "templates/PropertyMap.xml";
 
+/** Path to the binary copy of the property map, which is much faster to load than the XML */
+constexpr char gpkMapCachePath[] = "templates/PropertyMap.bin";
+
+enum class EMapCacheVersion
+{
+    Initial,
+    // Add new versions before this line
+
+    Max,
+    Current = Max - 1
+};
+
 /** Whether to do name lookups from the legacy map */
 constexpr bool gkUseLegacyMapForNameLookups = false;
 
@@ -142,6 +156,102 @@ SNameKey CreateKey(uint32 ID, const char* pkTypeName)
 {
     return SNameKey(CCRC32::StaticHashString(pkTypeName), ID);
 }
+
+/** Internal: Loads the map from the binary cache. Fails if the cache was built from a different version of the XML. */
+bool LoadMapCache()
+{
+    const TString kXMLPath = gDataDir + gpkMapPath;
+    const TString kCachePath = gDataDir + gpkMapCachePath;
+    std::vector<uint8> Buffer;
+
+    if (!FileUtil::Exists(kCachePath) || !FileUtil::LoadFileToBuffer(kCachePath, Buffer))
+        return false;
+
+    CMemoryInStream Cache(Buffer.data(), Buffer.size(), EEndian::BigEndian);
+    const uint32 Magic = Cache.ReadULong();
+    const uint32 Version = Cache.ReadULong();
+    const uint64 SourceSize = Cache.ReadULongLong();
+    const uint64 SourceModifiedTime = Cache.ReadULongLong();
+
+    if (Magic != FOURCC('PMAP') || Version != static_cast<uint32>(EMapCacheVersion::Current) ||
+        SourceSize != FileUtil::FileSize(kXMLPath) || SourceModifiedTime != FileUtil::LastModifiedTime(kXMLPath))
+    {
+        return false;
+    }
+
+    const uint32 NumTypeNames = Cache.ReadULong();
+
+    for (uint32 TypeIdx = 0; TypeIdx < NumTypeNames && !Cache.EoF(); TypeIdx++)
+    {
+        const uint32 TypeHash = Cache.ReadULong();
+        const uint32 NameLength = Cache.ReadULong();
+        gHashToTypeName.insert_or_assign(TypeHash, Cache.ReadString(NameLength));
+    }
+
+    const uint32 NumNames = Cache.ReadULong();
+
+    for (uint32 NameIdx = 0; NameIdx < NumNames && !Cache.EoF(); NameIdx++)
+    {
+        const uint32 TypeHash = Cache.ReadULong();
+        const uint32 ID = Cache.ReadULong();
+        const uint32 NameLength = Cache.ReadULong();
+
+        SNameValue& Value = gNameMap[SNameKey(TypeHash, ID)];
+        Value.Name = Cache.ReadString(NameLength);
+        Value.IsValid = Cache.ReadBool();
+    }
+
+    // A truncated cache is treated the same as a missing one
+    if (gHashToTypeName.size() != NumTypeNames || gNameMap.size() != NumNames)
+    {
+        warnf("Discarding invalid property map cache: %s", *kCachePath);
+        gHashToTypeName.clear();
+        gNameMap.clear();
+        return false;
+    }
+
+    return true;
+}
+
+/** Internal: Writes the map to the binary cache, tagged with the size and modified time of the XML it matches */
+void SaveMapCache()
+{
+    if (!gTemplatesWritable)
+        return;
+
+    const TString kXMLPath = gDataDir + gpkMapPath;
+    const TString kCachePath = gDataDir + gpkMapCachePath;
+    CFileOutStream Cache(kCachePath, EEndian::BigEndian);
+
+    if (!Cache.IsValid())
+    {
+        warnf("Failed to save property map cache: %s", *kCachePath);
+        return;
+    }
+
+    Cache.WriteULong(FOURCC('PMAP'));
+    Cache.WriteULong(static_cast<uint32>(EMapCacheVersion::Current));
+    Cache.WriteULongLong(FileUtil::FileSize(kXMLPath));
+    Cache.WriteULongLong(FileUtil::LastModifiedTime(kXMLPath));
+
+    Cache.WriteULong(static_cast<uint32>(gHashToTypeName.size()));
+
+    for (const auto& [TypeHash, TypeName] : gHashToTypeName)
+    {
+        Cache.WriteULong(TypeHash);
+        Cache.WriteSizedString(TypeName);
+    }
+
+    Cache.WriteULong(static_cast<uint32>(gNameMap.size()));
+
+    for (const auto& [Key, Value] : gNameMap)
+    {
+        Cache.WriteULong(Key.TypeHash);
+        Cache.WriteULong(Key.ID);
+        Cache.WriteSizedString(Value.Name);
+        Cache.WriteBool(Value.IsValid);
+    }
+}
 } // Anonymous namespace
 
 /** Loads property names into memory */
@@ -156,7 +266,7 @@ void LoadMap()
         ASSERT(Reader.IsValid());
         Reader << SerialParameter("PropertyMap", gLegacyNameMap, SH_HexDisplay);
     }
-    else
+    else if (!LoadMapCache())
     {
         CXMLReader Reader(gDataDir + gpkMapPath);
         ASSERT(Reader.IsValid());
@@ -167,6 +277,8 @@ void LoadMap()
         {
             value.IsValid = CalculatePropertyID(*value.Name, *gHashToTypeName[key.TypeHash]) == key.ID;
         }
+
+        SaveMapCache();
     }
 
     gMapIsLoaded = true;
@@ -226,6 +338,12 @@ void SaveMap(bool Force)
             ASSERT(Writer.IsValid());
             Writer << SerialParameter("PropertyMap", gNameMap, SH_HexDisplay);
         }
+
+        if constexpr (!gkUseLegacyMapForNameLookups)
+        {
+            SaveMapCache();
+        }
+
         gMapIsDirty = false;
     }
 }
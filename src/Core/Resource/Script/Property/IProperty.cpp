@@ -32,6 +32,15 @@ void IProperty::_ClearChildren()
     }
 
     mChildren.clear();
+    mChildrenByID.clear();
+}
+
+void IProperty::_BuildChildIndex()
+{
+    // Stable sort, so if two children share an ID, the first one is found, same as a linear search
+    mChildrenByID = mChildren;
+    std::stable_sort(mChildrenByID.begin(), mChildrenByID.end(),
+                     [](const auto* pkLeft, const auto* pkRight) { return pkLeft->mID < pkRight->mID; });
 }
 
 IProperty::~IProperty()
@@ -214,6 +223,7 @@ void IProperty::Initialize(IProperty* pInParent, CScriptTemplate* pInTemplate, u
         }
     }
 
+    _BuildChildIndex();
     mFlags |= EPropertyFlag::IsInitialized;
 }
 
@@ -228,6 +238,20 @@ void* IProperty::RawValuePtr(void* pData) const
 
 IProperty* IProperty::ChildByID(uint32 ID) const
 {
+    // The index is only valid if no children have been added or replaced since it was built
+    if (!mChildrenByID.empty() && mChildrenByID.size() == mChildren.size())
+    {
+        const auto iter = std::lower_bound(mChildrenByID.begin(), mChildrenByID.end(), ID,
+                                           [](const auto* element, uint32 ID) { return element->mID < ID; });
+
+        if (iter == mChildrenByID.cend() || (*iter)->mID != ID)
+        {
+            return nullptr;
+        }
+
+        return *iter;
+    }
+
     const auto iter = std::find_if(mChildren.begin(), mChildren.end(),
                                    [ID](const auto* element) { return element->mID == ID; });
 
@@ -482,6 +506,8 @@ bool IProperty::ConvertType(EPropertyType NewType, IProperty* pNewArchetype)
                 break;
             }
         }
+
+        mpParent->_BuildChildIndex();
     }
 
     // Change all our child properties to be parented under the new property. (Is this adoption?)
@@ -491,7 +517,9 @@ bool IProperty::ConvertType(EPropertyType NewType, IProperty* pNewArchetype)
         pNewProperty->mChildren.push_back(child);
     }
     ASSERT(pNewProperty->mChildren.size() == mChildren.size());
+    pNewProperty->_BuildChildIndex();
     mChildren.clear();
+    mChildrenByID.clear();
 
     // Create new versions of all sub-instances that inherit from the new property.
     // Note that when the sub-instances complete their conversion, they delete themselves.
@@ -133,6 +133,9 @@ protected:
     /** Child properties; these appear underneath this property on the UI */
     std::vector<IProperty*> mChildren;
 
+    /** Child properties sorted by ID, for fast lookups. Built when the property is initialized. */
+    std::vector<IProperty*> mChildrenByID;
+
     /** Game this property belongs to */
     EGame mGame;
 
@@ -161,6 +164,7 @@ protected:
     /** Private constructor - use static methods to instantiate */
     explicit IProperty(EGame Game);
     void _ClearChildren();
+    void _BuildChildIndex();
 
 public:
     virtual ~IProperty();
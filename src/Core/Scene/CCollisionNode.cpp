@@ -3,6 +3,7 @@
 #include "Core/Render/CDrawUtil.h"
 #include "Core/Render/CGraphics.h"
 #include "Core/Render/CRenderer.h"
+#include <Common/Math/MathUtil.h>
 
 CCollisionNode::CCollisionNode(CScene *pScene, uint32 NodeID, CSceneNode *pParent, CCollisionMeshGroup *pCollision)
     : CSceneNode(pScene, NodeID, pParent)
@@ -107,17 +108,65 @@ void CCollisionNode::Draw(FRenderOptions /*Options*/, int /*ComponentIndex*/, ER
     }
 }
 
-void CCollisionNode::RayAABoxIntersectTest(CRayCollisionTester& /*rTester*/, const SViewInfo& /*rkViewInfo*/)
+void CCollisionNode::RayAABoxIntersectTest(CRayCollisionTester& rTester, const SViewInfo& rkViewInfo)
 {
-    // todo
+    if (!mpCollision || rkViewInfo.GameMode)
+        return;
+
+    const CRay& rkRay = rTester.Ray();
+    const std::pair<bool, float> BoxResult = AABox().IntersectsRay(rkRay);
+
+    if (!BoxResult.first)
+        return;
+
+    for (size_t MeshIdx = 0; MeshIdx < mpCollision->NumMeshes(); MeshIdx++)
+    {
+        const CCollisionMesh *pkMesh = mpCollision->MeshByIndex(MeshIdx);
+        const auto [intersects, distance] = pkMesh->GetBVH().Bounds().Transformed(Transform()).IntersectsRay(rkRay);
+
+        if (intersects)
+            rTester.AddNode(this, static_cast<uint32>(MeshIdx), distance);
+    }
 }
 
-SRayIntersection CCollisionNode::RayNodeIntersectTest(const CRay& /*rkRay*/, uint32 /*AssetID*/, const SViewInfo& /*rkViewInfo*/)
+SRayIntersection CCollisionNode::RayNodeIntersectTest(const CRay& rkRay, uint32 AssetID, const SViewInfo& rkViewInfo)
 {
-    // todo
-    SRayIntersection Result;
-    Result.Hit = false;
-    return Result;
+    SRayIntersection Out;
+    Out.pNode = this;
+    Out.ComponentIndex = AssetID;
+    Out.Hit = false;
+
+    const CCollisionMesh *pkMesh = mpCollision->MeshByIndex(AssetID);
+    const SCollisionIndexData& kIndexData = pkMesh->GetIndexData();
+    const SCollisionRenderSettings& rkSettings = rkViewInfo.CollisionSettings;
+
+    // Only allow picking geometry that is actually drawn
+    std::vector<bool> HiddenMaterials(kIndexData.Materials.size());
+
+    for (size_t MatIdx = 0; MatIdx < kIndexData.Materials.size(); MatIdx++)
+    {
+        const CCollisionMaterial& kMat = kIndexData.Materials[MatIdx];
+        HiddenMaterials[MatIdx] = (rkSettings.HideMaterial & kMat) ||
+                                  (rkSettings.HideMask != 0 && (kMat.RawFlags() & rkSettings.HideMask) != 0);
+    }
+
+    const FRenderOptions Options = rkViewInfo.pRenderer->RenderOptions();
+    const bool AllowBackfaces = rkSettings.DrawBackfaces || mpCollision->Game() == EGame::DKCReturns ||
+                                (Options & ERenderOption::EnableBackfaceCull) == 0;
+
+    const CRay TransformedRay = rkRay.Transformed(Transform().Inverse());
+    const auto [intersects, distance] = pkMesh->GetBVH().IntersectsRay(TransformedRay, AllowBackfaces, &HiddenMaterials);
+
+    if (intersects)
+    {
+        Out.Hit = true;
+
+        const CVector3f HitPoint = TransformedRay.PointOnRay(distance);
+        const CVector3f WorldHitPoint = Transform() * HitPoint;
+        Out.Distance = Math::Distance(rkRay.Origin(), WorldHitPoint);
+    }
+
+    return Out;
 }
 
 void CCollisionNode::SetCollision(CCollisionMeshGroup *pCollision)
@@ -128,6 +177,7 @@ void CCollisionNode::SetCollision(CCollisionMeshGroup *pCollision)
         return;
 
     mpCollision->BuildRenderData();
+    mpCollision->BuildBVH();
 
     // Update bounds
     mLocalAABox = CAABox::Infinite();
@@ -137,4 +187,6 @@ void CCollisionNode::SetCollision(CCollisionMeshGroup *pCollision)
         const CCollisionMesh* pMesh = pCollision->MeshByIndex(MeshIdx);
         mLocalAABox.ExpandBounds(pMesh->Bounds());
     }
+
+    MarkTransformChanged();
 }
@@ -34,9 +34,7 @@ void CLightNode::AddToRenderer(CRenderer *pRenderer, const SViewInfo& rkViewInfo
 
     if (IsSelected() && mpLight->Type() == ELightType::Custom)
     {
-        const CAABox RadiusBox = (CAABox::One() * 2.f * mpLight->GetRadius()) + mPosition;
-
-        if (rkViewInfo.ViewFrustum.BoxInFrustum(RadiusBox))
+        if (rkViewInfo.ViewFrustum.BoxInFrustum(RadiusBox()))
             pRenderer->AddMesh(this, -1, AABox(), false, ERenderCommand::DrawSelection);
     }
 }
@@ -53,13 +51,7 @@ void CLightNode::DrawSelection()
 
 void CLightNode::RayAABoxIntersectTest(CRayCollisionTester& rTester, const SViewInfo& /*ViewInfo*/)
 {
-    const CVector2f BillScale = BillboardScale();
-    const float ScaleXY = (BillScale.X > BillScale.Y ? BillScale.X : BillScale.Y);
-
-    const CAABox BillBox = CAABox(mPosition + CVector3f(-ScaleXY, -ScaleXY, -BillScale.Y),
-                                  mPosition + CVector3f(ScaleXY, ScaleXY, BillScale.Y));
-
-    const auto [intersects, distance] = BillBox.IntersectsRay(rTester.Ray());
+    const auto [intersects, distance] = BillboardBox().IntersectsRay(rTester.Ray());
     if (intersects)
         rTester.AddNode(this, 0, distance);
 }
@@ -129,6 +121,17 @@ SRayIntersection CLightNode::RayNodeIntersectTest(const CRay& rkRay, uint32 Asse
     return Out;
 }
 
+bool CLightNode::SceneBounds(CAABox& rOutBounds) const
+{
+    rOutBounds = AABox();
+    rOutBounds.ExpandBounds(BillboardBox());
+
+    if (IsSelected() && mpLight->Type() == ELightType::Custom)
+        rOutBounds.ExpandBounds(RadiusBox());
+
+    return true;
+}
+
 CStructRef CLightNode::GetProperties() const
 {
     return CStructRef(mpLight, mpLight->GetProperties());
@@ -140,6 +143,9 @@ void CLightNode::PropertyModified(IProperty* pProperty)
 
     if (pProperty->Name() == "Position")
         SetPosition( mpLight->Position() );
+
+    // The light radius may have changed
+    MarkSceneBoundsChanged();
 }
 
 CVector2f CLightNode::BillboardScale() const
@@ -147,6 +153,21 @@ CVector2f CLightNode::BillboardScale() const
     return AbsoluteScale().XZ() * 0.75f;
 }
 
+CAABox CLightNode::BillboardBox() const
+{
+    // Because the billboard rotates a lot, expand the AABox on the X/Y axes to cover any possible orientation
+    const CVector2f BillScale = BillboardScale();
+    const float ScaleXY = (BillScale.X > BillScale.Y ? BillScale.X : BillScale.Y);
+
+    return CAABox(mPosition + CVector3f(-ScaleXY, -ScaleXY, -BillScale.Y),
+                  mPosition + CVector3f(ScaleXY, ScaleXY, BillScale.Y));
+}
+
+CAABox CLightNode::RadiusBox() const
+{
+    return (CAABox::One() * 2.f * mpLight->GetRadius()) + mPosition;
+}
+
 void CLightNode::CalculateTransform(CTransform4f& rOut) const
 {
     // Billboards don't rotate and their scale is applied separately
@@ -15,6 +15,7 @@ public:
     void DrawSelection() override;
     void RayAABoxIntersectTest(CRayCollisionTester& Tester, const SViewInfo& ViewInfo) override;
     SRayIntersection RayNodeIntersectTest(const CRay& Ray, uint32 AssetID, const SViewInfo& ViewInfo) override;
+    bool SceneBounds(CAABox& rOutBounds) const override;
     CStructRef GetProperties() const override;
     void PropertyModified(IProperty* pProperty) override;
     bool AllowsRotate() const override { return false; }
@@ -23,6 +24,8 @@ public:
     CVector2f BillboardScale() const;
 
 protected:
+    CAABox BillboardBox() const;
+    CAABox RadiusBox() const;
     void CalculateTransform(CTransform4f& rOut) const override;
 };
 
@@ -5,16 +5,19 @@
 #include "Core/Resource/Script/CScriptLayer.h"
 #include "Core/CRayCollisionTester.h"
 
+#include <Common/Macros.h>
 #include <Common/FileIO/CFileInStream.h>
 #include <Common/TString.h>
 #include <Common/Math/CRay.h>
 
+#include <iterator>
 #include <list>
 #include <string>
 
 CScene::CScene()
     : mpSceneRootNode(new CRootNode(this, UINT32_MAX, nullptr))
 {
+    ResetNodeIDs();
 }
 
 CScene::~CScene()
@@ -28,21 +31,25 @@ bool CScene::IsNodeIDUsed(uint32 ID) const
     return mNodeMap.find(ID) != mNodeMap.cend();
 }
 
-uint32 CScene::CreateNodeID(uint32 SuggestedID) const
+uint32 CScene::CreateNodeID(uint32 SuggestedID)
 {
     if (SuggestedID != UINT32_MAX)
     {
         if (IsNodeIDUsed(SuggestedID))
+        {
             errorf("Suggested node ID is already being used! New ID will be created.");
+        }
         else
+        {
+            ReserveNodeID(SuggestedID);
             return SuggestedID;
+        }
     }
 
-    uint32 ID = 0;
-
-    while (IsNodeIDUsed(ID))
-        ID++;
-
+    // Hand out the lowest unused ID
+    ASSERT(!mFreeNodeIDs.empty());
+    const uint32 ID = mFreeNodeIDs.begin()->first;
+    ReserveNodeID(ID);
     return ID;
 }
 
@@ -55,6 +62,7 @@ CModelNode* CScene::CreateModelNode(CModel *pModel, uint32 NodeID)
     auto* pNode = new CModelNode(this, ID, mpAreaRootNode, pModel);
     mNodes[ENodeType::Model].push_back(pNode);
     mNodeMap.insert_or_assign(ID, pNode);
+    mSpatialIndex.Insert(pNode);
     mNumNodes++;
     return pNode;
 }
@@ -68,6 +76,7 @@ CStaticNode* CScene::CreateStaticNode(CStaticModel *pModel, uint32 NodeID)
     auto* pNode = new CStaticNode(this, ID, mpAreaRootNode, pModel);
     mNodes[ENodeType::Static].push_back(pNode);
     mNodeMap.insert_or_assign(ID, pNode);
+    mSpatialIndex.Insert(pNode);
     mNumNodes++;
     return pNode;
 }
@@ -81,6 +90,7 @@ CCollisionNode* CScene::CreateCollisionNode(CCollisionMeshGroup *pMesh, uint32 N
     auto* pNode = new CCollisionNode(this, ID, mpAreaRootNode, pMesh);
     mNodes[ENodeType::Collision].push_back(pNode);
     mNodeMap.insert_or_assign(ID, pNode);
+    mSpatialIndex.Insert(pNode);
     mNumNodes++;
     return pNode;
 }
@@ -97,6 +107,7 @@ CScriptNode* CScene::CreateScriptNode(CScriptObject *pObj, uint32 NodeID)
     mNodes[ENodeType::Script].push_back(pNode);
     mNodeMap.insert_or_assign(ID, pNode);
     mScriptMap.insert_or_assign(InstanceID, pNode);
+    mSpatialIndex.Insert(pNode);
     pNode->BuildLightList(mpArea);
 
     // AreaAttributes check
@@ -121,6 +132,7 @@ CLightNode* CScene::CreateLightNode(CLight *pLight, uint32 NodeID)
     auto *pNode = new CLightNode(this, ID, mpAreaRootNode, pLight);
     mNodes[ENodeType::Light].push_back(pNode);
     mNodeMap.insert_or_assign(ID, pNode);
+    mSpatialIndex.Insert(pNode);
     mNumNodes++;
     return pNode;
 }
@@ -140,7 +152,10 @@ void CScene::DeleteNode(CSceneNode *pNode)
     }
 
     if (const auto MapIt = mNodeMap.find(pNode->ID()); MapIt != mNodeMap.end())
+    {
         mNodeMap.erase(MapIt);
+        ReleaseNodeID(pNode->ID());
+    }
 
     if (Type == ENodeType::Script)
     {
@@ -165,11 +180,22 @@ void CScene::DeleteNode(CSceneNode *pNode)
         }
     }
 
+    mSpatialIndex.Remove(pNode);
     pNode->Unparent();
     delete pNode;
     mNumNodes--;
 }
 
+void CScene::NodeBoundsChanged(const CSceneNode *pNode)
+{
+    // Only top-level nodes are indexed; child nodes contribute to the bounds of the node that owns them
+    for (; pNode != nullptr; pNode = pNode->Parent())
+    {
+        if (mSpatialIndex.MarkDirty(pNode))
+            return;
+    }
+}
+
 void CScene::SetActiveArea(CWorld *pWorld, CGameArea *pArea)
 {
     // Clear existing area
@@ -255,6 +281,8 @@ void CScene::PostLoad()
 
 void CScene::ClearScene()
 {
+    mSpatialIndex.Clear();
+
     if (mpAreaRootNode)
     {
         mpAreaRootNode->Unparent();
@@ -267,6 +295,7 @@ void CScene::ClearScene()
     mNodeMap.clear();
     mScriptMap.clear();
     mNumNodes = 0;
+    ResetNodeIDs();
 
     mpArea = nullptr;
     mpWorld = nullptr;
@@ -282,10 +311,14 @@ void CScene::AddSceneToRenderer(CRenderer *pRenderer, const SViewInfo& rkViewInf
     const FShowFlags ShowFlags = rkViewInfo.GameMode ? gkGameModeShowFlags : rkViewInfo.ShowFlags;
     const FNodeFlags NodeFlags = NodeFlagsForShowFlags(ShowFlags);
 
-    for (CSceneIterator It(this, NodeFlags, false); It; ++It)
+    mSpatialIndex.Update();
+    mCullResults.clear();
+    mSpatialIndex.QueryFrustum(rkViewInfo.ViewFrustum, mCullResults);
+
+    for (CSceneNode *pNode : mCullResults)
     {
-        if (rkViewInfo.GameMode || It->IsVisible())
-            It->AddToRenderer(pRenderer, rkViewInfo);
+        if ((NodeFlags & pNode->NodeType()) != 0 && (rkViewInfo.GameMode || pNode->IsVisible()))
+            pNode->AddToRenderer(pRenderer, rkViewInfo);
     }
 }
 
@@ -295,10 +328,14 @@ SRayIntersection CScene::SceneRayCast(const CRay& rkRay, const SViewInfo& rkView
     const FNodeFlags NodeFlags = NodeFlagsForShowFlags(ShowFlags);
     CRayCollisionTester Tester(rkRay);
 
-    for (CSceneIterator It(this, NodeFlags, false); It; ++It)
+    mSpatialIndex.Update();
+    mCullResults.clear();
+    mSpatialIndex.QueryRay(rkRay, mCullResults);
+
+    for (CSceneNode *pNode : mCullResults)
     {
-        if (It->IsVisible())
-            It->RayAABoxIntersectTest(Tester, rkViewInfo);
+        if ((NodeFlags & pNode->NodeType()) != 0 && pNode->IsVisible())
+            pNode->RayAABoxIntersectTest(Tester, rkViewInfo);
     }
 
     return Tester.TestNodes(rkViewInfo);
@@ -375,6 +412,62 @@ CGameArea* CScene::ActiveArea()
     return mpArea;
 }
 
+// ************ PRIVATE ************
+void CScene::ReserveNodeID(uint32 ID)
+{
+    // Split the free range containing the ID around it
+    auto It = mFreeNodeIDs.upper_bound(ID);
+    ASSERT(It != mFreeNodeIDs.begin());
+    --It;
+
+    const uint32 RangeStart = It->first;
+    const uint32 RangeEnd = It->second;
+    ASSERT(ID < RangeEnd);
+
+    It = mFreeNodeIDs.erase(It);
+
+    if (ID + 1 < RangeEnd)
+        It = mFreeNodeIDs.emplace_hint(It, ID + 1, RangeEnd);
+
+    if (RangeStart < ID)
+        mFreeNodeIDs.emplace_hint(It, RangeStart, ID);
+}
+
+void CScene::ReleaseNodeID(uint32 ID)
+{
+    // Merge the ID with any free ranges directly before or after it
+    uint32 RangeStart = ID;
+    uint32 RangeEnd = ID + 1;
+    auto Next = mFreeNodeIDs.upper_bound(ID);
+
+    if (Next != mFreeNodeIDs.begin())
+    {
+        const auto Prev = std::prev(Next);
+        ASSERT(Prev->second <= ID);
+
+        if (Prev->second == ID)
+        {
+            RangeStart = Prev->first;
+            mFreeNodeIDs.erase(Prev);
+        }
+    }
+
+    if (Next != mFreeNodeIDs.end() && Next->first == RangeEnd)
+    {
+        RangeEnd = Next->second;
+        Next = mFreeNodeIDs.erase(Next);
+    }
+
+    mFreeNodeIDs.emplace_hint(Next, RangeStart, RangeEnd);
+}
+
+void CScene::ResetNodeIDs()
+{
+    // UINT32_MAX is reserved for nodes that aren't registered with the scene, like the root nodes
+    mFreeNodeIDs.clear();
+    mFreeNodeIDs.emplace(0, UINT32_MAX);
+}
+
 // ************ STATIC ************
 FShowFlags CScene::ShowFlagsForNodeFlags(FNodeFlags NodeFlags)
 {
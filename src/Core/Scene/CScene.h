@@ -8,6 +8,7 @@
 #include "CScriptNode.h"
 #include "CStaticNode.h"
 #include "CCollisionNode.h"
+#include "CSceneSpatialIndex.h"
 #include "FShowFlags.h"
 #include "Core/Render/CRenderer.h"
 #include "Core/Render/SViewInfo.h"
@@ -17,6 +18,7 @@
 #include "Core/SRayIntersection.h"
 #include <Common/BasicTypes.h>
 
+#include <map>
 #include <unordered_map>
 #include <vector>
 
@@ -41,15 +43,20 @@ class CScene
 
     // Node Management
     std::unordered_map<uint32, CSceneNode*> mNodeMap;
+    std::map<uint32, uint32> mFreeNodeIDs; // Unused node IDs, as ranges of [first, second)
     std::unordered_map<uint32, CScriptNode*> mScriptMap;
 
+    // Culling
+    CSceneSpatialIndex mSpatialIndex;
+    std::vector<CSceneNode*> mCullResults;
+
 public:
     CScene();
     ~CScene();
 
     // Scene Management
     bool IsNodeIDUsed(uint32 ID) const;
-    uint32 CreateNodeID(uint32 SuggestedID = UINT32_MAX) const;
+    uint32 CreateNodeID(uint32 SuggestedID = UINT32_MAX);
 
     CModelNode* CreateModelNode(CModel *pModel, uint32 NodeID = UINT32_MAX);
     CStaticNode* CreateStaticNode(CStaticModel *pModel, uint32 NodeID = UINT32_MAX);
@@ -57,6 +64,7 @@ public:
     CScriptNode* CreateScriptNode(CScriptObject *pObj, uint32 NodeID = UINT32_MAX);
     CLightNode* CreateLightNode(CLight *pLight, uint32 NodeID = UINT32_MAX);
     void DeleteNode(CSceneNode *pNode);
+    void NodeBoundsChanged(const CSceneNode *pNode);
     void SetActiveArea(CWorld *pWorld, CGameArea *pArea);
     void PostLoad();
     void ClearScene();
@@ -72,6 +80,11 @@ public:
     // Static
     static FShowFlags ShowFlagsForNodeFlags(FNodeFlags NodeFlags);
     static FNodeFlags NodeFlagsForShowFlags(FShowFlags ShowFlags);
+
+private:
+    void ReserveNodeID(uint32 ID);
+    void ReleaseNodeID(uint32 ID);
+    void ResetNodeIDs();
 };
 
 #endif // CSCENE_H
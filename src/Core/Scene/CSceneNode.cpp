@@ -1,4 +1,5 @@
 #include "CSceneNode.h"
+#include "CScene.h"
 #include "Core/GameProject/CResourceStore.h"
 #include "Core/Render/CRenderer.h"
 #include "Core/Render/CGraphics.h"
@@ -51,6 +52,13 @@ bool CSceneNode::IsVisible() const
     return mVisible;
 }
 
+bool CSceneNode::SceneBounds(CAABox& rOutBounds) const
+{
+    // Default implementation for virtual function
+    rOutBounds = AABox();
+    return true;
+}
+
 CColor CSceneNode::TintColor(const SViewInfo& rkViewInfo) const
 {
     // Default implementation for virtual function
@@ -335,6 +343,13 @@ void CSceneNode::MarkTransformChanged() const
     }
 
     _mTransformDirty = true;
+    MarkSceneBoundsChanged();
+}
+
+void CSceneNode::MarkSceneBoundsChanged() const
+{
+    if (mpScene != nullptr)
+        mpScene->NodeBoundsChanged(this);
 }
 
 const CTransform4f& CSceneNode::Transform() const
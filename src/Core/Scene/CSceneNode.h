@@ -115,6 +115,8 @@ public:
     virtual bool AllowsRotate() const { return true; }
     virtual bool AllowsScale() const { return true; }
     virtual bool IsVisible() const;
+    /** Bounds the node renders and can be picked within. Returns false if those aren't bounded, so the node is never culled. */
+    virtual bool SceneBounds(CAABox& rOutBounds) const;
     virtual CColor TintColor(const SViewInfo& rkViewInfo) const;
     virtual CColor WireframeColor() const;
     virtual CStructRef GetProperties() const { return CStructRef(); }
@@ -142,6 +144,7 @@ public:
     const CTransform4f& Transform() const;
 protected:
     void MarkTransformChanged() const;
+    void MarkSceneBoundsChanged() const;
     void ForceRecalculateTransform() const;
     virtual void CalculateTransform(CTransform4f& rOut) const;
 
@@ -176,7 +179,7 @@ public:
     void SetScale(const CVector3f& rkScale)         { mScale = rkScale; MarkTransformChanged(); }
     void SetLightLayerIndex(uint32 Index)           { mLightLayerIndex = Index; }
     void SetMouseHovering(bool Hovering)            { mMouseHovering = Hovering; }
-    void SetSelected(bool Selected)                 { mSelected = Selected; }
+    void SetSelected(bool Selected)                 { if (mSelected != Selected) { mSelected = Selected; MarkSceneBoundsChanged(); } }
     void SetVisible(bool Visible)                   { mVisible = Visible; }
 
     // Static
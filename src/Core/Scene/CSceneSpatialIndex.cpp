@@ -0,0 +1,473 @@
+#include "CSceneSpatialIndex.h"
+#include "CSceneNode.h"
+#include "Core/BVHUtil.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <utility>
+
+namespace
+{
+
+CAABox Union(const CAABox& rkA, const CAABox& rkB)
+{
+    CAABox Out = rkA;
+    Out.ExpandBounds(rkB);
+    return Out;
+}
+
+float SurfaceArea(const CAABox& rkBox)
+{
+    const CVector3f Size = rkBox.Size();
+    return Size.X * Size.Y + Size.Y * Size.Z + Size.Z * Size.X;
+}
+
+bool Contains(const CAABox& rkOuter, const CAABox& rkInner)
+{
+    const CVector3f OuterMin = rkOuter.Min(), OuterMax = rkOuter.Max();
+    const CVector3f InnerMin = rkInner.Min(), InnerMax = rkInner.Max();
+
+    return OuterMin.X <= InnerMin.X && OuterMin.Y <= InnerMin.Y && OuterMin.Z <= InnerMin.Z &&
+           OuterMax.X >= InnerMax.X && OuterMax.Y >= InnerMax.Y && OuterMax.Z >= InnerMax.Z;
+}
+
+/** Empty, inverted and non-finite boxes can't be placed in the tree */
+bool IsUsableBox(const CAABox& rkBox)
+{
+    const CVector3f Min = rkBox.Min(), Max = rkBox.Max();
+
+    for (int Axis = 0; Axis < 3; Axis++)
+    {
+        if (!std::isfinite(Min[Axis]) || !std::isfinite(Max[Axis]) || Min[Axis] > Max[Axis])
+            return false;
+    }
+
+    return true;
+}
+
+/** Enlarges leaf bounds so that small transform changes don't require the leaf to be reinserted */
+CAABox Fatten(const CAABox& rkBox)
+{
+    const CVector3f Margin = rkBox.Size() * 0.1f + CVector3f(0.5f);
+    return CAABox(rkBox.Min() - Margin, rkBox.Max() + Margin);
+}
+
+}
+
+void CSceneSpatialIndex::Insert(CSceneNode *pNode)
+{
+    // The node's bounds are calculated on the next update, since it may not be fully set up yet
+    const auto [Iter, Inserted] = mProxies.try_emplace(pNode);
+
+    if (Inserted)
+    {
+        Iter->second.Dirty = true;
+        mDirtyNodes.push_back(pNode);
+    }
+}
+
+void CSceneSpatialIndex::Remove(CSceneNode *pNode)
+{
+    const auto Find = mProxies.find(pNode);
+
+    if (Find == mProxies.cend())
+        return;
+
+    SProxy& rProxy = Find->second;
+
+    if (rProxy.Leaf != skNullNode)
+    {
+        RemoveLeaf(rProxy.Leaf);
+        FreeNode(rProxy.Leaf);
+    }
+
+    if (rProxy.UnboundedSlot != skNullNode)
+        RemoveUnbounded(rProxy);
+
+    if (rProxy.Dirty)
+        mDirtyNodes.erase(std::find(mDirtyNodes.begin(), mDirtyNodes.end(), pNode));
+
+    mProxies.erase(Find);
+}
+
+void CSceneSpatialIndex::Clear()
+{
+    mTree.clear();
+    mRoot = skNullNode;
+    mFreeList = skNullNode;
+    mProxies.clear();
+    mDirtyNodes.clear();
+    mUnboundedNodes.clear();
+}
+
+bool CSceneSpatialIndex::MarkDirty(const CSceneNode *pNode)
+{
+    const auto Find = mProxies.find(pNode);
+
+    if (Find == mProxies.cend())
+        return false;
+
+    if (!Find->second.Dirty)
+    {
+        Find->second.Dirty = true;
+        mDirtyNodes.push_back(const_cast<CSceneNode*>(pNode));
+    }
+
+    return true;
+}
+
+void CSceneSpatialIndex::Update()
+{
+    // Calculating bounds can recalculate transforms, which may mark more nodes dirty, so don't use iterators here
+    for (size_t DirtyIdx = 0; DirtyIdx < mDirtyNodes.size(); DirtyIdx++)
+    {
+        CSceneNode *pNode = mDirtyNodes[DirtyIdx];
+        CAABox Bounds;
+        const bool Bounded = pNode->SceneBounds(Bounds) && IsUsableBox(Bounds);
+
+        SProxy& rProxy = mProxies[pNode];
+        rProxy.Dirty = false;
+
+        if (!Bounded)
+        {
+            if (rProxy.Leaf != skNullNode)
+            {
+                RemoveLeaf(rProxy.Leaf);
+                FreeNode(rProxy.Leaf);
+                rProxy.Leaf = skNullNode;
+            }
+
+            if (rProxy.UnboundedSlot == skNullNode)
+                AddUnbounded(rProxy, pNode);
+
+            continue;
+        }
+
+        if (rProxy.UnboundedSlot != skNullNode)
+            RemoveUnbounded(rProxy);
+
+        if (rProxy.Leaf != skNullNode)
+        {
+            if (Contains(mTree[rProxy.Leaf].Bounds, Bounds))
+                continue;
+
+            RemoveLeaf(rProxy.Leaf);
+        }
+        else
+        {
+            rProxy.Leaf = AllocateNode();
+        }
+
+        STreeNode& rLeaf = mTree[rProxy.Leaf];
+        rLeaf.Bounds = Fatten(Bounds);
+        rLeaf.pNode = pNode;
+        InsertLeaf(rProxy.Leaf);
+    }
+
+    mDirtyNodes.clear();
+}
+
+void CSceneSpatialIndex::QueryFrustum(const CFrustumPlanes& rkFrustum, std::vector<CSceneNode*>& rOutNodes) const
+{
+    rOutNodes.insert(rOutNodes.end(), mUnboundedNodes.cbegin(), mUnboundedNodes.cend());
+
+    if (mRoot == skNullNode)
+        return;
+
+    std::vector<int32> Stack;
+    Stack.reserve(BVHUtil::gkMaxDepth);
+    Stack.push_back(mRoot);
+
+    while (!Stack.empty())
+    {
+        const STreeNode& rkNode = mTree[Stack.back()];
+        Stack.pop_back();
+
+        if (!rkFrustum.BoxInFrustum(rkNode.Bounds))
+            continue;
+
+        if (rkNode.IsLeaf())
+        {
+            rOutNodes.push_back(rkNode.pNode);
+        }
+        else
+        {
+            Stack.push_back(rkNode.Right);
+            Stack.push_back(rkNode.Left);
+        }
+    }
+}
+
+void CSceneSpatialIndex::QueryRay(const CRay& rkRay, std::vector<CSceneNode*>& rOutNodes) const
+{
+    rOutNodes.insert(rOutNodes.end(), mUnboundedNodes.cbegin(), mUnboundedNodes.cend());
+
+    if (mRoot == skNullNode)
+        return;
+
+    const CVector3f Origin = rkRay.Origin();
+    const CVector3f Direction = rkRay.Direction();
+    const CVector3f InvDir(BVHUtil::SafeInverse(Direction.X), BVHUtil::SafeInverse(Direction.Y), BVHUtil::SafeInverse(Direction.Z));
+
+    std::vector<std::pair<float, CSceneNode*>> Hits;
+    std::vector<int32> Stack;
+    Stack.reserve(BVHUtil::gkMaxDepth);
+    Stack.push_back(mRoot);
+
+    while (!Stack.empty())
+    {
+        const STreeNode& rkNode = mTree[Stack.back()];
+        Stack.pop_back();
+
+        float Distance;
+        if (!BVHUtil::RayIntersectsBox(rkNode.Bounds.Min(), rkNode.Bounds.Max(), Origin, InvDir, FLT_MAX, Distance))
+            continue;
+
+        if (rkNode.IsLeaf())
+        {
+            Hits.emplace_back(Distance, rkNode.pNode);
+        }
+        else
+        {
+            Stack.push_back(rkNode.Right);
+            Stack.push_back(rkNode.Left);
+        }
+    }
+
+    std::stable_sort(Hits.begin(), Hits.end(), [](const auto& rkLeft, const auto& rkRight) {
+        return rkLeft.first < rkRight.first;
+    });
+
+    rOutNodes.reserve(rOutNodes.size() + Hits.size());
+
+    for (const auto& [Distance, pNode] : Hits)
+        rOutNodes.push_back(pNode);
+}
+
+// ************ PRIVATE ************
+int32 CSceneSpatialIndex::AllocateNode()
+{
+    if (mFreeList == skNullNode)
+    {
+        mTree.emplace_back();
+        return static_cast<int32>(mTree.size() - 1);
+    }
+
+    const int32 NodeIdx = mFreeList;
+    mFreeList = mTree[NodeIdx].Parent;
+    mTree[NodeIdx] = STreeNode();
+    return NodeIdx;
+}
+
+void CSceneSpatialIndex::FreeNode(int32 NodeIdx)
+{
+    STreeNode& rNode = mTree[NodeIdx];
+    rNode = STreeNode();
+    rNode.Parent = mFreeList;
+    rNode.Height = -1;
+    mFreeList = NodeIdx;
+}
+
+void CSceneSpatialIndex::InsertLeaf(int32 LeafIdx)
+{
+    if (mRoot == skNullNode)
+    {
+        mRoot = LeafIdx;
+        mTree[LeafIdx].Parent = skNullNode;
+        return;
+    }
+
+    // Find the best sibling for the new leaf, going by the increase in surface area it causes
+    const CAABox LeafBounds = mTree[LeafIdx].Bounds;
+    int32 SiblingIdx = mRoot;
+
+    while (!mTree[SiblingIdx].IsLeaf())
+    {
+        const STreeNode& rkNode = mTree[SiblingIdx];
+        const float Area = SurfaceArea(rkNode.Bounds);
+        const float CombinedArea = SurfaceArea(Union(rkNode.Bounds, LeafBounds));
+
+        // Cost of creating a new parent for this node and the new leaf, and the minimum cost of pushing the leaf further down
+        const float Cost = 2.f * CombinedArea;
+        const float InheritanceCost = 2.f * (CombinedArea - Area);
+
+        const auto ChildCost = [&](int32 ChildIdx) {
+            const STreeNode& rkChild = mTree[ChildIdx];
+            const float NewArea = SurfaceArea(Union(rkChild.Bounds, LeafBounds));
+            return (rkChild.IsLeaf() ? NewArea : NewArea - SurfaceArea(rkChild.Bounds)) + InheritanceCost;
+        };
+
+        const float LeftCost = ChildCost(rkNode.Left);
+        const float RightCost = ChildCost(rkNode.Right);
+
+        if (Cost < LeftCost && Cost < RightCost)
+            break;
+
+        SiblingIdx = (LeftCost < RightCost ? rkNode.Left : rkNode.Right);
+    }
+
+    // Create a new parent for the sibling and the leaf
+    const int32 OldParentIdx = mTree[SiblingIdx].Parent;
+    const int32 NewParentIdx = AllocateNode();
+
+    STreeNode& rNewParent = mTree[NewParentIdx];
+    rNewParent.Parent = OldParentIdx;
+    rNewParent.Bounds = Union(LeafBounds, mTree[SiblingIdx].Bounds);
+    rNewParent.Height = mTree[SiblingIdx].Height + 1;
+    rNewParent.Left = SiblingIdx;
+    rNewParent.Right = LeafIdx;
+
+    if (OldParentIdx != skNullNode)
+    {
+        STreeNode& rOldParent = mTree[OldParentIdx];
+
+        if (rOldParent.Left == SiblingIdx)
+            rOldParent.Left = NewParentIdx;
+        else
+            rOldParent.Right = NewParentIdx;
+    }
+    else
+    {
+        mRoot = NewParentIdx;
+    }
+
+    mTree[SiblingIdx].Parent = NewParentIdx;
+    mTree[LeafIdx].Parent = NewParentIdx;
+    Refit(OldParentIdx);
+}
+
+void CSceneSpatialIndex::RemoveLeaf(int32 LeafIdx)
+{
+    if (LeafIdx == mRoot)
+    {
+        mRoot = skNullNode;
+        return;
+    }
+
+    // Replace the leaf's parent with its sibling
+    const int32 ParentIdx = mTree[LeafIdx].Parent;
+    const int32 GrandParentIdx = mTree[ParentIdx].Parent;
+    const int32 SiblingIdx = (mTree[ParentIdx].Left == LeafIdx ? mTree[ParentIdx].Right : mTree[ParentIdx].Left);
+
+    if (GrandParentIdx != skNullNode)
+    {
+        STreeNode& rGrandParent = mTree[GrandParentIdx];
+
+        if (rGrandParent.Left == ParentIdx)
+            rGrandParent.Left = SiblingIdx;
+        else
+            rGrandParent.Right = SiblingIdx;
+
+        mTree[SiblingIdx].Parent = GrandParentIdx;
+        FreeNode(ParentIdx);
+        Refit(GrandParentIdx);
+    }
+    else
+    {
+        mRoot = SiblingIdx;
+        mTree[SiblingIdx].Parent = skNullNode;
+        FreeNode(ParentIdx);
+    }
+
+    mTree[LeafIdx].Parent = skNullNode;
+}
+
+int32 CSceneSpatialIndex::Balance(int32 NodeIdx)
+{
+    // Performs a left or right rotation if the node's subtrees differ in height by more than one
+    STreeNode& rA = mTree[NodeIdx];
+
+    if (rA.IsLeaf() || rA.Height < 2)
+        return NodeIdx;
+
+    const int32 BIdx = rA.Left;
+    const int32 CIdx = rA.Right;
+    STreeNode& rB = mTree[BIdx];
+    STreeNode& rC = mTree[CIdx];
+    const int32 Imbalance = rC.Height - rB.Height;
+
+    // Move the taller child up. Its shorter grandchild becomes the child of the old parent.
+    const auto Rotate = [&](int32 UpIdx, STreeNode& rUp, const STreeNode& rkStay, bool UpWasRight) {
+        const int32 FIdx = rUp.Left;
+        const int32 GIdx = rUp.Right;
+        STreeNode& rF = mTree[FIdx];
+        STreeNode& rG = mTree[GIdx];
+
+        rUp.Left = NodeIdx;
+        rUp.Parent = rA.Parent;
+        rA.Parent = UpIdx;
+
+        if (rUp.Parent != skNullNode)
+        {
+            STreeNode& rParent = mTree[rUp.Parent];
+
+            if (rParent.Left == NodeIdx)
+                rParent.Left = UpIdx;
+            else
+                rParent.Right = UpIdx;
+        }
+        else
+        {
+            mRoot = UpIdx;
+        }
+
+        const bool KeepF = (rF.Height > rG.Height);
+        const int32 KeepIdx = (KeepF ? FIdx : GIdx);
+        const int32 MoveIdx = (KeepF ? GIdx : FIdx);
+
+        rUp.Right = KeepIdx;
+        (UpWasRight ? rA.Right : rA.Left) = MoveIdx;
+        mTree[MoveIdx].Parent = NodeIdx;
+
+        rA.Bounds = Union(rkStay.Bounds, mTree[MoveIdx].Bounds);
+        rA.Height = 1 + std::max(rkStay.Height, mTree[MoveIdx].Height);
+        rUp.Bounds = Union(rA.Bounds, mTree[KeepIdx].Bounds);
+        rUp.Height = 1 + std::max(rA.Height, mTree[KeepIdx].Height);
+    };
+
+    if (Imbalance > 1)
+    {
+        Rotate(CIdx, rC, rB, true);
+        return CIdx;
+    }
+
+    if (Imbalance < -1)
+    {
+        Rotate(BIdx, rB, rC, false);
+        return BIdx;
+    }
+
+    return NodeIdx;
+}
+
+void CSceneSpatialIndex::Refit(int32 NodeIdx)
+{
+    while (NodeIdx != skNullNode)
+    {
+        NodeIdx = Balance(NodeIdx);
+
+        STreeNode& rNode = mTree[NodeIdx];
+        const STreeNode& rkLeft = mTree[rNode.Left];
+        const STreeNode& rkRight = mTree[rNode.Right];
+        rNode.Height = 1 + std::max(rkLeft.Height, rkRight.Height);
+        rNode.Bounds = Union(rkLeft.Bounds, rkRight.Bounds);
+
+        NodeIdx = rNode.Parent;
+    }
+}
+
+void CSceneSpatialIndex::AddUnbounded(SProxy& rProxy, CSceneNode *pNode)
+{
+    rProxy.UnboundedSlot = static_cast<int32>(mUnboundedNodes.size());
+    mUnboundedNodes.push_back(pNode);
+}
+
+void CSceneSpatialIndex::RemoveUnbounded(SProxy& rProxy)
+{
+    // Swap the last node into the freed slot
+    CSceneNode *pLast = mUnboundedNodes.back();
+    mUnboundedNodes[rProxy.UnboundedSlot] = pLast;
+    mProxies[pLast].UnboundedSlot = rProxy.UnboundedSlot;
+    mUnboundedNodes.pop_back();
+    rProxy.UnboundedSlot = skNullNode;
+}
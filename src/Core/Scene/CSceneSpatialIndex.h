@@ -0,0 +1,78 @@
+#ifndef CSCENESPATIALINDEX_H
+#define CSCENESPATIALINDEX_H
+
+#include <Common/BasicTypes.h>
+#include <Common/Math/CAABox.h>
+#include <Common/Math/CFrustumPlanes.h>
+#include <Common/Math/CRay.h>
+#include <unordered_map>
+#include <vector>
+
+class CSceneNode;
+
+/** Dynamic AABB tree over the top-level nodes of a scene, used to cull nodes before rendering and ray casts.
+ *  Leaves store slightly enlarged bounds so small movements don't require the tree to be updated.
+ *  Nodes that report unbounded scene bounds (see CSceneNode::SceneBounds) are kept aside and returned by every query. */
+class CSceneSpatialIndex
+{
+    static constexpr int32 skNullNode = -1;
+
+    struct STreeNode
+    {
+        CAABox Bounds;
+        CSceneNode *pNode = nullptr;
+        int32 Parent = skNullNode;  // Doubles as the next free node for nodes in the free list
+        int32 Left = skNullNode;
+        int32 Right = skNullNode;
+        int32 Height = 0;           // -1 for free nodes
+
+        bool IsLeaf() const { return Left == skNullNode; }
+    };
+
+    struct SProxy
+    {
+        int32 Leaf = skNullNode;
+        int32 UnboundedSlot = skNullNode;
+        bool Dirty = false;
+    };
+
+    std::vector<STreeNode> mTree;
+    int32 mRoot = skNullNode;
+    int32 mFreeList = skNullNode;
+
+    std::unordered_map<const CSceneNode*, SProxy> mProxies;
+    std::vector<CSceneNode*> mDirtyNodes;
+    std::vector<CSceneNode*> mUnboundedNodes;
+
+public:
+    void Insert(CSceneNode *pNode);
+    void Remove(CSceneNode *pNode);
+    void Clear();
+
+    /** Flags the node's bounds for an update. Returns false if the node isn't in the index. */
+    bool MarkDirty(const CSceneNode *pNode);
+
+    /** Refreshes the bounds of every node that was marked dirty since the last update */
+    void Update();
+
+    /** Appends every node that may be visible in the given frustum */
+    void QueryFrustum(const CFrustumPlanes& rkFrustum, std::vector<CSceneNode*>& rOutNodes) const;
+
+    /** Appends every node that may be hit by the ray. Unbounded nodes come first,
+     *  followed by the remaining nodes in front-to-back order of where the ray enters their bounds. */
+    void QueryRay(const CRay& rkRay, std::vector<CSceneNode*>& rOutNodes) const;
+
+    size_t NumNodes() const { return mProxies.size(); }
+
+private:
+    int32 AllocateNode();
+    void FreeNode(int32 NodeIdx);
+    void InsertLeaf(int32 LeafIdx);
+    void RemoveLeaf(int32 LeafIdx);
+    int32 Balance(int32 NodeIdx);
+    void Refit(int32 NodeIdx);
+    void AddUnbounded(SProxy& rProxy, CSceneNode *pNode);
+    void RemoveUnbounded(SProxy& rProxy);
+};
+
+#endif // CSCENESPATIALINDEX_H
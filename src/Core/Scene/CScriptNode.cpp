@@ -326,14 +326,7 @@ void CScriptNode::RayAABoxIntersectTest(CRayCollisionTester& rTester, const SVie
 
     else
     {
-        // Because the billboard rotates a lot, expand the AABox on the X/Y axes to cover any possible orientation
-        const CVector2f BillScale = BillboardScale();
-        const float ScaleXY = (BillScale.X > BillScale.Y ? BillScale.X : BillScale.Y);
-
-        const CAABox BillBox = CAABox(mPosition + CVector3f(-ScaleXY, -ScaleXY, -BillScale.Y),
-                                      mPosition + CVector3f(ScaleXY, ScaleXY, BillScale.Y));
-
-        const auto [intersects, distance] = BillBox.IntersectsRay(rkRay);
+        const auto [intersects, distance] = BillboardBox().IntersectsRay(rkRay);
         if (intersects)
             rTester.AddNode(this, 0, distance);
     }
@@ -447,6 +440,34 @@ bool CScriptNode::IsVisible() const
     return mVisible && mpInstance->Layer()->IsVisible() && Template()->IsVisible();
 }
 
+bool CScriptNode::SceneBounds(CAABox& rOutBounds) const
+{
+    // Script extras can draw anywhere, and selected nodes draw their connection lines and preview volume
+    if (mpExtra != nullptr || IsSelected())
+        return false;
+
+    rOutBounds = AABox();
+
+    if (!UsesModel())
+        rOutBounds.ExpandBounds(BillboardBox());
+
+    // Children without any geometry have inverted bounds, which must not be merged in
+    const auto ExpandByChild = [&rOutBounds](const CSceneNode* pkChild) {
+        const CAABox ChildBox = pkChild->AABox();
+        const CVector3f Min = ChildBox.Min(), Max = ChildBox.Max();
+
+        if (Min.X <= Max.X && Min.Y <= Max.Y && Min.Z <= Max.Z)
+            rOutBounds.ExpandBounds(ChildBox);
+    };
+
+    ExpandByChild(mpCollisionNode);
+
+    for (const auto* pAttachment : mAttachments)
+        ExpandByChild(pAttachment);
+
+    return true;
+}
+
 CColor CScriptNode::TintColor(const SViewInfo& ViewInfo) const
 {
     CColor BaseColor = CSceneNode::TintColor(ViewInfo);
@@ -731,6 +752,16 @@ CVector2f CScriptNode::BillboardScale() const
     return Out * 0.5f * Template()->PreviewScale();
 }
 
+CAABox CScriptNode::BillboardBox() const
+{
+    // Because the billboard rotates a lot, expand the AABox on the X/Y axes to cover any possible orientation
+    const CVector2f BillScale = BillboardScale();
+    const float ScaleXY = (BillScale.X > BillScale.Y ? BillScale.X : BillScale.Y);
+
+    return CAABox(mPosition + CVector3f(-ScaleXY, -ScaleXY, -BillScale.Y),
+                  mPosition + CVector3f(ScaleXY, ScaleXY, BillScale.Y));
+}
+
 CTransform4f CScriptNode::BoneTransform(uint32 BoneID, EAttachType AttachType, bool Absolute) const
 {
     CTransform4f Out;
@@ -48,6 +48,7 @@ public:
     bool AllowsRotate() const override;
     bool AllowsScale() const override;
     bool IsVisible() const override;
+    bool SceneBounds(CAABox& rOutBounds) const override;
     CColor TintColor(const SViewInfo& rkViewInfo) const override;
     CColor WireframeColor() const override;
     CStructRef GetProperties() const override;
@@ -77,6 +78,7 @@ public:
     CResource* DisplayAsset() const                      { return mpDisplayAsset; }
 
 protected:
+    CAABox BillboardBox() const;
     void SetDisplayAsset(CResource *pRes);
     void CalculateTransform(CTransform4f& rOut) const override;
 };
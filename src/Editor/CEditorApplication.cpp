@@ -136,18 +136,15 @@ void CEditorApplication::EditResource(CResourceEntry *pEntry)
         {
         case EResourceType::Area:
             // We can't open an area on its own. Find a world that contains this area.
-            for (TResourceIterator<EResourceType::World> It; It; ++It)
+            for (CResourceEntry *pWorldEntry : pEntry->ResourceStore()->FindReferencers(pEntry->ID(), EResourceType::World))
             {
-                if (It->Dependencies()->HasDependency(pEntry->ID()))
+                CWorld *pWorld = (CWorld*) pWorldEntry->Load();
+                uint32 AreaIdx = pWorld->AreaIndex(pEntry->ID());
+
+                if (AreaIdx != UINT32_MAX)
                 {
-                    CWorld *pWorld = (CWorld*) It->Load();
-                    uint32 AreaIdx = pWorld->AreaIndex(pEntry->ID());
-
-                    if (AreaIdx != UINT32_MAX)
-                    {
-                        mpWorldEditor->SetArea(pWorld, AreaIdx);
-                        break;
-                    }
+                    mpWorldEditor->SetArea(pWorld, AreaIdx);
+                    break;
                 }
             }
             break;
@@ -233,14 +230,8 @@ bool CEditorApplication::CookPackageList(QList<CPackage*> PackageList)
 
     QFuture<void> Future = QtConcurrent::run([&]()
     {
-        Dialog.SetNumTasks(PackageList.size());
-
-        for (int PkgIdx = 0; PkgIdx < PackageList.size() && !Dialog.ShouldCancel(); PkgIdx++)
-        {
-            CPackage *pPkg = PackageList[PkgIdx];
-            Dialog.SetTask(PkgIdx, "Cooking " + pPkg->Name() + ".pak...");
-            pPkg->Cook(&Dialog);
-        }
+        const std::vector<CPackage*> Packages(PackageList.begin(), PackageList.end());
+        mpActiveProject->CookPackages(Packages, &Dialog);
     });
 
     Dialog.WaitForResults(Future);
@@ -314,7 +305,10 @@ void CEditorApplication::TickEditors()
         gpEditorStore->ConditionalSaveStore();
 
     if (gpResourceStore)
+    {
+        gpResourceStore->UpdateAsyncLoads();
         gpResourceStore->ConditionalSaveStore();
+    }
 
     // Tick each editor window and redraw their viewports
     for (IEditor *pEditor : mEditorWindows)
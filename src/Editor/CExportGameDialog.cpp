@@ -29,7 +29,7 @@ CExportGameDialog::CExportGameDialog(const QString& rkIsoPath, const QString& rk
 
     if (ValidateGame())
     {
-        mBuildVer = FindBuildVersion();
+        mBuildVer = CGameExporter::FindBuildVersion(mpDisc.get(), mGame);
         mpExporter = std::make_unique<CGameExporter>(mDiscType, mGame, mWiiFrontend, mRegion, mGameTitle, mGameID, mBuildVer);
         InitUI(rkExportDir);
 
@@ -93,117 +93,24 @@ void CExportGameDialog::InitUI(QString ExportDir)
 
 bool CExportGameDialog::ValidateGame()
 {
-    if (!mpDisc) return false;
+    SDiscInfo Info;
 
-    const nod::Header& rkHeader = mpDisc->getHeader();
-    mGameTitle = rkHeader.m_gameTitle;
-    mGameID = TString(6, 0);
-    memcpy(&mGameID[0], rkHeader.m_gameID, 6);
-
-    // The MP2 ISO doesn't have a colon in the game name and it kinda annoys me
-    if (mGameTitle == "Metroid Prime 2 Echoes")
-        mGameTitle = "Metroid Prime 2: Echoes";
-
-    // Check region byte
-    switch (mGameID[3])
-    {
-    case 'E':
-        mRegion = ERegion::NTSC;
-        break;
-
-    case 'P':
-        mRegion = ERegion::PAL;
-        break;
-
-    case 'J':
-        mRegion = ERegion::JPN;
-        break;
-
-    default:
+    if (!CGameExporter::IdentifyDisc(mpDisc.get(), Info))
         return false;
-    }
 
-    // Set region byte to X so we don't need to compare every regional variant of the ID
-    // Then figure out what game this is
-    CFourCC GameID(&mGameID[0]);
-    GameID[3] = 'X';
+    mGameTitle = Info.GameTitle;
+    mGameID = Info.GameID;
+    mDiscType = Info.DiscType;
+    mGame = Info.Game;
+    mRegion = Info.Region;
 
-    switch (GameID.ToLong())
+    if (mDiscType != EDiscType::Normal)
     {
-    case FOURCC('GM8X'):
-        // This ID is normally MP1, but it's used by the MP1 NTSC demo and the MP2 bonus disc demo as well
-        if (strcmp(rkHeader.m_gameTitle, "Long Game Name") == 0)
-        {
-            // Calculate the CRC of the apploader to figure out which game this is.
-            std::unique_ptr<uint8_t[]> pApploaderData = mpDisc->getDataPartition()->getApploaderBuf();
-            uint ApploaderSize = (uint) mpDisc->getDataPartition()->getApploaderSize();
-            uint ApploaderHash = CCRC32::StaticHashData(pApploaderData.get(), ApploaderSize);
-
-            if (ApploaderHash == 0x21B7AFF5)
-            {
-                // This is the hash for the NTSC MP1 demo.
-                mGame = EGame::PrimeDemo;
-            }
-            else
-            {
-                // Hash is different, so this is most likely an Echoes demo build
-                mGame = EGame::EchoesDemo;
-            }
-
-            break;
-        }
-        else
-        {
-            // This could be either Metroid Prime, or the PAL demo of it...
-            // In either case, the PAL demo is based on a later build of the game than the NTSC demo
-            // So the PAL demo should be configured the same way as the release build of the game anyway
-            mGame = EGame::Prime;
-            break;
-        }
-
-    case FOURCC('G2MX'):
-        // Echoes, but also appears in the MP3 proto
-        if (mGameID[4] == 'A' && mGameID[5] == 'B')
-            mGame = EGame::CorruptionProto;
-        else
-            mGame = EGame::Echoes;
-        break;
-
-    case FOURCC('RM3X'):
-        mGame = EGame::Corruption;
-        break;
-
-    case FOURCC('SF8X'):
-        mGame = EGame::DKCReturns;
-        break;
-
-    case FOURCC('R3MX'):
-        // Trilogy
-        mDiscType = EDiscType::Trilogy;
         if (!RequestWiiPortGame()) return false;
 
         // Force change game name so it isn't "Metroid Prime Trilogy"
-        if (!mWiiFrontend)
+        if (mDiscType == EDiscType::Trilogy && !mWiiFrontend)
             mGameTitle = GetGameName(mGame);
-
-        break;
-
-    case FOURCC('R3IX'):
-        // MP1 Wii de Asobu
-        mGame = EGame::Prime;
-        mDiscType = EDiscType::WiiDeAsobu;
-        if (!RequestWiiPortGame()) return false;
-        break;
-
-    case FOURCC('R32X'):
-        mGame = EGame::Echoes;
-        mDiscType = EDiscType::WiiDeAsobu;
-        if (!RequestWiiPortGame()) return false;
-        break;
-
-    default:
-        // Unrecognized game ID
-        return false;
     }
 
     // The demo builds are not supported. The MP1 demo does not have script templates currently.
@@ -278,43 +185,6 @@ bool CExportGameDialog::RequestWiiPortGame()
     return false;
 }
 
-float CExportGameDialog::FindBuildVersion()
-{
-    ASSERT(mpDisc != nullptr);
-
-    // MP1 demo build doesn't have a build version
-    if (mGame == EGame::PrimeDemo) return 0.f;
-
-    // Get DOL buffer
-    std::unique_ptr<uint8_t[]> pDolData = mpDisc->getDataPartition()->getDOLBuf();
-    uint32 DolSize = (uint32) mpDisc->getDataPartition()->getDOLSize();
-
-    // Find build info string
-    constexpr char pkSearchText[] = "!#$MetroidBuildInfo!#$";
-    const int SearchTextSize = strlen(pkSearchText);
-
-    for (uint32 SearchIdx = 0; SearchIdx < DolSize - SearchTextSize + 1; SearchIdx++)
-    {
-        int Match = 0;
-
-        while (pDolData[SearchIdx + Match] == pkSearchText[Match] && Match < SearchTextSize)
-            Match++;
-
-        if (Match == SearchTextSize)
-        {
-            // Found the build info string; extract version number
-            TString BuildInfo = (char*) &pDolData[SearchIdx + SearchTextSize];
-            int BuildVerStart = BuildInfo.IndexOfPhrase("Build v") + 7;
-            ASSERT(BuildVerStart != 6);
-
-            return BuildInfo.SubString(BuildVerStart, 5).ToFloat();
-        }
-    }
-
-    errorf("Failed to find MetroidBuildInfo string. Build Version will be set to 0.");
-    return 0.f;
-}
-
 void CExportGameDialog::RecursiveAddToTree(const nod::Node *pkNode, QTreeWidgetItem *pParent)
 {
     // Get sorted list of nodes
@@ -41,7 +41,6 @@ public:
     void InitUI(QString ExportDir);
     bool ValidateGame();
     bool RequestWiiPortGame();
-    float FindBuildVersion();
 
     // Disc Tree
     void RecursiveAddToTree(const nod::Node *pkNode, class QTreeWidgetItem *pParent);
@@ -25,6 +25,7 @@ CProjectSettingsDialog::CProjectSettingsDialog(QWidget *pParent)
     mpUI->setupUi(this);
 
     connect(mpUI->GameNameLineEdit, &QLineEdit::editingFinished, this, &CProjectSettingsDialog::GameNameChanged);
+    connect(mpUI->RawAssetFormatComboBox, qOverload<int>(&QComboBox::currentIndexChanged), this, &CProjectSettingsDialog::RawAssetFormatChanged);
     connect(mpUI->CookPackageButton, &QPushButton::clicked, this, &CProjectSettingsDialog::CookPackage);
     connect(mpUI->CookAllDirtyPackagesButton, &QPushButton::clicked, this, &CProjectSettingsDialog::CookAllDirtyPackages);
     connect(mpUI->BuildIsoButton, &QPushButton::clicked, this, &CProjectSettingsDialog::BuildISO);
@@ -61,6 +62,10 @@ void CProjectSettingsDialog::ActiveProjectChanged(CGameProject *pProj)
         mpUI->BuildLineEdit->setText(tr("%1 (%2)").arg(BuildVer).arg(TO_QSTRING(BuildName)));
         mpUI->RegionLineEdit->setText(TO_QSTRING(RegionName));
 
+        mpUI->RawAssetFormatComboBox->blockSignals(true);
+        mpUI->RawAssetFormatComboBox->setCurrentIndex(static_cast<int>(pProj->RawAssetFormat()));
+        mpUI->RawAssetFormatComboBox->blockSignals(false);
+
         // Banner info
         const COpeningBanner Banner(pProj);
         mpUI->GameNameLineEdit->setText(TO_QSTRING(Banner.EnglishGameName()));
@@ -93,6 +98,12 @@ void CProjectSettingsDialog::GameNameChanged()
     }
 }
 
+void CProjectSettingsDialog::RawAssetFormatChanged(int Index)
+{
+    if (mpProject)
+        mpProject->SetRawAssetFormat(static_cast<ERawAssetFormat>(Index));
+}
+
 void CProjectSettingsDialog::SetupPackagesList()
 {
     mpUI->PackagesList->clear();
@@ -29,6 +29,7 @@ public:
 public slots:
     void ActiveProjectChanged(CGameProject *pProj);
     void GameNameChanged();
+    void RawAssetFormatChanged(int Index);
     void SetupPackagesList();
     void CookPackage();
     void CookAllDirtyPackages();
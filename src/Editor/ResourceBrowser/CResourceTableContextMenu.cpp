@@ -169,11 +169,8 @@ void CResourceTableContextMenu::ShowReferencers()
 
     QList<CResourceEntry*> EntryList;
 
-    for (CResourceIterator Iter(mpClickedEntry->ResourceStore()); Iter; ++Iter)
-    {
-        if (Iter->Dependencies()->HasDependency(mpClickedEntry->ID()))
-            EntryList.push_back(*Iter);
-    }
+    for (CResourceEntry *pReferencer : mpClickedEntry->ResourceStore()->FindReferencers(mpClickedEntry->ID()))
+        EntryList.push_back(pReferencer);
 
     if (!mpModel->IsDisplayingUserEntryList())
         mpBrowser->SetInspectedEntry(mpClickedEntry);
@@ -23,6 +23,7 @@
 
 #include <Common/Log.h>
 #include <Core/GameProject/CGameProject.h>
+#include <Core/GameProject/CResourceLoadQueue.h>
 #include <Core/Render/CDrawUtil.h>
 #include <Core/Resource/Script/NGameList.h>
 #include <Core/Scene/CSceneIterator.h>
@@ -218,6 +219,7 @@ CWorldEditor::CWorldEditor(QWidget *parent)
 CWorldEditor::~CWorldEditor()
 {
     mScene.ClearScene();
+    mpAreaLoad = nullptr;
     mpArea = nullptr;
     mpWorld = nullptr;
     if (gpResourceStore)
@@ -240,6 +242,8 @@ bool CWorldEditor::CloseWorld()
         mpLinkDialog->close();
         mpQuickplayAction->setEnabled(false);
 
+        mpAreaLoad = nullptr;
+        mLoadingAreaIndex = -1;
         mpArea = nullptr;
         mpWorld = nullptr;
         if (gpResourceStore)
@@ -265,14 +269,48 @@ bool CWorldEditor::SetArea(CWorld *pWorld, int AreaIndex)
     ClearSelection();
     UndoStack().clear();
 
-    // Load new area
+    // Start loading the new area. The area, its textures and its models are read and decoded in the background,
+    // and the editor keeps running until EditorTick sees the load is done and switches over to the area.
     mpWorld = pWorld;
     CAssetID AreaID = mpWorld->AreaResourceID(AreaIndex);
-    CResourceEntry *pAreaEntry = gpResourceStore->FindEntry(AreaID);
-    ASSERT(pAreaEntry);
+    mpAreaLoad = gpResourceStore->LoadResourceAsync(AreaID);
+    mLoadingAreaIndex = AreaIndex;
+
+    if (!mpAreaLoad)
+    {
+        mpWorld = nullptr;
+        mLoadingAreaIndex = -1;
+        return false;
+    }
+
+    UpdateWindowTitle();
+    UpdateStatusBar();
+
+    // Nothing to wait for if everything is loaded already
+    if (mpAreaLoad->IsFinished() || mpAreaLoad->IsReady())
+        FinishAreaLoad();
+
+    return true;
+}
+
+void CWorldEditor::FinishAreaLoad()
+{
+    const std::shared_ptr<CResourceLoadRequest> pAreaLoad = std::move(mpAreaLoad);
+    const int AreaIndex = mLoadingAreaIndex;
+    mLoadingAreaIndex = -1;
+
+    mpArea = pAreaLoad->Wait();
+
+    if (!mpArea)
+    {
+        errorf("Failed to load area: %s", *pAreaLoad->Entry()->CookedAssetPath(true));
+        mpWorld = nullptr;
+        UpdateWindowTitle();
+        UpdateStatusBar();
+        emit MapChanged(mpWorld, mpArea);
+        return;
+    }
 
-    mpArea = pAreaEntry->Load();
-    ASSERT(mpArea);
     mpWorld->SetAreaLayerInfo(mpArea);
     mScene.SetActiveArea(mpWorld, mpArea);
 
@@ -290,6 +328,7 @@ bool CWorldEditor::SetArea(CWorld *pWorld, int AreaIndex)
 
     // Update UI stuff
     UpdateWindowTitle();
+    UpdateStatusBar();
 
     CGameTemplate *pGame = NGameList::GetGameTemplate(mpArea->Game());
     mpLinkDialog->SetGame(pGame);
@@ -313,8 +352,6 @@ bool CWorldEditor::SetArea(CWorld *pWorld, int AreaIndex)
     // Emit signals
     emit MapChanged(mpWorld, mpArea);
     emit LayersModified();
-
-    return true;
 }
 
 void CWorldEditor::ResetCamera()
@@ -346,6 +383,10 @@ CSceneViewport* CWorldEditor::Viewport() const
 // ************ PUBLIC SLOTS ************
 void CWorldEditor::EditorTick(float)
 {
+    // The application finishes ready requests just before ticking editors, so this doesn't block
+    if (mpAreaLoad && (mpAreaLoad->IsFinished() || mpAreaLoad->IsReady()))
+        FinishAreaLoad();
+
     // Update new link line
     UpdateNewLinkLine();
 }
@@ -779,6 +820,8 @@ void CWorldEditor::UpdateWindowTitle()
 
             if (mpArea && CurrentGame() < EGame::DKCReturns)
                 WindowTitle += " - " + TO_QSTRING( mpWorld->AreaInGameName(mpArea->WorldIndex()) );
+            else if (mpAreaLoad)
+                WindowTitle += " - " + tr("Loading...");
         }
     }
 
@@ -791,7 +834,9 @@ void CWorldEditor::UpdateStatusBar()
     // Would be cool to do more frequent status bar updates with more info. Unfortunately, this causes lag.
     QString StatusText;
 
-    if (!mGizmoHovering)
+    if (mpAreaLoad)
+        StatusText = tr("Loading area...");
+    else if (!mGizmoHovering)
     {
         if (ui->MainViewport->underMouse())
         {
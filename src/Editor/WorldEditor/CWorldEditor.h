@@ -36,6 +36,8 @@
 #include <array>
 #include <memory>
 
+class CResourceLoadRequest;
+
 namespace Ui {
 class CWorldEditor;
 }
@@ -59,6 +61,10 @@ class CWorldEditor : public INodeEditor
     TResPtr<CWorld> mpWorld;
     TResPtr<CGameArea> mpArea;
 
+    // Area that's being loaded in the background; it becomes the active area once the load finishes
+    std::shared_ptr<CResourceLoadRequest> mpAreaLoad;
+    int mLoadingAreaIndex = -1;
+
     CCollisionRenderSettingsDialog* mpCollisionDialog;
     CLinkDialog* mpLinkDialog;
     CGeneratePropertyNamesDialog* mpGeneratePropertyNamesDialog;
@@ -95,6 +101,7 @@ public:
 
     CWorld* ActiveWorld() const      { return mpWorld; }
     CGameArea* ActiveArea() const    { return mpArea; }
+    bool IsLoadingArea() const       { return mpAreaLoad != nullptr; }
     EGame CurrentGame() const        { return gpEdApp->CurrentGame(); }
     CLinkDialog* LinkDialog() const  { return mpLinkDialog; }
     CGeneratePropertyNamesDialog* NameGeneratorDialog() const    { return mpGeneratePropertyNamesDialog; }
@@ -143,6 +150,7 @@ public slots:
     void LaunchQuickplayFromLocation(CVector3f Location, bool ForceAsSpawnPosition);
 
 protected:
+    void FinishAreaLoad();
     QAction* AddEditModeButton(QIcon Icon, QString ToolTip, EWorldEditorMode Mode);
     void SetSidebar(CWorldEditorSidebar *pSidebar);
     void GizmoModeChanged(CGizmo::EGizmoMode Mode) override;